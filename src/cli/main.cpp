@@ -0,0 +1,301 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+
+#include <cstdio>
+
+#include "../core/curl_builder.h"
+#include "../core/decode_search.h"
+#include "../core/decoder.h"
+#include "../core/json_index.h"
+#include "../core/parallel.h"
+#include "../core/unpacker.h"
+
+#ifdef Q_OS_WIN
+    #include <fcntl.h>
+    #include <io.h>
+#endif
+
+// Headless front end to dave_core for shell pipelines and batch jobs. Links Qt6::Core only, so
+// startup is a QCoreApplication and nothing else.
+
+namespace {
+
+constexpr qint64 kChunkSize = 1 << 20;
+
+enum Command { Decode, Unpack, Beautify, FormatJson, ValidateJson };
+
+struct Job {
+    Command command = Decode;
+    Decoder::Algorithm algorithm = Decoder::Base64;
+    bool autoDecode = false;
+    int rotShift = 13;
+};
+
+// Outcome of one input: bytes for stdout, plus an error or informational note for stderr.
+struct Result {
+    QByteArray output;
+    QString error;
+    QString note;
+};
+
+// Note for a result the unpacker's budget cut short; empty when it ran to the end
+QString partialNote(Unpacker::StopReason reason) {
+    static const char *const kReasons[] = {"", "layer limit reached", "time limit reached",
+                                           "size limit reached", "layers repeat", "cancelled"};
+    return reason == Unpacker::FixedPoint ? QString()
+                                          : QString("partial result, %1").arg(kReasons[reason]);
+}
+
+Result runWhole(const Job &job, QByteArrayView input) {
+    Result result;
+    switch (job.command) {
+        case Decode: {
+            if (job.autoDecode) {
+                DecodeSearch search;
+                const QList<DecodeSearch::Chain> chains = search.search(input);
+                if (chains.isEmpty()) {
+                    result.error = "Error: No encoding layers found";
+                } else {
+                    result.output = chains.first().output;
+                    result.note = DecodeSearch::describe(chains.first().steps);
+                }
+                break;
+            }
+            qsizetype position = -1;
+            const Decoder::Status status =
+                Decoder::decode(input, job.algorithm, result.output, job.rotShift, &position);
+            if (status != Decoder::Ok) {
+                result.error = Decoder::errorMessage(job.algorithm, status, position);
+            }
+            break;
+        }
+        case Unpack:
+        case Beautify:
+        case FormatJson: {
+            const Unpacker::Budget budget;
+            QStringList layers;
+            const Unpacker::StopReason reason =
+                job.command == Unpack
+                    ? Unpacker::deobfuscateJavaScript(input, result.output, budget, &layers)
+                : job.command == Beautify
+                    ? Unpacker::beautifyJavaScriptParallel(input, result.output, budget)
+                    : Unpacker::formatJson(input, result.output, budget);
+            QStringList notes = {layers.join(" → "), partialNote(reason)};
+            notes.removeAll(QString());
+            result.note = notes.join("; ");
+            break;
+        }
+        case ValidateJson:
+            JsonIndex::validate(input, nullptr, &result.error);
+            break;
+    }
+    return result;
+}
+
+// Files are memory-mapped and handed to the byte-oriented core without a copy.
+Result runFile(const Job &job, const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {{}, "Error: " + file.errorString(), {}};
+    }
+    if (file.size() == 0) {
+        return runWhole(job, QByteArrayView());
+    }
+    if (const uchar *mapped = file.map(0, file.size())) {
+        return runWhole(job, QByteArrayView(reinterpret_cast<const char *>(mapped), file.size()));
+    }
+
+    // Pipes and other special files cannot be mapped
+    const QByteArray contents = file.readAll();
+    return runWhole(job, contents);
+}
+
+// Plain decoding never needs the whole input, so stdin is decoded chunk by chunk in bounded
+// memory; everything else reads stdin to the end first.
+Result runStdin(const Job &job, QFile &in, QFile &out) {
+    const bool streamable = job.command == Decode && !job.autoDecode;
+    if (!streamable) {
+        return runWhole(job, in.readAll());
+    }
+
+    Decoder::Stream stream(job.algorithm, job.rotShift);
+    QByteArray buffer(kChunkSize, Qt::Uninitialized);
+    qint64 read = 0;
+    while ((read = in.read(buffer.data(), kChunkSize)) > 0) {
+        if (!stream.push(QByteArrayView(buffer.constData(), read))) {
+            break;
+        }
+        out.write(stream.takeOutput());
+    }
+    if (!stream.hasError()) {
+        stream.finish();
+        out.write(stream.takeOutput());
+    }
+    return {{}, stream.errorString(), {}};
+}
+
+bool parseDecodeAlgorithm(const QString &name, Job &job) {
+    if (name == "base64") {
+        job.algorithm = Decoder::Base64;
+    } else if (name == "hex") {
+        job.algorithm = Decoder::Hex;
+    } else if (name == "rot") {
+        job.algorithm = Decoder::ROT;
+    } else if (name == "rot47") {
+        job.algorithm = Decoder::ROT47;
+    } else if (name == "auto") {
+        job.autoDecode = true;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseHttpMethod(const QString &name, CurlBuilder::HttpMethod &method) {
+    for (int value = CurlBuilder::GET; value <= CurlBuilder::OPTIONS; value++) {
+        const auto candidate = static_cast<CurlBuilder::HttpMethod>(value);
+        if (CurlBuilder::httpMethodToString(candidate).compare(name, Qt::CaseInsensitive) == 0) {
+            method = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Diagnostics go to stderr so stdout stays clean for the next stage of a pipeline.
+void printError(const QString &message) {
+    std::fprintf(stderr, "dave-cli: %s\n", qPrintable(message));
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("dave-cli");
+    QCoreApplication::setApplicationVersion(DAVE_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Decode, unpack and format from the command line.\n\n"
+        "Commands:\n"
+        "  decode <base64|hex|rot|rot47|auto> [files...]\n"
+        "  unpack [files...]        Deobfuscate JavaScript, layer by layer\n"
+        "  beautify [files...]      Reformat JavaScript\n"
+        "  format-json [files...]   Repair and indent JSON\n"
+        "  validate-json [files...] Report the first JSON syntax error\n"
+        "  curl-build <url>         Print a curl command\n\n"
+        "Without files, input is read from standard input. Several files are processed in\n"
+        "parallel and written to standard output in the order given.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("command", "The command to run.");
+
+    const QCommandLineOption shiftOption({"s", "shift"}, "ROT shift for decode rot.", "n", "13");
+    const QCommandLineOption requestOption({"X", "request"}, "curl-build: HTTP method.", "method");
+    const QCommandLineOption headerOption({"H", "header"}, "curl-build: \"Name: value\" header.",
+                                          "header");
+    const QCommandLineOption dataOption({"d", "data"}, "curl-build: request body.", "body");
+    const QCommandLineOption locationOption({"L", "location"}, "curl-build: follow redirects.");
+    const QCommandLineOption insecureOption({"k", "insecure"}, "curl-build: skip TLS checks.");
+    const QCommandLineOption includeOption({"i", "include"}, "curl-build: show response headers.");
+    const QCommandLineOption verboseOption("verbose", "curl-build: verbosity 0-3.", "level", "0");
+    parser.addOptions({shiftOption, requestOption, headerOption, dataOption, locationOption,
+                       insecureOption, includeOption, verboseOption});
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty()) {
+        parser.showHelp(1);
+    }
+    const QString command = arguments.takeFirst();
+
+#ifdef Q_OS_WIN
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+
+    if (command == "curl-build") {
+        if (arguments.size() != 1) {
+            printError("curl-build takes exactly one URL");
+            return 1;
+        }
+        CurlBuilder::CurlOptions options;
+        options.url = arguments.first();
+        if (parser.isSet(requestOption) &&
+            !parseHttpMethod(parser.value(requestOption), options.method)) {
+            printError("unknown HTTP method " + parser.value(requestOption));
+            return 1;
+        }
+        for (const QString &header : parser.values(headerOption)) {
+            const qsizetype colon = header.indexOf(':');
+            if (colon > 0) {
+                options.headers.append(
+                    {header.left(colon).trimmed(), header.mid(colon + 1).trimmed()});
+            }
+        }
+        options.body = parser.value(dataOption);
+        options.followRedirects = parser.isSet(locationOption);
+        options.insecure = parser.isSet(insecureOption);
+        options.includeResponseHeaders = parser.isSet(includeOption);
+        const int verbose = qBound(0, parser.value(verboseOption).toInt(), 3);
+        options.verbose = static_cast<CurlBuilder::VerboseLevel>(verbose);
+        out.write(CurlBuilder::buildCurlCommand(options).toUtf8() + '\n');
+        return 0;
+    }
+
+    Job job;
+    if (command == "decode") {
+        if (arguments.isEmpty() || !parseDecodeAlgorithm(arguments.takeFirst(), job)) {
+            printError("decode needs one of base64, hex, rot, rot47 or auto");
+            return 1;
+        }
+        job.rotShift = parser.value(shiftOption).toInt();
+    } else if (command == "unpack") {
+        job.command = Unpack;
+    } else if (command == "beautify") {
+        job.command = Beautify;
+    } else if (command == "format-json") {
+        job.command = FormatJson;
+    } else if (command == "validate-json") {
+        job.command = ValidateJson;
+    } else {
+        printError("unknown command " + command);
+        return 1;
+    }
+
+    if (arguments.isEmpty()) {
+        QFile in;
+        in.open(stdin, QIODevice::ReadOnly);
+        const Result result = runStdin(job, in, out);
+        out.write(result.output);
+        if (!result.note.isEmpty()) {
+            printError(result.note);
+        }
+        if (!result.error.isEmpty()) {
+            printError(result.error);
+            return 1;
+        }
+        return 0;
+    }
+
+    QList<Result> results(arguments.size());
+    Result *perFile = results.data();
+    parallel::forEach(static_cast<int>(arguments.size()),
+                      [&](int i) { perFile[i] = runFile(job, arguments[i]); });
+
+    int exitCode = 0;
+    for (qsizetype i = 0; i < results.size(); i++) {
+        out.write(results[i].output);
+        if (!results[i].note.isEmpty()) {
+            printError(arguments[i] + ": " + results[i].note);
+        }
+        if (!results[i].error.isEmpty()) {
+            printError(arguments[i] + ": " + results[i].error);
+            exitCode = 1;
+        }
+    }
+    return exitCode;
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Bump allocator for large trees of trivially destructible nodes. Allocation is a pointer
+// increment inside the current block; nothing is freed individually, and the whole arena goes
+// away in one sweep over its blocks. Blocks double in size, so even a tree of millions of nodes
+// lives in a handful of them.
+class Arena {
+  public:
+    explicit Arena(qsizetype firstBlockSize = 64 * 1024) : nextBlockSize(firstBlockSize) {}
+    ~Arena() { release(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    Arena(Arena &&other) noexcept { *this = std::move(other); }
+    Arena &operator=(Arena &&other) noexcept {
+        if (this != &other) {
+            release();
+            head = std::exchange(other.head, nullptr);
+            cursor = std::exchange(other.cursor, nullptr);
+            limit = std::exchange(other.limit, nullptr);
+            nextBlockSize = other.nextBlockSize;
+            used = std::exchange(other.used, 0);
+        }
+        return *this;
+    }
+
+    void *allocate(qsizetype size, qsizetype align = alignof(std::max_align_t)) {
+        char *aligned = alignUp(cursor, align);
+        if (!cursor || size > limit - aligned) {
+            grow(size + align);
+            aligned = alignUp(cursor, align);
+        }
+        cursor = aligned + size;
+        used += size;
+        return aligned;
+    }
+
+    template <typename T, typename... Args>
+    T *create(Args &&...args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+    }
+
+    template <typename T>
+    T *allocateArray(qsizetype count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return static_cast<T *>(allocate(count * qsizetype(sizeof(T)), alignof(T)));
+    }
+
+    qsizetype bytesUsed() const { return used; }
+
+  private:
+    // Each block starts with a link to the previous one
+    struct Block {
+        Block *previous;
+    };
+
+    static char *alignUp(char *pointer, qsizetype align) {
+        const quintptr value = reinterpret_cast<quintptr>(pointer);
+        return reinterpret_cast<char *>((value + align - 1) & ~quintptr(align - 1));
+    }
+
+    void grow(qsizetype atLeast) {
+        const qsizetype size = qMax(nextBlockSize, atLeast + qsizetype(sizeof(Block)));
+        Block *block = static_cast<Block *>(std::malloc(size));
+        Q_CHECK_PTR(block);
+        block->previous = head;
+        head = block;
+        cursor = reinterpret_cast<char *>(block + 1);
+        limit = reinterpret_cast<char *>(block) + size;
+        nextBlockSize = size * 2;
+    }
+
+    void release() {
+        while (head) {
+            std::free(std::exchange(head, head->previous));
+        }
+        cursor = limit = nullptr;
+        used = 0;
+    }
+
+    Block *head = nullptr;
+    char *cursor = nullptr;
+    char *limit = nullptr;
+    qsizetype nextBlockSize;
+    qsizetype used = 0;
+};
\ No newline at end of file
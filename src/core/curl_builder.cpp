@@ -2,46 +2,84 @@
 
 #include <QStringList>
 
-QString CurlBuilder::buildCurlCommand(const CurlOptions &options) {
-    QString command = "curl";
+CurlBuilder::Command::Edit CurlBuilder::Command::update(const CurlOptions &options) {
+    QStringList next = {"curl"};
 
     // Add URL first (right after curl)
-    if (!options.url.isEmpty()) {
-        command += " \"" + escapeShellArg(options.url) + "\"";
-    }
+    next.append(options.url.isEmpty() ? QString() : quoted(QString(), options.url));
 
     // Add method
-    if (options.method != GET) {
-        command += " -X " + httpMethodToString(options.method);
-    }
+    next.append(options.method != GET ? " -X " + httpMethodToString(options.method) : QString());
 
     // Add flags
-    if (options.verbose != None) {
-        command += " " + verboseLevelToString(options.verbose);
-    }
-    if (options.followRedirects) {
-        command += " -L";
-    }
-    if (options.insecure) {
-        command += " -k";
-    }
-    if (options.includeResponseHeaders) {
-        command += " -i";
-    }
+    next.append(options.verbose != None ? " " + verboseLevelToString(options.verbose)
+                                        : QString());
+    next.append(options.followRedirects ? " -L" : "");
+    next.append(options.insecure ? " -k" : "");
+    next.append(options.includeResponseHeaders ? " -i" : "");
 
     // Add headers
     for (const auto &header : options.headers) {
         if (!header.first.isEmpty() && !header.second.isEmpty()) {
-            command += " -H \"" + escapeShellArg(header.first + ": " + header.second) + "\"";
+            next.append(quoted("-H", header.first + ": " + header.second));
         }
     }
 
-    // Add body
-    if (!options.body.isEmpty()) {
-        command += " -d \"" + escapeShellArg(options.body) + "\"";
+    // Add body; an unchanged one keeps its segment, shared rather than escaped again
+    if (!segments.isEmpty() && options.body == body) {
+        next.append(segments.last());
+    } else {
+        next.append(options.body.isEmpty() ? QString() : quoted("-d", options.body));
     }
+    body = options.body;
 
-    return command;
+    // Segments equal at either end are skipped whole; within the span left between them the
+    // edit is trimmed to the characters that differ
+    qsizetype front = 0;
+    while (front < qMin(segments.size(), next.size()) && segments[front] == next[front]) {
+        front++;
+    }
+    qsizetype back = 0;
+    while (back < qMin(segments.size(), next.size()) - front &&
+           segments[segments.size() - 1 - back] == next[next.size() - 1 - back]) {
+        back++;
+    }
+
+    Edit edit;
+    for (qsizetype k = 0; k < front; k++) {
+        edit.position += segments[k].size();
+    }
+    for (qsizetype k = front; k < segments.size() - back; k++) {
+        edit.removed += segments[k].size();
+    }
+    for (qsizetype k = front; k < next.size() - back; k++) {
+        edit.inserted += next[k];
+    }
+    segments = next;
+
+    const QStringView removed = QStringView(command).mid(edit.position, edit.removed);
+    const QStringView inserted = edit.inserted;
+    const qsizetype shorter = qMin(removed.size(), inserted.size());
+    qsizetype prefix = 0;
+    while (prefix < shorter && removed[prefix] == inserted[prefix]) {
+        prefix++;
+    }
+    qsizetype suffix = 0;
+    while (suffix < shorter - prefix &&
+           removed[removed.size() - 1 - suffix] == inserted[inserted.size() - 1 - suffix]) {
+        suffix++;
+    }
+    edit.position += prefix;
+    edit.removed -= prefix + suffix;
+    edit.inserted = edit.inserted.mid(prefix, edit.inserted.size() - prefix - suffix);
+    command.replace(edit.position, edit.removed, edit.inserted);
+    return edit;
+}
+
+QString CurlBuilder::buildCurlCommand(const CurlOptions &options) {
+    Command command;
+    command.update(options);
+    return command.text();
 }
 
 QString CurlBuilder::httpMethodToString(HttpMethod method) {
@@ -103,4 +141,9 @@ QString CurlBuilder::escapeShellArg(const QString &arg) {
     QString escaped = arg;
     escaped.replace("\"", "\\\"");
     return escaped;
+}
+
+// ` flag "arg"`, or ` "arg"` without a flag
+QString CurlBuilder::quoted(const QString &flag, const QString &arg) {
+    return (flag.isEmpty() ? " \"" : " " + flag + " \"") + escapeShellArg(arg) + "\"";
 }
\ No newline at end of file
@@ -21,6 +21,28 @@ class CurlBuilder {
         QString body;
     };
 
+    // buildCurlCommand()'s output kept as one segment per option, header and the body. update()
+    // renders the body again only when it differs, and returns the span of the command that
+    // changed, trimmed to what actually differs, so a view can patch the command in place
+    // instead of being reset: a keystroke in a large body then costs a comparison and an escape
+    // pass rather than a rebuild and a relayout of the whole command.
+    class Command {
+      public:
+        struct Edit {
+            qsizetype position = 0;
+            qsizetype removed = 0;
+            QString inserted;
+        };
+
+        Edit update(const CurlOptions &options);
+        const QString &text() const { return command; }
+
+      private:
+        QStringList segments;  // "curl", then each option as rendered, the body last
+        QString body;          // the body `segments` was rendered from
+        QString command;
+    };
+
     static QString buildCurlCommand(const CurlOptions &options);
     static QString httpMethodToString(HttpMethod method);
     static QString verboseLevelToString(VerboseLevel level);
@@ -28,4 +50,5 @@ class CurlBuilder {
 
   private:
     static QString escapeShellArg(const QString &arg);
+    static QString quoted(const QString &flag, const QString &arg);
 };
\ No newline at end of file
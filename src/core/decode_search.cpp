@@ -0,0 +1,174 @@
+#include "decode_search.h"
+
+#include <QQueue>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+
+#include "task_control.h"
+
+namespace {
+
+// Containers dave cannot unpack itself; a chain that reaches one has still found the payload.
+bool isKnownBinary(QByteArrayView data) {
+    static const QByteArrayView kMagic[] = {
+        QByteArrayView("\x1f\x8b", 2),  // gzip
+        "PK\x03\x04",                   // zip
+        "\x89PNG",                      // PNG
+        "%PDF",                         // PDF
+        "\x7f" "ELF",                   // ELF
+        QByteArrayView("\x78\x9c", 2),  // zlib, default compression
+        QByteArrayView("\x78\xda", 2),  // zlib, best compression
+    };
+    for (QByteArrayView magic : kMagic) {
+        if (data.startsWith(magic)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+QList<DecodeSearch::Chain> DecodeSearch::search(QByteArrayView input) {
+    return search(input, Budget());
+}
+
+QList<DecodeSearch::Chain> DecodeSearch::search(QByteArrayView input, const Budget &budget) {
+    struct Pending {
+        QByteArray data;
+        QList<Step> steps;
+    };
+
+    QList<Chain> chains;
+    QSet<QByteArray> seen;
+    QQueue<Pending> queue;
+
+    const QByteArray root = input.toByteArray();
+    seen.insert(root);
+    queue.enqueue({root, {}});
+
+    int expansions = 0;
+    while (!queue.isEmpty() && expansions < budget.maxExpansions) {
+        if (budget.control) {
+            if (budget.control->cancelled()) {
+                break;  // the chains found so far are still ranked and returned
+            }
+            budget.control->report(expansions, budget.maxExpansions);
+        }
+        if (cachedBytes > budget.maxCacheBytes) {
+            clearCache();  // `seen` still keeps this search from visiting anything twice
+        }
+        const Pending current = queue.dequeue();
+        const bool last = current.steps.size() >= budget.maxDepth;
+        // A copy: analysing the children below may rehash the cache
+        const Expansion expansion = expansionFor(current.data, budget, !last);
+        expansions++;
+
+        if (!current.steps.isEmpty()) {
+            // Readable output that no longer looks encoded is what the caller is after
+            double score = 0.5;
+            if (!expansion.binary) {
+                score = expansion.printable * (1.0 - 0.5 * expansion.encodedConfidence);
+            }
+            chains.append({current.steps, current.data, score});
+        }
+        if (last) {
+            continue;
+        }
+
+        for (const Child &child : expansion.children) {
+            if (child.confidence < budget.minConfidence || seen.contains(child.output)) {
+                continue;
+            }
+            seen.insert(child.output);
+
+            const Expansion &next = analysisFor(child.output);
+            if (!next.binary && next.printable < budget.minPrintable) {
+                continue;  // decoded to garbage; nothing below it is worth exploring
+            }
+            QList<Step> steps = current.steps;
+            steps.append(child.step);
+            queue.enqueue({child.output, steps});
+        }
+    }
+
+    // Breadth-first order already puts shorter chains first among equal scores
+    std::stable_sort(chains.begin(), chains.end(),
+                     [](const Chain &a, const Chain &b) { return a.score > b.score; });
+    if (chains.size() > budget.maxResults) {
+        chains.resize(budget.maxResults);
+    }
+    return chains;
+}
+
+void DecodeSearch::clearCache() {
+    cache.clear();
+    cachedBytes = 0;
+}
+
+qsizetype DecodeSearch::cacheSize() const {
+    return cache.size();
+}
+
+QString DecodeSearch::describe(const QList<Step> &steps) {
+    QStringList names;
+    for (const Step &step : steps) {
+        switch (step.algorithm) {
+            case Decoder::Base64:
+                names.append("Base64");
+                break;
+            case Decoder::Hex:
+                names.append("Hex");
+                break;
+            case Decoder::ROT:
+                names.append(QString("ROT%1").arg(step.rotShift));
+                break;
+            case Decoder::ROT47:
+                names.append("ROT47");
+                break;
+        }
+    }
+    return names.join(" → ");
+}
+
+DecodeSearch::Expansion &DecodeSearch::analysisFor(const QByteArray &data) {
+    Expansion &expansion = cache[data];
+    if (!expansion.analysed) {
+        expansion.analysed = true;
+        expansion.printable = Decoder::printableRatio(data);
+        expansion.binary = isKnownBinary(data);
+        cachedBytes += data.size();
+    }
+    return expansion;
+}
+
+DecodeSearch::Expansion &DecodeSearch::expansionFor(const QByteArray &data, const Budget &budget,
+                                                    bool decode) {
+    Expansion &expansion = analysisFor(data);
+    if (!expansion.detected) {
+        expansion.detected = true;
+        expansion.detections = Decoder::detectEncoding(QByteArrayView(data));
+        if (!expansion.detections.isEmpty()) {
+            expansion.encodedConfidence = expansion.detections.first().confidence;
+        }
+    }
+    if (!decode || expansion.expanded || expansion.binary || data.size() > budget.maxSize) {
+        return expansion;  // left unexpanded so a later, larger budget can still decode it
+    }
+
+    // Decode every plausible layer once; the budget's confidence cut is applied per search
+    for (const Decoder::Detection &detection : expansion.detections) {
+        QByteArray output;
+        const Decoder::Status status =
+            Decoder::decode(data, detection.algorithm, output, detection.rotShift);
+        if (status == Decoder::Ok && !output.isEmpty() && output != data) {
+            cachedBytes += output.size();
+            expansion.children.append(
+                {{detection.algorithm, detection.rotShift}, output, detection.confidence});
+        }
+    }
+    expansion.expanded = true;
+    return expansion;
+}
\ No newline at end of file
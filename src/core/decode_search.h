@@ -0,0 +1,77 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QList>
+
+#include "decoder.h"
+
+class TaskControl;
+
+// Peels nested encodings (base64 of hex of ROT13 ...) automatically. Decode chains are explored
+// breadth-first from the input, each layer proposing only the encodings detectEncoding() finds
+// plausible, and every intermediate result is cached by its content: two chains that reach the
+// same bytes share everything below that point, within one search and across later searches on
+// the same DecodeSearch. A result is decoded further only when the search visits it; reaching it
+// just measures how printable it is, which is enough to prune garbage before it is queued.
+class DecodeSearch {
+  public:
+    struct Step {
+        Decoder::Algorithm algorithm = Decoder::Base64;
+        int rotShift = 0;
+    };
+
+    struct Chain {
+        QList<Step> steps;
+        QByteArray output;
+        double score = 0;  // 0 .. 1, how much the output looks like a final, readable result
+    };
+
+    struct Budget {
+        int maxDepth = 6;
+        int maxExpansions = 256;               // distinct intermediate results to visit
+        qsizetype maxSize = 64 * 1024 * 1024;  // larger intermediates are not decoded further
+        double minConfidence = 0.3;            // weaker detections are not followed
+        double minPrintable = 0.6;             // outputs below this are garbage and pruned
+        int maxResults = 5;
+        TaskControl *control = nullptr;  // checked between expansions; told expansions / max
+        // Results cached across searches; the cache is cleared between expansions beyond this
+        qsizetype maxCacheBytes = 256 * 1024 * 1024;
+    };
+
+    // Best chains first; empty when no layer of the input decodes to anything plausible.
+    QList<Chain> search(QByteArrayView input);
+    QList<Chain> search(QByteArrayView input, const Budget &budget);
+
+    void clearCache();
+    qsizetype cacheSize() const;
+
+    static QString describe(const QList<Step> &steps);
+
+  private:
+    struct Child {
+        Step step;
+        QByteArray output;
+        double confidence = 0;
+    };
+
+    // Everything learned about one intermediate result, keyed by the result itself. Filled in as
+    // needed: printable and binary when a chain reaches it, the rest when the search visits it.
+    struct Expansion {
+        double printable = 0;
+        double encodedConfidence = 0;  // best detectEncoding() confidence: still looks encoded
+        bool binary = false;           // known binary container; decoding stops here
+        bool analysed = false;
+        bool detected = false;
+        bool expanded = false;
+        QList<Decoder::Detection> detections;
+        QList<Child> children;
+    };
+
+    Expansion &analysisFor(const QByteArray &data);
+    Expansion &expansionFor(const QByteArray &data, const Budget &budget, bool decode);
+
+    QHash<QByteArray, Expansion> cache;
+    qsizetype cachedBytes = 0;  // of the results in `cache`, keys and children
+};
\ No newline at end of file
@@ -1,7 +1,1389 @@
 #include "decoder.h"
 
 #include <QByteArray>
-#include <QRegularExpression>
+#include <QVector>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "parallel.h"
+#include "simd.h"
+#include "task_control.h"
+
+namespace {
+
+// ============================================================================
+// Shared helpers
+// ============================================================================
+
+// Outcome of decoding a character buffer into a caller-provided byte buffer.
+struct DecodeResult {
+    qsizetype size = 0;
+    qsizetype errorPosition = -1;  // index of the first offending character
+    bool truncated = false;        // input ended in the middle of an encoded unit
+};
+
+#if defined(DAVE_SIMD_X86)
+
+DAVE_TARGET_SSE41 inline __m128i loadBytes16(const char *in) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+}
+
+// UTF-16 units above 0xFF saturate to 0x00 or 0xFF, neither of which any decoder accepts.
+DAVE_TARGET_SSE41 inline __m128i loadBytes16(const char16_t *in) {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 8));
+    return _mm_packus_epi16(lo, hi);
+}
+
+DAVE_TARGET_SSE41 inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+DAVE_TARGET_AVX2 inline __m256i loadBytes32(const char *in) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+}
+
+DAVE_TARGET_AVX2 inline __m256i loadBytes32(const char16_t *in) {
+    const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+    const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + 16));
+    // packus works per 128-bit lane; restore the original character order afterwards
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+DAVE_TARGET_AVX2 inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+#elif defined(DAVE_SIMD_NEON)
+
+inline uint8x16_t inRangeNeon(uint8x16_t v, uint8_t lo, uint8_t hi) {
+    return vcleq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8(static_cast<uint8_t>(hi - lo)));
+}
+
+#endif
+
+// ============================================================================
+// Base64
+// ============================================================================
+
+// Sextet values for the scalar path. Both the standard ("+/") and URL-safe ("-_") alphabets
+// are accepted so either flavour decodes without the caller having to say which it is.
+constexpr unsigned char kB64Invalid = 0xFF;
+constexpr unsigned char kB64Skip = 0xFE;  // MIME line wrapping and other whitespace
+constexpr unsigned char kB64Pad = 0xFD;
+
+constexpr std::array<unsigned char, 256> makeBase64Table() {
+    std::array<unsigned char, 256> table{};
+    for (auto &entry : table) {
+        entry = kB64Invalid;
+    }
+    for (int i = 0; i < 26; i++) {
+        table['A' + i] = static_cast<unsigned char>(i);
+        table['a' + i] = static_cast<unsigned char>(26 + i);
+    }
+    for (int i = 0; i < 10; i++) {
+        table['0' + i] = static_cast<unsigned char>(52 + i);
+    }
+    table['+'] = 62;
+    table['-'] = 62;
+    table['/'] = 63;
+    table['_'] = 63;
+    table['='] = kB64Pad;
+    table[' '] = kB64Skip;
+    table['\t'] = kB64Skip;
+    table['\n'] = kB64Skip;
+    table['\r'] = kB64Skip;
+    table['\f'] = kB64Skip;
+    table['\v'] = kB64Skip;
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> kBase64Table = makeBase64Table();
+
+template <typename CharT>
+inline unsigned char base64Value(CharT ch) {
+    const auto code = static_cast<std::make_unsigned_t<CharT>>(ch);
+    return code < 256 ? kBase64Table[code] : kB64Invalid;
+}
+
+// A kernel decodes whole blocks of alphabet characters (no whitespace or padding) and returns
+// how many input characters it consumed; it stops at the first block it cannot handle.
+template <typename CharT>
+using Base64Kernel = qsizetype (*)(const CharT *in, qsizetype length, char *out, bool urlSafe);
+
+template <typename CharT>
+qsizetype base64KernelScalar(const CharT *in, qsizetype length, char *out, bool) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 4) {
+        const unsigned char a = base64Value(in[consumed]);
+        const unsigned char b = base64Value(in[consumed + 1]);
+        const unsigned char c = base64Value(in[consumed + 2]);
+        const unsigned char d = base64Value(in[consumed + 3]);
+        if ((a | b | c | d) & 0xC0) {
+            break;
+        }
+        const unsigned int triple = (a << 18) | (b << 12) | (c << 6) | d;
+        *out++ = static_cast<char>(triple >> 16);
+        *out++ = static_cast<char>(triple >> 8);
+        *out++ = static_cast<char>(triple);
+        consumed += 4;
+    }
+    return consumed;
+}
+
+#if defined(DAVE_SIMD_X86)
+
+// Maps 16 alphabet characters to sextets in place; returns false if any byte is not in the
+// alphabet. Bytes >= 0x80 compare as negative and therefore fall outside every range.
+DAVE_TARGET_SSE41 inline bool base64Sextets16(__m128i &v, bool urlSafe) {
+    const char char62 = urlSafe ? '-' : '+';
+    const char char63 = urlSafe ? '_' : '/';
+    const __m128i upper = inRange16(v, 'A', 'Z');
+    const __m128i lower = inRange16(v, 'a', 'z');
+    const __m128i digit = inRange16(v, '0', '9');
+    const __m128i is62 = _mm_cmpeq_epi8(v, _mm_set1_epi8(char62));
+    const __m128i is63 = _mm_cmpeq_epi8(v, _mm_set1_epi8(char63));
+
+    const __m128i valid =
+        _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(is62, is63)));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+        return false;
+    }
+
+    __m128i offset = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+    offset = _mm_or_si128(offset, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+    offset = _mm_or_si128(offset, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+    offset =
+        _mm_or_si128(offset, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - char62))));
+    offset =
+        _mm_or_si128(offset, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - char63))));
+    v = _mm_add_epi8(v, offset);
+    return true;
+}
+
+// Packs 16 sextets (four per 32-bit lane) into 12 bytes at the front of the register.
+DAVE_TARGET_SSE41 inline __m128i packSextets16(__m128i sextets) {
+    const __m128i pairs = _mm_maddubs_epi16(sextets, _mm_set1_epi32(0x01400140));
+    const __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(triples,
+                            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+template <typename CharT>
+DAVE_TARGET_SSE41 qsizetype base64KernelSse41(const CharT *in, qsizetype length, char *out,
+                                              bool urlSafe) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 16) {
+        __m128i v = loadBytes16(in + consumed);
+        if (!base64Sextets16(v, urlSafe)) {
+            break;
+        }
+        alignas(16) char block[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(block), packSextets16(v));
+        std::memcpy(out, block, 12);
+        out += 12;
+        consumed += 16;
+    }
+    return consumed;
+}
+
+DAVE_TARGET_AVX2 inline bool base64Sextets32(__m256i &v, bool urlSafe) {
+    const char char62 = urlSafe ? '-' : '+';
+    const char char63 = urlSafe ? '_' : '/';
+    const __m256i upper = inRange32(v, 'A', 'Z');
+    const __m256i lower = inRange32(v, 'a', 'z');
+    const __m256i digit = inRange32(v, '0', '9');
+    const __m256i is62 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(char62));
+    const __m256i is63 = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(char63));
+
+    const __m256i valid = _mm256_or_si256(_mm256_or_si256(upper, lower),
+                                          _mm256_or_si256(digit, _mm256_or_si256(is62, is63)));
+    if (_mm256_movemask_epi8(valid) != -1) {
+        return false;
+    }
+
+    __m256i offset = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+    offset = _mm256_or_si256(offset, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+    offset = _mm256_or_si256(
+        offset, _mm256_and_si256(is62, _mm256_set1_epi8(static_cast<char>(62 - char62))));
+    offset = _mm256_or_si256(
+        offset, _mm256_and_si256(is63, _mm256_set1_epi8(static_cast<char>(63 - char63))));
+    v = _mm256_add_epi8(v, offset);
+    return true;
+}
+
+template <typename CharT>
+DAVE_TARGET_AVX2 qsizetype base64KernelAvx2(const CharT *in, qsizetype length, char *out,
+                                            bool urlSafe) {
+    const __m256i pairMul = _mm256_set1_epi32(0x01400140);
+    const __m256i tripleMul = _mm256_set1_epi32(0x00011000);
+    const __m256i reorder = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1,
+                                             -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                                             -1, -1);
+    const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+    qsizetype consumed = 0;
+    while (length - consumed >= 32) {
+        __m256i v = loadBytes32(in + consumed);
+        if (!base64Sextets32(v, urlSafe)) {
+            break;
+        }
+        const __m256i pairs = _mm256_maddubs_epi16(v, pairMul);
+        const __m256i triples = _mm256_madd_epi16(pairs, tripleMul);
+        const __m256i packed =
+            _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(triples, reorder), compact);
+        alignas(32) char block[32];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(block), packed);
+        std::memcpy(out, block, 24);
+        out += 24;
+        consumed += 32;
+    }
+    return consumed;
+}
+
+#elif defined(DAVE_SIMD_NEON)
+
+inline uint8x16x4_t loadQuads64(const char *in) {
+    return vld4q_u8(reinterpret_cast<const uint8_t *>(in));
+}
+
+inline uint8x16x4_t loadQuads64(const char16_t *in) {
+    const uint16x8x4_t lo = vld4q_u16(reinterpret_cast<const uint16_t *>(in));
+    const uint16x8x4_t hi = vld4q_u16(reinterpret_cast<const uint16_t *>(in + 32));
+    uint8x16x4_t quads;
+    for (int i = 0; i < 4; i++) {
+        quads.val[i] = vcombine_u8(vqmovn_u16(lo.val[i]), vqmovn_u16(hi.val[i]));
+    }
+    return quads;
+}
+
+// Maps 16 characters to sextets; invalid lanes are left as 0xFF so the caller can reduce them.
+inline uint8x16_t base64SextetsNeon(uint8x16_t v, bool urlSafe) {
+    const uint8_t char62 = urlSafe ? '-' : '+';
+    const uint8_t char63 = urlSafe ? '_' : '/';
+    const uint8x16_t upper = inRangeNeon(v, 'A', 'Z');
+    const uint8x16_t lower = inRangeNeon(v, 'a', 'z');
+    const uint8x16_t digit = inRangeNeon(v, '0', '9');
+    const uint8x16_t is62 = vceqq_u8(v, vdupq_n_u8(char62));
+    const uint8x16_t is63 = vceqq_u8(v, vdupq_n_u8(char63));
+
+    uint8x16_t result = vdupq_n_u8(0xFF);
+    result = vbslq_u8(upper, vsubq_u8(v, vdupq_n_u8('A')), result);
+    result = vbslq_u8(lower, vsubq_u8(v, vdupq_n_u8('a' - 26)), result);
+    result = vbslq_u8(digit, vaddq_u8(v, vdupq_n_u8(52 - '0')), result);
+    result = vbslq_u8(is62, vdupq_n_u8(62), result);
+    result = vbslq_u8(is63, vdupq_n_u8(63), result);
+    return result;
+}
+
+template <typename CharT>
+qsizetype base64KernelNeon(const CharT *in, qsizetype length, char *out, bool urlSafe) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 64) {
+        const uint8x16x4_t quads = loadQuads64(in + consumed);
+        const uint8x16_t a = base64SextetsNeon(quads.val[0], urlSafe);
+        const uint8x16_t b = base64SextetsNeon(quads.val[1], urlSafe);
+        const uint8x16_t c = base64SextetsNeon(quads.val[2], urlSafe);
+        const uint8x16_t d = base64SextetsNeon(quads.val[3], urlSafe);
+        if (vmaxvq_u8(vorrq_u8(vorrq_u8(a, b), vorrq_u8(c, d))) > 63) {
+            break;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(a, 2), vshrq_n_u8(b, 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(b, 4), vshrq_n_u8(c, 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(c, 6), d);
+        vst3q_u8(reinterpret_cast<uint8_t *>(out), bytes);
+        out += 48;
+        consumed += 64;
+    }
+    return consumed;
+}
+
+#endif
+
+template <typename CharT>
+Base64Kernel<CharT> selectBase64Kernel() {
+#if defined(DAVE_SIMD_X86)
+    const simd::CpuFeatures &cpu = simd::cpuFeatures();
+    if (cpu.avx2) {
+        return &base64KernelAvx2<CharT>;
+    }
+    if (cpu.sse41) {
+        return &base64KernelSse41<CharT>;
+    }
+#elif defined(DAVE_SIMD_NEON)
+    return &base64KernelNeon<CharT>;
+#endif
+    return &base64KernelScalar<CharT>;
+}
+
+// Decodes one chunk of standard, URL-safe or MIME-wrapped base64 into `out`, which must have
+// room for (length / 4) * 3 + 3 bytes. An unfinished quad is carried in `state` for the next
+// chunk; finishBase64() flushes it. Whitespace is skipped anywhere and padding is optional but
+// may only appear at the end. Error positions are absolute (state.position based).
+template <typename CharT, typename State>
+DecodeResult decodeBase64Chars(const CharT *in, qsizetype length, char *out, State &state) {
+    static const Base64Kernel<CharT> kernel = selectBase64Kernel<CharT>();
+    // After the kernel bails out on a block (typically a line break), stay on the scalar path
+    // for a block's worth of input rather than retrying after every quad.
+    constexpr qsizetype kScalarRun = 64;
+
+    DecodeResult result;
+    char *const outStart = out;
+    qsizetype scalarUntil = 0;
+    qsizetype i = 0;
+
+    while (i < length) {
+        if (state.padding > 0) {
+            // "xx==" or "xxx=" only; after that nothing but more padding or whitespace
+            const unsigned char tail = base64Value(in[i]);
+            if (tail == kB64Pad && state.count + state.padding < 4) {
+                state.padding++;
+            } else if (tail != kB64Skip) {
+                result.errorPosition = state.position + i;
+                return result;
+            }
+            i++;
+            continue;
+        }
+
+        if (state.count == 0 && i >= scalarUntil) {
+            const qsizetype consumed = kernel(in + i, length - i, out, state.urlSafe);
+            i += consumed;
+            out += consumed / 4 * 3;
+            scalarUntil = i + kScalarRun;
+            if (i >= length) {
+                break;
+            }
+        }
+
+        const CharT ch = in[i];
+        const unsigned char value = base64Value(ch);
+        if (value < 64) {
+            if (state.count == 0) {
+                state.unitStart = state.position + i;
+            }
+            if (ch == '-' || ch == '_') {
+                state.urlSafe = true;
+            } else if (ch == '+' || ch == '/') {
+                state.urlSafe = false;
+            }
+            state.bits = (state.bits << 6) | value;
+            if (++state.count == 4) {
+                *out++ = static_cast<char>(state.bits >> 16);
+                *out++ = static_cast<char>(state.bits >> 8);
+                *out++ = static_cast<char>(state.bits);
+                state.bits = 0;
+                state.count = 0;
+            }
+        } else if (value == kB64Pad && state.count >= 2) {
+            state.padding = 1;
+        } else if (value != kB64Skip) {
+            result.errorPosition = state.position + i;
+            return result;
+        }
+        i++;
+    }
+
+    state.position += length;
+    result.size = out - outStart;
+    return result;
+}
+
+// Flushes the quad left over after the last chunk. Unpadded tails are accepted; a lone
+// trailing sextet cannot encode a whole byte.
+template <typename State>
+DecodeResult finishBase64(char *out, State &state) {
+    DecodeResult result;
+    if (state.count == 1) {
+        result.errorPosition = state.unitStart;
+        result.truncated = true;
+        return result;
+    }
+    if (state.count == 2) {
+        out[0] = static_cast<char>(state.bits >> 4);
+        result.size = 1;
+    } else if (state.count == 3) {
+        out[0] = static_cast<char>(state.bits >> 10);
+        out[1] = static_cast<char>(state.bits >> 2);
+        result.size = 2;
+    }
+    state = State();
+    return result;
+}
+
+// ============================================================================
+// Hex
+// ============================================================================
+
+constexpr unsigned char kHexInvalid = 0xFF;
+constexpr unsigned char kHexSeparator = 0xFE;  // whitespace and common dump punctuation
+constexpr unsigned char kHexEscape = 0xFD;     // '\' of a "\x" escape
+
+constexpr std::array<unsigned char, 256> makeHexTable() {
+    std::array<unsigned char, 256> table{};
+    for (auto &entry : table) {
+        entry = kHexInvalid;
+    }
+    for (int i = 0; i < 10; i++) {
+        table['0' + i] = static_cast<unsigned char>(i);
+    }
+    for (int i = 0; i < 6; i++) {
+        table['A' + i] = static_cast<unsigned char>(10 + i);
+        table['a' + i] = static_cast<unsigned char>(10 + i);
+    }
+    for (char separator : {' ', '\t', '\n', '\r', '\f', '\v', ':', '-', ',', ';', '|'}) {
+        table[static_cast<unsigned char>(separator)] = kHexSeparator;
+    }
+    table['\\'] = kHexEscape;
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> kHexTable = makeHexTable();
+
+template <typename CharT>
+inline unsigned char hexValue(CharT ch) {
+    const auto code = static_cast<std::make_unsigned_t<CharT>>(ch);
+    return code < 256 ? kHexTable[code] : kHexInvalid;
+}
+
+template <typename CharT>
+inline bool isHexX(CharT ch) {
+    return ch == 'x' || ch == 'X';
+}
+
+// Same contract as the base64 kernels: whole blocks of hex digits only, two digits per byte.
+template <typename CharT>
+using HexKernel = qsizetype (*)(const CharT *in, qsizetype length, char *out);
+
+template <typename CharT>
+qsizetype hexKernelScalar(const CharT *in, qsizetype length, char *out) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 2) {
+        const unsigned char hi = hexValue(in[consumed]);
+        const unsigned char lo = hexValue(in[consumed + 1]);
+        if ((hi | lo) & 0xF0) {
+            break;
+        }
+        *out++ = static_cast<char>((hi << 4) | lo);
+        consumed += 2;
+    }
+    return consumed;
+}
+
+#if defined(DAVE_SIMD_X86)
+
+// Converts 16 hex digits to nibbles in place; returns false if any byte is not a hex digit.
+DAVE_TARGET_SSE41 inline bool hexNibbles16(__m128i &v) {
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    const __m128i digit = inRange16(v, '0', '9');
+    const __m128i alpha = inRange16(lower, 'a', 'f');
+    if (_mm_movemask_epi8(_mm_or_si128(digit, alpha)) != 0xFFFF) {
+        return false;
+    }
+    v = _mm_blendv_epi8(_mm_sub_epi8(lower, _mm_set1_epi8('a' - 10)),
+                        _mm_sub_epi8(v, _mm_set1_epi8('0')), digit);
+    return true;
+}
+
+template <typename CharT>
+DAVE_TARGET_SSE41 qsizetype hexKernelSse41(const CharT *in, qsizetype length, char *out) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 16) {
+        __m128i v = loadBytes16(in + consumed);
+        if (!hexNibbles16(v)) {
+            break;
+        }
+        // (hi * 16 + lo) per 16-bit lane, then narrow to bytes
+        const __m128i pairs = _mm_maddubs_epi16(v, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out), _mm_packus_epi16(pairs, pairs));
+        out += 8;
+        consumed += 16;
+    }
+    return consumed;
+}
+
+DAVE_TARGET_AVX2 inline bool hexNibbles32(__m256i &v) {
+    const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    const __m256i digit = inRange32(v, '0', '9');
+    const __m256i alpha = inRange32(lower, 'a', 'f');
+    if (_mm256_movemask_epi8(_mm256_or_si256(digit, alpha)) != -1) {
+        return false;
+    }
+    v = _mm256_blendv_epi8(_mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10)),
+                           _mm256_sub_epi8(v, _mm256_set1_epi8('0')), digit);
+    return true;
+}
+
+template <typename CharT>
+DAVE_TARGET_AVX2 qsizetype hexKernelAvx2(const CharT *in, qsizetype length, char *out) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 32) {
+        __m256i v = loadBytes32(in + consumed);
+        if (!hexNibbles32(v)) {
+            break;
+        }
+        const __m256i pairs = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(pairs, pairs),
+                                                        _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm256_castsi256_si128(packed));
+        out += 16;
+        consumed += 32;
+    }
+    return consumed;
+}
+
+#elif defined(DAVE_SIMD_NEON)
+
+inline uint8x16x2_t loadPairs32(const char *in) {
+    return vld2q_u8(reinterpret_cast<const uint8_t *>(in));
+}
+
+inline uint8x16x2_t loadPairs32(const char16_t *in) {
+    const uint16x8x2_t lo = vld2q_u16(reinterpret_cast<const uint16_t *>(in));
+    const uint16x8x2_t hi = vld2q_u16(reinterpret_cast<const uint16_t *>(in + 16));
+    uint8x16x2_t pairs;
+    for (int i = 0; i < 2; i++) {
+        pairs.val[i] = vcombine_u8(vqmovn_u16(lo.val[i]), vqmovn_u16(hi.val[i]));
+    }
+    return pairs;
+}
+
+// Invalid lanes come out as 0xFF so the caller can reduce them with a max.
+inline uint8x16_t hexNibblesNeon(uint8x16_t v) {
+    const uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+    uint8x16_t result = vdupq_n_u8(0xFF);
+    result = vbslq_u8(inRangeNeon(lower, 'a', 'f'), vsubq_u8(lower, vdupq_n_u8('a' - 10)), result);
+    result = vbslq_u8(inRangeNeon(v, '0', '9'), vsubq_u8(v, vdupq_n_u8('0')), result);
+    return result;
+}
+
+template <typename CharT>
+qsizetype hexKernelNeon(const CharT *in, qsizetype length, char *out) {
+    qsizetype consumed = 0;
+    while (length - consumed >= 32) {
+        const uint8x16x2_t pairs = loadPairs32(in + consumed);
+        const uint8x16_t hi = hexNibblesNeon(pairs.val[0]);
+        const uint8x16_t lo = hexNibblesNeon(pairs.val[1]);
+        if (vmaxvq_u8(vorrq_u8(hi, lo)) > 15) {
+            break;
+        }
+        vst1q_u8(reinterpret_cast<uint8_t *>(out), vorrq_u8(vshlq_n_u8(hi, 4), lo));
+        out += 16;
+        consumed += 32;
+    }
+    return consumed;
+}
+
+#endif
+
+template <typename CharT>
+HexKernel<CharT> selectHexKernel() {
+#if defined(DAVE_SIMD_X86)
+    const simd::CpuFeatures &cpu = simd::cpuFeatures();
+    if (cpu.avx2) {
+        return &hexKernelAvx2<CharT>;
+    }
+    if (cpu.sse41) {
+        return &hexKernelSse41<CharT>;
+    }
+#elif defined(DAVE_SIMD_NEON)
+    return &hexKernelNeon<CharT>;
+#endif
+    return &hexKernelScalar<CharT>;
+}
+
+// Decodes one chunk of hex digits into `out`, which must have room for length / 2 + 1 bytes,
+// in a single pass. Separators, "0x" prefixes and "\x" escapes between bytes are skipped; any
+// other character is an error at its absolute index. A dangling nibble is carried in `state`.
+template <typename CharT, typename State>
+DecodeResult decodeHexChars(const CharT *in, qsizetype length, char *out, State &state) {
+    static const HexKernel<CharT> kernel = selectHexKernel<CharT>();
+    constexpr qsizetype kScalarRun = 64;
+
+    DecodeResult result;
+    char *const outStart = out;
+    qsizetype scalarUntil = 0;
+    qsizetype i = 0;
+
+    // A "0x" or "\x" split across chunks leaves its 'x' at the start of this one
+    if (state.prefix != 0 && length > 0) {
+        const char prefix = state.prefix;
+        state.prefix = 0;
+        if (isHexX(in[0])) {
+            i = 1;
+        } else if (prefix == '0') {
+            state.bits = 0;
+            state.count = 1;
+            state.unitStart = state.position - 1;
+        } else {
+            result.errorPosition = state.position - 1;
+            return result;
+        }
+    }
+
+    while (i < length) {
+        if (state.count == 0 && i >= scalarUntil) {
+            const qsizetype consumed = kernel(in + i, length - i, out);
+            i += consumed;
+            out += consumed / 2;
+            scalarUntil = i + kScalarRun;
+            if (i >= length) {
+                break;
+            }
+        }
+
+        const CharT ch = in[i];
+        const unsigned char value = hexValue(ch);
+        const bool lastInChunk = i + 1 == length;
+        if (value < 16) {
+            // A "0x" prefix can only start on a byte boundary
+            if (state.count == 0 && ch == '0' && (lastInChunk || isHexX(in[i + 1]))) {
+                if (lastInChunk) {
+                    state.prefix = '0';  // decided by the first character of the next chunk
+                }
+                i += lastInChunk ? 1 : 2;
+                continue;
+            }
+            if (state.count == 1) {
+                *out++ = static_cast<char>((state.bits << 4) | value);
+                state.count = 0;
+            } else {
+                state.bits = value;
+                state.unitStart = state.position + i;
+                state.count = 1;
+            }
+            i++;
+        } else if (value == kHexSeparator && state.count == 0) {
+            i++;
+        } else if (value == kHexEscape && state.count == 0 && lastInChunk) {
+            state.prefix = '\\';
+            i++;
+        } else if (value == kHexEscape && state.count == 0 && isHexX(in[i + 1])) {
+            i += 2;
+        } else {
+            result.errorPosition = state.position + i;
+            return result;
+        }
+    }
+
+    state.position += length;
+    result.size = out - outStart;
+    return result;
+}
+
+template <typename State>
+DecodeResult finishHex(State &state) {
+    DecodeResult result;
+    if (state.prefix == '\\') {
+        result.errorPosition = state.position - 1;
+    }
+    result.truncated = state.count != 0 || state.prefix == '0';
+    state = State();
+    return result;
+}
+
+// ============================================================================
+// ROT
+// ============================================================================
+
+// Every rotation is "subtract `shift` within [lo, hi], wrapping by `span`", compared after OR-ing
+// `fold` into the character. Folding 0x20 maps both letter cases onto 'a'..'z' so ROTn needs a
+// single range; ROT47 rotates all of printable ASCII without folding. Anything outside the range
+// is left untouched, so UTF-8 and UTF-16 text rotate identically.
+struct Rotation {
+    int fold;
+    int lo;
+    int hi;
+    int shift;
+    int span;
+};
+
+inline Rotation rotationFor(Decoder::Algorithm algorithm, int shift) {
+    if (algorithm == Decoder::ROT47) {
+        return {0, '!', '~', 47, 94};
+    }
+    return {0x20, 'a', 'z', ((shift % 26) + 26) % 26, 26};
+}
+
+// Kernels rotate whole blocks in place and return how many characters they handled.
+template <typename CharT>
+using RotateKernel = qsizetype (*)(CharT *data, qsizetype length, const Rotation &rot);
+
+template <typename CharT>
+qsizetype rotateKernelScalar(CharT *data, qsizetype length, const Rotation &rot) {
+    for (qsizetype i = 0; i < length; i++) {
+        const int folded = data[i] | rot.fold;
+        if (folded >= rot.lo && folded <= rot.hi) {
+            const int wrap = folded - rot.lo < rot.shift ? rot.span : 0;
+            data[i] = static_cast<CharT>(data[i] + wrap - rot.shift);
+        }
+    }
+    return length;
+}
+
+#if defined(DAVE_SIMD_X86)
+
+// Lanes >= 0x80 (bytes) or >= 0x8000 (UTF-16) compare as negative and are never rotated.
+DAVE_TARGET_SSE41 inline __m128i rotateLanes(__m128i v, const Rotation &rot, char) {
+    const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(static_cast<char>(rot.fold)));
+    const __m128i inside = inRange16(folded, static_cast<char>(rot.lo), static_cast<char>(rot.hi));
+    const __m128i offset = _mm_sub_epi8(folded, _mm_set1_epi8(static_cast<char>(rot.lo)));
+    const __m128i wrap = _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(rot.shift)), offset);
+    const __m128i delta =
+        _mm_sub_epi8(_mm_and_si128(wrap, _mm_set1_epi8(static_cast<char>(rot.span))),
+                     _mm_set1_epi8(static_cast<char>(rot.shift)));
+    return _mm_add_epi8(v, _mm_and_si128(inside, delta));
+}
+
+DAVE_TARGET_SSE41 inline __m128i rotateLanes(__m128i v, const Rotation &rot, char16_t) {
+    const __m128i folded = _mm_or_si128(v, _mm_set1_epi16(static_cast<short>(rot.fold)));
+    const __m128i inside =
+        _mm_and_si128(_mm_cmpgt_epi16(folded, _mm_set1_epi16(static_cast<short>(rot.lo - 1))),
+                      _mm_cmplt_epi16(folded, _mm_set1_epi16(static_cast<short>(rot.hi + 1))));
+    const __m128i offset = _mm_sub_epi16(folded, _mm_set1_epi16(static_cast<short>(rot.lo)));
+    const __m128i wrap = _mm_cmpgt_epi16(_mm_set1_epi16(static_cast<short>(rot.shift)), offset);
+    const __m128i delta =
+        _mm_sub_epi16(_mm_and_si128(wrap, _mm_set1_epi16(static_cast<short>(rot.span))),
+                      _mm_set1_epi16(static_cast<short>(rot.shift)));
+    return _mm_add_epi16(v, _mm_and_si128(inside, delta));
+}
+
+template <typename CharT>
+DAVE_TARGET_SSE41 qsizetype rotateKernelSse41(CharT *data, qsizetype length, const Rotation &rot) {
+    constexpr qsizetype kStep = 16 / sizeof(CharT);
+    qsizetype done = 0;
+    for (; length - done >= kStep; done += kStep) {
+        auto *block = reinterpret_cast<__m128i *>(data + done);
+        _mm_storeu_si128(block, rotateLanes(_mm_loadu_si128(block), rot, CharT()));
+    }
+    return done;
+}
+
+DAVE_TARGET_AVX2 inline __m256i rotateLanes(__m256i v, const Rotation &rot, char) {
+    const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(static_cast<char>(rot.fold)));
+    const __m256i inside = inRange32(folded, static_cast<char>(rot.lo), static_cast<char>(rot.hi));
+    const __m256i offset = _mm256_sub_epi8(folded, _mm256_set1_epi8(static_cast<char>(rot.lo)));
+    const __m256i wrap = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(rot.shift)), offset);
+    const __m256i delta =
+        _mm256_sub_epi8(_mm256_and_si256(wrap, _mm256_set1_epi8(static_cast<char>(rot.span))),
+                        _mm256_set1_epi8(static_cast<char>(rot.shift)));
+    return _mm256_add_epi8(v, _mm256_and_si256(inside, delta));
+}
+
+DAVE_TARGET_AVX2 inline __m256i rotateLanes(__m256i v, const Rotation &rot, char16_t) {
+    const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi16(static_cast<short>(rot.fold)));
+    const __m256i inside = _mm256_and_si256(
+        _mm256_cmpgt_epi16(folded, _mm256_set1_epi16(static_cast<short>(rot.lo - 1))),
+        _mm256_cmpgt_epi16(_mm256_set1_epi16(static_cast<short>(rot.hi + 1)), folded));
+    const __m256i offset = _mm256_sub_epi16(folded, _mm256_set1_epi16(static_cast<short>(rot.lo)));
+    const __m256i wrap =
+        _mm256_cmpgt_epi16(_mm256_set1_epi16(static_cast<short>(rot.shift)), offset);
+    const __m256i delta =
+        _mm256_sub_epi16(_mm256_and_si256(wrap, _mm256_set1_epi16(static_cast<short>(rot.span))),
+                         _mm256_set1_epi16(static_cast<short>(rot.shift)));
+    return _mm256_add_epi16(v, _mm256_and_si256(inside, delta));
+}
+
+template <typename CharT>
+DAVE_TARGET_AVX2 qsizetype rotateKernelAvx2(CharT *data, qsizetype length, const Rotation &rot) {
+    constexpr qsizetype kStep = 32 / sizeof(CharT);
+    qsizetype done = 0;
+    for (; length - done >= kStep; done += kStep) {
+        auto *block = reinterpret_cast<__m256i *>(data + done);
+        _mm256_storeu_si256(block, rotateLanes(_mm256_loadu_si256(block), rot, CharT()));
+    }
+    return done;
+}
+
+#elif defined(DAVE_SIMD_NEON)
+
+inline void rotateBlockNeon(char *data, const Rotation &rot) {
+    auto *bytes = reinterpret_cast<uint8_t *>(data);
+    const uint8x16_t v = vld1q_u8(bytes);
+    const uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(static_cast<uint8_t>(rot.fold)));
+    const uint8x16_t inside = inRangeNeon(folded, rot.lo, rot.hi);
+    const uint8x16_t offset = vsubq_u8(folded, vdupq_n_u8(static_cast<uint8_t>(rot.lo)));
+    const uint8x16_t wrap = vcltq_u8(offset, vdupq_n_u8(static_cast<uint8_t>(rot.shift)));
+    const uint8x16_t delta = vsubq_u8(vandq_u8(wrap, vdupq_n_u8(static_cast<uint8_t>(rot.span))),
+                                      vdupq_n_u8(static_cast<uint8_t>(rot.shift)));
+    vst1q_u8(bytes, vaddq_u8(v, vandq_u8(inside, delta)));
+}
+
+inline void rotateBlockNeon(char16_t *data, const Rotation &rot) {
+    auto *units = reinterpret_cast<uint16_t *>(data);
+    const uint16x8_t v = vld1q_u16(units);
+    const uint16x8_t folded = vorrq_u16(v, vdupq_n_u16(static_cast<uint16_t>(rot.fold)));
+    const uint16x8_t offset = vsubq_u16(folded, vdupq_n_u16(static_cast<uint16_t>(rot.lo)));
+    const uint16x8_t inside =
+        vcleq_u16(offset, vdupq_n_u16(static_cast<uint16_t>(rot.hi - rot.lo)));
+    const uint16x8_t wrap = vcltq_u16(offset, vdupq_n_u16(static_cast<uint16_t>(rot.shift)));
+    const uint16x8_t delta =
+        vsubq_u16(vandq_u16(wrap, vdupq_n_u16(static_cast<uint16_t>(rot.span))),
+                  vdupq_n_u16(static_cast<uint16_t>(rot.shift)));
+    vst1q_u16(units, vaddq_u16(v, vandq_u16(inside, delta)));
+}
+
+template <typename CharT>
+qsizetype rotateKernelNeon(CharT *data, qsizetype length, const Rotation &rot) {
+    constexpr qsizetype kStep = 16 / sizeof(CharT);
+    qsizetype done = 0;
+    for (; length - done >= kStep; done += kStep) {
+        rotateBlockNeon(data + done, rot);
+    }
+    return done;
+}
+
+#endif
+
+template <typename CharT>
+RotateKernel<CharT> selectRotateKernel() {
+#if defined(DAVE_SIMD_X86)
+    const simd::CpuFeatures &cpu = simd::cpuFeatures();
+    if (cpu.avx2) {
+        return &rotateKernelAvx2<CharT>;
+    }
+    if (cpu.sse41) {
+        return &rotateKernelSse41<CharT>;
+    }
+#elif defined(DAVE_SIMD_NEON)
+    return &rotateKernelNeon<CharT>;
+#endif
+    return &rotateKernelScalar<CharT>;
+}
+
+// Applies `rot` to a presized buffer in place.
+template <typename CharT>
+void rotateChars(CharT *data, qsizetype length, const Rotation &rot) {
+    static const RotateKernel<CharT> kernel = selectRotateKernel<CharT>();
+    const qsizetype done = kernel(data, length, rot);
+    rotateKernelScalar(data + done, length - done, rot);
+}
+
+// Relative frequencies of 'a'..'z' in English text.
+constexpr std::array<double, 26> kEnglishLetterFrequency = {
+    0.08167, 0.01492, 0.02782, 0.04253, 0.12702, 0.02228, 0.02015, 0.06094, 0.06966,
+    0.00153, 0.00772, 0.04025, 0.02406, 0.06749, 0.07507, 0.01929, 0.00095, 0.05987,
+    0.06327, 0.09056, 0.02758, 0.00978, 0.02360, 0.00150, 0.01974, 0.00074};
+
+using LetterCounts = std::array<qsizetype, 26>;
+
+// Mean log10 English frequency of the letters counted in `counts` once rotated back by `shift`.
+inline double englishScore(const LetterCounts &counts, qsizetype letters, int shift) {
+    static const std::array<double, 26> logFrequency = [] {
+        std::array<double, 26> table{};
+        for (int i = 0; i < 26; i++) {
+            table[i] = std::log10(kEnglishLetterFrequency[i]);
+        }
+        return table;
+    }();
+
+    if (letters == 0) {
+        return 0;
+    }
+    double logLikelihood = 0;
+    for (int letter = 0; letter < 26; letter++) {
+        logLikelihood += counts[letter] * logFrequency[(letter + 26 - shift) % 26];
+    }
+    return logLikelihood / letters;
+}
+
+// Scores every ROT shift from one pass over the input. Rotating only relabels letters, so the
+// letter histogram of the input is enough to score each candidate without producing its text.
+template <typename CharT>
+QList<Decoder::RotCandidate> rankShifts(const CharT *in, qsizetype length) {
+    LetterCounts counts{};
+    qsizetype letters = 0;
+    for (qsizetype i = 0; i < length; i++) {
+        const int folded = in[i] | 0x20;
+        if (folded >= 'a' && folded <= 'z') {
+            counts[folded - 'a']++;
+            letters++;
+        }
+    }
+
+    QList<Decoder::RotCandidate> candidates;
+    candidates.reserve(25);
+    for (int shift = 1; shift < 26; shift++) {
+        candidates.append({shift, englishScore(counts, letters, shift)});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Decoder::RotCandidate &a, const Decoder::RotCandidate &b) {
+                         return a.score > b.score;
+                     });
+    return candidates;
+}
+
+// ============================================================================
+// Parallel segmentation
+// ============================================================================
+
+// Keep segments large enough that scheduling stays negligible next to the decoding
+constexpr qsizetype kMinSegment = 256 * 1024;
+
+// Symbols are the characters that carry data: sextets for base64, digits for hex. Whitespace,
+// separators, padding and the '0' of a "0x" prefix are not symbols.
+template <typename CharT>
+inline bool isSymbol(const CharT *in, qsizetype i, qsizetype length, bool hex) {
+    if (!hex) {
+        return base64Value(in[i]) < 64;
+    }
+    return hexValue(in[i]) < 16 && !(in[i] == '0' && i + 1 < length && isHexX(in[i + 1]));
+}
+
+template <typename CharT>
+qsizetype countSymbols(const CharT *in, qsizetype begin, qsizetype end, qsizetype length,
+                       bool hex) {
+    qsizetype symbols = 0;
+    for (qsizetype i = begin; i < end; i++) {
+        symbols += isSymbol(in, i, length, hex);
+    }
+    return symbols;
+}
+
+// Decodes base64 or hex on the thread pool. Symbols are counted per segment first; each cut is
+// then moved forward to the first symbol that starts a whole unit (quad or byte), which gives
+// every segment a fresh decoder state and a disjoint slice of one preallocated output buffer,
+// without first copying the input into a whitespace-free form. Returns false if any segment
+// fails, in which case the caller re-runs the sequential decoder for the exact error. Segments
+// not yet started when `control` is cancelled are skipped, which also returns false.
+template <typename State, typename CharT>
+bool decodeSegmented(const CharT *in, qsizetype length, bool hex, int segments, QByteArray &out,
+                     TaskControl *control) {
+    const qsizetype unitSymbols = hex ? 2 : 4;
+    const qsizetype unitBytes = hex ? 1 : 3;
+    const qsizetype step = length / segments;
+
+    // Counting and decoding each read every segment once; both count towards progress
+    std::atomic<int> done{0};
+    const int passes = 2 * segments;
+    auto finishedSegment = [&] {
+        if (control) {
+            control->report(++done, passes);
+        }
+    };
+
+    QVector<qsizetype> counts(segments);
+    parallel::forEach(segments, [&](int k) {
+        const qsizetype begin = k * step;
+        const qsizetype end = k + 1 == segments ? length : begin + step;
+        counts[k] = countSymbols(in, begin, end, length, hex);
+        finishedSegment();
+    });
+    if (control && control->cancelled()) {
+        return false;
+    }
+
+    // starts[k] is where segment k begins in the input, units[k] how many whole units precede it
+    QVector<qsizetype> starts(segments + 1);
+    QVector<qsizetype> units(segments + 1);
+    qsizetype symbols = 0;
+    for (int k = 1; k < segments; k++) {
+        symbols += counts[k - 1];
+        if (starts[k - 1] > k * step) {
+            // The previous cut moved past this one's place, so segment k - 1 stays empty
+            starts[k] = starts[k - 1];
+            units[k] = units[k - 1];
+            continue;
+        }
+        qsizetype skip = (unitSymbols - symbols % unitSymbols) % unitSymbols;
+        units[k] = (symbols + skip) / unitSymbols;
+        qsizetype pos = k * step;
+        for (; pos < length; pos++) {
+            if (isSymbol(in, pos, length, hex)) {
+                if (skip == 0) {
+                    break;
+                }
+                skip--;
+            }
+        }
+        starts[k] = pos;
+    }
+    symbols += counts[segments - 1];
+
+    // Cuts past the last symbol leave empty segments; the final unit (and any padding) then
+    // belongs to the last segment that has input
+    while (segments > 1 && starts[segments - 1] >= length) {
+        segments--;
+    }
+    starts[segments] = length;
+
+    out.resize(hex ? symbols / 2 + 1 : symbols / 4 * 3 + 3);
+    QVector<qsizetype> sizes(segments);
+    QVector<char> ok(segments, 0);
+    parallel::forEach(segments, [&](int k) {
+        if (control && control->cancelled()) {
+            return;
+        }
+        State state;
+        state.position = starts[k];
+        char *slice = out.data() + units[k] * unitBytes;
+        const qsizetype sliceLength = starts[k + 1] - starts[k];
+        DecodeResult result = hex ? decodeHexChars(in + starts[k], sliceLength, slice, state)
+                                  : decodeBase64Chars(in + starts[k], sliceLength, slice, state);
+        finishedSegment();
+        if (result.errorPosition >= 0) {
+            return;
+        }
+        if (k + 1 < segments) {
+            // Interior segments must end on a unit boundary and fill their slice exactly
+            ok[k] = state.count == 0 && state.padding == 0 && state.prefix == 0 &&
+                    result.size == (units[k + 1] - units[k]) * unitBytes;
+            sizes[k] = result.size;
+            return;
+        }
+        const qsizetype size = result.size;
+        result = hex ? finishHex(state) : finishBase64(slice + size, state);
+        ok[k] = result.errorPosition < 0 && !result.truncated;
+        sizes[k] = size + result.size;
+    });
+
+    if (ok.contains(0)) {
+        return false;
+    }
+    out.truncate(units[segments - 1] * unitBytes + sizes[segments - 1]);
+    return true;
+}
+
+// Rotates in place on the thread pool, in equal segments since every character maps to one.
+// Returns false if `control` was cancelled before every segment had run.
+template <typename CharT>
+bool rotateParallel(CharT *data, qsizetype length, const Rotation &rot, TaskControl *control) {
+    if (length < Decoder::ParallelThreshold) {
+        rotateChars(data, length, rot);
+        return true;
+    }
+    const int segments = parallel::workerCount(length, kMinSegment);
+    const qsizetype step = length / segments;
+    std::atomic<int> done{0};
+    parallel::forEach(segments, [&](int k) {
+        if (control && control->cancelled()) {
+            return;
+        }
+        const qsizetype begin = k * step;
+        const qsizetype end = k + 1 == segments ? length : begin + step;
+        rotateChars(data + begin, end - begin, rot);
+        if (control) {
+            control->report(++done, segments);
+        }
+    });
+    return !(control && control->cancelled());
+}
+
+// ============================================================================
+// Whole-buffer decoding
+// ============================================================================
+
+// Upper bound on the decoded size of `length` input bytes.
+inline qsizetype maxDecodedSize(Decoder::Algorithm algorithm, qsizetype length) {
+    switch (algorithm) {
+        case Decoder::Base64:
+            return length / 4 * 3 + 3;
+        case Decoder::Hex:
+            return length / 2 + 1;
+        default:
+            return length;
+    }
+}
+
+// Decodes a complete base64 or hex buffer into `out` (maxDecodedSize() bytes).
+template <typename State, typename CharT>
+DecodeResult decodeUnits(const CharT *in, qsizetype length, bool hex, char *out) {
+    State state;
+    DecodeResult result =
+        hex ? decodeHexChars(in, length, out, state) : decodeBase64Chars(in, length, out, state);
+    if (result.errorPosition < 0) {
+        const qsizetype size = result.size;
+        result = hex ? finishHex(state) : finishBase64(out + size, state);
+        result.size = hex ? size : size + result.size;
+    }
+    return result;
+}
+
+// Decodes a complete byte buffer into `out` (maxDecodedSize() bytes) on the calling thread.
+template <typename State>
+DecodeResult decodeWhole(const char *in, qsizetype length, Decoder::Algorithm algorithm,
+                         int rotShift, char *out) {
+    if (algorithm == Decoder::Base64 || algorithm == Decoder::Hex) {
+        return decodeUnits<State>(in, length, algorithm == Decoder::Hex, out);
+    }
+    std::memcpy(out, in, length);
+    rotateChars(out, length, rotationFor(algorithm, rotShift));
+    DecodeResult result;
+    result.size = length;
+    return result;
+}
+
+inline Decoder::Status statusOf(const DecodeResult &result) {
+    if (result.truncated) {
+        return Decoder::IncompleteInput;
+    }
+    return result.errorPosition >= 0 ? Decoder::InvalidInput : Decoder::Ok;
+}
+
+// ============================================================================
+// Encoding detection
+// ============================================================================
+
+// Everything the classifier looks at, derived from a single histogram of the sample.
+struct EncodingFeatures {
+    qsizetype length = 0;       // characters sampled
+    qsizetype symbols = 0;      // non-whitespace characters
+    qsizetype spaces = 0;       // ' ' and '\t'; MIME wrapping only ever adds line breaks
+    qsizetype upper = 0;
+    qsizetype lower = 0;
+    qsizetype digits = 0;
+    qsizetype hexLetters = 0;   // a-f and A-F, which tell hex apart from decimal numbers
+    qsizetype nonAscii = 0;
+    double entropy = 0;         // bits per non-whitespace character
+    LetterCounts letters{};     // case-folded letter histogram of the sample as is
+    LetterCounts rot47Letters{};  // ... and of its ROT47 rotation
+    qsizetype rot47LetterTotal = 0;
+};
+
+// Histogram bin 256 collects every UTF-16 unit above Latin-1.
+template <typename CharT>
+inline int histogramBin(CharT ch) {
+    const auto code = static_cast<std::make_unsigned_t<CharT>>(ch);
+    return code < 256 ? code : 256;
+}
+
+template <typename CharT>
+EncodingFeatures collectFeatures(const CharT *in, qsizetype length) {
+    // Four interleaved histograms keep runs of equal characters from serializing on one counter
+    std::array<std::array<qsizetype, 257>, 4> partial{};
+    qsizetype i = 0;
+    for (; i + 4 <= length; i += 4) {
+        partial[0][histogramBin(in[i])]++;
+        partial[1][histogramBin(in[i + 1])]++;
+        partial[2][histogramBin(in[i + 2])]++;
+        partial[3][histogramBin(in[i + 3])]++;
+    }
+    for (; i < length; i++) {
+        partial[0][histogramBin(in[i])]++;
+    }
+
+    std::array<qsizetype, 257> histogram{};
+    for (int bin = 0; bin < 257; bin++) {
+        histogram[bin] = partial[0][bin] + partial[1][bin] + partial[2][bin] + partial[3][bin];
+    }
+
+    EncodingFeatures features;
+    features.length = length;
+    features.nonAscii = histogram[256];
+    for (int bin = 0; bin < 256; bin++) {
+        const qsizetype count = histogram[bin];
+        if (count == 0) {
+            continue;
+        }
+        if (bin >= 0x80) {
+            features.nonAscii += count;
+        }
+        if (bin == ' ' || bin == '\t') {
+            features.spaces += count;
+        }
+        if (base64Value(char16_t(bin)) == kB64Skip) {
+            continue;
+        }
+        features.symbols += count;
+        const int folded = bin | 0x20;
+        if (folded >= 'a' && folded <= 'z') {
+            (bin & 0x20 ? features.lower : features.upper) += count;
+            features.letters[folded - 'a'] += count;
+            features.hexLetters += folded <= 'f' ? count : 0;
+        } else if (bin >= '0' && bin <= '9') {
+            features.digits += count;
+        }
+        if (bin >= '!' && bin <= '~') {
+            const int rotated = '!' + (bin - '!' + 47) % 94;
+            const int rotatedFolded = rotated | 0x20;
+            if (rotatedFolded >= 'a' && rotatedFolded <= 'z') {
+                features.rot47Letters[rotatedFolded - 'a'] += count;
+                features.rot47LetterTotal += count;
+            }
+        }
+    }
+    features.symbols += histogram[256];
+
+    for (int bin = 0; bin < 257; bin++) {
+        const qsizetype count = histogram[bin];
+        if (count > 0 && (bin == 256 || base64Value(char16_t(bin)) != kB64Skip)) {
+            const double p = double(count) / features.symbols;
+            features.entropy -= p * std::log2(p);
+        }
+    }
+    return features;
+}
+
+// Runs a decoder over the sample; `complete` also requires the input to end on a whole unit.
+// Returns the printable ratio of the output, or -1 if the sample does not decode.
+template <typename State, typename CharT>
+double trialDecode(const CharT *in, qsizetype length, bool hex, bool complete) {
+    QByteArray out(maxDecodedSize(hex ? Decoder::Hex : Decoder::Base64, length), Qt::Uninitialized);
+    State state;
+    DecodeResult result = hex ? decodeHexChars(in, length, out.data(), state)
+                              : decodeBase64Chars(in, length, out.data(), state);
+    if (result.errorPosition >= 0) {
+        return -1;
+    }
+    const qsizetype size = result.size;
+    if (complete) {
+        const DecodeResult tail = hex ? finishHex(state) : finishBase64(out.data() + size, state);
+        if (tail.errorPosition >= 0 || tail.truncated) {
+            return -1;
+        }
+    }
+    return Decoder::printableRatio(QByteArrayView(out.constData(), size));
+}
+
+// English letters average about -1.25 on englishScore(), uniformly random ones about -1.75.
+constexpr double kEnglishScoreFloor = -1.45;
+
+template <typename State, typename CharT>
+QList<Decoder::Detection> detectEncodings(const CharT *in, qsizetype length) {
+    QList<Decoder::Detection> detections;
+    const qsizetype sampled = qMin(length, Decoder::DetectSampleSize);
+    const bool complete = sampled == length;
+    const EncodingFeatures f = collectFeatures(in, sampled);
+    if (f.symbols < 4) {
+        return detections;
+    }
+    const double alnum = double(f.upper + f.lower + f.digits) / f.symbols;
+
+    // Hex: the narrowest alphabet, so it wins whenever it fits
+    const double hexText = trialDecode<State>(in, sampled, true, complete);
+    if (hexText >= 0) {
+        double confidence = 0.6;
+        confidence += f.hexLetters > 0 ? 0.2 : -0.2;  // only decimal digits may just be a number
+        confidence += hexText > 0.9 ? 0.15 : 0;
+        detections.append({Decoder::Hex, 0, confidence});
+    }
+
+    const double base64Text = f.spaces == 0 ? trialDecode<State>(in, sampled, false, complete) : -1;
+    if (base64Text >= 0) {
+        double confidence = 0.45;
+        confidence += f.upper > 0 && f.lower > 0 && f.digits > 0 ? 0.15 : 0;
+        confidence += f.entropy > 4.5 ? 0.15 : 0;
+        confidence += base64Text > 0.9 ? 0.2 : 0;
+        confidence -= hexText >= 0 ? 0.3 : 0;  // every hex string is also valid base64
+        confidence -= f.symbols < 8 ? 0.2 : 0;
+        detections.append({Decoder::Base64, 0, confidence});
+    }
+
+    // ROT: mostly letters whose best rotation reads far more like English than the text as is
+    const qsizetype letterTotal = f.upper + f.lower;
+    if (letterTotal >= 8 && double(letterTotal) / f.symbols > 0.6) {
+        const double identity = englishScore(f.letters, letterTotal, 0);
+        int bestShift = 0;
+        double best = identity;
+        for (int shift = 1; shift < 26; shift++) {
+            const double score = englishScore(f.letters, letterTotal, shift);
+            if (score > best) {
+                best = score;
+                bestShift = shift;
+            }
+        }
+        if (bestShift != 0 && best > kEnglishScoreFloor && best - identity > 0.1) {
+            detections.append({Decoder::ROT, bestShift, qMin(0.9, 0.3 + 2 * (best - identity))});
+        }
+    }
+
+    // ROT47 turns English letters into punctuation and digits, so compare against the sample's
+    // own letters rather than requiring it to look like text
+    if (f.nonAscii == 0 && f.rot47LetterTotal >= 8 &&
+        double(f.rot47LetterTotal) / f.symbols > 0.6 && alnum < 0.8) {
+        const double rotated = englishScore(f.rot47Letters, f.rot47LetterTotal, 0);
+        const double identity = letterTotal > 0 ? englishScore(f.letters, letterTotal, 0) : -3;
+        if (rotated > kEnglishScoreFloor && rotated > identity) {
+            detections.append({Decoder::ROT47, 0, qMin(0.9, 0.4 + (rotated - identity))});
+        }
+    }
+
+    for (Decoder::Detection &detection : detections) {
+        detection.confidence = qBound(0.0, detection.confidence, 1.0);
+    }
+    detections.erase(std::remove_if(detections.begin(), detections.end(),
+                                    [](const Decoder::Detection &detection) {
+                                        return detection.confidence <= 0;
+                                    }),
+                     detections.end());
+    std::stable_sort(detections.begin(), detections.end(),
+                     [](const Decoder::Detection &a, const Decoder::Detection &b) {
+                         return a.confidence > b.confidence;
+                     });
+    return detections;
+}
+
+// Shared by the QString and byte entry points: decodes into `output`, reusing its capacity, and
+// leaves it empty on failure.
+template <typename State, typename CharT>
+Decoder::Status decodeInto(const CharT *in, qsizetype length, Decoder::Algorithm algorithm,
+                           QByteArray &output, qsizetype *errorPosition) {
+    output.resize(maxDecodedSize(algorithm, length));
+    const DecodeResult result =
+        decodeUnits<State>(in, length, algorithm == Decoder::Hex, output.data());
+    const Decoder::Status status = statusOf(result);
+    output.truncate(status == Decoder::Ok ? result.size : 0);
+    if (errorPosition) {
+        *errorPosition = result.errorPosition;
+    }
+    return status;
+}
+
+inline const char16_t *utf16(const QString &input) {
+    return reinterpret_cast<const char16_t *>(input.constData());
+}
+
+QString rotateString(const QString &input, const Rotation &rot) {
+    QString result = input;
+    rotateChars(reinterpret_cast<char16_t *>(result.data()), result.size(), rot);
+    return result;
+}
+
+Decoder::Status rotateBytes(QByteArrayView input, const Rotation &rot, QByteArray &output) {
+    output.resize(input.size());
+    if (!input.isEmpty()) {
+        std::memcpy(output.data(), input.data(), input.size());
+        rotateChars(output.data(), output.size(), rot);
+    }
+    return Decoder::Ok;
+}
+
+// ============================================================================
+// Live decoding
+// ============================================================================
+
+// Live keeps a checkpoint about every this many characters of text it has measured, which
+// bounds the scan that turns an edit position into a symbol count.
+constexpr qsizetype kLiveCheckpointSpacing = 4096;
+
+// Length of in[i] in QString::toUtf8(): a surrogate pair counts on its high half, and an
+// unpaired surrogate becomes a single '?'.
+inline qsizetype utf8Length(const char16_t *in, qsizetype i, qsizetype length) {
+    const char16_t ch = in[i];
+    if (ch < 0x80) {
+        return 1;
+    }
+    if (ch < 0x800) {
+        return 2;
+    }
+    if (QChar::isHighSurrogate(ch)) {
+        return i + 1 < length && QChar::isLowSurrogate(in[i + 1]) ? 4 : 1;
+    }
+    if (QChar::isLowSurrogate(ch)) {
+        return i > 0 && QChar::isHighSurrogate(in[i - 1]) ? 0 : 1;
+    }
+    return 3;
+}
+
+}  // namespace
 
 QString Decoder::decode(const QString &input, Algorithm algorithm, int rotShift) {
     switch (algorithm) {
@@ -11,59 +1393,611 @@ QString Decoder::decode(const QString &input, Algorithm algorithm, int rotShift)
             return decodeHex(input);
         case ROT:
             return decodeROT(input, rotShift);
+        case ROT47:
+            return decodeROT47(input);
         default:
             return "Error: Unknown algorithm";
     }
 }
 
 QString Decoder::decodeBase64(const QString &input) {
-    QByteArray inputBytes = input.toUtf8();
-    QByteArray decoded = QByteArray::fromBase64(inputBytes);
-
-    if (decoded.isEmpty() && !input.isEmpty()) {
-        return "Error: Invalid base64 input";
+    // Decode straight from the UTF-16 buffer; there is no intermediate UTF-8 copy.
+    QByteArray decoded;
+    qsizetype position = -1;
+    const Status status =
+        decodeInto<UnitState>(utf16(input), input.size(), Base64, decoded, &position);
+    if (status != Ok) {
+        return errorMessage(Base64, status, position);
     }
-
     return QString::fromUtf8(decoded);
 }
 
 QString Decoder::decodeHex(const QString &input) {
-    QString cleanInput = input;
-    cleanInput.remove(QRegularExpression("[^0-9A-Fa-f]"));
+    QByteArray decoded;
+    qsizetype position = -1;
+    const Status status =
+        decodeInto<UnitState>(utf16(input), input.size(), Hex, decoded, &position);
+    if (status != Ok) {
+        return errorMessage(Hex, status, position);
+    }
+    return QString::fromUtf8(decoded);
+}
 
-    if (cleanInput.length() % 2 != 0) {
+QString Decoder::decodeROT(const QString &input, int shift) {
+    return rotateString(input, rotationFor(ROT, shift));
+}
+
+QString Decoder::decodeROT47(const QString &input) {
+    return rotateString(input, rotationFor(ROT47, 0));
+}
+
+QString Decoder::errorMessage(Algorithm algorithm, Status status, qsizetype position) {
+    if (algorithm == Hex && status == IncompleteInput) {
         return "Error: Invalid hex input (odd length)";
     }
+    return QString("Error: Invalid %1 input at position %2")
+        .arg(algorithm == Hex ? "hex" : "base64")
+        .arg(position);
+}
 
-    QByteArray decoded = QByteArray::fromHex(cleanInput.toUtf8());
-    return QString::fromUtf8(decoded);
+QList<Decoder::RotCandidate> Decoder::rankROTShifts(const QString &input) {
+    return rankShifts(utf16(input), input.size());
 }
 
-QString Decoder::decodeROT(const QString &input, int shift) {
-    QString result;
-    for (const QChar &ch : input) {
-        if (ch.isLetter()) {
-            QChar base = ch.isUpper() ? 'A' : 'a';
-            int shifted = (ch.toLatin1() - base.toLatin1() - shift + 26) % 26;
-            result += QChar(base.toLatin1() + shifted);
-        } else {
-            result += ch;
+QList<Decoder::RotCandidate> Decoder::rankROTShifts(QByteArrayView input) {
+    return rankShifts(input.data(), input.size());
+}
+
+QList<Decoder::Detection> Decoder::detectEncoding(const QString &input) {
+    return detectEncodings<UnitState>(utf16(input), input.size());
+}
+
+QList<Decoder::Detection> Decoder::detectEncoding(QByteArrayView input) {
+    return detectEncodings<UnitState>(input.data(), input.size());
+}
+
+double Decoder::printableRatio(QByteArrayView data) {
+    if (data.isEmpty()) {
+        return 0;
+    }
+
+    qsizetype printable = 0;
+    qsizetype i = 0;
+    while (i < data.size()) {
+        const auto byte = static_cast<unsigned char>(data[i]);
+        if (byte < 0x80) {
+            printable += (byte >= 0x20 && byte < 0x7F) || byte == '\n' || byte == '\r' ||
+                         byte == '\t';
+            i++;
+            continue;
+        }
+
+        const int length = byte >= 0xF0 && byte <= 0xF4   ? 4
+                           : byte >= 0xE0 && byte <= 0xEF ? 3
+                           : byte >= 0xC2 && byte <= 0xDF ? 2
+                                                          : 1;
+        int valid = length > 1 && i + length <= data.size() ? length : 1;
+        for (int k = 1; k < valid; k++) {
+            if ((static_cast<unsigned char>(data[i + k]) & 0xC0) != 0x80) {
+                valid = 1;
+            }
         }
+        printable += valid > 1 ? valid : 0;
+        i += valid;
     }
-    return result;
+    return double(printable) / data.size();
 }
 
-QString Decoder::toBase(int num, int base) {
-    if (num == 0)
-        return "0";
+Decoder::Status Decoder::decode(QByteArrayView input, Algorithm algorithm, QByteArray &output,
+                                int rotShift, qsizetype *errorPosition) {
+    switch (algorithm) {
+        case Base64:
+            return decodeBase64(input, output, errorPosition);
+        case Hex:
+            return decodeHex(input, output, errorPosition);
+        case ROT:
+        case ROT47:
+            if (errorPosition) {
+                *errorPosition = -1;
+            }
+            return rotateBytes(input, rotationFor(algorithm, rotShift), output);
+        default:
+            output.clear();
+            return InvalidInput;
+    }
+}
 
-    QString chars = "0123456789abcdefghijklmnopqrstuvwxyz";
-    QString result;
+Decoder::Status Decoder::decodeBase64(QByteArrayView input, QByteArray &output,
+                                      qsizetype *errorPosition) {
+    return decodeInto<UnitState>(input.data(), input.size(), Base64, output, errorPosition);
+}
 
-    while (num > 0) {
-        result.prepend(chars[num % base]);
-        num /= base;
+Decoder::Status Decoder::decodeHex(QByteArrayView input, QByteArray &output,
+                                   qsizetype *errorPosition) {
+    return decodeInto<UnitState>(input.data(), input.size(), Hex, output, errorPosition);
+}
+
+Decoder::Status Decoder::decodeROT(QByteArrayView input, int shift, QByteArray &output) {
+    return rotateBytes(input, rotationFor(ROT, shift), output);
+}
+
+Decoder::Status Decoder::decodeROT47(QByteArrayView input, QByteArray &output) {
+    return rotateBytes(input, rotationFor(ROT47, 0), output);
+}
+
+QString Decoder::decodeParallel(const QString &input, Algorithm algorithm, int rotShift,
+                                TaskControl *control) {
+    if (input.size() < ParallelThreshold) {
+        return decode(input, algorithm, rotShift);
+    }
+    if (algorithm == ROT || algorithm == ROT47) {
+        QString result = input;
+        const bool done = rotateParallel(reinterpret_cast<char16_t *>(result.data()), result.size(),
+                                         rotationFor(algorithm, rotShift), control);
+        return done ? result : QString();
+    }
+
+    QByteArray decoded;
+    qsizetype position = -1;
+    const Status status = decodeParallel(input, algorithm, decoded, rotShift, control, &position);
+    return status == Ok ? QString::fromUtf8(decoded) : errorMessage(algorithm, status, position);
+}
+
+Decoder::Status Decoder::decodeParallel(const QString &input, Algorithm algorithm,
+                                        QByteArray &output, int rotShift, TaskControl *control,
+                                        qsizetype *errorPosition) {
+    if (errorPosition) {
+        *errorPosition = -1;
     }
+    if (algorithm == ROT || algorithm == ROT47) {
+        // ROT only moves ASCII letters, which UTF-8 keeps as single bytes, so it can rotate the
+        // UTF-8 form in place
+        output = input.toUtf8();
+        if (!rotateParallel(output.data(), output.size(), rotationFor(algorithm, rotShift),
+                            control)) {
+            output.clear();
+        }
+        return Ok;
+    }
+    if (algorithm != Base64 && algorithm != Hex) {
+        output.clear();
+        return InvalidInput;
+    }
+
+    const char16_t *chars = utf16(input);
+    if (input.size() < ParallelThreshold) {
+        return decodeInto<UnitState>(chars, input.size(), algorithm, output, errorPosition);
+    }
+    const int segments = parallel::workerCount(input.size(), kMinSegment);
+    const bool ok = decodeSegmented<UnitState>(chars, input.size(), algorithm == Hex, segments,
+                                               output, control);
+    if (control && control->cancelled()) {
+        output.clear();
+        return Ok;
+    }
+    if (control) {
+        control->report(1, 1);
+    }
+    return ok ? Ok : decodeInto<UnitState>(chars, input.size(), algorithm, output, errorPosition);
+}
+
+Decoder::BatchResult Decoder::decodeBatch(const QByteArrayView *inputs, qsizetype count,
+                                          Algorithm algorithm, int rotShift) {
+    BatchResult batch;
+    batch.items.resize(count);
+
+    // Give every item a worst-case slot so workers never share or reallocate output
+    qsizetype arenaSize = 0;
+    for (qsizetype i = 0; i < count; i++) {
+        batch.items[i].offset = arenaSize;
+        arenaSize += maxDecodedSize(algorithm, inputs[i].size());
+    }
+    batch.arena.resize(arenaSize);
+
+    constexpr qsizetype kItemsPerTask = 1024;
+    const int tasks = static_cast<int>((count + kItemsPerTask - 1) / kItemsPerTask);
+    parallel::forEach(tasks, [&](int task) {
+        const qsizetype end = qMin(count, (task + 1) * kItemsPerTask);
+        for (qsizetype i = task * kItemsPerTask; i < end; i++) {
+            BatchItem &item = batch.items[i];
+            const DecodeResult result =
+                decodeWhole<UnitState>(inputs[i].data(), inputs[i].size(), algorithm, rotShift,
+                                       batch.arena.data() + item.offset);
+            item.status = statusOf(result);
+            item.errorPosition = result.errorPosition;
+            item.length = item.status == Ok ? result.size : 0;
+        }
+    });
+
+    return batch;
+}
+
+Decoder::BatchResult Decoder::decodeBatch(const QList<QByteArrayView> &inputs,
+                                          Algorithm algorithm, int rotShift) {
+    return decodeBatch(inputs.constData(), inputs.size(), algorithm, rotShift);
+}
+
+QByteArrayView Decoder::BatchResult::output(qsizetype index) const {
+    const BatchItem &item = items.at(index);
+    return QByteArrayView(arena.constData() + item.offset, item.length);
+}
+
+Decoder::Stream::Stream(Algorithm algorithm, int rotShift)
+    : algorithm(algorithm), rotShift(rotShift) {}
+
+bool Decoder::Stream::push(QByteArrayView chunk) {
+    if (hasError() || finished) {
+        return false;
+    }
+
+    const qsizetype offset = output.size();
+    DecodeResult result;
+    switch (algorithm) {
+        case Base64:
+            output.resize(offset + chunk.size() / 4 * 3 + 3);
+            result = decodeBase64Chars(chunk.data(), chunk.size(), output.data() + offset, state);
+            break;
+        case Hex:
+            output.resize(offset + chunk.size() / 2 + 1);
+            result = decodeHexChars(chunk.data(), chunk.size(), output.data() + offset, state);
+            break;
+        case ROT:
+        case ROT47:
+            output.append(chunk.data(), chunk.size());
+            rotateChars(output.data() + offset, chunk.size(), rotationFor(algorithm, rotShift));
+            result.size = chunk.size();
+            break;
+    }
+    output.truncate(offset + result.size);
+
+    if (result.errorPosition >= 0) {
+        return fail(algorithm == Base64 ? "Invalid base64 input" : "Invalid hex input",
+                    result.errorPosition);
+    }
+    return true;
+}
+
+bool Decoder::Stream::finish() {
+    if (hasError() || finished) {
+        return !hasError();
+    }
+    finished = true;
+
+    DecodeResult result;
+    if (algorithm == Base64) {
+        const qsizetype offset = output.size();
+        output.resize(offset + 2);
+        result = finishBase64(output.data() + offset, state);
+        output.truncate(offset + result.size);
+        if (result.errorPosition >= 0) {
+            return fail("Invalid base64 input", result.errorPosition);
+        }
+    } else if (algorithm == Hex) {
+        result = finishHex(state);
+        if (result.errorPosition >= 0) {
+            return fail("Invalid hex input", result.errorPosition);
+        }
+        if (result.truncated) {
+            return fail("Invalid hex input (odd length)", -1);
+        }
+    }
+    return true;
+}
+
+QByteArray Decoder::Stream::takeOutput() {
+    QByteArray taken;
+    taken.swap(output);
+    return taken;
+}
+
+bool Decoder::Stream::hasError() const {
+    return !error.isEmpty();
+}
+
+QString Decoder::Stream::errorString() const {
+    return error;
+}
+
+qsizetype Decoder::Stream::errorPosition() const {
+    return errorIndex;
+}
+
+bool Decoder::Stream::fail(const QString &message, qsizetype position) {
+    error = position >= 0 ? QString("Error: %1 at position %2").arg(message).arg(position)
+                          : "Error: " + message;
+    errorIndex = position;
+    output.clear();
+    return false;
+}
+
+Decoder::Live::Live(Algorithm algorithm, int rotShift) : algorithm(algorithm), rotShift(rotShift) {
+    checkpoints.append({0, 0});
+}
+
+Decoder::Live::Edit Decoder::Live::setText(const QString &text) {
+    input = text;
+    return redecodeAll(outputSize);
+}
 
+QString Decoder::Live::errorString() const {
+    return hasError() ? errorMessage(algorithm, InvalidInput, errorAt) : QString();
+}
+
+Decoder::Live::Edit Decoder::Live::edit(qsizetype position, qsizetype removed,
+                                        const QString &added) {
+    position = qBound<qsizetype>(0, position, input.size());
+    removed = qBound<qsizetype>(0, removed, input.size() - position);
+
+    // The edited characters plus one on each side, whose counts can change with them: a hex
+    // '0' is a digit or the start of "0x" depending on what follows, and a surrogate counts
+    // differently paired and alone
+    const qsizetype begin = alignBack(qMax<qsizetype>(0, position - 1));
+    const qsizetype oldEnd = alignForward(qMin(position + removed + 1, input.size()));
+    const qsizetype count = countBefore(begin);
+    const qsizetype oldSpan = measure(begin, oldEnd, nullptr);
+
+    input.replace(position, removed, added);
+    const qsizetype shift = added.size() - removed;
+    const qsizetype newEnd = oldEnd + shift;
+    QList<Checkpoint> seeded;
+    const qsizetype newSpan = measure(begin, newEnd, &seeded);
+    const qsizetype delta = newSpan - oldSpan;
+    updateCheckpoints(begin, oldEnd, newEnd, count, newSpan, delta, seeded);
+
+    Edit result;
+    if (algorithm == ROT || algorithm == ROT47) {
+        // One character in, one character out
+        result.position = count;
+        result.removed = oldSpan;
+        result.inserted =
+            rotateString(input.mid(begin, newEnd - begin), rotationFor(algorithm, rotShift))
+                .toUtf8();
+    } else if (errorAt >= 0 && begin > errorAt) {
+        // Whether a character decodes depends on the ones before it and the one after it at
+        // most, so an edit past the first error leaves it where it is
+        return result;
+    } else {
+        // The error is still there after the edit if its character lay beyond the span
+        const qsizetype oldError = errorAt >= oldEnd ? errorAt + shift : -1;
+        if (!redecodeUnits(begin, newEnd, count, newSpan, delta, oldError, result)) {
+            result = Edit();
+            result.resync = true;
+            return result;
+        }
+    }
+    outputSize += result.inserted.size() - result.removed;
     return result;
+}
+
+Decoder::Live::Checkpoint Decoder::Live::checkpointAt(qsizetype index) const {
+    Checkpoint checkpoint = checkpoints[index];
+    if (index >= shiftFrom) {
+        checkpoint.position += pending.position;
+        checkpoint.count += pending.count;
+    }
+    return checkpoint;
+}
+
+// Index of the last checkpoint at or before `position`
+qsizetype Decoder::Live::checkpointBefore(qsizetype position) const {
+    qsizetype low = 0;
+    qsizetype high = checkpoints.size();
+    while (high - low > 1) {
+        const qsizetype middle = low + (high - low) / 2;
+        if (checkpointAt(middle).position <= position) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// Moves the start of the pending shift to `index`, adding it to the checkpoints the boundary
+// passes going forward and taking it off those it passes going back
+void Decoder::Live::moveShift(qsizetype index) {
+    for (; shiftFrom < index; shiftFrom++) {
+        checkpoints[shiftFrom].position += pending.position;
+        checkpoints[shiftFrom].count += pending.count;
+    }
+    for (; shiftFrom > index; shiftFrom--) {
+        checkpoints[shiftFrom - 1].position -= pending.position;
+        checkpoints[shiftFrom - 1].count -= pending.count;
+    }
+}
+
+// Checkpoints inside the old span counted text that has changed and are dropped; the ones
+// after it move with the edit. New ones go at the start of the span, every spacing through it
+// and at its end wherever the next checkpoint is a spacing or more away, so no gap ever grows
+// past the spacing and countBefore() stays a short scan however many edits drop checkpoints.
+void Decoder::Live::updateCheckpoints(qsizetype begin, qsizetype oldEnd, qsizetype newEnd,
+                                      qsizetype count, qsizetype newSpan, qsizetype delta,
+                                      const QList<Checkpoint> &seeded) {
+    const qsizetype first = checkpointBefore(begin) + 1;
+    qsizetype last = first;
+    while (last < checkpoints.size() && checkpointAt(last).position < oldEnd) {
+        last++;
+    }
+    moveShift(first);
+    checkpoints.remove(first, last - first);
+    pending.position += newEnd - oldEnd;
+    pending.count += delta;
+
+    QList<Checkpoint> added;
+    qsizetype previous = checkpointAt(first - 1).position;
+    if (begin - previous >= kLiveCheckpointSpacing) {
+        added.append({begin, count});
+        previous = begin;
+    }
+    for (const Checkpoint &checkpoint : seeded) {
+        added.append({checkpoint.position, count + checkpoint.count});
+        previous = checkpoint.position;
+    }
+    const qsizetype next = first < checkpoints.size() ? checkpointAt(first).position
+                                                      : input.size();
+    if (next - previous >= kLiveCheckpointSpacing && previous < newEnd && newEnd < next) {
+        added.append({newEnd, count + newSpan});
+    }
+    if (!added.isEmpty()) {
+        checkpoints.insert(first, added.size(), Checkpoint());
+        std::copy(added.cbegin(), added.cend(), checkpoints.begin() + first);
+        shiftFrom += added.size();
+    }
+}
+
+qsizetype Decoder::Live::measure(qsizetype begin, qsizetype end, QList<Checkpoint> *seed) const {
+    const char16_t *in = utf16(input);
+    const qsizetype length = input.size();
+    const bool rot = algorithm == ROT || algorithm == ROT47;
+    qsizetype count = 0;
+    qsizetype next = begin + kLiveCheckpointSpacing;
+    for (qsizetype i = begin; i < end; i++) {
+        if (seed && i == next) {
+            seed->append({i, count});
+            next += kLiveCheckpointSpacing;
+        }
+        count += rot ? utf8Length(in, i, length) : isSymbol(in, i, length, algorithm == Hex);
+    }
+    return count;
+}
+
+qsizetype Decoder::Live::countBefore(qsizetype position) const {
+    const Checkpoint checkpoint = checkpointAt(checkpointBefore(position));
+    return checkpoint.count + measure(checkpoint.position, position, nullptr);
+}
+
+qsizetype Decoder::Live::alignBack(qsizetype position) const {
+    const bool splitsPair = position > 0 && position < input.size() &&
+                            input.at(position).isLowSurrogate() &&
+                            input.at(position - 1).isHighSurrogate();
+    return splitsPair ? position - 1 : position;
+}
+
+qsizetype Decoder::Live::alignForward(qsizetype position) const {
+    const bool splitsPair = position > 0 && position < input.size() &&
+                            input.at(position).isLowSurrogate() &&
+                            input.at(position - 1).isHighSurrogate();
+    return splitsPair ? position + 1 : position;
+}
+
+// Decodes input[begin, end) with a fresh decoder. With `last`, an unfinished unit at the end of
+// the text is left out of `out` rather than reported, since it is most likely still being typed;
+// otherwise the span must end on a unit boundary. `errorPosition` is -1 unless a character in
+// the span is invalid.
+bool Decoder::Live::decodeSpan(qsizetype begin, qsizetype end, bool last, QByteArray &out,
+                               qsizetype &errorPosition) const {
+    const bool hex = algorithm == Hex;
+    const char16_t *in = utf16(input) + begin;
+    out.resize(maxDecodedSize(algorithm, end - begin));
+    UnitState state;
+    state.position = begin;
+    const DecodeResult result = hex ? decodeHexChars(in, end - begin, out.data(), state)
+                                    : decodeBase64Chars(in, end - begin, out.data(), state);
+    errorPosition = result.errorPosition;
+    qsizetype size = result.size;
+    if (errorPosition < 0 && last && !hex && state.count > 1) {
+        size += finishBase64(out.data() + size, state).size;
+    }
+    out.truncate(size);
+    if (errorPosition >= 0) {
+        return false;
+    }
+    return last || (state.count == 0 && state.padding == 0 && state.prefix == 0);
+}
+
+// Re-decodes base64 or hex from the first symbol of the unit holding input[begin]. The text
+// before that decodes as it did, so the first invalid character from there on is the first of
+// the text. An edit that adds or removes whole units leaves every later unit as it was, so
+// decoding stops at the end of the unit holding the last edited symbol, and an error beyond
+// it (`oldError`, -1 if none) stays; any other edit realigns the rest of the text, which is
+// decoded up to its first error or its end. Returns false only when the text decodes again
+// after an error, which takes all of it.
+bool Decoder::Live::redecodeUnits(qsizetype begin, qsizetype newEnd, qsizetype count,
+                                  qsizetype newSpan, qsizetype delta, qsizetype oldError,
+                                  Edit &edit) {
+    const bool hex = algorithm == Hex;
+    const qsizetype unitSymbols = hex ? 2 : 4;
+    const qsizetype unitBytes = hex ? 1 : 3;
+    const char16_t *in = utf16(input);
+    const qsizetype length = input.size();
+
+    const qsizetype firstUnit = count / unitSymbols;
+    qsizetype start = begin;
+    for (qsizetype skip = count % unitSymbols; skip > 0;) {
+        start--;
+        skip -= isSymbol(in, start, length, hex);
+    }
+    // A fresh decoder has to see the whole of a "0x" or "\x" prefix
+    if (hex && start > 0 && isHexX(in[start]) && (in[start - 1] == '0' || in[start - 1] == '\\')) {
+        start--;
+    }
+    qsizetype errorPosition = -1;
+
+    if (delta % unitSymbols == 0) {
+        qsizetype symbols = count + newSpan;
+        const qsizetype target = (symbols + unitSymbols - 1) / unitSymbols * unitSymbols;
+        qsizetype end = newEnd;
+        for (; end < length && symbols < target; end++) {
+            symbols += isSymbol(in, end, length, hex);
+        }
+        const qsizetype endUnit = target / unitSymbols;
+        const bool beforeError = !hasError() || (oldError >= 0 && end <= oldError);
+        if (symbols == target && beforeError) {
+            const bool clean = decodeSpan(start, end, false, edit.inserted, errorPosition);
+            if (errorPosition >= 0) {
+                return fail(errorPosition, edit);
+            }
+            if (clean && hasError()) {
+                return fail(oldError, edit);
+            }
+            if (clean && edit.inserted.size() == (endUnit - firstUnit) * unitBytes) {
+                edit.position = firstUnit * unitBytes;
+                edit.removed = (endUnit - delta / unitSymbols - firstUnit) * unitBytes;
+                return edit.removed >= 0 && edit.position + edit.removed <= outputSize;
+            }
+            // Padding or a prefix left open at the unit end: the text after it reads differently
+        }
+    }
+
+    decodeSpan(start, length, true, edit.inserted, errorPosition);
+    if (errorPosition >= 0) {
+        return fail(errorPosition, edit);
+    }
+    if (hasError()) {
+        return false;
+    }
+    edit.position = firstUnit * unitBytes;
+    edit.removed = outputSize - edit.position;
+    return edit.removed >= 0;
+}
+
+// Replaces the whole output with the error at `position`
+bool Decoder::Live::fail(qsizetype position, Edit &edit) {
+    errorAt = position;
+    edit.position = 0;
+    edit.removed = outputSize;
+    edit.inserted = errorString().toUtf8();
+    return true;
+}
+
+Decoder::Live::Edit Decoder::Live::redecodeAll(qsizetype previousSize) {
+    checkpoints = {{0, 0}};
+    measure(0, input.size(), &checkpoints);
+    shiftFrom = checkpoints.size();
+    pending = {0, 0};
+
+    Edit edit;
+    edit.removed = previousSize;
+    errorAt = -1;
+    if (algorithm == ROT || algorithm == ROT47) {
+        edit.inserted = rotateString(input, rotationFor(algorithm, rotShift)).toUtf8();
+    } else {
+        qsizetype position = -1;
+        if (!decodeSpan(0, input.size(), true, edit.inserted, position)) {
+            errorAt = position;
+            edit.inserted = errorString().toUtf8();
+        }
+    }
+    outputSize = edit.inserted.size();
+    return edit;
 }
\ No newline at end of file
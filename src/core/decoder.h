@@ -1,16 +1,210 @@
 #pragma once
 
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
 #include <QString>
 
+class TaskControl;
+
 class Decoder {
+  private:
+    // Carry-over between chunks: the unfinished base64 quad or hex byte and where it began.
+    struct UnitState {
+        quint32 bits = 0;
+        int count = 0;
+        int padding = 0;          // '=' seen so far; only padding and whitespace may follow
+        char prefix = 0;          // '0' or '\' of a hex "0x"/"\x" split across chunks
+        bool urlSafe = false;     // last 62/63 symbol came from the URL-safe alphabet
+        qsizetype unitStart = 0;  // absolute index where the unfinished unit began
+        qsizetype position = 0;   // absolute index of the next input character
+    };
+
   public:
-    enum Algorithm { Base64, Hex, ROT };
+    enum Algorithm { Base64, Hex, ROT, ROT47 };
+
+    enum Status { Ok, InvalidInput, IncompleteInput };
+
+    // Outcome of one batch input; its decoded bytes are arena[offset, offset + length).
+    struct BatchItem {
+        qsizetype offset = 0;
+        qsizetype length = 0;
+        Status status = Ok;
+        qsizetype errorPosition = -1;
+    };
+
+    // One ROT shift ranked by rankROTShifts(); higher scores look more like English.
+    struct RotCandidate {
+        int shift = 0;
+        double score = 0;
+    };
+
+    // A plausible encoding for an unlabelled blob, as suggested by detectEncoding().
+    struct Detection {
+        Algorithm algorithm = Base64;
+        int rotShift = 0;  // shift to pass to decodeROT() for ROT detections
+        double confidence = 0;  // 0 .. 1
+    };
+
+    struct BatchResult {
+        QByteArray arena;
+        QList<BatchItem> items;
+
+        QByteArrayView output(qsizetype index) const;
+    };
+
+    // Incremental decoder for inputs too large to hold in memory at once. Feed chunks of any
+    // size with push(), drain decoded bytes with takeOutput() and call finish() after the last
+    // chunk. The result is byte-identical to the one-shot functions over the whole input.
+    class Stream {
+      public:
+        explicit Stream(Algorithm algorithm, int rotShift = 13);
+
+        bool push(QByteArrayView chunk);
+        bool finish();
+        QByteArray takeOutput();
+
+        bool hasError() const;
+        QString errorString() const;
+        qsizetype errorPosition() const;
+
+      private:
+        bool fail(const QString &message, qsizetype position);
+
+        Algorithm algorithm;
+        int rotShift;
+        UnitState state;
+        QByteArray output;
+        QString error;
+        qsizetype errorIndex = -1;
+        bool finished = false;
+    };
+
+    // Keeps the decoded form of a text in step with edits to it, for decoding as the user types.
+    // Each edit re-decodes only the whole base64 quads or hex bytes it touches (a ROT edit only
+    // its own characters) and returns the change to splice into the previous output, so the cost
+    // follows the size of the edit rather than of the text. An edit that shifts the unit
+    // alignment re-decodes through to the end, or to the first invalid character. The output is
+    // the decoded bytes, less a unit still being typed at the end, or the UTF-8 error message
+    // while the text does not decode.
+    //
+    // Edits after the first invalid character leave the error as it is, and edits before it
+    // only look for an earlier one. The one edit that needs the whole text decoded is the one
+    // that removes the last error: it comes back with `resync` set, and the caller decodes the
+    // text with setText(), which is the same full pass as decode() and belongs off the GUI
+    // thread for a large text.
+    class Live {
+      public:
+        // Replace output[position, position + removed) with `inserted`, unless `resync` is set
+        struct Edit {
+            qsizetype position = 0;
+            qsizetype removed = 0;
+            QByteArray inserted;
+            bool resync = false;
+        };
+
+        explicit Live(Algorithm algorithm = Base64, int rotShift = 13);
+
+        Edit setText(const QString &text);
+        Edit edit(qsizetype position, qsizetype removed, const QString &added);
+
+        const QString &text() const { return input; }
+        bool hasError() const { return errorAt >= 0; }
+        QString errorString() const;
+
+      private:
+        // Symbols (UTF-8 bytes for ROT) in input[0, position)
+        struct Checkpoint {
+            qsizetype position;
+            qsizetype count;
+        };
+
+        Checkpoint checkpointAt(qsizetype index) const;
+        qsizetype checkpointBefore(qsizetype position) const;
+        void moveShift(qsizetype index);
+        void updateCheckpoints(qsizetype begin, qsizetype oldEnd, qsizetype newEnd,
+                               qsizetype count, qsizetype newSpan, qsizetype delta,
+                               const QList<Checkpoint> &seeded);
+        qsizetype measure(qsizetype begin, qsizetype end, QList<Checkpoint> *seed) const;
+        qsizetype countBefore(qsizetype position) const;
+        qsizetype alignBack(qsizetype position) const;
+        qsizetype alignForward(qsizetype position) const;
+        bool decodeSpan(qsizetype begin, qsizetype end, bool last, QByteArray &out,
+                        qsizetype &errorPosition) const;
+        bool redecodeUnits(qsizetype begin, qsizetype newEnd, qsizetype count, qsizetype newSpan,
+                           qsizetype delta, qsizetype oldError, Edit &edit);
+        Edit redecodeAll(qsizetype previousSize);
+        bool fail(qsizetype position, Edit &edit);
+
+        Algorithm algorithm;
+        int rotShift;
+        QString input;
+        qsizetype errorAt = -1;  // first character that does not decode, -1 while all do
+        qsizetype outputSize = 0;
+
+        // Sorted, the first at position 0. An edit moves every checkpoint after it, so those
+        // from `shiftFrom` on are stored without `pending` added: typing in one place then
+        // moves the boundary over a few entries instead of rewriting all that follow.
+        QList<Checkpoint> checkpoints;
+        qsizetype shiftFrom = 1;
+        Checkpoint pending = {0, 0};
+    };
 
     static QString decode(const QString &input, Algorithm algorithm, int rotShift = 13);
     static QString decodeBase64(const QString &input);
     static QString decodeHex(const QString &input);
     static QString decodeROT(const QString &input, int shift);
+    static QString decodeROT47(const QString &input);
 
-  private:
-    static QString toBase(int num, int base);
+    // The message the QString functions return for a failed decode
+    static QString errorMessage(Algorithm algorithm, Status status, qsizetype position);
+
+    // Share of bytes that read as text: printable ASCII, whitespace and well-formed UTF-8, so
+    // non-English plaintext is not mistaken for garbage. Scores trial decodes during detection.
+    static double printableRatio(QByteArrayView data);
+
+    // Scores all 25 ROT shifts in a single pass over the input and returns them best first,
+    // so a ROT-obfuscated string can be cracked without trying each shift by hand. The score
+    // is the mean log10 English frequency of the decoded letters.
+    static QList<RotCandidate> rankROTShifts(const QString &input);
+    static QList<RotCandidate> rankROTShifts(QByteArrayView input);
+
+    // Guesses which encoding a blob uses and returns the plausible ones, most likely first.
+    // Only the first DetectSampleSize characters are classified (one histogram pass plus a trial
+    // decode), so the cost does not grow with the size of a paste.
+    static constexpr qsizetype DetectSampleSize = 16 * 1024;
+    static QList<Detection> detectEncoding(const QString &input);
+    static QList<Detection> detectEncoding(QByteArrayView input);
+
+    // Byte-oriented forms of the above for binary payloads and bulk callers. The decoded bytes
+    // replace the contents of `output`, whose capacity is reused across calls; on failure
+    // `output` is left empty and `errorPosition` (if given) receives the offending byte index.
+    static Status decode(QByteArrayView input, Algorithm algorithm, QByteArray &output,
+                         int rotShift = 13, qsizetype *errorPosition = nullptr);
+    static Status decodeBase64(QByteArrayView input, QByteArray &output,
+                               qsizetype *errorPosition = nullptr);
+    static Status decodeHex(QByteArrayView input, QByteArray &output,
+                            qsizetype *errorPosition = nullptr);
+    static Status decodeROT(QByteArrayView input, int shift, QByteArray &output);
+    static Status decodeROT47(QByteArrayView input, QByteArray &output);
+
+    // Same results as decode(), computed on the global thread pool. Inputs shorter than
+    // ParallelThreshold characters are decoded on the calling thread. Larger ones report progress
+    // to `control` segment by segment, and return an empty string once it is cancelled.
+    static constexpr qsizetype ParallelThreshold = 4 * 1024 * 1024;
+    static QString decodeParallel(const QString &input, Algorithm algorithm, int rotShift = 13,
+                                  TaskControl *control = nullptr);
+    // The decoded bytes as they are, for output that need not be text (ROT gives the UTF-8 of
+    // its result). A cancelled call leaves `output` empty and returns Ok.
+    static Status decodeParallel(const QString &input, Algorithm algorithm, QByteArray &output,
+                                 int rotShift = 13, TaskControl *control = nullptr,
+                                 qsizetype *errorPosition = nullptr);
+
+    // Decodes many short values (cookies, IDs, one token per log line) into a single arena.
+    // A batch costs two allocations however many items it has, and items are spread across
+    // the global thread pool.
+    static BatchResult decodeBatch(const QByteArrayView *inputs, qsizetype count,
+                                   Algorithm algorithm, int rotShift = 13);
+    static BatchResult decodeBatch(const QList<QByteArrayView> &inputs, Algorithm algorithm,
+                                   int rotShift = 13);
 };
\ No newline at end of file
@@ -0,0 +1,348 @@
+#include "highlighter.h"
+
+#include <type_traits>
+
+#include "js_lexer.h"
+
+namespace {
+
+// What the lexer is inside of; the literals and comments can stop and resume anywhere
+enum Context { Code, LineComment, BlockComment, SingleQuoted, DoubleQuoted, TemplateText };
+
+// State layout: bits 0-2 the context, bit 3 set when a '/' would divide rather than start a
+// regex, bit 4 set after a member access '.', and above that one bit per open brace, innermost
+// lowest, set for the "${" of a template substitution. Braces nested deeper than the state
+// holds fall off the top and read back as plain blocks.
+constexpr Highlighter::State kContextMask = 0x7;
+constexpr Highlighter::State kDivision = 0x8;
+constexpr Highlighter::State kAfterDot = 0x10;
+constexpr int kBraceShift = 5;
+constexpr Highlighter::State kBraceMask = 0x7FFFFFFF;
+
+constexpr qsizetype kMaxKeywordLength = 10;  // "instanceof"
+
+template <typename CharT>
+inline char16_t unitAt(const CharT *text, qsizetype i) {
+    return static_cast<std::make_unsigned_t<CharT>>(text[i]);
+}
+
+inline bool isIdentifierStart(char16_t unit) {
+    return (unit >= 'a' && unit <= 'z') || (unit >= 'A' && unit <= 'Z') || unit == '$' ||
+           unit == '_' || unit == '\\' || unit >= 0x80;
+}
+
+inline bool isIdentifierPart(char16_t unit) {
+    return isIdentifierStart(unit) || (unit >= '0' && unit <= '9');
+}
+
+template <typename CharT>
+struct Lexer {
+    const CharT *text;
+    qsizetype length;
+    Highlighter::Language language;
+    QList<Highlighter::Span> *spans;
+    qsizetype pos;
+    int context;
+    bool regexAllowed;
+    bool afterDot;
+    Highlighter::State braces;
+
+    char16_t at(qsizetype i) const { return i < length ? unitAt(text, i) : 0; }
+
+    void span(qsizetype start, Highlighter::Format format) {
+        if (spans && pos > start && format != Highlighter::Plain) {
+            spans->append({start, pos - start, format});
+        }
+    }
+
+    void openBrace(bool substitution) {
+        braces = ((braces << 1) | (substitution ? 1 : 0)) & (kBraceMask >> kBraceShift);
+    }
+
+    bool closeBrace() {
+        const bool substitution = braces & 1;
+        braces >>= 1;
+        return substitution;
+    }
+
+    // text[start, pos) as UTF-16 in `buffer`, or empty if it is longer than any keyword
+    QStringView word(qsizetype start, char16_t (&buffer)[kMaxKeywordLength]) const {
+        const qsizetype size = pos - start;
+        if (size > kMaxKeywordLength) {
+            return QStringView();
+        }
+        for (qsizetype i = 0; i < size; i++) {
+            buffer[i] = unitAt(text, start + i);
+        }
+        return QStringView(buffer, size);
+    }
+
+    bool isKeyword(QStringView name) const {
+        if (language == Highlighter::Json) {
+            return name == u"true" || name == u"false" || name == u"null" || name == u"NaN" ||
+                   name == u"Infinity";
+        }
+        // Every keyword is lower case, which rules out most names before the table lookup
+        const char16_t first = name.isEmpty() ? 0 : name.front().unicode();
+        return name.size() >= 2 && first >= 'a' && first <= 'z' && JsLexer::isKeyword(name);
+    }
+
+    // Lexes until `end`; the literal or comment the lexer is inside of is continued first
+    qsizetype run(qsizetype end) {
+        while (pos < end) {
+            if (context == Code) {
+                lexToken(end);
+            } else if (context == LineComment || context == BlockComment) {
+                continueComment(pos, end);
+            } else if (context == TemplateText) {
+                continueTemplate(pos, end);
+            } else {
+                continueString(pos, end);
+            }
+        }
+        return pos;
+    }
+
+    // The continue functions lex on from `pos` and colour from `start`, before it if the
+    // opening characters were just read
+    void continueComment(qsizetype start, qsizetype end) {
+        while (pos < end) {
+            const char16_t unit = unitAt(text, pos);
+            if (context == LineComment && (unit == '\n' || unit == '\r')) {
+                context = Code;
+                break;
+            }
+            if (context == BlockComment && unit == '*' && at(pos + 1) == '/') {
+                pos += 2;
+                context = Code;
+                break;
+            }
+            pos++;
+        }
+        span(start, Highlighter::Comment);
+    }
+
+    // Quoted strings end at their quote or, unterminated, at the end of the line; a backslash
+    // escapes the next character, a line break included
+    void continueString(qsizetype start, qsizetype end) {
+        const char16_t quote = context == SingleQuoted ? '\'' : '"';
+        while (pos < end) {
+            const char16_t unit = unitAt(text, pos);
+            if (unit == '\\') {
+                pos = qMin(pos + 2, length);
+                if (at(pos - 1) == '\r' && at(pos) == '\n') {
+                    pos++;
+                }
+                continue;
+            }
+            if (unit == '\n' || unit == '\r') {
+                context = Code;
+                break;
+            }
+            pos++;
+            if (unit == quote) {
+                context = Code;
+                break;
+            }
+        }
+        regexAllowed = false;
+        span(start, context == Code && isPropertyName() ? Highlighter::Property
+                                                       : Highlighter::String);
+    }
+
+    // A JSON string followed by ':' is an object key
+    bool isPropertyName() const {
+        if (language != Highlighter::Json) {
+            return false;
+        }
+        qsizetype i = pos;
+        while (i < length && (at(i) == ' ' || at(i) == '\t')) {
+            i++;
+        }
+        return at(i) == ':';
+    }
+
+    void continueTemplate(qsizetype start, qsizetype end) {
+        while (pos < end) {
+            const char16_t unit = unitAt(text, pos);
+            if (unit == '\\') {
+                pos = qMin(pos + 2, length);
+            } else if (unit == '`') {
+                pos++;
+                context = Code;
+                regexAllowed = false;
+                break;
+            } else if (unit == '$' && at(pos + 1) == '{') {
+                pos += 2;
+                openBrace(true);
+                context = Code;
+                regexAllowed = true;
+                break;
+            } else {
+                pos++;
+            }
+        }
+        span(start, Highlighter::String);
+    }
+
+    void lexToken(qsizetype end) {
+        const char16_t unit = unitAt(text, pos);
+        const char16_t next = at(pos + 1);
+        if (unit == ' ' || unit == '\t' || unit == '\n' || unit == '\r') {
+            pos++;
+            return;
+        }
+
+        const bool dot = afterDot;
+        afterDot = false;
+        const qsizetype start = pos;
+        if (unit == '/' && (next == '/' || next == '*')) {
+            afterDot = dot;  // comments leave the surrounding tokens as they were
+            pos += 2;
+            context = next == '/' ? LineComment : BlockComment;
+            continueComment(start, end);
+            return;
+        }
+        if (unit == '\'' || unit == '"') {
+            pos++;
+            context = unit == '\'' ? SingleQuoted : DoubleQuoted;
+            continueString(start, end);
+            return;
+        }
+        if (unit == '`' && language == Highlighter::JavaScript) {
+            pos++;
+            context = TemplateText;
+            continueTemplate(start, end);
+            return;
+        }
+        if ((unit >= '0' && unit <= '9') || (unit == '.' && next >= '0' && next <= '9')) {
+            lexNumber();
+            span(start, Highlighter::Number);
+            regexAllowed = false;
+            return;
+        }
+        if (isIdentifierStart(unit)) {
+            for (pos++; pos < length && isIdentifierPart(unitAt(text, pos)); pos++) {
+            }
+            char16_t buffer[kMaxKeywordLength];
+            const QStringView name = word(start, buffer);
+            const bool keyword = !dot && !name.isEmpty() && isKeyword(name);
+            span(start, keyword ? Highlighter::Keyword : Highlighter::Plain);
+            // Values, unlike the other keywords, are followed by division
+            regexAllowed = keyword && name != u"this" && name != u"super" && name != u"null" &&
+                           name != u"true" && name != u"false";
+            return;
+        }
+        if (unit == '/' && regexAllowed && language == Highlighter::JavaScript && lexRegex()) {
+            span(start, Highlighter::Regex);
+            regexAllowed = false;
+            return;
+        }
+        lexPunctuator(unit, next, end);
+    }
+
+    void lexNumber() {
+        const bool hex = unitAt(text, pos) == '0' && (at(pos + 1) | 0x20) == 'x';
+        for (pos++; pos < length; pos++) {
+            const char16_t unit = unitAt(text, pos);
+            const bool exponentSign = !hex && (unit == '+' || unit == '-') &&
+                                      (unitAt(text, pos - 1) | 0x20) == 'e';
+            if (!isIdentifierPart(unit) && unit != '.' && !exponentSign) {
+                break;
+            }
+        }
+    }
+
+    // A regex runs to the next '/' outside a character class on the same line
+    bool lexRegex() {
+        bool inClass = false;
+        for (qsizetype i = pos + 1; i < length; i++) {
+            const char16_t unit = unitAt(text, i);
+            if (unit == '\n' || unit == '\r') {
+                return false;
+            }
+            if (unit == '\\') {
+                i++;
+            } else if (unit == '[') {
+                inClass = true;
+            } else if (unit == ']') {
+                inClass = false;
+            } else if (unit == '/' && !inClass) {
+                for (pos = i + 1; pos < length && isIdentifierPart(unitAt(text, pos)); pos++) {
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void lexPunctuator(char16_t unit, char16_t next, qsizetype end) {
+        pos++;
+        regexAllowed = true;
+        switch (unit) {
+            case '{':
+                openBrace(false);
+                break;
+            case '}':
+                if (closeBrace() && language == Highlighter::JavaScript) {
+                    context = TemplateText;  // the rest of the template after a substitution
+                    continueTemplate(pos - 1, end);
+                    return;
+                }
+                regexAllowed = false;
+                break;
+            case ')':
+            case ']':
+                regexAllowed = false;
+                break;
+            case '+':
+            case '-':
+                if (next == unit) {
+                    pos++;
+                    regexAllowed = false;
+                }
+                break;
+            case '.':
+                afterDot = true;
+                break;
+            case '?':
+                afterDot = next == '.' && !(at(pos + 1) >= '0' && at(pos + 1) <= '9');
+                pos += afterDot ? 1 : 0;
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+template <typename CharT>
+qsizetype lexText(const CharT *text, qsizetype length, qsizetype begin, qsizetype end,
+                  Highlighter::State &state, Highlighter::Language language,
+                  QList<Highlighter::Span> *spans) {
+    Lexer<CharT> lexer{text,
+                       length,
+                       language,
+                       spans,
+                       begin,
+                       int(state & kContextMask),
+                       (state & kDivision) == 0,
+                       (state & kAfterDot) != 0,
+                       (state & kBraceMask) >> kBraceShift};
+    const qsizetype stop = lexer.run(qMin(end, length));
+    state = Highlighter::State(lexer.context) | (lexer.regexAllowed ? 0 : kDivision) |
+            (lexer.afterDot ? kAfterDot : 0) | ((lexer.braces << kBraceShift) & kBraceMask);
+    return stop;
+}
+
+}  // namespace
+
+qsizetype Highlighter::lex(QByteArrayView text, qsizetype begin, qsizetype end, State &state,
+                           Language language, QList<Span> *spans) {
+    return lexText(text.data(), text.size(), begin, end, state, language, spans);
+}
+
+qsizetype Highlighter::lex(QStringView text, qsizetype begin, qsizetype end, State &state,
+                           Language language, QList<Span> *spans) {
+    return lexText(reinterpret_cast<const char16_t *>(text.data()), text.size(), begin, end, state,
+                   language, spans);
+}
\ No newline at end of file
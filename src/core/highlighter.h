@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QByteArrayView>
+#include <QList>
+#include <QStringView>
+
+// Resumable lexer behind the JavaScript and JSON highlighting of the output panes. It can stop
+// between any two tokens and inside comments, strings and template literals, and goes on from
+// the State it stopped in, so a view lexes only the part it shows, starting from a state it
+// remembered at some point before it, and an editor re-lexes only the lines that changed.
+//
+// This is not JsLexer: it only has to colour tokens, so it keeps no token list and everything
+// it needs to resume (what it is inside, whether a '/' starts a regex, which open braces are
+// template substitutions) fits in one 31-bit State.
+class Highlighter {
+  public:
+    enum Language { JavaScript, Json };
+
+    enum Format { Plain, Keyword, Number, String, Property, Comment, Regex };
+
+    struct Span {
+        qsizetype start = 0;
+        qsizetype length = 0;
+        Format format = Plain;
+    };
+
+    using State = quint32;  // 0 at the start of a text; never negative as an int
+
+    // Lexes text[begin, end) starting in `state` and appends the spans that are not Plain, in
+    // order, to `spans` if given. Lexing stops at `end` inside a comment, string or template, and
+    // otherwise after the token that reaches it. Returns that position and leaves `state` there.
+    static qsizetype lex(QByteArrayView text, qsizetype begin, qsizetype end, State &state,
+                         Language language, QList<Span> *spans = nullptr);
+    static qsizetype lex(QStringView text, qsizetype begin, qsizetype end, State &state,
+                         Language language, QList<Span> *spans = nullptr);
+};
\ No newline at end of file
@@ -0,0 +1,2284 @@
+#include "js_ast.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "js_lexer.h"
+#include "task_control.h"
+
+namespace {
+
+using Node = JsAst::Node;
+using Token = JsLexer::Token;
+
+// Expressions, functions, literals and member chains nested inside one another. Each level
+// costs a few stack frames in the parser and one in every pass.
+constexpr int kMaxNesting = 128;
+
+// Binding strength, loosest first
+enum Precedence {
+    kSequence = 1,
+    kAssignment,  // arrows, yield and spread too
+    kConditional,
+    kNullish,
+    kOr,
+    kAnd,
+    kBitOr,
+    kBitXor,
+    kBitAnd,
+    kEquality,
+    kRelational,
+    kShift,
+    kAdditive,
+    kMultiplicative,
+    kExponent,
+    kUnary,
+    kPostfix,
+    kNew,   // new without an argument list
+    kCall,  // calls, member access, new with arguments
+    kPrimary
+};
+
+int binaryPrecedence(QStringView op) {
+    struct Entry {
+        QStringView op;
+        int precedence;
+    };
+    static constexpr Entry kOperators[] = {
+        {u"??", kNullish},            {u"||", kOr},                 {u"&&", kAnd},
+        {u"|", kBitOr},               {u"^", kBitXor},              {u"&", kBitAnd},
+        {u"==", kEquality},           {u"!=", kEquality},           {u"===", kEquality},
+        {u"!==", kEquality},          {u"<", kRelational},          {u">", kRelational},
+        {u"<=", kRelational},         {u">=", kRelational},         {u"in", kRelational},
+        {u"instanceof", kRelational}, {u"<<", kShift},              {u">>", kShift},
+        {u">>>", kShift},             {u"+", kAdditive},            {u"-", kAdditive},
+        {u"*", kMultiplicative},      {u"/", kMultiplicative},      {u"%", kMultiplicative},
+        {u"**", kExponent}};
+    for (const Entry &entry : kOperators) {
+        if (entry.op == op) {
+            return entry.precedence;
+        }
+    }
+    return 0;
+}
+
+bool isAssignmentOperator(QStringView op) {
+    static constexpr QStringView kOperators[] = {
+        u"=",   u"+=",   u"-=", u"*=", u"/=", u"%=",  u"**=", u"<<=",
+        u">>=", u">>>=", u"&=", u"|=", u"^=", u"&&=", u"||=", u"?\?="};
+    return std::find(std::begin(kOperators), std::end(kOperators), op) != std::end(kOperators);
+}
+
+bool isLogical(QStringView op) {
+    return op == u"&&" || op == u"||" || op == u"??";
+}
+
+bool isIdentifierName(QStringView text) {
+    if (text.isEmpty() || text.front().isDigit()) {
+        return false;
+    }
+    return std::all_of(text.begin(), text.end(), [](QChar ch) {
+        const char16_t unit = ch.unicode();
+        return (unit >= 'a' && unit <= 'z') || (unit >= 'A' && unit <= 'Z') ||
+               (unit >= '0' && unit <= '9') || unit == '_' || unit == '$';
+    });
+}
+
+// Value of a numeric literal. False for BigInts, and for integers past 2^53 written in another
+// base, which would have to be rounded the way JavaScript does.
+bool numberValue(QStringView literal, double &value) {
+    if (literal.endsWith('n')) {
+        return false;
+    }
+    QString digits = literal.toString();
+    digits.remove('_');
+
+    int base = 10;
+    qsizetype first = 0;
+    if (digits.size() > 2 && digits[0] == '0') {
+        const char16_t prefix = digits[1].unicode() | 0x20;
+        base = prefix == 'x' ? 16 : prefix == 'o' ? 8 : prefix == 'b' ? 2 : 10;
+        first = base == 10 ? 0 : 2;
+    }
+    if (base == 10 && digits.size() > 1 && digits[0] == '0' &&
+        std::all_of(digits.begin(), digits.end(),
+                    [](QChar ch) { return ch.digitValue() >= 0 && ch.digitValue() < 8; })) {
+        base = 8;  // legacy octal, 010 == 8
+        first = 1;
+    }
+    if (base == 10) {
+        bool ok = false;
+        value = digits.toDouble(&ok);
+        return ok;
+    }
+
+    value = 0;
+    for (qsizetype k = first; k < digits.size(); k++) {
+        const int digit = digits[k].isDigit() ? digits[k].digitValue()
+                                              : (digits[k].unicode() | 0x20) - 'a' + 10;
+        if (digit < 0 || digit >= base) {
+            return false;
+        }
+        value = value * base + digit;
+    }
+    return value <= 9007199254740992.0;
+}
+
+// Literals written other than in plain decimal
+bool isNonDecimal(QStringView literal) {
+    return literal.contains('_') ||
+           (literal.size() > 1 && literal[0] == '0' && literal[1] != '.' &&
+            (literal[1].unicode() | 0x20) != 'e');
+}
+
+// Number::toString: the shortest digits that read back as the same double
+QString numberText(double value) {
+    if (value == 0) {
+        return std::signbit(value) ? QString("-0") : QString("0");
+    }
+    if (value < 0) {
+        return '-' + numberText(-value);
+    }
+
+    QString scientific;
+    for (int digits = 1; digits <= 17; digits++) {
+        scientific = QString::number(value, 'e', digits - 1);
+        if (scientific.toDouble() == value) {
+            break;
+        }
+    }
+    const qsizetype e = scientific.indexOf('e');
+    QString mantissa = scientific.left(e).remove('.');
+    while (mantissa.size() > 1 && mantissa.endsWith('0')) {
+        mantissa.chop(1);
+    }
+    const qsizetype k = mantissa.size();
+    const int n = scientific.mid(e + 1).toInt() + 1;  // the decimal point sits after n digits
+    if (k <= n && n <= 21) {
+        return mantissa + QString(n - k, '0');
+    }
+    if (n > 0 && n <= 21) {
+        return mantissa.left(n) + '.' + mantissa.mid(n);
+    }
+    if (n > -6 && n <= 0) {
+        return "0." + QString(-n, '0') + mantissa;
+    }
+    QString text = mantissa.left(1);
+    if (k > 1) {
+        text += '.' + mantissa.mid(1);
+    }
+    return text + 'e' + (n > 0 ? '+' : '-') + QString::number(std::abs(n - 1));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Parser
+// ---------------------------------------------------------------------------------------------
+
+class Nesting {
+  public:
+    explicit Nesting(int &depth) : depth(depth) { depth++; }
+    ~Nesting() { depth--; }
+    bool tooDeep() const { return depth > kMaxNesting; }
+
+  private:
+    int &depth;
+};
+
+class Parser {
+  public:
+    Parser(QStringView source, Arena &arena, Deadline *deadline);
+
+    Node *program();
+    qsizetype nodeCount() const { return nodes; }
+    bool interrupted() const { return stopped; }
+
+    QHash<QStringView, Node *> arrays;  // declared with an array literal; null if twice
+    QHash<QStringView, int> mentions;
+
+  private:
+    const Token &token(qsizetype k) const { return tokens[qBound(qsizetype(0), k, last)]; }
+    QStringView text(qsizetype k) const;
+    qsizetype endOf(qsizetype k) const { return token(k).start + token(k).length; }
+    bool atEnd() const { return i >= last; }
+    bool newlineBefore(qsizetype k) const { return token(k).newlines > 0; }
+    bool isPunctuator(qsizetype k, QStringView punctuator) const;
+    bool isWord(qsizetype k, QStringView word) const;
+    bool expect(QStringView punctuator);
+    bool startsTemplate(qsizetype k) const;
+    qsizetype matching(qsizetype k) const { return k < last ? match[k] : -1; }
+
+    Node *make(JsAst::Kind kind, qsizetype first, const QList<Node *> &children);
+    Node *make(JsAst::Kind kind, qsizetype first, const QList<Node *> &children, QStringView op);
+    Node *makeSource(qsizetype first, const QList<Node *> &children, int precedence);
+
+    // Statements are not nodes; they only decide where expressions start
+    void statements(QList<Node *> &roots);
+    bool statement(QList<Node *> &roots);
+    bool endStatement();
+    void skipStatement();
+    bool skipModuleClause();
+    bool outOfTime();
+    bool declarations(QList<Node *> &roots);
+    bool condition(QList<Node *> &roots);
+    bool forHeader(QList<Node *> &roots);
+    bool body(QList<Node *> &roots);
+
+    Node *expression();
+    Node *assignment();
+    bool startsArrow() const;
+    Node *arrow();
+    Node *yield();
+    Node *conditional();
+    Node *binary(int minimum);
+    Node *unary();
+    Node *postfix();
+    Node *callChain();
+    Node *newExpression();
+    Node *member(qsizetype first, Node *object, bool optional);
+    Node *computedMember(qsizetype first, Node *object, bool optional);
+    Node *call(JsAst::Kind kind, qsizetype first, Node *callee, bool optional);
+    bool arguments(QList<Node *> &children);
+    Node *spread();
+    Node *primary();
+    Node *number();
+    Node *string();
+    Node *templateLiteral(qsizetype first, QList<Node *> children, int precedence);
+    Node *array();
+    Node *object();
+    bool property(QList<Node *> &children, bool inClass);
+    Node *function();
+    Node *classNode();
+
+    QStringView source;
+    Arena &arena;
+    Deadline *deadline;
+    bool stopped = false;
+    QList<Token> tokens;     // comments dropped, ending with EndOfInput
+    QList<qsizetype> match;  // index of the closing bracket for each opening one
+    qsizetype last = 0;
+    qsizetype i = 0;
+    int depth = 0;
+    qsizetype nodes = 0;
+};
+
+Parser::Parser(QStringView source, Arena &arena, Deadline *deadline)
+    : source(source), arena(arena), deadline(deadline) {
+    // A comment holding a line break still counts as one for ASI
+    JsLexer lexer(source);
+    int newlines = 0;
+    tokens.reserve(source.size() / 4);
+    for (Token next = lexer.next();; next = lexer.next()) {
+        if (outOfTime()) {
+            next = Token();  // the rest is not looked at; it is printed as written
+            next.start = source.size();
+        }
+        if (next.type == JsLexer::LineComment || next.type == JsLexer::BlockComment) {
+            const QStringView comment = source.mid(next.start, next.length);
+            newlines += next.newlines + (comment.contains('\n') || comment.contains('\r'));
+            continue;
+        }
+        next.newlines += newlines;
+        newlines = 0;
+        tokens.append(next);
+        if (next.type == JsLexer::EndOfInput) {
+            break;
+        }
+    }
+    last = tokens.size() - 1;
+
+    match.fill(-1, tokens.size());
+    QList<qsizetype> open;
+    for (qsizetype k = 0; k < last; k++) {
+        if (tokens[k].type != JsLexer::Punctuator || tokens[k].length != 1) {
+            continue;
+        }
+        const char16_t unit = source[tokens[k].start].unicode();
+        if (unit == '(' || unit == '[' || unit == '{') {
+            open.append(k);
+        } else if ((unit == ')' || unit == ']' || unit == '}') && !open.isEmpty()) {
+            const char16_t opener = source[tokens[open.last()].start].unicode();
+            if ((opener == '(' && unit == ')') || (opener == '[' && unit == ']') ||
+                (opener == '{' && unit == '}')) {
+                match[open.last()] = k;
+                open.removeLast();
+            }
+        }
+    }
+}
+
+QStringView Parser::text(qsizetype k) const {
+    const Token &t = token(k);
+    return source.mid(t.start, t.length);
+}
+
+bool Parser::isPunctuator(qsizetype k, QStringView punctuator) const {
+    return token(k).type == JsLexer::Punctuator && text(k) == punctuator;
+}
+
+bool Parser::isWord(qsizetype k, QStringView word) const {
+    const JsLexer::TokenType type = token(k).type;
+    return (type == JsLexer::Identifier || type == JsLexer::Keyword) && text(k) == word;
+}
+
+// A tag is followed by a whole template or its head, never by the rest of one
+bool Parser::startsTemplate(qsizetype k) const {
+    return token(k).type == JsLexer::Template && text(k).startsWith('`');
+}
+
+bool Parser::expect(QStringView punctuator) {
+    if (!isPunctuator(i, punctuator)) {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+Node *Parser::make(JsAst::Kind kind, qsizetype first, const QList<Node *> &children) {
+    Node *node = arena.create<Node>();
+    node->kind = kind;
+    node->precedence = kPrimary;
+    node->start = token(first).start;
+    node->end = qMax(node->start, endOf(i - 1));
+    node->count = int(children.size());
+    node->children = arena.allocateArray<Node *>(children.size());
+    std::copy(children.begin(), children.end(), node->children);
+    nodes++;
+    return node;
+}
+
+Node *Parser::make(JsAst::Kind kind, qsizetype first, const QList<Node *> &children,
+                   QStringView op) {
+    Node *node = make(kind, first, children);
+    node->operators = arena.create<QStringView>(op);
+    return node;
+}
+
+Node *Parser::makeSource(qsizetype first, const QList<Node *> &children, int precedence) {
+    Node *node = make(JsAst::Source, first, children);
+    node->precedence = precedence;
+    qsizetype *bounds = arena.allocateArray<qsizetype>(2 * children.size());
+    for (qsizetype k = 0; k < children.size(); k++) {
+        bounds[2 * k] = children[k]->start;
+        bounds[2 * k + 1] = children[k]->end;
+    }
+    node->bounds = bounds;
+    return node;
+}
+
+Node *Parser::program() {
+    QList<Node *> roots;
+    while (!atEnd()) {
+        statements(roots);
+        i++;  // a stray closing brace
+    }
+
+    Node *root = makeSource(0, roots, kSequence);
+    root->start = 0;
+    root->end = source.size();
+
+    if (!arrays.isEmpty() && !stopped) {
+        for (qsizetype k = 0; k < last; k++) {
+            if (tokens[k].type == JsLexer::Identifier && arrays.contains(text(k)) &&
+                !isPunctuator(k - 1, u".") && !isPunctuator(k - 1, u"?.")) {
+                mentions[text(k)]++;
+            }
+        }
+    }
+    return root;
+}
+
+// Runs up to the brace closing the enclosing body. Blocks need no nodes of their own, so they
+// are only counted.
+void Parser::statements(QList<Node *> &roots) {
+    int blocks = 0;
+    while (!atEnd()) {
+        if (outOfTime()) {
+            i = last;  // the tree is dropped, so where this leaves it does not matter
+        } else if (isPunctuator(i, u"}")) {
+            if (blocks == 0) {
+                return;
+            }
+            blocks--;
+            i++;
+        } else if (isPunctuator(i, u"{")) {
+            blocks++;
+            i++;
+        } else if (isPunctuator(i, u";")) {
+            i++;
+        } else {
+            const qsizetype first = i;
+            const qsizetype count = roots.size();
+            if (!statement(roots)) {
+                roots.resize(count);
+                i = first;
+                skipStatement();
+            }
+        }
+    }
+}
+
+bool Parser::outOfTime() {
+    stopped = stopped || (deadline && deadline->expired());
+    return stopped;
+}
+
+bool Parser::statement(QList<Node *> &roots) {
+    const QStringView word = text(i);
+    if (token(i).type == JsLexer::Keyword) {
+        if (word == u"var" || word == u"const" ||
+            (word == u"let" && (token(i + 1).type == JsLexer::Identifier ||
+                                isPunctuator(i + 1, u"[") || isPunctuator(i + 1, u"{")))) {
+            return declarations(roots) && endStatement();
+        }
+        if (word == u"function" || word == u"class") {
+            Node *node = word == u"function" ? function() : classNode();
+            if (node) {
+                roots.append(node);
+            }
+            return node;
+        }
+        if (word == u"if" || word == u"while" || word == u"with" || word == u"switch") {
+            i++;
+            return condition(roots);
+        }
+        if (word == u"for") {
+            i++;
+            return forHeader(roots);
+        }
+        if (word == u"return" || word == u"throw") {
+            i++;
+            // A line break after return ends the statement
+            if (!atEnd() && !isPunctuator(i, u";") && !isPunctuator(i, u"}") &&
+                !(word == u"return" && newlineBefore(i))) {
+                Node *value = expression();
+                if (!value) {
+                    return false;
+                }
+                roots.append(value);
+            }
+            return endStatement();
+        }
+        if (word == u"break" || word == u"continue") {
+            i++;
+            if (token(i).type == JsLexer::Identifier && !newlineBefore(i)) {
+                i++;
+            }
+            return endStatement();
+        }
+        if (word == u"else" || word == u"do" || word == u"try" || word == u"finally" ||
+            word == u"debugger") {
+            i++;
+            return true;
+        }
+        if (word == u"catch") {
+            i++;
+            if (isPunctuator(i, u"(")) {
+                if (matching(i) < 0) {
+                    return false;
+                }
+                i = matching(i) + 1;
+            }
+            return true;
+        }
+        if (word == u"case") {
+            i++;
+            Node *value = expression();
+            if (!value) {
+                return false;
+            }
+            roots.append(value);
+            return expect(u":");
+        }
+        if (word == u"default") {
+            i++;
+            expect(u":");  // or export default
+            return true;
+        }
+        if (word == u"export") {
+            i++;
+            return isPunctuator(i, u"*") || isPunctuator(i, u"{") ? skipModuleClause() : true;
+        }
+        if (word == u"import" && !isPunctuator(i + 1, u"(") && !isPunctuator(i + 1, u".")) {
+            i++;
+            return skipModuleClause();
+        }
+    } else if (token(i).type == JsLexer::Identifier) {
+        if (word == u"async" && isWord(i + 1, u"function") && !newlineBefore(i + 1)) {
+            Node *node = function();
+            if (node) {
+                roots.append(node);
+            }
+            return node;
+        }
+        if (isPunctuator(i + 1, u":")) {
+            i += 2;  // label
+            return true;
+        }
+    }
+
+    Node *node = expression();
+    if (!node || !endStatement()) {
+        return false;
+    }
+    node->statement = true;
+    roots.append(node);
+    return true;
+}
+
+// A statement ends at a semicolon, before a closing brace, or wherever a line break lets ASI
+// insert a semicolon.
+bool Parser::endStatement() {
+    if (expect(u";")) {
+        return true;
+    }
+    return atEnd() || isPunctuator(i, u"}") || newlineBefore(i);
+}
+
+void Parser::skipStatement() {
+    const qsizetype first = i;
+    while (!atEnd()) {
+        if (isPunctuator(i, u"(") || isPunctuator(i, u"[") || isPunctuator(i, u"{")) {
+            i = matching(i) < 0 ? last : matching(i) + 1;
+        } else if (expect(u";")) {
+            return;
+        } else if (isPunctuator(i, u"}")) {
+            i += i == first;
+            return;
+        } else {
+            i++;
+        }
+    }
+}
+
+// import ... from '...', export {...}, export * from '...'
+bool Parser::skipModuleClause() {
+    while (!atEnd() && !isPunctuator(i, u";")) {
+        if (isPunctuator(i, u"{")) {
+            if (matching(i) < 0) {
+                return false;
+            }
+            i = matching(i) + 1;
+            if (!isWord(i, u"from")) {
+                break;
+            }
+        } else if (token(i++).type == JsLexer::String) {
+            break;
+        }
+    }
+    return endStatement();
+}
+
+// var, let or const, up to the end of the declarator list; the caller checks what follows
+bool Parser::declarations(QList<Node *> &roots) {
+    i++;
+    while (true) {
+        qsizetype name = -1;
+        if (token(i).type == JsLexer::Identifier) {
+            name = i++;
+        } else if ((isPunctuator(i, u"[") || isPunctuator(i, u"{")) && matching(i) >= 0) {
+            i = matching(i) + 1;  // destructuring pattern
+        } else {
+            return false;
+        }
+
+        if (expect(u"=")) {
+            Node *value = assignment();
+            if (!value) {
+                return false;
+            }
+            roots.append(value);
+            if (name >= 0 && value->kind == JsAst::Array) {
+                arrays.insert(text(name), arrays.contains(text(name)) ? nullptr : value);
+            }
+        }
+        if (!expect(u",")) {
+            return true;
+        }
+    }
+}
+
+bool Parser::condition(QList<Node *> &roots) {
+    if (!expect(u"(")) {
+        return false;
+    }
+    Node *node = expression();
+    if (!node || !expect(u")")) {
+        return false;
+    }
+    roots.append(node);
+    return true;
+}
+
+// for (init; test; update), for (x in y), for (const x of y)
+bool Parser::forHeader(QList<Node *> &roots) {
+    if (isWord(i, u"await")) {
+        i++;
+    }
+    const qsizetype close = matching(i);
+    if (!isPunctuator(i, u"(") || close < 0) {
+        return false;
+    }
+    i++;
+    while (i < close) {
+        if (isPunctuator(i, u";") || isWord(i, u"in") || isWord(i, u"of")) {
+            i++;
+        } else if (isWord(i, u"var") || isWord(i, u"let") || isWord(i, u"const")) {
+            if (!declarations(roots)) {
+                return false;
+            }
+        } else {
+            Node *node = expression();
+            if (!node) {
+                return false;
+            }
+            roots.append(node);
+        }
+    }
+    if (i != close) {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+bool Parser::body(QList<Node *> &roots) {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep() || !expect(u"{")) {
+        return false;
+    }
+    statements(roots);
+    return expect(u"}");
+}
+
+Node *Parser::expression() {
+    const qsizetype first = i;
+    Node *node = assignment();
+    if (!node || !isPunctuator(i, u",")) {
+        return node;
+    }
+    QList<Node *> items{node};
+    while (expect(u",")) {
+        Node *item = assignment();
+        if (!item) {
+            return nullptr;
+        }
+        items.append(item);
+    }
+    return make(JsAst::Sequence, first, items);
+}
+
+Node *Parser::assignment() {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    if (startsArrow()) {
+        return arrow();
+    }
+    if (isWord(i, u"yield")) {
+        return yield();
+    }
+
+    const qsizetype first = i;
+    Node *target = conditional();
+    if (!target || token(i).type != JsLexer::Punctuator || !isAssignmentOperator(text(i))) {
+        return target;
+    }
+    const QStringView op = text(i++);
+    Node *value = assignment();
+    return value ? make(JsAst::Assignment, first, {target, value}, op) : nullptr;
+}
+
+bool Parser::startsArrow() const {
+    qsizetype k = i;
+    if (isWord(k, u"async") && !newlineBefore(k + 1) &&
+        (token(k + 1).type == JsLexer::Identifier || isPunctuator(k + 1, u"("))) {
+        k++;
+    }
+    if (token(k).type == JsLexer::Identifier) {
+        return isPunctuator(k + 1, u"=>");
+    }
+    return isPunctuator(k, u"(") && matching(k) >= 0 && isPunctuator(matching(k) + 1, u"=>");
+}
+
+// Parameters stay source text; the body is parsed like any other
+Node *Parser::arrow() {
+    const qsizetype first = i;
+    if (isWord(i, u"async") && !isPunctuator(i + 1, u"=>")) {
+        i++;
+    }
+    i = isPunctuator(i, u"(") ? matching(i) + 1 : i + 1;
+    i++;  // =>
+
+    QList<Node *> children;
+    if (isPunctuator(i, u"{")) {
+        if (!body(children)) {
+            return nullptr;
+        }
+    } else {
+        Node *value = assignment();
+        if (!value) {
+            return nullptr;
+        }
+        children.append(value);
+    }
+    return makeSource(first, children, kAssignment);
+}
+
+Node *Parser::yield() {
+    const qsizetype first = i++;
+    expect(u"*");
+    QList<Node *> children;
+    const bool operand = !newlineBefore(i) && !atEnd() &&
+                         (token(i).type != JsLexer::Punctuator || isPunctuator(i, u"(") ||
+                          isPunctuator(i, u"[") || isPunctuator(i, u"{") ||
+                          isPunctuator(i, u"!") || isPunctuator(i, u"-") ||
+                          isPunctuator(i, u"+") || isPunctuator(i, u"~"));
+    if (operand) {
+        Node *value = assignment();
+        if (!value) {
+            return nullptr;
+        }
+        children.append(value);
+    }
+    return makeSource(first, children, kAssignment);
+}
+
+Node *Parser::conditional() {
+    const qsizetype first = i;
+    Node *test = binary(kNullish);
+    if (!test || !expect(u"?")) {
+        return test;
+    }
+    Node *then = assignment();
+    if (!then || !expect(u":")) {
+        return nullptr;
+    }
+    Node *otherwise = assignment();
+    return otherwise ? make(JsAst::Conditional, first, {test, then, otherwise}) : nullptr;
+}
+
+// Operators of one precedence in a row make a single node, so a long concatenation stays flat
+// instead of nesting once per operand.
+Node *Parser::binary(int minimum) {
+    const qsizetype first = i;
+    Node *left = unary();
+    while (left) {
+        const int precedence =
+            token(i).type == JsLexer::Punctuator || token(i).type == JsLexer::Keyword
+                ? binaryPrecedence(text(i))
+                : 0;
+        if (precedence == 0 || precedence < minimum) {
+            break;
+        }
+
+        QList<Node *> operands{left};
+        QList<QStringView> operators;
+        if (precedence == kExponent) {
+            const Nesting nesting(depth);  // right associative, so it nests
+            operators.append(text(i++));
+            Node *right = nesting.tooDeep() ? nullptr : binary(kExponent);
+            if (!right) {
+                return nullptr;
+            }
+            operands.append(right);
+        } else {
+            while ((token(i).type == JsLexer::Punctuator || token(i).type == JsLexer::Keyword) &&
+                   binaryPrecedence(text(i)) == precedence) {
+                operators.append(text(i++));
+                Node *right = binary(precedence + 1);
+                if (!right) {
+                    return nullptr;
+                }
+                operands.append(right);
+            }
+        }
+
+        left = make(JsAst::Binary, first, operands);
+        QStringView *ops = arena.allocateArray<QStringView>(operators.size());
+        std::copy(operators.begin(), operators.end(), ops);
+        left->operators = ops;
+    }
+    return left;
+}
+
+Node *Parser::unary() {
+    const QStringView op = text(i);
+    const bool prefix =
+        (token(i).type == JsLexer::Punctuator &&
+         (op == u"!" || op == u"~" || op == u"+" || op == u"-" || op == u"++" || op == u"--")) ||
+        (token(i).type == JsLexer::Keyword &&
+         (op == u"typeof" || op == u"void" || op == u"delete" || op == u"await"));
+    if (!prefix) {
+        return postfix();
+    }
+
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    const qsizetype first = i++;
+    Node *operand = unary();
+    return operand ? make(JsAst::Unary, first, {operand}, op) : nullptr;
+}
+
+Node *Parser::postfix() {
+    const qsizetype first = i;
+    Node *operand = callChain();
+    if (operand && (isPunctuator(i, u"++") || isPunctuator(i, u"--")) && !newlineBefore(i)) {
+        const QStringView op = text(i++);
+        return make(JsAst::Postfix, first, {operand}, op);
+    }
+    return operand;
+}
+
+// Member accesses, calls and tagged templates after a primary expression. Every link nests the
+// tree one level deeper, so links count against the nesting cap.
+Node *Parser::callChain() {
+    const qsizetype first = i;
+    Node *node = isWord(i, u"new") ? newExpression() : primary();
+    for (int links = depth; node; links++) {
+        if (links > kMaxNesting) {
+            return nullptr;
+        }
+        if (isPunctuator(i, u".") || isPunctuator(i, u"?.")) {
+            const bool optional = text(i++) == u"?.";
+            if (optional && isPunctuator(i, u"(")) {
+                node = call(JsAst::Call, first, node, true);
+            } else if (optional && isPunctuator(i, u"[")) {
+                node = computedMember(first, node, true);
+            } else {
+                node = member(first, node, optional);
+            }
+        } else if (isPunctuator(i, u"[")) {
+            node = computedMember(first, node, false);
+        } else if (isPunctuator(i, u"(")) {
+            node = call(JsAst::Call, first, node, false);
+        } else if (startsTemplate(i)) {
+            node = templateLiteral(first, {node}, kCall);
+        } else {
+            break;
+        }
+    }
+    return node;
+}
+
+Node *Parser::newExpression() {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    const qsizetype first = i++;
+    if (expect(u".")) {
+        i++;  // new.target
+        Node *node = make(JsAst::Identifier, first, {});
+        node->text = source.mid(node->start, node->end - node->start);
+        return node;
+    }
+
+    // The callee takes member accesses but no calls: new a.b() calls a.b as a constructor
+    Node *callee = isWord(i, u"new") ? newExpression() : primary();
+    while (callee) {
+        if (expect(u".")) {
+            callee = member(first + 1, callee, false);
+        } else if (isPunctuator(i, u"[")) {
+            callee = computedMember(first + 1, callee, false);
+        } else if (startsTemplate(i)) {
+            callee = templateLiteral(first + 1, {callee}, kCall);
+        } else {
+            break;
+        }
+    }
+    if (!callee) {
+        return nullptr;
+    }
+    if (!isPunctuator(i, u"(")) {
+        return make(JsAst::New, first, {callee});
+    }
+    Node *node = call(JsAst::New, first, callee, false);
+    if (node) {
+        node->arguments = true;
+    }
+    return node;
+}
+
+Node *Parser::member(qsizetype first, Node *object, bool optional) {
+    const JsLexer::TokenType type = token(i).type;
+    if (type != JsLexer::Identifier && type != JsLexer::Keyword) {
+        return nullptr;
+    }
+    const qsizetype nameToken = i++;
+    Node *name = make(JsAst::Identifier, nameToken, {});
+    name->text = text(nameToken);
+    Node *node = make(JsAst::Member, first, {object, name});
+    node->optional = optional;
+    return node;
+}
+
+Node *Parser::computedMember(qsizetype first, Node *object, bool optional) {
+    i++;
+    Node *property = expression();
+    if (!property || !expect(u"]")) {
+        return nullptr;
+    }
+    Node *node = make(JsAst::Member, first, {object, property});
+    node->computed = true;
+    node->optional = optional;
+    return node;
+}
+
+Node *Parser::call(JsAst::Kind kind, qsizetype first, Node *callee, bool optional) {
+    QList<Node *> children{callee};
+    if (!arguments(children)) {
+        return nullptr;
+    }
+    Node *node = make(kind, first, children);
+    node->optional = optional;
+    return node;
+}
+
+bool Parser::arguments(QList<Node *> &children) {
+    if (!expect(u"(")) {
+        return false;
+    }
+    while (!expect(u")")) {
+        Node *argument = isPunctuator(i, u"...") ? spread() : assignment();
+        if (!argument || (!expect(u",") && !isPunctuator(i, u")"))) {
+            return false;
+        }
+        children.append(argument);
+    }
+    return true;
+}
+
+Node *Parser::spread() {
+    const qsizetype first = i;
+    const QStringView op = text(i++);
+    Node *operand = assignment();
+    return operand ? make(JsAst::Unary, first, {operand}, op) : nullptr;
+}
+
+Node *Parser::primary() {
+    const qsizetype first = i;
+    const QStringView word = text(i);
+    switch (token(i).type) {
+        case JsLexer::Number:
+            return number();
+        case JsLexer::String:
+            return string();
+        case JsLexer::Template:
+            return templateLiteral(first, {}, kPrimary);
+        case JsLexer::Regex:
+            i++;
+            return makeSource(first, {}, kPrimary);
+        case JsLexer::Identifier: {
+            if (word == u"async" && isWord(i + 1, u"function") && !newlineBefore(i + 1)) {
+                return function();
+            }
+            i++;
+            Node *node = make(JsAst::Identifier, first, {});
+            node->text = word;
+            return node;
+        }
+        case JsLexer::Keyword: {
+            if (word == u"function") {
+                return function();
+            }
+            if (word == u"class") {
+                return classNode();
+            }
+            JsAst::Kind kind;
+            if (word == u"true" || word == u"false") {
+                kind = JsAst::Boolean;
+            } else if (word == u"null") {
+                kind = JsAst::Null;
+            } else if (word == u"this" || word == u"super" || word == u"import") {
+                kind = JsAst::Identifier;
+            } else {
+                return nullptr;
+            }
+            i++;
+            Node *node = make(kind, first, {});
+            node->text = word;
+            node->boolean = word == u"true";
+            return node;
+        }
+        case JsLexer::Punctuator:
+            if (word == u"(") {
+                i++;
+                Node *inner = expression();
+                return inner && expect(u")") ? inner : nullptr;
+            }
+            if (word == u"[") {
+                return array();
+            }
+            if (word == u"{") {
+                return object();
+            }
+            return nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+Node *Parser::number() {
+    const qsizetype first = i++;
+    double value = 0;
+    if (!numberValue(text(first), value)) {
+        return makeSource(first, {}, kPrimary);
+    }
+    Node *node = make(JsAst::Number, first, {});
+    node->number = value;
+    node->text = text(first);
+    return node;
+}
+
+// The value points into the source when the literal has no escapes, and into the arena when
+// it does.
+Node *Parser::string() {
+    const qsizetype first = i++;
+    const QStringView literal = text(first);
+    QString value;
+    if (!JsLexer::stringValue(literal, value)) {
+        return makeSource(first, {}, kPrimary);
+    }
+    Node *node = make(JsAst::String, first, {});
+    if (value.size() == literal.size() - 2) {
+        node->text = literal.mid(1, value.size());
+    } else {
+        char16_t *data = arena.allocateArray<char16_t>(value.size());
+        std::memcpy(data, value.utf16(), value.size() * sizeof(char16_t));
+        node->text = QStringView(data, value.size());
+    }
+    return node;
+}
+
+// A whole `...` token, or a head, middles and tail around the substitutions. A tag comes in as
+// the first child.
+Node *Parser::templateLiteral(qsizetype first, QList<Node *> children, int precedence) {
+    while (token(i).type == JsLexer::Template && text(i).endsWith(u"${")) {
+        i++;
+        Node *substitution = expression();
+        if (!substitution || token(i).type != JsLexer::Template || !text(i).startsWith('}')) {
+            return nullptr;
+        }
+        children.append(substitution);
+    }
+    i++;
+    return makeSource(first, children, precedence);
+}
+
+// Holes make the array source text, since the printer has no spelling for them
+Node *Parser::array() {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    const qsizetype first = i++;
+    QList<Node *> elements;
+    bool holes = false;
+    while (!expect(u"]")) {
+        if (expect(u",")) {
+            holes = true;
+            continue;
+        }
+        Node *element = isPunctuator(i, u"...") ? spread() : assignment();
+        if (!element || (!expect(u",") && !isPunctuator(i, u"]"))) {
+            return nullptr;
+        }
+        elements.append(element);
+    }
+    return holes ? makeSource(first, elements, kPrimary)
+                 : make(JsAst::Array, first, elements);
+}
+
+Node *Parser::object() {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    const qsizetype first = i++;
+    QList<Node *> children;
+    while (!expect(u"}")) {
+        if (!property(children, false) || (!expect(u",") && !isPunctuator(i, u"}"))) {
+            return nullptr;
+        }
+    }
+    return makeSource(first, children, kPrimary);
+}
+
+// One member of an object literal or class body. Keys stay source text; computed keys, values,
+// field initializers and method bodies are parsed.
+bool Parser::property(QList<Node *> &children, bool inClass) {
+    if (isPunctuator(i, u"...")) {
+        Node *value = spread();
+        if (value) {
+            children.append(value);
+        }
+        return value;
+    }
+
+    // get, set, async, static and accessor are modifiers unless they are the key themselves
+    auto isKeyEnd = [this](qsizetype k) {
+        return isPunctuator(k, u"(") || isPunctuator(k, u":") || isPunctuator(k, u",") ||
+               isPunctuator(k, u"}") || isPunctuator(k, u"=") || isPunctuator(k, u";") ||
+               newlineBefore(k);
+    };
+    while ((isWord(i, u"get") || isWord(i, u"set") || isWord(i, u"async") ||
+            isWord(i, u"static") || isWord(i, u"accessor")) &&
+           !isKeyEnd(i + 1)) {
+        i++;
+    }
+    expect(u"*");
+
+    if (expect(u"[")) {
+        Node *key = assignment();
+        if (!key || !expect(u"]")) {
+            return false;
+        }
+        children.append(key);
+    } else if (token(i).type == JsLexer::Identifier || token(i).type == JsLexer::Keyword ||
+               token(i).type == JsLexer::String || token(i).type == JsLexer::Number) {
+        i++;
+    } else {
+        return false;
+    }
+
+    if (isPunctuator(i, u"(")) {
+        if (matching(i) < 0) {
+            return false;
+        }
+        i = matching(i) + 1;  // parameters
+        return body(children);
+    }
+    if (isPunctuator(i, u"=") || (!inClass && isPunctuator(i, u":"))) {
+        i++;
+        Node *value = assignment();
+        if (!value) {
+            return false;
+        }
+        children.append(value);
+    }
+    return true;
+}
+
+Node *Parser::function() {
+    const qsizetype first = i;
+    if (isWord(i, u"async")) {
+        i++;
+    }
+    i++;
+    expect(u"*");
+    if (token(i).type == JsLexer::Identifier) {
+        i++;
+    }
+    if (!isPunctuator(i, u"(") || matching(i) < 0) {
+        return nullptr;
+    }
+    i = matching(i) + 1;  // parameters
+
+    QList<Node *> children;
+    return body(children) ? makeSource(first, children, kPrimary) : nullptr;
+}
+
+Node *Parser::classNode() {
+    const Nesting nesting(depth);
+    if (nesting.tooDeep()) {
+        return nullptr;
+    }
+    const qsizetype first = i++;
+    if (token(i).type == JsLexer::Identifier) {
+        i++;
+    }
+    QList<Node *> children;
+    if (isWord(i, u"extends")) {
+        i++;
+        Node *heritage = callChain();
+        if (!heritage) {
+            return nullptr;
+        }
+        children.append(heritage);
+    }
+    if (!expect(u"{")) {
+        return nullptr;
+    }
+    while (!expect(u"}")) {
+        if (expect(u";")) {
+            continue;
+        }
+        if (isWord(i, u"static") && isPunctuator(i + 1, u"{")) {
+            i++;
+            if (!body(children)) {
+                return nullptr;
+            }
+        } else if (atEnd() || !property(children, true)) {
+            return nullptr;
+        }
+    }
+    return makeSource(first, children, kPrimary);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Constant folding
+// ---------------------------------------------------------------------------------------------
+
+struct Constant {
+    enum Type { None, Undefined, Null, Boolean, Number, String, EmptyArray };
+
+    Type type = None;
+    bool boolean = false;
+    double number = 0;
+    QString string;
+};
+
+Constant numberConstant(double value) {
+    Constant constant;
+    constant.type = Constant::Number;
+    constant.number = value;
+    return constant;
+}
+
+Constant stringConstant(const QString &value) {
+    Constant constant;
+    constant.type = Constant::String;
+    constant.string = value;
+    return constant;
+}
+
+Constant booleanConstant(bool value) {
+    Constant constant;
+    constant.type = Constant::Boolean;
+    constant.boolean = value;
+    return constant;
+}
+
+Constant constantOf(const Node *node) {
+    Constant constant;
+    switch (node->kind) {
+        case JsAst::Number:
+            return numberConstant(node->number);
+        case JsAst::String:
+            return stringConstant(node->text.toString());
+        case JsAst::Boolean:
+            return booleanConstant(node->boolean);
+        case JsAst::Null:
+            constant.type = Constant::Null;
+            break;
+        case JsAst::Array:
+            constant.type = node->count == 0 ? Constant::EmptyArray : Constant::None;
+            break;
+        case JsAst::Unary:
+            // void 0 and the like, and negative numbers, which are not literals of their own
+            if (node->operators[0] == u"void" &&
+                constantOf(node->children[0]).type != Constant::None) {
+                constant.type = Constant::Undefined;
+            } else if (node->operators[0] == u"-" && node->children[0]->kind == JsAst::Number) {
+                return numberConstant(-node->children[0]->number);
+            }
+            break;
+        default:
+            break;
+    }
+    return constant;
+}
+
+// ToNumber of a string: decimal, Infinity, or 0x/0o/0b integers, blanks around it ignored
+double stringToNumber(QStringView text) {
+    text = text.trimmed();
+    if (text.isEmpty()) {
+        return 0;
+    }
+    const double nan = std::nan("");
+    if (text.size() > 2 && text[0] == '0' && !text[1].isDigit() && text[1] != '.' &&
+        (text[1].unicode() | 0x20) != 'e') {
+        double value = 0;
+        return numberValue(text, value) && !text.contains('_') ? value : nan;
+    }
+
+    const QStringView unsigned_ = text.front() == '+' || text.front() == '-' ? text.mid(1) : text;
+    if (unsigned_ == u"Infinity") {
+        return text.front() == '-' ? -INFINITY : INFINITY;
+    }
+    qsizetype k = 0;
+    qsizetype digits = 0;
+    auto skipDigits = [&] {
+        while (k < unsigned_.size() && unsigned_[k].unicode() >= '0' &&
+               unsigned_[k].unicode() <= '9') {
+            k++;
+            digits++;
+        }
+    };
+    skipDigits();
+    if (k < unsigned_.size() && unsigned_[k] == '.') {
+        k++;
+        skipDigits();
+    }
+    if (digits == 0) {
+        return nan;
+    }
+    if (k < unsigned_.size() && (unsigned_[k] == 'e' || unsigned_[k] == 'E')) {
+        k++;
+        if (k < unsigned_.size() && (unsigned_[k] == '+' || unsigned_[k] == '-')) {
+            k++;
+        }
+        digits = 0;
+        skipDigits();
+        if (digits == 0) {
+            return nan;
+        }
+    }
+    return k == unsigned_.size() ? text.toString().toDouble() : nan;
+}
+
+Constant toPrimitive(const Constant &value) {
+    return value.type == Constant::EmptyArray ? stringConstant(QString()) : value;
+}
+
+bool toStringPrimitive(const Constant &value) {
+    return value.type == Constant::String || value.type == Constant::EmptyArray;
+}
+
+double toNumber(const Constant &value) {
+    switch (value.type) {
+        case Constant::Null:
+        case Constant::EmptyArray:
+            return 0;
+        case Constant::Boolean:
+            return value.boolean ? 1 : 0;
+        case Constant::Number:
+            return value.number;
+        case Constant::String:
+            return stringToNumber(value.string);
+        default:
+            return std::nan("");
+    }
+}
+
+QString toString(const Constant &value) {
+    switch (value.type) {
+        case Constant::Undefined:
+            return "undefined";
+        case Constant::Null:
+            return "null";
+        case Constant::Boolean:
+            return value.boolean ? "true" : "false";
+        case Constant::Number:
+            return std::isnan(value.number)   ? QString("NaN")
+                   : std::isinf(value.number) ? QString(value.number < 0 ? "-Infinity" : "Infinity")
+                                              : numberText(value.number);
+        case Constant::String:
+            return value.string;
+        default:
+            return QString();
+    }
+}
+
+bool truthy(const Constant &value) {
+    switch (value.type) {
+        case Constant::Boolean:
+            return value.boolean;
+        case Constant::Number:
+            return value.number != 0 && !std::isnan(value.number);
+        case Constant::String:
+            return !value.string.isEmpty();
+        case Constant::EmptyArray:
+            return true;
+        default:
+            return false;
+    }
+}
+
+double toInt32(double value) {
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    double wrapped = std::fmod(std::trunc(value), 4294967296.0);
+    if (wrapped < 0) {
+        wrapped += 4294967296.0;
+    }
+    return wrapped >= 2147483648.0 ? wrapped - 4294967296.0 : wrapped;
+}
+
+quint32 toUint32(double value) {
+    return quint32(qint64(toInt32(value)));
+}
+
+bool strictEquals(const Constant &left, const Constant &right) {
+    if (left.type != right.type) {
+        return false;
+    }
+    switch (left.type) {
+        case Constant::Boolean:
+            return left.boolean == right.boolean;
+        case Constant::Number:
+            return left.number == right.number;
+        case Constant::String:
+            return left.string == right.string;
+        case Constant::EmptyArray:
+            return false;  // two literals are two objects
+        default:
+            return true;
+    }
+}
+
+bool looseEquals(const Constant &left, const Constant &right) {
+    if (left.type == right.type) {
+        return strictEquals(left, right);
+    }
+    const bool leftNullish = left.type == Constant::Null || left.type == Constant::Undefined;
+    const bool rightNullish = right.type == Constant::Null || right.type == Constant::Undefined;
+    if (leftNullish || rightNullish) {
+        return leftNullish && rightNullish;
+    }
+    if (left.type == Constant::EmptyArray || right.type == Constant::EmptyArray) {
+        return looseEquals(toPrimitive(left), toPrimitive(right));
+    }
+    return toNumber(left) == toNumber(right);
+}
+
+QString typeOf(const Constant &value) {
+    switch (value.type) {
+        case Constant::Undefined:
+            return "undefined";
+        case Constant::Boolean:
+            return "boolean";
+        case Constant::Number:
+            return "number";
+        case Constant::String:
+            return "string";
+        default:
+            return "object";
+    }
+}
+
+// `left op right` for two constants; None when the operator is not one that folds
+Constant evaluate(const Constant &left, QStringView op, const Constant &right) {
+    if (op == u"+") {
+        const Constant a = toPrimitive(left);
+        const Constant b = toPrimitive(right);
+        if (a.type == Constant::String || b.type == Constant::String) {
+            return stringConstant(toString(a) + toString(b));
+        }
+        return numberConstant(toNumber(a) + toNumber(b));
+    }
+    if (op == u"===" || op == u"!==") {
+        return booleanConstant(strictEquals(left, right) == (op == u"==="));
+    }
+    if (op == u"==" || op == u"!=") {
+        return booleanConstant(looseEquals(left, right) == (op == u"=="));
+    }
+    if (op == u"<" || op == u">" || op == u"<=" || op == u">=") {
+        const Constant a = toPrimitive(left);
+        const Constant b = toPrimitive(right);
+        const bool swap = op == u">" || op == u"<=";
+        const Constant &first = swap ? b : a;
+        const Constant &second = swap ? a : b;
+        bool less = false;
+        bool undefined = false;  // a comparison with NaN
+        if (first.type == Constant::String && second.type == Constant::String) {
+            less = first.string < second.string;
+        } else {
+            const double x = toNumber(first);
+            const double y = toNumber(second);
+            undefined = std::isnan(x) || std::isnan(y);
+            less = x < y;
+        }
+        // a <= b is !(b < a), except that NaN makes both false
+        const bool negate = op == u"<=" || op == u">=";
+        return booleanConstant(!undefined && less != negate);
+    }
+
+    const double a = toNumber(left);
+    const double b = toNumber(right);
+    if (op == u"-") {
+        return numberConstant(a - b);
+    }
+    if (op == u"*") {
+        return numberConstant(a * b);
+    }
+    if (op == u"/") {
+        return numberConstant(a / b);
+    }
+    if (op == u"%") {
+        return numberConstant(std::fmod(a, b));
+    }
+    if (op == u"**") {
+        const bool nan = std::isnan(b) || (std::abs(a) == 1 && std::isinf(b));
+        return numberConstant(nan ? std::nan("") : std::pow(a, b));
+    }
+
+    const qint32 x = qint32(toInt32(a));
+    const quint32 shift = toUint32(b) & 31;
+    if (op == u"<<") {
+        return numberConstant(qint32(quint32(x) << shift));
+    }
+    if (op == u">>") {
+        return numberConstant(x >> shift);
+    }
+    if (op == u">>>") {
+        return numberConstant(quint32(x) >> shift);
+    }
+    const qint32 y = qint32(toInt32(b));
+    if (op == u"&") {
+        return numberConstant(x & y);
+    }
+    if (op == u"|") {
+        return numberConstant(x | y);
+    }
+    if (op == u"^") {
+        return numberConstant(x ^ y);
+    }
+    return Constant();
+}
+
+// Whether the value can be written as a literal; undefined, NaN and Infinity cannot
+bool hasLiteral(const Constant &value) {
+    switch (value.type) {
+        case Constant::Null:
+        case Constant::Boolean:
+        case Constant::String:
+            return true;
+        case Constant::Number:
+            return std::isfinite(value.number);
+        default:
+            return false;
+    }
+}
+
+// run + value where the result is a string, appending in place
+void append(Constant &run, const Constant &value) {
+    if (run.type != Constant::String) {
+        run = stringConstant(toString(toPrimitive(run)));
+    }
+    run.string += toString(toPrimitive(value));
+}
+
+class Folder {
+  public:
+    Folder(Arena &arena, qsizetype &nodes, Deadline *deadline)
+        : arena(arena), nodes(nodes), deadline(deadline) {}
+
+    // Folds the children first; returns the node to use in place of `node`. `target` is set
+    // for what an assignment, ++, -- or delete writes to. Past the deadline nodes are returned
+    // as they are.
+    Node *fold(Node *node, bool target);
+
+    int replaced = 0;
+
+  private:
+    Node *constantNode(const Constant &value, const Node *original);
+    Node *foldUnary(Node *node);
+    Node *foldChain(Node *node);
+    Node *foldLogical(Node *node);
+    Node *foldMember(Node *node, bool target);
+    void setOperands(Node *node, const QList<Node *> &operands, QList<QStringView> operators);
+
+    Arena &arena;
+    qsizetype &nodes;
+    Deadline *deadline;
+};
+
+bool writesOperand(const Node *node) {
+    if (node->kind == JsAst::Postfix || node->kind == JsAst::Assignment) {
+        return true;
+    }
+    return node->kind == JsAst::Unary &&
+           (node->operators[0] == u"++" || node->operators[0] == u"--" ||
+            node->operators[0] == u"delete");
+}
+
+Node *Folder::fold(Node *node, bool target) {
+    if (deadline && deadline->expired()) {
+        return node;
+    }
+    for (int k = 0; k < node->count; k++) {
+        Node *child = node->children[k];
+        Node *folded = fold(child, k == 0 && writesOperand(node));
+        if (folded != child) {
+            folded->statement = child->statement;
+            node->children[k] = folded;
+            node->changed = true;
+        } else if (child->changed) {
+            node->changed = true;
+        }
+    }
+
+    switch (node->kind) {
+        case JsAst::Number:
+            if (!node->changed && isNonDecimal(node->text)) {
+                node->changed = true;
+                replaced++;
+            }
+            return node;
+        case JsAst::Unary:
+            return foldUnary(node);
+        case JsAst::Binary:
+            return isLogical(node->operators[0]) ? foldLogical(node) : foldChain(node);
+        case JsAst::Conditional: {
+            const Constant test = constantOf(node->children[0]);
+            if (test.type == Constant::None) {
+                return node;
+            }
+            replaced++;
+            return node->children[truthy(test) ? 1 : 2];
+        }
+        case JsAst::Member:
+            return foldMember(node, target);
+        default:
+            return node;
+    }
+}
+
+// Values without a literal spelling (undefined, NaN, Infinity) are left as the expression
+Node *Folder::constantNode(const Constant &value, const Node *original) {
+    if (!hasLiteral(value)) {
+        return nullptr;
+    }
+    const JsAst::Kind kind = value.type == Constant::Null      ? JsAst::Null
+                             : value.type == Constant::Boolean ? JsAst::Boolean
+                             : value.type == Constant::Number  ? JsAst::Number
+                                                               : JsAst::String;
+
+    Node *node = arena.create<Node>();
+    node->kind = kind;
+    node->changed = true;
+    node->precedence = kPrimary;
+    node->start = original->start;
+    node->end = original->end;
+    node->boolean = value.boolean;
+    node->number = value.number;
+    if (kind == JsAst::String) {
+        char16_t *data = arena.allocateArray<char16_t>(value.string.size());
+        std::memcpy(data, value.string.utf16(), value.string.size() * sizeof(char16_t));
+        node->text = QStringView(data, value.string.size());
+    }
+    nodes++;
+    replaced++;
+    return node;
+}
+
+Node *Folder::foldUnary(Node *node) {
+    const QStringView op = node->operators[0];
+    const Node *operand = node->children[0];
+    const Constant value = constantOf(operand);
+    if (value.type == Constant::None) {
+        return node;
+    }
+    // -1 as written is already as plain as it gets
+    if (op == u"-" && operand->kind == JsAst::Number && !operand->changed) {
+        return node;
+    }
+
+    Constant result;
+    if (op == u"!") {
+        result = booleanConstant(!truthy(value));
+    } else if (op == u"-") {
+        result = numberConstant(-toNumber(value));
+    } else if (op == u"+") {
+        result = numberConstant(toNumber(value));
+    } else if (op == u"~") {
+        result = numberConstant(~qint32(toInt32(toNumber(value))));
+    } else if (op == u"typeof") {
+        result = stringConstant(typeOf(value));
+    }
+    Node *folded = constantNode(result, node);
+    return folded ? folded : node;
+}
+
+// Constants at the start of a chain fold left to right. Past that, a + b + "x" + 1 still
+// becomes a + b + "x1": once an operand is known to make the running value a string, the
+// operands after it only append, so neighbouring constants can be joined. A run of constants
+// is built up in place and becomes one node at its end, so a long concatenation stays linear.
+Node *Folder::foldChain(Node *node) {
+    QList<Node *> operands{node->children[0]};
+    QList<QStringView> operators;
+    Constant run = constantOf(node->children[0]);  // value of the last operand
+    qsizetype runEnd = node->children[0]->end;
+    bool merged = false;            // the last operand stands for several
+    bool stringBeforeLast = false;  // the running value before the last operand
+    bool stringThroughLast = run.type == Constant::String;
+    auto flush = [&] {
+        if (merged) {
+            Node *constant = constantNode(run, operands.last());
+            constant->end = runEnd;
+            operands.last() = constant;
+            merged = false;
+        }
+    };
+
+    for (int k = 1; k < node->count; k++) {
+        const QStringView op = node->operators[k - 1];
+        Node *right = node->children[k];
+        const Constant value = constantOf(right);
+
+        bool merge = false;
+        if (run.type != Constant::None && value.type != Constant::None) {
+            const bool concatenates =
+                op == u"+" && (toStringPrimitive(run) || toStringPrimitive(value));
+            if (operands.size() == 1 && !concatenates) {
+                const Constant result = evaluate(run, op, value);
+                if (hasLiteral(result)) {
+                    run = result;
+                    merge = true;
+                }
+            } else if (operands.size() == 1 ||
+                       (op == u"+" && operators.last() == u"+" &&
+                        (run.type == Constant::String || stringBeforeLast))) {
+                append(run, value);
+                merge = true;
+            }
+        }
+
+        if (merge) {
+            runEnd = right->end;
+            merged = true;
+            stringThroughLast = run.type == Constant::String;
+        } else {
+            flush();
+            stringBeforeLast = stringThroughLast;
+            stringThroughLast = op == u"+" && (stringThroughLast || value.type == Constant::String);
+            operators.append(op);
+            operands.append(right);
+            run = value;
+            runEnd = right->end;
+        }
+    }
+    flush();
+
+    if (operands.size() == node->count) {
+        return node;
+    }
+    if (operands.size() == 1) {
+        return operands.first();
+    }
+    setOperands(node, operands, operators);
+    return node;
+}
+
+// A constant operand either decides the result, ending the chain there, or passes control on
+// and can be dropped: 1 && a is a, 0 && a is 0, a || false || b is a || b.
+Node *Folder::foldLogical(Node *node) {
+    const QStringView op = node->operators[0];
+    QList<Node *> kept;
+    for (int k = 0; k < node->count; k++) {
+        Node *operand = node->children[k];
+        const Constant value = constantOf(operand);
+        if (value.type == Constant::None || k == node->count - 1) {
+            kept.append(operand);
+            continue;
+        }
+        const bool decides =
+            op == u"&&"   ? !truthy(value)
+            : op == u"||" ? truthy(value)
+                          : value.type != Constant::Null && value.type != Constant::Undefined;
+        if (decides) {
+            kept.append(operand);
+            break;
+        }
+    }
+
+    if (kept.size() == node->count) {
+        return node;
+    }
+    replaced += node->count - int(kept.size());
+    if (kept.size() == 1) {
+        return kept.first();
+    }
+    setOperands(node, kept, QList<QStringView>(kept.size() - 1, op));
+    return node;
+}
+
+// "abc"[1] and "abc".length fold; obj["name"] is rewritten as obj.name
+Node *Folder::foldMember(Node *node, bool target) {
+    Node *object = node->children[0];
+    Node *property = node->children[1];
+    if (node->computed && property->kind == JsAst::String && isIdentifierName(property->text)) {
+        node->computed = false;
+        node->changed = true;
+        property->kind = JsAst::Identifier;
+        property->changed = true;
+        replaced++;
+    }
+    if (target || object->kind != JsAst::String) {
+        return node;
+    }
+
+    if (!node->computed && property->text == u"length") {
+        Node *folded = constantNode(numberConstant(object->text.size()), node);
+        return folded ? folded : node;
+    }
+    const Constant key = constantOf(property);
+    if (node->computed && key.type == Constant::Number && key.number >= 0 &&
+        key.number < object->text.size() && key.number == std::trunc(key.number)) {
+        const QString character = object->text.mid(qsizetype(key.number), 1).toString();
+        Node *folded = constantNode(stringConstant(character), node);
+        return folded ? folded : node;
+    }
+    return node;
+}
+
+// The node keeps its arrays, which only ever shrink here
+void Folder::setOperands(Node *node, const QList<Node *> &operands,
+                         QList<QStringView> operators) {
+    std::copy(operands.begin(), operands.end(), node->children);
+    node->count = int(operands.size());
+    QStringView *ops = const_cast<QStringView *>(node->operators);
+    std::copy(operators.begin(), operators.end(), ops);
+    node->changed = true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// String arrays
+// ---------------------------------------------------------------------------------------------
+
+bool isLiteral(const Node *node) {
+    return node->kind == JsAst::Number || node->kind == JsAst::String ||
+           node->kind == JsAst::Boolean || node->kind == JsAst::Null;
+}
+
+// Element of `array` that `read` (a computed member access on it) picks, if that is constant
+const Node *element(const Node *array, const Node *read) {
+    const Constant key = constantOf(read->children[1]);
+    double index = key.type == Constant::Number ? key.number : std::nan("");
+    if (key.type == Constant::String && !key.string.isEmpty() &&
+        numberText(stringToNumber(key.string)) == key.string) {
+        index = stringToNumber(key.string);  // arr["2"]
+    }
+    if (!(index >= 0 && index < array->count) || index != std::trunc(index)) {
+        return nullptr;
+    }
+    return array->children[qsizetype(index)];
+}
+
+class ArrayInliner {
+  public:
+    ArrayInliner(const QHash<QStringView, Node *> &arrays, Deadline *deadline)
+        : arrays(arrays), deadline(deadline) {}
+
+    // Counts the reads of each array, and rejects arrays used any other way. A count cut short
+    // by the deadline must not be used.
+    void count(const Node *node, bool target);
+    // Replaces the reads, until the deadline; true if anything under `node` changed
+    bool replace(Node *node, Arena &arena);
+
+    QHash<QStringView, int> reads;  // -1 once the array must be left alone
+    int replaced = 0;
+
+  private:
+    const Node *arrayRead(const Node *node) const;
+
+    const QHash<QStringView, Node *> &arrays;
+    Deadline *deadline;
+};
+
+const Node *ArrayInliner::arrayRead(const Node *node) const {
+    if (node->kind != JsAst::Member || !node->computed || node->optional ||
+        node->children[0]->kind != JsAst::Identifier) {
+        return nullptr;
+    }
+    return arrays.value(node->children[0]->text);
+}
+
+void ArrayInliner::count(const Node *node, bool target) {
+    if (deadline && deadline->expired()) {
+        return;
+    }
+    if (const Node *array = arrayRead(node)) {
+        int &n = reads[node->children[0]->text];
+        n = n < 0 || target || !element(array, node) ? -1 : n + 1;
+        count(node->children[1], false);
+        return;
+    }
+    if (node->kind == JsAst::Identifier && arrays.contains(node->text)) {
+        reads[node->text] = -1;
+        return;
+    }
+    for (int k = 0; k < node->count; k++) {
+        // The name after a dot is not a variable
+        if (node->kind != JsAst::Member || node->computed || k == 0) {
+            count(node->children[k], k == 0 && writesOperand(node));
+        }
+    }
+}
+
+bool ArrayInliner::replace(Node *node, Arena &arena) {
+    bool changed = false;
+    for (int k = 0; k < node->count && !(deadline && deadline->expired()); k++) {
+        Node *child = node->children[k];
+        const Node *array = arrayRead(child);
+        if (array && reads.value(child->children[0]->text) > 0) {
+            Node *copy = arena.create<Node>(*element(array, child));
+            copy->changed = true;
+            copy->statement = child->statement;
+            node->children[k] = copy;
+            replaced++;
+            changed = true;
+        } else if (replace(child, arena)) {
+            changed = true;
+        }
+    }
+    node->changed |= changed;
+    return changed;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Printing
+// ---------------------------------------------------------------------------------------------
+
+int precedenceOf(const Node *node) {
+    switch (node->kind) {
+        case JsAst::Number:
+            return std::signbit(node->number) ? kUnary : kPrimary;
+        case JsAst::Unary:
+            return node->operators[0] == u"..." ? kAssignment : kUnary;
+        case JsAst::Postfix:
+            return kPostfix;
+        case JsAst::Binary:
+            return binaryPrecedence(node->operators[0]);
+        case JsAst::Conditional:
+            return kConditional;
+        case JsAst::Assignment:
+            return kAssignment;
+        case JsAst::Sequence:
+            return kSequence;
+        case JsAst::Call:
+        case JsAst::Member:
+            return kCall;
+        case JsAst::New:
+            return node->arguments ? kCall : kNew;
+        case JsAst::Source:
+            return node->precedence;
+        default:
+            return kPrimary;
+    }
+}
+
+// new (a().b)() must keep its parentheses, or the call would bind to new
+bool hasCall(const Node *node) {
+    while (node->kind == JsAst::Member ||
+           (node->kind == JsAst::Source && node->precedence == kCall)) {
+        node = node->children[0];
+    }
+    return node->kind == JsAst::Call;
+}
+
+// ?? cannot be mixed with && or || without parentheses
+bool mixesNullish(const Node *parent, const Node *child) {
+    if (child->kind != JsAst::Binary || !isLogical(child->operators[0])) {
+        return false;
+    }
+    return (parent->operators[0] == u"??") != (child->operators[0] == u"??");
+}
+
+// Would be read as a declaration or a block at the start of a statement
+bool startsLikeDeclaration(QStringView text) {
+    return text.startsWith(u"function") || text.startsWith(u"class") ||
+           text.startsWith(u"async function") || text.startsWith('{') ||
+           text.startsWith(u"let[") || text.startsWith(u"let [");
+}
+
+class Printer {
+  public:
+    Printer(QStringView source, Deadline *deadline) : source(source), deadline(deadline) {
+        output.reserve(source.size());
+    }
+
+    // Prints nothing more once the deadline has expired
+    void print(const Node *node, int minimum, bool parenthesize = false);
+
+    QString output;
+
+  private:
+    void printStructure(const Node *node);
+    void printSource(const Node *node);
+    void printList(const Node *node, int first, QStringView separator);
+    void separate(qsizetype joint);
+    bool inParentheses(qsizetype start, qsizetype end) const;
+
+    QStringView source;
+    Deadline *deadline;
+};
+
+void Printer::print(const Node *node, int minimum, bool parenthesize) {
+    if (deadline && deadline->expired()) {
+        return;
+    }
+    parenthesize = parenthesize || precedenceOf(node) < minimum;
+    if (parenthesize) {
+        output += '(';
+    }
+    if (node->kind == JsAst::Source) {
+        printSource(node);
+    } else if (!node->changed) {
+        output += source.mid(node->start, node->end - node->start);
+    } else {
+        printStructure(node);
+    }
+    if (parenthesize) {
+        output += ')';
+    }
+}
+
+// Source text between the children as written. A changed child gets the parentheses its new
+// shape needs in that spot, unless the source already has them.
+void Printer::printSource(const Node *node) {
+    qsizetype pos = node->start;
+    qsizetype joint = -1;  // where a changed child's text ended
+    for (int k = 0; k < node->count; k++) {
+        const Node *child = node->children[k];
+        const qsizetype start = node->bounds[2 * k];
+        const qsizetype end = node->bounds[2 * k + 1];
+        output += source.mid(pos, start - pos);
+        separate(joint);
+        pos = end;
+        joint = -1;
+        if (!child->changed) {
+            print(child, kSequence);
+            continue;
+        }
+
+        const qsizetype mark = output.size();
+        if (inParentheses(start, end)) {
+            print(child, kSequence);
+        } else if (child->statement) {
+            print(child, kSequence);
+            if (startsLikeDeclaration(QStringView(output).mid(mark))) {
+                output.insert(mark, '(');
+                output += ')';
+            }
+        } else {
+            print(child, k == 0 && node->precedence == kCall ? kCall : kAssignment);
+        }
+        separate(mark);
+        joint = output.size();
+    }
+    output += source.mid(pos, node->end - pos);
+    separate(joint);
+}
+
+// return!0 printed as return true needs a space it did not have before
+void Printer::separate(qsizetype joint) {
+    if (joint <= 0 || joint >= output.size()) {
+        return;
+    }
+    auto isWordCharacter = [](QChar ch) {
+        return ch.isLetterOrNumber() || ch == '_' || ch == '$' || ch == '\\' ||
+               ch.unicode() >= 0x80;
+    };
+    const QChar before = output[joint - 1];
+    const QChar after = output[joint];
+    if ((isWordCharacter(before) && isWordCharacter(after)) ||
+        (before == after && (before == '+' || before == '-'))) {
+        output.insert(joint, ' ');
+    }
+}
+
+bool Printer::inParentheses(qsizetype start, qsizetype end) const {
+    while (start > 0 && source[start - 1].isSpace()) {
+        start--;
+    }
+    while (end < source.size() && source[end].isSpace()) {
+        end++;
+    }
+    return start > 0 && source[start - 1] == '(' && end < source.size() && source[end] == ')';
+}
+
+void Printer::printList(const Node *node, int first, QStringView separator) {
+    for (int k = first; k < node->count; k++) {
+        if (k > first) {
+            output += separator;
+        }
+        print(node->children[k], kAssignment);
+    }
+}
+
+void Printer::printStructure(const Node *node) {
+    const Node *const *children = node->children;
+    switch (node->kind) {
+        case JsAst::Number:
+            output += numberText(node->number);
+            break;
+        case JsAst::String:
+            output += JsLexer::quote(node->text);
+            break;
+        case JsAst::Boolean:
+            output += node->boolean ? u"true" : u"false";
+            break;
+        case JsAst::Null:
+            output += u"null";
+            break;
+        case JsAst::Identifier:
+            output += node->text;
+            break;
+        case JsAst::Array:
+            output += '[';
+            printList(node, 0, u", ");
+            output += ']';
+            break;
+        case JsAst::Unary: {
+            const QStringView op = node->operators[0];
+            output += op;
+            if (op == u"...") {
+                print(children[0], kAssignment);
+                break;
+            }
+            if (op.front().isLetter()) {
+                output += ' ';
+            }
+            const qsizetype mark = output.size();
+            print(children[0], kUnary);
+            // - -x, not --x
+            if ((op.back() == '+' || op.back() == '-') && mark < output.size() &&
+                (output[mark] == '+' || output[mark] == '-')) {
+                output.insert(mark, ' ');
+            }
+            break;
+        }
+        case JsAst::Postfix:
+            print(children[0], kCall);
+            output += node->operators[0];
+            break;
+        case JsAst::Binary: {
+            const int precedence = binaryPrecedence(node->operators[0]);
+            for (int k = 0; k < node->count; k++) {
+                if (k > 0) {
+                    output += ' ';
+                    output += node->operators[k - 1];
+                    output += ' ';
+                }
+                // ** groups to the right, and takes no unary operator on its left
+                int minimum = k == 0 ? precedence : precedence + 1;
+                if (precedence == kExponent) {
+                    minimum = k == 0 ? kPostfix : kExponent;
+                }
+                print(children[k], minimum, mixesNullish(node, children[k]));
+            }
+            break;
+        }
+        case JsAst::Conditional:
+            print(children[0], kNullish);
+            output += u" ? ";
+            print(children[1], kAssignment);
+            output += u" : ";
+            print(children[2], kAssignment);
+            break;
+        case JsAst::Assignment:
+            print(children[0], kCall);
+            output += ' ';
+            output += node->operators[0];
+            output += ' ';
+            print(children[1], kAssignment);
+            break;
+        case JsAst::Sequence:
+            printList(node, 0, u", ");
+            break;
+        case JsAst::Call:
+            print(children[0], kCall);
+            output += node->optional ? u"?.(" : u"(";
+            printList(node, 1, u", ");
+            output += ')';
+            break;
+        case JsAst::New:
+            output += u"new ";
+            print(children[0], kCall, hasCall(children[0]));
+            if (node->arguments) {
+                output += '(';
+                printList(node, 1, u", ");
+                output += ')';
+            }
+            break;
+        case JsAst::Member:
+            print(children[0], kCall, children[0]->kind == JsAst::Number);  // (1).toString()
+            if (node->computed) {
+                output += node->optional ? u"?.[" : u"[";
+                print(children[1], kSequence);
+                output += ']';
+            } else {
+                output += node->optional ? u"?." : u".";
+                output += children[1]->text;
+            }
+            break;
+        case JsAst::Source:
+            break;
+    }
+}
+
+}  // namespace
+
+void JsAst::parse(const QString &script, Deadline *deadline) {
+    source = script;
+    arena = Arena();
+    Parser parser(source, arena, deadline);
+    rootNode = parser.program();
+    nodes = parser.nodeCount();
+    arrays = parser.arrays;
+    mentions = parser.mentions;
+    if (parser.interrupted()) {
+        rootNode = nullptr;
+        nodes = 0;
+        arrays.clear();
+        mentions.clear();
+    }
+}
+
+int JsAst::foldConstants(Deadline *deadline) {
+    if (!rootNode) {
+        return 0;
+    }
+    Folder folder(arena, nodes, deadline);
+    folder.fold(rootNode, false);
+    return folder.replaced;
+}
+
+int JsAst::inlineStringArrays(Deadline *deadline) {
+    if (!rootNode || arrays.isEmpty()) {
+        return 0;
+    }
+    QHash<QStringView, Node *> candidates;
+    for (const QStringView &name : arrays.keys()) {
+        Node *array = arrays.value(name);
+        if (array && array->count > 0 &&
+            std::all_of(array->children, array->children + array->count, isLiteral)) {
+            candidates.insert(name, array);
+        }
+    }
+
+    ArrayInliner inliner(candidates, deadline);
+    inliner.count(rootNode, false);
+    if (deadline && deadline->expired()) {
+        return 0;
+    }
+    // Every mention of the name but the declaration has to be one of the reads
+    for (const QStringView &name : inliner.reads.keys()) {
+        if (inliner.reads.value(name) + 1 != mentions.value(name)) {
+            inliner.reads.insert(name, -1);
+        }
+    }
+    inliner.replace(rootNode, arena);
+    return inliner.replaced;
+}
+
+QString JsAst::toSource(Deadline *deadline) const {
+    if (!rootNode) {
+        return source;
+    }
+    Printer printer(source, deadline);
+    printer.print(rootNode, kSequence);
+    return deadline && deadline->expired() ? QString() : printer.output;
+}
+
+QString JsAst::simplify(const QString &script, Deadline *deadline) {
+    JsAst ast;
+    ast.parse(script, deadline);
+    const int folded = ast.foldConstants(deadline);
+    const int inlined = ast.inlineStringArrays(deadline);
+    if (folded == 0 && inlined == 0) {
+        return script;
+    }
+    if (inlined > 0) {
+        ast.foldConstants(deadline);
+    }
+    const QString simplified = ast.toSource(deadline);
+    return deadline && deadline->expired() ? script : simplified;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+
+#include "arena.h"
+
+class Deadline;
+
+// JavaScript parsed for the deobfuscation passes. Expressions become a tree; statements,
+// function bodies, object literals and anything else the passes have no use for stay source
+// text, with the expressions found inside them as children. A statement the parser cannot make
+// sense of is kept as written, so every script round-trips.
+//
+// Parsing is one pass over the tokens and every pass visits each node once, so the cost stays
+// linear in the size of the script. Nesting is capped to keep deep input off the stack; past the
+// cap a statement is left as written. Nodes live in an arena owned by the tree.
+//
+// Every pass takes an optional Deadline and stops early once it has expired.
+class JsAst {
+  public:
+    enum Kind {
+        Source,  // text copied as written, with the nodes inside it printed in place
+        Number,
+        String,
+        Boolean,
+        Null,
+        Identifier,  // this, super and new.target too
+        Array,
+        Unary,    // prefix operators and spread
+        Postfix,  // a++, a--
+        Binary,   // a chain of operators of one precedence, e.g. a + b - c
+        Conditional,
+        Assignment,
+        Call,
+        New,
+        Member,
+        Sequence
+    };
+
+    struct Node {
+        Kind kind;
+        bool changed;    // differs from the source; printed from the tree rather than copied
+        bool statement;  // an expression statement on its own
+        bool computed;   // Member: a[b] rather than a.b
+        bool optional;   // Member and Call: a?.b, a?.[b], a?.(b)
+        bool arguments;  // New: followed by an argument list
+        bool boolean;
+        int precedence;   // Source: how tightly the text binds
+        int count;        // children
+        qsizetype start;  // source range; parentheses around the node are not part of it
+        qsizetype end;
+        Node **children;
+        const qsizetype *bounds;       // Source: range of each child slot as parsed
+        const QStringView *operators;  // Binary: count - 1; Unary, Postfix, Assignment: one
+        QStringView text;              // Identifier name, String value
+        double number;
+    };
+
+    JsAst() = default;
+    JsAst(const JsAst &) = delete;
+    JsAst &operator=(const JsAst &) = delete;
+
+    // Replaces the current tree. Never fails: whatever does not parse is kept as source text.
+    // A parse cut short by `deadline` leaves no tree, so the passes keep the script as written.
+    void parse(const QString &script, Deadline *deadline = nullptr);
+
+    const Node *root() const { return rootNode; }
+    qsizetype nodeCount() const { return nodes; }
+
+    // Evaluates constant subexpressions with JavaScript's semantics: "a" + "b", 0x10 * 2, !![],
+    // typeof "", "abc"[1], true ? a : b, ... Hex, octal and binary literals are rewritten in
+    // decimal, and obj["name"] becomes obj.name. Returns the number of nodes replaced.
+    int foldConstants(Deadline *deadline = nullptr);
+
+    // Replaces reads like arr[3] of arrays that are declared once, hold only constants and are
+    // never written, passed around or shadowed, with the element itself. Returns the number of
+    // reads replaced.
+    int inlineStringArrays(Deadline *deadline = nullptr);
+
+    // Untouched code comes out exactly as written; changed expressions are printed compactly.
+    // Empty if `deadline` expires before the end.
+    QString toSource(Deadline *deadline = nullptr) const;
+
+    // parse, fold, inline, fold again, print; the script as it was if `deadline` expires
+    static QString simplify(const QString &script, Deadline *deadline = nullptr);
+
+  private:
+    QString source;
+    Arena arena;
+    Node *rootNode = nullptr;
+    qsizetype nodes = 0;
+    QHash<QStringView, Node *> arrays;  // var x = [...]; null when x is declared more than once
+    QHash<QStringView, int> mentions;   // occurrences of each declared array's name
+};
\ No newline at end of file
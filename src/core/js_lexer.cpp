@@ -0,0 +1,620 @@
+#include "js_lexer.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+// Sorted for binary search. Contextual words that can also be plain names (of, get, async...)
+// are left out, except for the few that change how a following '/' reads.
+constexpr std::array<QStringView, 38> kKeywords = {
+    u"await",      u"break",  u"case",   u"catch",  u"class",    u"const",  u"continue",
+    u"debugger",   u"default", u"delete", u"do",     u"else",     u"export", u"extends",
+    u"false",      u"finally", u"for",    u"function", u"if",     u"import", u"in",
+    u"instanceof", u"let",    u"new",    u"null",   u"return",   u"super",  u"switch",
+    u"this",       u"throw",  u"true",   u"try",    u"typeof",   u"var",    u"void",
+    u"while",      u"with",   u"yield",
+};
+
+bool isLineTerminator(char16_t unit) {
+    return unit == '\n' || unit == '\r' || unit == 0x2028 || unit == 0x2029;
+}
+
+bool isIdentifierStart(QChar ch) {
+    const char16_t unit = ch.unicode();
+    if (unit < 0x80) {
+        return (unit >= 'a' && unit <= 'z') || (unit >= 'A' && unit <= 'Z') || unit == '$' ||
+               unit == '_' || unit == '\\';
+    }
+    return ch.isLetter() || ch.isSurrogate();
+}
+
+bool isIdentifierPart(QChar ch) {
+    const char16_t unit = ch.unicode();
+    if (unit < 0x80) {
+        return isIdentifierStart(ch) || (unit >= '0' && unit <= '9');
+    }
+    return ch.isLetterOrNumber() || ch.isMark() || ch.isSurrogate() || unit == 0x200C ||
+           unit == 0x200D;
+}
+
+bool isDigit(char16_t unit) {
+    return unit >= '0' && unit <= '9';
+}
+
+int hexDigit(char16_t unit) {
+    if (isDigit(unit)) {
+        return unit - '0';
+    }
+    unit |= 0x20;
+    return unit >= 'a' && unit <= 'f' ? unit - 'a' + 10 : -1;
+}
+
+// Code points above U+FFFF become a surrogate pair
+void appendCodePoint(QString &output, char32_t codePoint) {
+    if (QChar::requiresSurrogates(codePoint)) {
+        output += QChar(QChar::highSurrogate(codePoint));
+        output += QChar(QChar::lowSurrogate(codePoint));
+    } else {
+        output += QChar(static_cast<char16_t>(codePoint));
+    }
+}
+
+// Decodes a \x, \u or legacy octal escape starting at the backslash at `pos` and returns the
+// position after it, or nullptr when the hex digits are missing.
+const QChar *decodeNumericEscape(const QChar *pos, const QChar *end, QString &output) {
+    const char16_t kind = pos[1].unicode();
+    const QChar *digit = pos + 2;
+    char32_t value = 0;
+    if (kind == 'u' && digit < end && *digit == '{') {
+        for (digit++; digit < end && hexDigit(digit->unicode()) >= 0; digit++) {
+            value = value * 16 + hexDigit(digit->unicode());
+            if (value > 0x10FFFF) {
+                return nullptr;
+            }
+        }
+        if (digit == pos + 3 || digit == end || *digit != '}') {
+            return nullptr;
+        }
+        appendCodePoint(output, value);
+        return digit + 1;
+    }
+    if (kind == 'x' || kind == 'u') {
+        const int digits = kind == 'x' ? 2 : 4;
+        if (end - digit < digits) {
+            return nullptr;
+        }
+        for (int i = 0; i < digits; i++) {
+            const int nibble = hexDigit(digit[i].unicode());
+            if (nibble < 0) {
+                return nullptr;
+            }
+            value = value * 16 + nibble;
+        }
+        output += QChar(static_cast<char16_t>(value));
+        return digit + digits;
+    }
+
+    // Legacy octal, at most \377
+    const int maxDigits = kind <= '3' ? 3 : 2;
+    digit = pos + 1;
+    for (int i = 0; i < maxDigits && digit < end && digit->unicode() >= '0' &&
+                    digit->unicode() <= '7';
+         i++, digit++) {
+        value = value * 8 + (digit->unicode() - '0');
+    }
+    output += QChar(static_cast<char16_t>(value));
+    return digit;
+}
+
+// Characters that can follow the first one of a multi-character punctuator
+bool isOperatorChar(char16_t unit) {
+    switch (unit) {
+        case '=':
+        case '>':
+        case '<':
+        case '&':
+        case '|':
+        case '?':
+        case '.':
+        case '+':
+        case '-':
+        case '*':
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+JsLexer::JsLexer(QStringView source) : source(source) {}
+
+bool JsLexer::isKeyword(QStringView word) {
+    return std::binary_search(kKeywords.begin(), kKeywords.end(), word);
+}
+
+bool JsLexer::stringValue(QStringView literal, QString &value) {
+    if (literal.size() < 2 || literal.front() != literal.back() ||
+        (literal.front() != '\'' && literal.front() != '"' && literal.front() != '`')) {
+        return false;
+    }
+
+    const QChar *pos = literal.data() + 1;
+    const QChar *end = literal.data() + literal.size() - 1;
+    value.clear();
+    value.reserve(end - pos);
+    while (pos < end) {
+        const QChar *plain = pos;
+        while (pos < end && *pos != '\\') {
+            pos++;
+        }
+        value.append(plain, pos - plain);
+        if (end - pos < 2) {
+            break;
+        }
+
+        const char16_t next = pos[1].unicode();
+        switch (next) {
+            case 'n':
+                value += '\n';
+                break;
+            case 't':
+                value += '\t';
+                break;
+            case 'r':
+                value += '\r';
+                break;
+            case 'b':
+                value += '\b';
+                break;
+            case 'f':
+                value += '\f';
+                break;
+            case 'v':
+                value += '\v';
+                break;
+            default:
+                if (isLineTerminator(next)) {
+                    // A line continuation stands for nothing
+                    if (next == '\r' && end - pos > 2 && pos[2] == '\n') {
+                        pos++;
+                    }
+                } else if (next == 'x' || next == 'u' || (next >= '0' && next <= '7')) {
+                    const QChar *after = decodeNumericEscape(pos, end, value);
+                    if (!after) {
+                        return false;
+                    }
+                    pos = after;
+                    continue;
+                } else {
+                    value += pos[1];
+                }
+        }
+        pos += 2;
+    }
+    return true;
+}
+
+QString JsLexer::quote(QStringView text) {
+    QString quoted;
+    quoted.reserve(text.size() + 2);
+    quoted += '\'';
+    for (QChar ch : text) {
+        const char16_t unit = ch.unicode();
+        if (unit == '\'' || unit == '\\') {
+            quoted += '\\';
+            quoted += ch;
+        } else if (unit == '\n') {
+            quoted += u"\\n";
+        } else if (unit == '\r') {
+            quoted += u"\\r";
+        } else if (unit < 0x20 || unit == 0x2028 || unit == 0x2029) {
+            quoted += QString("\\u%1").arg(int(unit), 4, 16, QChar('0'));
+        } else {
+            quoted += ch;
+        }
+    }
+    quoted += '\'';
+    return quoted;
+}
+
+QStringView JsLexer::text(const Token &token) const {
+    return source.mid(token.start, token.length);
+}
+
+QList<JsLexer::Token> JsLexer::tokenize(QStringView source) {
+    JsLexer lexer(source);
+    QList<Token> tokens;
+    tokens.reserve(source.size() / 4);
+    for (Token token = lexer.next(); token.type != EndOfInput; token = lexer.next()) {
+        tokens.append(token);
+    }
+    return tokens;
+}
+
+QList<qsizetype> JsLexer::topLevelEnds(QStringView source) {
+    // Only what decides how a later '/' reads is tracked of the tokens passed over
+    enum Last { Operator, Operand, Word, MemberName };
+
+    QList<qsizetype> ends;
+    JsLexer lexer(source);
+    Token token;
+    qsizetype &pos = lexer.pos;
+    const qsizetype size = source.size();
+    Last last = Operator;
+    QStringView word;     // the last identifier or keyword
+    bool member = false;  // the last token was '.' or '?.'
+    int depth = 0;        // open brackets and template substitutions
+    while (pos < size) {
+        const QChar ch = source[pos];
+        const char16_t unit = ch.unicode();
+        const char16_t following = pos + 1 < size ? source[pos + 1].unicode() : 0;
+        if (isLineTerminator(unit) || ch.isSpace() || unit == 0xFEFF) {
+            pos++;
+            continue;
+        }
+
+        // Comments are skipped like whitespace
+        if (unit == '/' && following == '/') {
+            while (pos < size && !isLineTerminator(source[pos].unicode())) {
+                pos++;
+            }
+            continue;
+        }
+        if (unit == '/' && following == '*') {
+            const qsizetype close = source.indexOf(u"*/", pos + 2);
+            pos = close < 0 ? size : close + 2;
+            continue;
+        }
+
+        const qsizetype start = pos;
+        const bool afterDot = member;
+        member = false;
+        if (unit == '#' && following == '!' && pos == 0) {
+            while (pos < size && !isLineTerminator(source[pos].unicode())) {
+                pos++;
+            }
+        } else if (unit == '`' || (unit == '}' && !lexer.braceIsSubstitution.isEmpty() &&
+                                   lexer.braceIsSubstitution.last())) {
+            if (unit == '}') {
+                lexer.braceIsSubstitution.removeLast();
+                depth = qMax(0, depth - 1);
+            }
+            const qsizetype open = lexer.braceIsSubstitution.size();
+            lexer.lexTemplate(token);
+            if (lexer.braceIsSubstitution.size() > open) {
+                depth++;
+                last = Operator;
+            } else {
+                last = Operand;
+            }
+        } else if (unit == '"' || unit == '\'') {
+            lexer.lexString(token);
+            last = Operand;
+        } else if (isDigit(unit) || (unit == '.' && isDigit(following))) {
+            lexer.lexNumber(token);
+            last = Operand;
+        } else if (isIdentifierStart(ch) || (unit == '#' && isIdentifierStart(QChar(following)))) {
+            pos++;
+            while (pos < size && isIdentifierPart(source[pos])) {
+                pos += source[pos] == '\\' ? 2 : 1;
+            }
+            pos = qMin(pos, size);
+            word = source.mid(start, pos - start);
+            last = afterDot ? MemberName : Word;
+        } else if (unit == '/') {
+            // Keywords are looked up only here, where it matters
+            bool regex = last == Operator;
+            if (last == Word) {
+                regex = isKeyword(word) && word != u"this" && word != u"super" &&
+                        word != u"null" && word != u"true" && word != u"false";
+            }
+            if (!regex || !lexer.lexRegex(token)) {
+                pos++;
+                last = Operator;
+            } else {
+                last = Operand;
+            }
+        } else {
+            pos++;
+            last = Operator;
+            switch (unit) {
+                case '(':
+                case '[':
+                    depth++;
+                    break;
+                case '{':
+                    lexer.braceIsSubstitution.append(false);
+                    depth++;
+                    break;
+                case ')':
+                case ']':
+                    depth = qMax(0, depth - 1);
+                    last = Operand;
+                    break;
+                case '}':
+                    if (!lexer.braceIsSubstitution.isEmpty()) {
+                        lexer.braceIsSubstitution.removeLast();
+                    }
+                    depth = qMax(0, depth - 1);
+                    last = Operand;
+                    if (depth == 0) {
+                        ends.append(pos);
+                    }
+                    break;
+                case ';':
+                    if (depth == 0) {
+                        ends.append(pos);
+                    }
+                    break;
+                case '.':
+                    if (following == '.' && pos + 1 < size && source[pos + 1] == '.') {
+                        pos += 2;  // spread
+                    } else {
+                        member = true;
+                    }
+                    break;
+                case '?':
+                    // a?.5:b is a conditional, not optional chaining
+                    if (following == '.' &&
+                        !(pos + 1 < size && isDigit(source[pos + 1].unicode()))) {
+                        pos++;
+                        member = true;
+                    }
+                    break;
+                case '+':
+                case '-':
+                    if (following == unit) {
+                        pos++;
+                        last = Operand;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return ends;
+}
+
+JsLexer::Token JsLexer::next() {
+    Token token;
+    token.newlines = skipWhitespace();
+    token.start = pos;
+    if (pos >= source.size()) {
+        return token;
+    }
+
+    const char16_t unit = source[pos].unicode();
+    const char16_t following = pos + 1 < source.size() ? source[pos + 1].unicode() : 0;
+    if (unit == '/' && following == '/') {
+        token.type = LineComment;
+        while (pos < source.size() && !isLineTerminator(source[pos].unicode())) {
+            pos++;
+        }
+    } else if (unit == '/' && following == '*') {
+        token.type = BlockComment;
+        const qsizetype close = source.indexOf(u"*/", pos + 2);
+        pos = close < 0 ? source.size() : close + 2;
+    } else if (unit == '#' && following == '!' && pos == 0) {
+        token.type = LineComment;  // hashbang
+        while (pos < source.size() && !isLineTerminator(source[pos].unicode())) {
+            pos++;
+        }
+    } else if (unit == '`') {
+        lexTemplate(token);
+    } else if (unit == '}' && !braceIsSubstitution.isEmpty() && braceIsSubstitution.last()) {
+        braceIsSubstitution.removeLast();
+        lexTemplate(token);
+    } else if (unit == '"' || unit == '\'') {
+        lexString(token);
+    } else if (isDigit(unit) || (unit == '.' && isDigit(following))) {
+        lexNumber(token);
+    } else if (isIdentifierStart(source[pos]) || (unit == '#' && pos + 1 < source.size() &&
+                                                  isIdentifierStart(source[pos + 1]))) {
+        lexIdentifier(token);
+    } else if (unit != '/' || !regexAllowed() || !lexRegex(token)) {
+        lexPunctuator(token);
+    }
+
+    token.length = pos - token.start;
+    if (token.type != LineComment && token.type != BlockComment) {
+        previous = token;
+    }
+    return token;
+}
+
+int JsLexer::skipWhitespace() {
+    int newlines = 0;
+    while (pos < source.size()) {
+        const QChar ch = source[pos];
+        const char16_t unit = ch.unicode();
+        if (isLineTerminator(unit)) {
+            // \r\n is a single line break
+            if (unit != '\r' || pos + 1 >= source.size() || source[pos + 1] != '\n') {
+                newlines++;
+            }
+        } else if (!ch.isSpace() && unit != 0xFEFF) {
+            break;
+        }
+        pos++;
+    }
+    return newlines;
+}
+
+// A '/' starts a regex wherever an expression may begin, and is division after anything that
+// ends an operand.
+bool JsLexer::regexAllowed() const {
+    const QStringView last = text(previous);
+    switch (previous.type) {
+        case EndOfInput:
+            return true;
+        case Keyword:
+            return last != u"this" && last != u"super" && last != u"null" && last != u"true" &&
+                   last != u"false";
+        case Punctuator:
+            return last != u")" && last != u"]" && last != u"}" && last != u"++" && last != u"--";
+        case Template:
+            return last.endsWith(u"${");
+        default:
+            return false;
+    }
+}
+
+void JsLexer::lexIdentifier(Token &token) {
+    pos++;
+    while (pos < source.size() && isIdentifierPart(source[pos])) {
+        pos += source[pos] == '\\' ? 2 : 1;  // \uXXXX escapes; the hex digits are parts too
+    }
+    pos = qMin(pos, source.size());
+
+    // Keywords are ordinary property names after a member access
+    const QStringView last = text(previous);
+    const bool member = previous.type == Punctuator && (last == u"." || last == u"?.");
+    const QStringView word = source.mid(token.start, pos - token.start);
+    token.type = !member && isKeyword(word) ? Keyword : Identifier;
+}
+
+void JsLexer::lexNumber(Token &token) {
+    token.type = Number;
+    auto digits = [this](bool hex) {
+        while (pos < source.size()) {
+            const QChar ch = source[pos];
+            const char16_t unit = ch.unicode();
+            if (!isDigit(unit) && unit != '_' &&
+                !(hex && ((unit >= 'a' && unit <= 'f') || (unit >= 'A' && unit <= 'F')))) {
+                break;
+            }
+            pos++;
+        }
+    };
+
+    const char16_t prefix = pos + 1 < source.size() ? source[pos + 1].unicode() | 0x20 : 0;
+    if (source[pos] == '0' && (prefix == 'x' || prefix == 'o' || prefix == 'b')) {
+        pos += 2;
+        digits(true);
+    } else {
+        digits(false);
+        if (pos < source.size() && source[pos] == '.') {
+            pos++;
+            digits(false);
+        }
+        if (pos < source.size() && (source[pos] == 'e' || source[pos] == 'E')) {
+            pos++;
+            if (pos < source.size() && (source[pos] == '+' || source[pos] == '-')) {
+                pos++;
+            }
+            digits(false);
+        }
+    }
+    if (pos < source.size() && source[pos] == 'n') {
+        pos++;  // BigInt
+    }
+}
+
+void JsLexer::lexString(Token &token) {
+    token.type = String;
+    const QChar quote = source[pos++];
+    while (pos < source.size()) {
+        const QChar ch = source[pos];
+        if (ch == quote) {
+            pos++;
+            return;
+        }
+        if (ch == '\\') {
+            pos += 2;
+        } else if (isLineTerminator(ch.unicode())) {
+            return;  // unterminated; the line break belongs to whatever follows
+        } else {
+            pos++;
+        }
+    }
+    pos = source.size();
+}
+
+void JsLexer::lexTemplate(Token &token) {
+    token.type = Template;
+    pos++;  // the opening ` or the } closing a substitution
+    while (pos < source.size()) {
+        const QChar ch = source[pos];
+        if (ch == '\\') {
+            pos += 2;
+        } else if (ch == '`') {
+            pos++;
+            return;
+        } else if (ch == '$' && pos + 1 < source.size() && source[pos + 1] == '{') {
+            pos += 2;
+            braceIsSubstitution.append(true);
+            return;
+        } else {
+            pos++;
+        }
+    }
+    pos = source.size();
+}
+
+// Scans /body/flags; a '/' inside a character class does not end the body. Fails without
+// moving when the line ends first, leaving the '/' to be read as division.
+bool JsLexer::lexRegex(Token &token) {
+    qsizetype end = pos + 1;
+    bool inClass = false;
+    while (true) {
+        if (end >= source.size() || isLineTerminator(source[end].unicode())) {
+            return false;
+        }
+        const QChar ch = source[end];
+        if (ch == '\\') {
+            end++;
+            if (end >= source.size() || isLineTerminator(source[end].unicode())) {
+                return false;
+            }
+        } else if (ch == '[') {
+            inClass = true;
+        } else if (ch == ']') {
+            inClass = false;
+        } else if (ch == '/' && !inClass) {
+            break;
+        }
+        end++;
+    }
+
+    end++;
+    while (end < source.size() && isIdentifierPart(source[end])) {
+        end++;
+    }
+    token.type = Regex;
+    pos = end;
+    return true;
+}
+
+void JsLexer::lexPunctuator(Token &token) {
+    token.type = Punctuator;
+
+    // Longest match first
+    static constexpr QStringView kMultiChar[] = {
+        u">>>=", u"...", u"===", u"!==", u"**=", u"<<=", u">>=", u">>>", u"&&=", u"||=", u"?\?=",
+        u"=>",   u"==",  u"!=",  u"<=",  u">=",  u"&&",  u"||",  u"??",  u"?.",  u"++",  u"--",
+        u"+=",   u"-=",  u"*=",  u"/=",  u"%=",  u"&=",  u"|=",  u"^=",  u"**",  u"<<",  u">>"};
+    const QStringView rest = source.mid(pos);
+    if (rest.size() > 1 && isOperatorChar(rest[1].unicode())) {
+        for (QStringView candidate : kMultiChar) {
+            if (!rest.startsWith(candidate)) {
+                continue;
+            }
+            // a?.5:b is a conditional, not optional chaining
+            if (candidate == u"?." && rest.size() > 2 && isDigit(rest[2].unicode())) {
+                continue;
+            }
+            pos += candidate.size();
+            return;
+        }
+    }
+
+    const QChar ch = source[pos++];
+    if (ch == '{') {
+        braceIsSubstitution.append(false);
+    } else if (ch == '}' && !braceIsSubstitution.isEmpty()) {
+        braceIsSubstitution.removeLast();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Streaming JavaScript tokenizer. Tokens refer back into the source by offset, so lexing
+// allocates nothing per token. Regex literals are told apart from division by the previous
+// significant token, and template literals are split at their ${ } substitutions so the
+// embedded expressions come out as ordinary tokens.
+class JsLexer {
+  public:
+    enum TokenType {
+        Identifier,
+        Keyword,
+        Number,
+        String,
+        Template,  // a whole `...` literal, or the part of one up to or after a substitution
+        Regex,
+        Punctuator,
+        LineComment,
+        BlockComment,
+        EndOfInput
+    };
+
+    struct Token {
+        TokenType type = EndOfInput;
+        qsizetype start = 0;
+        qsizetype length = 0;
+        int newlines = 0;  // line breaks between the previous token and this one; relevant to ASI
+    };
+
+    explicit JsLexer(QStringView source);
+
+    Token next();
+    QStringView text(const Token &token) const;
+
+    static QList<Token> tokenize(QStringView source);
+    // Offsets just past each ';' and '}' at bracket depth 0, i.e. the ends of top-level
+    // statements, for cutting a script into pieces. Strings, comments, templates and regexes are
+    // skipped by the same rules as next(), but no tokens are built, which makes this several
+    // times faster than lexing.
+    static QList<qsizetype> topLevelEnds(QStringView source);
+    static bool isKeyword(QStringView word);
+
+    // Value of a string literal, quotes included; template literals without substitutions
+    // count as well. False when an escape in it is malformed.
+    static bool stringValue(QStringView literal, QString &value);
+    // Single-quoted literal for `text`, escaping only what has to be
+    static QString quote(QStringView text);
+
+  private:
+    int skipWhitespace();
+    bool regexAllowed() const;
+    void lexIdentifier(Token &token);
+    void lexNumber(Token &token);
+    void lexString(Token &token);
+    void lexTemplate(Token &token);
+    bool lexRegex(Token &token);
+    void lexPunctuator(Token &token);
+
+    QStringView source;
+    qsizetype pos = 0;
+    Token previous;  // last token other than a comment
+    QList<bool> braceIsSubstitution;  // open braces; true for the ${ of a template
+};
\ No newline at end of file
@@ -0,0 +1,898 @@
+#include "json5_document.h"
+
+#include <QSet>
+#include <QtCore/qnumeric.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "task_control.h"
+
+namespace {
+
+using Value = Json5Document::Value;
+using Member = Json5Document::Member;
+using Key = Json5Document::Key;
+
+bool isWordByte(unsigned char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') ||
+           ch == '_' || ch == '$' || ch >= 0x80;
+}
+
+bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+int hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+char *appendUtf8(char *out, char32_t codePoint) {
+    if (codePoint < 0x80) {
+        *out++ = static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (codePoint >> 6));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (codePoint >> 12));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (codePoint >> 18));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+    return out;
+}
+
+bool startsWith(const char *pos, const char *end, const char *word) {
+    const qsizetype length = qsizetype(std::strlen(word));
+    return end - pos >= length && std::memcmp(pos, word, length) == 0;
+}
+
+// ============================================================================
+// Parser
+// ============================================================================
+
+// Single pass over the source with an explicit stack of open containers, so nesting depth is
+// limited by memory rather than by the call stack. Children are collected in scratch lists
+// shared by all containers and copied into the arena, at their final size, when the container
+// closes.
+class Parser {
+  public:
+    Parser(const QByteArray &source, Arena &arena, QHash<QByteArrayView, const Key *> &keys,
+           Deadline *deadline)
+        : begin(source.constData()),
+          pos(begin),
+          end(begin + source.size()),
+          arena(arena),
+          keys(keys),
+          deadline(deadline) {}
+
+    Value *run();
+
+    qsizetype nodes = 0;
+    qsizetype errorPosition = -1;
+    const char *errorMessage = nullptr;
+
+  private:
+    struct Frame {
+        Value *container;
+        qsizetype scratchStart;
+    };
+
+    bool fail(const char *at, const char *message);
+    bool skipSpace();
+    void attach(Value *value, const Key *key, qsizetype keyPosition);
+    void close();
+    bool parseKey(const Key *&key);
+    bool parseString(const char *&text, qsizetype &size);
+    bool parseNumber(Value *value);
+    bool parseWord(Value *value);
+    const Key *intern(const char *data, qsizetype size);
+
+    const char *begin;
+    const char *pos;
+    const char *end;
+    Arena &arena;
+    QHash<QByteArrayView, const Key *> &keys;
+    Deadline *deadline;
+    QList<Frame> frames;
+    QList<Value *> items;
+    QList<Member> members;
+    Value *root = nullptr;
+};
+
+Value *Parser::run() {
+    enum Expect { ExpectValue, ExpectKey, AfterValue };
+    Expect expect = ExpectValue;
+    const Key *key = nullptr;
+    qsizetype keyPosition = 0;
+
+    while (true) {
+        if (deadline && deadline->expired()) {
+            fail(pos, "Out of time");
+            return nullptr;
+        }
+        if (!skipSpace()) {
+            return nullptr;
+        }
+        if (pos == end) {
+            if (frames.isEmpty() && root) {
+                return root;
+            }
+            fail(end, "Unexpected end of input");
+            return nullptr;
+        }
+        const char ch = *pos;
+        const bool inObject =
+            !frames.isEmpty() && frames.last().container->type == Json5Document::Object;
+        const char closing = frames.isEmpty() ? '\0' : (inObject ? '}' : ']');
+
+        if (expect == AfterValue) {
+            if (frames.isEmpty()) {
+                fail(pos, "Unexpected content after the value");
+                return nullptr;
+            }
+            if (ch == ',') {
+                expect = inObject ? ExpectKey : ExpectValue;
+            } else if (ch == closing) {
+                close();
+            } else {
+                fail(pos, inObject ? "Expected ',' or '}'" : "Expected ',' or ']'");
+                return nullptr;
+            }
+            pos++;
+            continue;
+        }
+
+        // Right after an opening bracket or a trailing comma
+        if (ch == closing && (expect == ExpectKey || !inObject)) {
+            close();
+            pos++;
+            expect = AfterValue;
+            continue;
+        }
+
+        if (expect == ExpectKey) {
+            keyPosition = pos - begin;
+            if (!parseKey(key) || !skipSpace()) {
+                return nullptr;
+            }
+            if (pos == end || *pos != ':') {
+                fail(pos, "Expected ':'");
+                return nullptr;
+            }
+            pos++;
+            expect = ExpectValue;
+            continue;
+        }
+
+        Value *value = arena.create<Value>();
+        value->position = pos - begin;
+        nodes++;
+        if (ch == '{' || ch == '[') {
+            value->type = ch == '{' ? Json5Document::Object : Json5Document::Array;
+            attach(value, key, keyPosition);
+            frames.append({value, ch == '{' ? members.size() : items.size()});
+            pos++;
+            expect = ch == '{' ? ExpectKey : ExpectValue;
+            continue;
+        }
+
+        bool parsed;
+        if (ch == '"' || ch == '\'') {
+            value->type = Json5Document::String;
+            parsed = parseString(value->text, value->size);
+        } else if (isDigit(ch) || ch == '-' || ch == '+' || ch == '.') {
+            parsed = parseNumber(value);
+        } else if (isWordByte(static_cast<unsigned char>(ch))) {
+            parsed = parseWord(value);
+        } else {
+            parsed = fail(pos, "Expected a value");
+        }
+        if (!parsed) {
+            return nullptr;
+        }
+        attach(value, key, keyPosition);
+        expect = AfterValue;
+    }
+}
+
+bool Parser::fail(const char *at, const char *message) {
+    errorPosition = at - begin;
+    errorMessage = message;
+    return false;
+}
+
+// Whitespace as JSON5 defines it, including NBSP, BOM and the Unicode line separators, plus
+// line and block comments.
+bool Parser::skipSpace() {
+    while (pos < end) {
+        const unsigned char ch = static_cast<unsigned char>(*pos);
+        const qsizetype left = end - pos;
+        if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f') {
+            pos++;
+        } else if (ch == '/' && left > 1 && pos[1] == '/') {
+            pos += 2;
+            while (pos < end && *pos != '\n' && *pos != '\r') {
+                pos++;
+            }
+        } else if (ch == '/' && left > 1 && pos[1] == '*') {
+            const char *comment = pos;
+            pos += 2;
+            while (pos < end && !(*pos == '*' && pos + 1 < end && pos[1] == '/')) {
+                pos++;
+            }
+            if (pos == end) {
+                return fail(comment, "Unterminated comment");
+            }
+            pos += 2;
+        } else if (startsWith(pos, end, "\xC2\xA0")) {
+            pos += 2;
+        } else if (startsWith(pos, end, "\xEF\xBB\xBF") || startsWith(pos, end, "\xE2\x80\xA8") ||
+                   startsWith(pos, end, "\xE2\x80\xA9")) {
+            pos += 3;
+        } else {
+            break;
+        }
+    }
+    return true;
+}
+
+void Parser::attach(Value *value, const Key *key, qsizetype keyPosition) {
+    if (frames.isEmpty()) {
+        root = value;
+    } else if (frames.last().container->type == Json5Document::Object) {
+        members.append({key, keyPosition, value});
+    } else {
+        items.append(value);
+    }
+}
+
+void Parser::close() {
+    const Frame frame = frames.takeLast();
+    Value *container = frame.container;
+    if (container->type == Json5Document::Object) {
+        container->size = members.size() - frame.scratchStart;
+        container->members = arena.allocateArray<Member>(container->size);
+        std::copy(members.cbegin() + frame.scratchStart, members.cend(), container->members);
+        members.resize(frame.scratchStart);
+    } else {
+        container->size = items.size() - frame.scratchStart;
+        container->items = arena.allocateArray<Value *>(container->size);
+        std::copy(items.cbegin() + frame.scratchStart, items.cend(), container->items);
+        items.resize(frame.scratchStart);
+    }
+}
+
+bool Parser::parseKey(const Key *&key) {
+    const char *text = nullptr;
+    qsizetype size = 0;
+    if (*pos == '"' || *pos == '\'') {
+        if (!parseString(text, size)) {
+            return false;
+        }
+    } else {
+        // Unquoted keys: identifier characters, digits allowed anywhere
+        text = pos;
+        while (pos < end && isWordByte(static_cast<unsigned char>(*pos))) {
+            pos++;
+        }
+        size = pos - text;
+        if (size == 0) {
+            return fail(pos, "Expected a key");
+        }
+    }
+    key = intern(text, size);
+    return true;
+}
+
+// Strings without escapes are views into the source; the rest are decoded into the arena.
+bool Parser::parseString(const char *&text, qsizetype &size) {
+    const char quote = *pos;
+    const char *start = ++pos;
+    const char *scan = start;
+    while (scan < end && *scan != quote && *scan != '\\' && *scan != '\n' && *scan != '\r') {
+        scan++;
+    }
+    if (scan < end && *scan == quote) {
+        text = start;
+        size = scan - start;
+        pos = scan + 1;
+        return true;
+    }
+
+    // Find the closing quote first; escapes only ever shrink, so that bounds the output
+    const char *closing = scan;
+    while (closing < end && *closing != quote) {
+        if (*closing == '\n' || *closing == '\r') {
+            return fail(closing, "Unterminated string");
+        }
+        if (*closing == '\\') {
+            closing += startsWith(closing + 1, end, "\r\n") ? 3 : 2;
+        } else {
+            closing++;
+        }
+    }
+    if (closing >= end) {
+        return fail(end, "Unterminated string");
+    }
+
+    char *buffer = arena.allocateArray<char>(closing - start);
+    std::memcpy(buffer, start, scan - start);
+    char *out = buffer + (scan - start);
+    const char *in = scan;
+    while (in < closing) {
+        if (*in != '\\') {
+            *out++ = *in++;
+            continue;
+        }
+        const char escape = in[1];
+        in += 2;
+        switch (escape) {
+            case 'b':
+                *out++ = '\b';
+                break;
+            case 'f':
+                *out++ = '\f';
+                break;
+            case 'n':
+                *out++ = '\n';
+                break;
+            case 'r':
+                *out++ = '\r';
+                break;
+            case 't':
+                *out++ = '\t';
+                break;
+            case 'v':
+                *out++ = '\v';
+                break;
+            case '0':
+                *out++ = '\0';
+                break;
+            case '\r':
+                if (in < closing && *in == '\n') {
+                    in++;
+                }
+                break;  // a backslash before a line break continues the string on the next line
+            case '\n':
+                break;
+            case 'x':
+            case 'u': {
+                const int digits = escape == 'x' ? 2 : 4;
+                char32_t codePoint = 0;
+                for (int i = 0; i < digits; i++) {
+                    const int digit = in + i < closing ? hexValue(in[i]) : -1;
+                    if (digit < 0) {
+                        return fail(in + i, "Invalid escape");
+                    }
+                    codePoint = codePoint << 4 | char32_t(digit);
+                }
+                in += digits;
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF && closing - in >= 6 &&
+                    in[0] == '\\' && in[1] == 'u') {
+                    char32_t low = 0;
+                    for (int i = 2; i < 6 && hexValue(in[i]) >= 0; i++) {
+                        low = low << 4 | char32_t(hexValue(in[i]));
+                    }
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        in += 6;
+                    }
+                }
+                if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+                    codePoint = 0xFFFD;  // unpaired surrogate
+                }
+                out = appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                if (escape == '\xE2' && closing - in >= 2 && in[0] == '\x80' &&
+                    (in[1] == '\xA8' || in[1] == '\xA9')) {
+                    in += 2;  // \ U+2028 or U+2029 is a line continuation too
+                } else {
+                    *out++ = escape;  // \' \" \\ \/ and any other character stand for themselves
+                }
+                break;
+        }
+    }
+    text = buffer;
+    size = out - buffer;
+    pos = closing + 1;
+    return true;
+}
+
+bool Parser::parseNumber(Value *value) {
+    value->type = Json5Document::Number;
+    const char *start = pos;
+    if (*pos == '-' || *pos == '+') {
+        pos++;
+    }
+
+    if (startsWith(pos, end, "Infinity") || startsWith(pos, end, "NaN")) {
+        pos += *pos == 'I' ? 8 : 3;
+    } else if (startsWith(pos, end, "0x") || startsWith(pos, end, "0X")) {
+        pos += 2;
+        const char *digits = pos;
+        while (pos < end && hexValue(*pos) >= 0) {
+            pos++;
+        }
+        if (pos == digits) {
+            return fail(pos, "Invalid number");
+        }
+    } else {
+        bool digits = false;
+        while (pos < end && isDigit(*pos)) {
+            pos++;
+            digits = true;
+        }
+        if (pos < end && *pos == '.') {
+            pos++;
+            while (pos < end && isDigit(*pos)) {
+                pos++;
+                digits = true;
+            }
+        }
+        if (!digits) {
+            return fail(pos, "Invalid number");
+        }
+        if (pos < end && (*pos == 'e' || *pos == 'E')) {
+            pos++;
+            if (pos < end && (*pos == '+' || *pos == '-')) {
+                pos++;
+            }
+            if (pos == end || !isDigit(*pos)) {
+                return fail(pos, "Invalid number");
+            }
+            while (pos < end && isDigit(*pos)) {
+                pos++;
+            }
+        }
+    }
+    if (pos < end && (isWordByte(static_cast<unsigned char>(*pos)) || *pos == '.')) {
+        return fail(pos, "Invalid number");
+    }
+    value->text = start;
+    value->size = pos - start;
+    return true;
+}
+
+// Literals, and bare words read as strings: the run of word characters and inline spaces up to
+// the next delimiter, without trailing spaces.
+bool Parser::parseWord(Value *value) {
+    const char *start = pos;
+    const char *wordEnd = pos;
+    while (pos < end && (isWordByte(static_cast<unsigned char>(*pos)) || *pos == ' ' ||
+                         *pos == '\t')) {
+        if (*pos != ' ' && *pos != '\t') {
+            wordEnd = pos + 1;
+        }
+        pos++;
+    }
+    pos = wordEnd;
+
+    const QByteArrayView word(start, wordEnd - start);
+    if (word == QByteArrayView("true") || word == QByteArrayView("false")) {
+        value->type = Json5Document::Bool;
+        value->boolean = word.size() == 4;
+    } else if (word == QByteArrayView("null")) {
+        value->type = Json5Document::Null;
+    } else if (word == QByteArrayView("Infinity") || word == QByteArrayView("NaN")) {
+        pos = start;
+        return parseNumber(value);
+    } else if (frames.isEmpty()) {
+        return fail(start, "Expected a value");  // plain text, not a payload with a bare word
+    } else {
+        value->type = Json5Document::String;
+        value->text = start;
+        value->size = word.size();
+    }
+    return true;
+}
+
+const Key *Parser::intern(const char *data, qsizetype size) {
+    const QByteArrayView view(data, size);
+    if (const Key *known = keys.value(view)) {
+        return known;
+    }
+    const Key *key = arena.create<Key>(data, size);
+    keys.insert(view, key);
+    return key;
+}
+
+// ============================================================================
+// Output and comparison
+// ============================================================================
+
+void appendString(QByteArray &out, QByteArrayView text) {
+    static const char kHex[] = "0123456789abcdef";
+    out.append('"');
+    const char *run = text.data();
+    const char *end = run + text.size();
+    for (const char *p = run; p < end; p++) {
+        const unsigned char ch = static_cast<unsigned char>(*p);
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+        out.append(run, p - run);
+        run = p + 1;
+        out.append('\\');
+        switch (ch) {
+            case '"':
+            case '\\':
+                out.append(char(ch));
+                break;
+            case '\b':
+                out.append('b');
+                break;
+            case '\f':
+                out.append('f');
+                break;
+            case '\n':
+                out.append('n');
+                break;
+            case '\r':
+                out.append('r');
+                break;
+            case '\t':
+                out.append('t');
+                break;
+            default:
+                out.append("u00");
+                out.append(kHex[ch >> 4]);
+                out.append(kHex[ch & 0xF]);
+                break;
+        }
+    }
+    out.append(run, end - run);
+    out.append('"');
+}
+
+// Numbers as strict JSON: no plus sign, no bare decimal point, no leading zeros, hex in decimal
+void appendNumber(QByteArray &out, const Value *value) {
+    const char *pos = value->text;
+    const char *end = pos + value->size;
+    const bool sign = *pos == '-' || *pos == '+';
+    if (pos[sign] == 'I' || pos[sign] == 'N') {
+        out.append("null");
+        return;
+    }
+    if (*pos == '-') {
+        out.append('-');
+    }
+    pos += sign;
+    if (startsWith(pos, end, "0x") || startsWith(pos, end, "0X")) {
+        const double magnitude = qAbs(value->toDouble());
+        if (magnitude < 9007199254740992.0) {  // 2^53: every integer below is exact
+            out.append(QByteArray::number(static_cast<qulonglong>(magnitude)));
+        } else {
+            out.append(QByteArray::number(magnitude, 'g', 17));
+        }
+        return;
+    }
+    while (end - pos > 1 && *pos == '0' && isDigit(pos[1])) {
+        pos++;
+    }
+    if (*pos == '.') {
+        out.append('0');
+    }
+    for (; pos < end; pos++) {
+        if (*pos == '.' && (pos + 1 == end || !isDigit(pos[1]))) {
+            continue;  // "5." is 5
+        }
+        out.append(*pos);
+    }
+}
+
+void appendScalar(QByteArray &out, const Value *value) {
+    switch (value->type) {
+        case Json5Document::Null:
+            out.append("null");
+            break;
+        case Json5Document::Bool:
+            out.append(value->boolean ? "true" : "false");
+            break;
+        case Json5Document::Number:
+            appendNumber(out, value);
+            break;
+        case Json5Document::String:
+            appendString(out, value->string());
+            break;
+        default:
+            break;
+    }
+}
+
+bool keyLess(const Key *a, const Key *b) {
+    const int order = std::memcmp(a->data, b->data, size_t(qMin(a->size, b->size)));
+    return order < 0 || (order == 0 && a->size < b->size);
+}
+
+bool sameScalar(const Value *a, const Value *b) {
+    switch (a->type) {
+        case Json5Document::Bool:
+            return a->boolean == b->boolean;
+        case Json5Document::Number: {
+            const double x = a->toDouble();
+            const double y = b->toDouble();
+            return x == y || (qIsNaN(x) && qIsNaN(y));
+        }
+        case Json5Document::String:
+            return a->string() == b->string();
+        default:
+            return true;
+    }
+}
+
+bool isContainer(const Value *value) {
+    return value->type == Json5Document::Array || value->type == Json5Document::Object;
+}
+
+QHash<QByteArrayView, const Value *> lastMembers(const Value *object) {
+    QHash<QByteArrayView, const Value *> members;
+    members.reserve(object->size);
+    for (qsizetype i = 0; i < object->size; i++) {
+        members.insert(object->members[i].key->view(), object->members[i].value);
+    }
+    return members;
+}
+
+// One step of a JSON Pointer, with '~' and '/' escaped
+QString pointerStep(QByteArrayView key) {
+    QString step = QString::fromUtf8(key);
+    step.replace('~', "~0");
+    step.replace('/', "~1");
+    return '/' + step;
+}
+
+}  // namespace
+
+double Json5Document::Value::toDouble() const {
+    const char *pos = text;
+    const char *end = text + size;
+    const bool negative = *pos == '-';
+    pos += *pos == '-' || *pos == '+';
+    double magnitude = 0;
+    if (*pos == 'I') {
+        magnitude = qInf();
+    } else if (*pos == 'N') {
+        return qQNaN();
+    } else if (startsWith(pos, end, "0x") || startsWith(pos, end, "0X")) {
+        for (pos += 2; pos < end; pos++) {
+            magnitude = magnitude * 16 + hexValue(*pos);
+        }
+    } else {
+        magnitude = QByteArray::fromRawData(pos, end - pos).toDouble();
+    }
+    return negative ? -magnitude : magnitude;
+}
+
+const Json5Document::Value *Json5Document::Value::find(QByteArrayView key) const {
+    if (type != Object) {
+        return nullptr;
+    }
+    for (qsizetype i = size - 1; i >= 0; i--) {
+        if (members[i].key->view() == key) {
+            return members[i].value;
+        }
+    }
+    return nullptr;
+}
+
+bool Json5Document::parse(const QByteArray &text, qsizetype *errorPosition, QString *error,
+                          Deadline *deadline) {
+    keys.clear();
+    rootValue = nullptr;
+    nodes = 0;
+    // Sized so typical documents fit the first block; pages that are never touched cost nothing
+    arena = Arena(qMax<qsizetype>(64 * 1024, text.size() * 2));
+    source = text;
+
+    Parser parser(source, arena, keys, deadline);
+    rootValue = parser.run();
+    if (!rootValue) {
+        if (errorPosition) {
+            *errorPosition = parser.errorPosition;
+        }
+        if (error) {
+            *error = QString("Error: %1 at position %2")
+                         .arg(QLatin1String(parser.errorMessage))
+                         .arg(parser.errorPosition);
+        }
+        keys.clear();
+        arena = Arena();
+        source.clear();
+        return false;
+    }
+    nodes = parser.nodes;
+    return true;
+}
+
+QByteArray Json5Document::toJson(Deadline *deadline) const {
+    return toJson(rootValue, deadline);
+}
+
+QByteArray Json5Document::toJson(const Value *value, Deadline *deadline) {
+    struct Frame {
+        const Value *container;
+        qsizetype next;
+    };
+
+    QByteArray out;
+    QList<Frame> stack;
+    const Value *current = value;
+    while (current || !stack.isEmpty()) {
+        if (deadline && deadline->expired()) {
+            return QByteArray();
+        }
+        if (current) {
+            if (isContainer(current)) {
+                out.append(current->type == Object ? '{' : '[');
+                stack.append({current, 0});
+            } else {
+                appendScalar(out, current);
+            }
+            current = nullptr;
+            continue;
+        }
+
+        Frame &top = stack.last();
+        const Value *container = top.container;
+        if (top.next == container->size) {
+            out.append(container->type == Object ? '}' : ']');
+            stack.removeLast();
+            continue;
+        }
+        if (top.next > 0) {
+            out.append(',');
+        }
+        if (container->type == Object) {
+            const Member &member = container->members[top.next];
+            appendString(out, member.key->view());
+            out.append(':');
+            current = member.value;
+        } else {
+            current = container->items[top.next];
+        }
+        top.next++;
+    }
+    return out;
+}
+
+void Json5Document::sortKeys() {
+    QList<Value *> pending;
+    if (rootValue) {
+        pending.append(rootValue);
+    }
+    while (!pending.isEmpty()) {
+        Value *value = pending.takeLast();
+        if (value->type == Object) {
+            std::stable_sort(
+                value->members, value->members + value->size,
+                [](const Member &a, const Member &b) { return keyLess(a.key, b.key); });
+            for (qsizetype i = 0; i < value->size; i++) {
+                pending.append(value->members[i].value);
+            }
+        } else if (value->type == Array) {
+            for (qsizetype i = 0; i < value->size; i++) {
+                pending.append(value->items[i]);
+            }
+        }
+    }
+}
+
+QList<Json5Document::DuplicateKey> Json5Document::duplicateKeys() const {
+    struct Pending {
+        const Value *value;
+        QString path;
+    };
+
+    QList<DuplicateKey> duplicates;
+    QList<Pending> pending;
+    if (rootValue) {
+        pending.append({rootValue, QString()});
+    }
+    QSet<const Key *> seen;
+    while (!pending.isEmpty()) {
+        const Pending current = pending.takeLast();
+        const Value *value = current.value;
+        if (value->type == Object) {
+            seen.clear();
+            for (qsizetype i = 0; i < value->size; i++) {
+                const Member &member = value->members[i];
+                if (seen.contains(member.key)) {
+                    duplicates.append(
+                        {current.path, member.key->view().toByteArray(), member.position});
+                }
+                seen.insert(member.key);
+            }
+        }
+        // Children are queued in reverse so the report follows document order
+        for (qsizetype i = isContainer(value) ? value->size - 1 : -1; i >= 0; i--) {
+            if (value->type == Object) {
+                const Member &member = value->members[i];
+                if (isContainer(member.value)) {
+                    pending.append({member.value, current.path + pointerStep(member.key->view())});
+                }
+            } else if (isContainer(value->items[i])) {
+                pending.append({value->items[i], current.path + '/' + QString::number(i)});
+            }
+        }
+    }
+    std::sort(duplicates.begin(), duplicates.end(),
+              [](const DuplicateKey &a, const DuplicateKey &b) { return a.position < b.position; });
+    return duplicates;
+}
+
+QList<Json5Document::Difference> Json5Document::diff(const Json5Document &before,
+                                                     const Json5Document &after) {
+    struct Pair {
+        const Value *before;
+        const Value *after;
+        QString path;
+    };
+
+    QList<Difference> differences;
+    QList<Pair> pending;
+    pending.append({before.rootValue, after.rootValue, QString()});
+    while (!pending.isEmpty()) {
+        const Pair pair = pending.takeLast();
+        const Value *a = pair.before;
+        const Value *b = pair.after;
+        if (!a || !b) {
+            if (a || b) {
+                differences.append({a ? Difference::Removed : Difference::Added, pair.path,
+                                    toJson(a), toJson(b)});
+            }
+            continue;
+        }
+        if (a->type != b->type || (!isContainer(a) && !sameScalar(a, b))) {
+            differences.append({Difference::Changed, pair.path, toJson(a), toJson(b)});
+            continue;
+        }
+
+        // Children are compared in document order: collect them, then queue in reverse
+        QList<Pair> children;
+        if (a->type == Object) {
+            // Members are matched by key; when a key repeats, its last value counts
+            const QHash<QByteArrayView, const Value *> beforeMembers = lastMembers(a);
+            const QHash<QByteArrayView, const Value *> afterMembers = lastMembers(b);
+            for (qsizetype i = 0; i < a->size; i++) {
+                const QByteArrayView key = a->members[i].key->view();
+                if (beforeMembers.value(key) == a->members[i].value) {
+                    children.append({a->members[i].value, afterMembers.value(key),
+                                     pair.path + pointerStep(key)});
+                }
+            }
+            for (qsizetype i = 0; i < b->size; i++) {
+                const QByteArrayView key = b->members[i].key->view();
+                const Value *value = b->members[i].value;
+                if (!beforeMembers.contains(key) && afterMembers.value(key) == value) {
+                    children.append({nullptr, value, pair.path + pointerStep(key)});
+                }
+            }
+        } else if (a->type == Array) {
+            for (qsizetype i = 0; i < qMax(a->size, b->size); i++) {
+                children.append({i < a->size ? a->items[i] : nullptr,
+                                 i < b->size ? b->items[i] : nullptr,
+                                 pair.path + '/' + QString::number(i)});
+            }
+        }
+        for (qsizetype i = children.size() - 1; i >= 0; i--) {
+            pending.append(children[i]);
+        }
+    }
+    return differences;
+}
\ No newline at end of file
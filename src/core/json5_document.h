@@ -0,0 +1,103 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "arena.h"
+
+class Deadline;
+
+// Relaxed JSON parsed into a tree. Besides strict JSON, the parser takes JSON5: comments, single
+// quoted strings, unquoted keys, trailing commas, hex numbers, leading or trailing decimal
+// points, explicit plus signs, Infinity and NaN. As a last resort for hand-edited payloads, a
+// bare word where a value belongs inside an object or array ({"mode": fast}) is read as a
+// string; at the top level only true, false, null, Infinity and NaN are.
+//
+// The parse is a single pass without recursion. Nodes live in an arena owned by the document,
+// object keys are interned so each distinct key is stored once, and strings without escapes
+// point straight into the source, which the document keeps alive. Destroying the document frees
+// everything at once, however many nodes it holds.
+class Json5Document {
+  public:
+    enum Type { Null, Bool, Number, String, Array, Object };
+
+    struct Key {
+        const char *data;
+        qsizetype size;
+
+        QByteArrayView view() const { return QByteArrayView(data, size); }
+    };
+
+    struct Member;
+
+    struct Value {
+        Type type;
+        bool boolean;
+        qsizetype position;  // offset of the value in the source
+        qsizetype size;      // bytes of a String or Number, entries of an Array or Object
+        union {
+            const char *text;  // String contents decoded, or the Number as written
+            Value **items;
+            Member *members;
+        };
+
+        QByteArrayView string() const { return QByteArrayView(text, size); }
+        double toDouble() const;  // a Number's value, converted when asked for
+        const Value *find(QByteArrayView key) const;  // the last member named `key`, if any
+    };
+
+    struct Member {
+        const Key *key;
+        qsizetype position;  // offset of the key in the source
+        Value *value;
+    };
+
+    struct DuplicateKey {
+        QString path;        // JSON Pointer to the object holding the key twice, "" for the root
+        QByteArray key;
+        qsizetype position;  // offset of the repeated occurrence
+    };
+
+    struct Difference {
+        enum Kind { Added, Removed, Changed };
+
+        Kind kind;
+        QString path;  // JSON Pointer, "" for the root; members matched by key, items by index
+        QByteArray before;
+        QByteArray after;
+    };
+
+    Json5Document() = default;
+    Json5Document(const Json5Document &) = delete;
+    Json5Document &operator=(const Json5Document &) = delete;
+
+    // Replaces the current tree. On failure the document is empty and errorPosition receives
+    // the byte offset of the offending character. Once `deadline` has expired the parse stops
+    // and fails where it got to.
+    bool parse(const QByteArray &source, qsizetype *errorPosition = nullptr,
+               QString *error = nullptr, Deadline *deadline = nullptr);
+
+    const Value *root() const { return rootValue; }
+    qsizetype nodeCount() const { return nodes; }
+    qsizetype arenaSize() const { return arena.bytesUsed(); }
+
+    // Strict JSON, compact, members in document order. Infinity and NaN have no JSON spelling
+    // and are written as null. Empty if `deadline` expires before the end.
+    QByteArray toJson(Deadline *deadline = nullptr) const;
+
+    void sortKeys();  // stable, so repeated keys keep their relative order
+    QList<DuplicateKey> duplicateKeys() const;
+    static QList<Difference> diff(const Json5Document &before, const Json5Document &after);
+
+    static QByteArray toJson(const Value *value, Deadline *deadline = nullptr);
+
+  private:
+    QByteArray source;
+    Arena arena;
+    QHash<QByteArrayView, const Key *> keys;
+    Value *rootValue = nullptr;
+    qsizetype nodes = 0;
+};
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "json_formatter.h"
+
+#include "json_index.h"
+
+namespace {
+
+bool isWhitespace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+bool isStructural(char ch) {
+    switch (ch) {
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ',':
+        case ':':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool endsScalar(char ch) {
+    switch (ch) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ',':
+        case ':':
+        case '"':
+            return true;
+        default:
+            return false;
+    }
+}
+
+}  // namespace
+
+JsonFormatter::JsonFormatter() : JsonFormatter(Options()) {}
+
+JsonFormatter::JsonFormatter(const Options &options) : options(options) {
+    indentUnit = options.useTabs ? QByteArray("\t") : QByteArray(qMax(0, options.indentWidth), ' ');
+}
+
+QByteArray JsonFormatter::format(QByteArrayView input) {
+    return format(input, Options());
+}
+
+QByteArray JsonFormatter::format(QByteArrayView input, const Options &options) {
+    // A whole document is walked over its structural index instead of byte by byte: strings and
+    // scalars are copied in one piece and whitespace between tokens is never looked at. The tape is
+    // consumed as it is built, so it stays small and in cache.
+    JsonFormatter formatter(options);
+    formatter.output.reserve(input.size() + (options.compact ? 0 : input.size() / 2));
+
+    JsonIndex::Scanner scanner;
+    QList<qsizetype> tape;
+    qsizetype window = 0;
+    do {
+        const qsizetype length = qMin(JsonIndex::kWindowSize, input.size() - window);
+        scanner.scan(input.sliced(window, length), tape);
+        window += length;
+        const bool final = window == input.size();
+        if (final) {
+            scanner.finish(tape);
+        }
+        tape.remove(0, formatter.writeTape(input, tape, final));
+    } while (window < input.size());
+    return formatter.takeOutput();
+}
+
+void JsonFormatter::push(QByteArrayView chunk) {
+    output.reserve(output.size() + chunk.size() + (options.compact ? 0 : chunk.size() / 2));
+
+    const char *pos = chunk.data();
+    const char *end = pos + chunk.size();
+    while (pos < end) {
+        if (inString) {
+            // Strings are copied in runs up to the next quote or backslash
+            const char *run = pos;
+            if (escaped) {
+                pos++;  // the escaped character was cut off from its backslash by the chunk
+                escaped = false;
+            }
+            while (pos < end && *pos != '"' && *pos != '\\') {
+                pos++;
+            }
+            if (pos < end && *pos == '\\') {
+                pos++;
+                if (pos < end) {
+                    pos++;
+                } else {
+                    escaped = true;
+                }
+            } else if (pos < end) {
+                pos++;
+                inString = false;
+            }
+            output.append(run, pos - run);
+            continue;
+        }
+
+        const char ch = *pos;
+        switch (ch) {
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                pos++;
+                break;
+            case '{':
+            case '[':
+            case '}':
+            case ']':
+            case ',':
+            case ':':
+                writeStructural(ch);
+                pos++;
+                break;
+            case '"':
+                beginToken();
+                output.append(ch);
+                inString = true;
+                pos++;
+                break;
+            default: {
+                // Numbers, literals and anything unexpected pass through as written
+                beginToken();
+                const char *run = pos;
+                while (pos < end && !endsScalar(*pos)) {
+                    pos++;
+                }
+                output.append(run, pos - run);
+                break;
+            }
+        }
+    }
+}
+
+QByteArray JsonFormatter::takeOutput() {
+    QByteArray taken;
+    taken.swap(output);
+    return taken;
+}
+
+qsizetype JsonFormatter::writeTape(QByteArrayView input, const QList<qsizetype> &tape, bool final) {
+    const char *data = input.data();
+    qsizetype t = 0;
+    for (; t < tape.size(); t++) {
+        const qsizetype pos = tape[t];
+        const char ch = data[pos];
+        if (isStructural(ch)) {
+            writeStructural(ch);
+            continue;
+        }
+
+        // Strings end at the next entry, their closing quote; scalars at the whitespace before it
+        const bool known = t + 1 < tape.size();
+        if (!known && !final) {
+            break;
+        }
+        qsizetype end = known ? tape[t + 1] : input.size();
+        if (ch == '"') {
+            end = known ? tape[++t] + 1 : end;
+        } else {
+            while (isWhitespace(data[end - 1])) {
+                end--;
+            }
+        }
+        beginToken();
+        output.append(data + pos, end - pos);
+    }
+    return t;
+}
+
+void JsonFormatter::writeStructural(char ch) {
+    switch (ch) {
+        case '{':
+        case '[':
+            beginToken();
+            output.append(ch);
+            depth++;
+            breakPending = true;
+            justOpened = true;
+            break;
+        case '}':
+        case ']':
+            depth = qMax(0, depth - 1);
+            breakPending = !justOpened;  // {} and [] stay together
+            beginToken();
+            output.append(ch);
+            valueEnded = depth == 0;
+            break;
+        case ',':
+            output.append(ch);
+            breakPending = true;
+            break;
+        default:
+            output.append(ch);
+            if (!options.compact) {
+                output.append(' ');
+            }
+            break;
+    }
+}
+
+void JsonFormatter::beginToken() {
+    justOpened = false;
+    if (valueEnded) {
+        output.append('\n');  // values of a stream go one per line, even when compact
+    } else if (breakPending && !options.compact) {
+        output.append('\n');
+        for (int i = 0; i < depth; i++) {
+            output.append(indentUnit);
+        }
+    }
+    valueEnded = false;
+    breakPending = false;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+
+// Incremental JSON pretty-printer. Feed UTF-8 chunks of any size with push() and drain the
+// formatted text with takeOutput(); the only state kept between chunks is a handful of flags
+// and the nesting depth, so documents far larger than memory can be piped through. Input is
+// reformatted as written: structure is not validated, and text inside strings is never touched.
+// The one-shot format() drives the same output rules from a JsonIndex tape instead.
+class JsonFormatter {
+  public:
+    struct Options {
+        int indentWidth = 2;
+        bool useTabs = false;  // one tab per level instead of indentWidth spaces
+        bool compact = false;  // minify: drop all whitespace outside strings
+    };
+
+    JsonFormatter();
+    explicit JsonFormatter(const Options &options);
+
+    void push(QByteArrayView chunk);
+    QByteArray takeOutput();
+
+    static QByteArray format(QByteArrayView input);
+    static QByteArray format(QByteArrayView input, const Options &options);
+
+  private:
+    // Writes the tokens at the given JsonIndex entries and returns how many were used; without
+    // `final`, an entry whose extent depends on the next one is left for the next call.
+    qsizetype writeTape(QByteArrayView input, const QList<qsizetype> &tape, bool final);
+    void writeStructural(char ch);  // one of { } [ ] , :
+    void beginToken();
+
+    Options options;
+    QByteArray indentUnit;
+    QByteArray output;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    bool breakPending = false;  // a line break and indentation are due before the next token
+    bool justOpened = false;    // nothing since the last '{' or '['; a close keeps them together
+    bool valueEnded = false;    // a top-level value was closed; the next one starts a new line
+};
\ No newline at end of file
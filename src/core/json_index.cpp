@@ -0,0 +1,534 @@
+#include "json_index.h"
+
+#include <QtCore/qalgorithms.h>
+
+#include <array>
+
+#include "simd.h"
+
+namespace {
+
+constexpr qsizetype kBlockSize = 64;
+
+// One bit per byte of a 64-byte block, bit i standing for byte i.
+struct BlockMasks {
+    quint64 quote = 0;
+    quint64 backslash = 0;
+    quint64 whitespace = 0;
+    quint64 structural = 0;  // { } [ ] : ,
+};
+
+// ============================================================================
+// Classification kernels
+// ============================================================================
+
+enum ByteClass : unsigned char {
+    kQuote = 1,
+    kBackslash = 2,
+    kWhitespace = 4,
+    kStructural = 8
+};
+
+constexpr std::array<unsigned char, 256> makeByteClassTable() {
+    std::array<unsigned char, 256> table{};
+    table['"'] = kQuote;
+    table['\\'] = kBackslash;
+    table[' '] = table['\t'] = table['\n'] = table['\r'] = kWhitespace;
+    table['{'] = table['}'] = table['['] = table[']'] = table[':'] = table[','] = kStructural;
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> kByteClass = makeByteClassTable();
+
+using ClassifyKernel = void (*)(const char *block, BlockMasks &masks);
+
+void classifyScalar(const char *block, BlockMasks &masks) {
+    for (int i = 0; i < kBlockSize; i++) {
+        const unsigned char cls = kByteClass[static_cast<unsigned char>(block[i])];
+        const quint64 bit = quint64(1) << i;
+        masks.quote |= (cls & kQuote) ? bit : 0;
+        masks.backslash |= (cls & kBackslash) ? bit : 0;
+        masks.whitespace |= (cls & kWhitespace) ? bit : 0;
+        masks.structural |= (cls & kStructural) ? bit : 0;
+    }
+}
+
+#if defined(DAVE_SIMD_X86)
+
+DAVE_TARGET_AVX2 inline quint64 matchMask32(__m256i v, char ch) {
+    return static_cast<quint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(ch))));
+}
+
+DAVE_TARGET_AVX2 void classifyAvx2(const char *block, BlockMasks &masks) {
+    for (int half = 0; half < 2; half++) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + half * 32));
+        // '{' and '[' differ only in bit 0x20, as do '}' and ']'
+        const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        const int shift = half * 32;
+        masks.quote |= matchMask32(v, '"') << shift;
+        masks.backslash |= matchMask32(v, '\\') << shift;
+        masks.whitespace |= (matchMask32(v, ' ') | matchMask32(v, '\t') | matchMask32(v, '\n') |
+                             matchMask32(v, '\r'))
+                            << shift;
+        masks.structural |= (matchMask32(folded, '{') | matchMask32(folded, '}') |
+                             matchMask32(v, ':') | matchMask32(v, ','))
+                            << shift;
+    }
+}
+
+#elif defined(DAVE_SIMD_NEON)
+
+// Gathers the top bit of each byte of four comparison results into one 64-bit mask.
+inline quint64 movemaskNeon(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) {
+    static const uint8_t kWeights[16] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                                         0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+    const uint8x16_t weights = vld1q_u8(kWeights);
+    uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+    const uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+inline uint8x16_t whitespaceNeon(uint8x16_t v) {
+    return vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+                    vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+}
+
+inline uint8x16_t structuralNeon(uint8x16_t v) {
+    const uint8x16_t folded = vorrq_u8(v, vdupq_n_u8(0x20));
+    return vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+                    vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+}
+
+void classifyNeon(const char *block, BlockMasks &masks) {
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(block);
+    const uint8x16_t v0 = vld1q_u8(in);
+    const uint8x16_t v1 = vld1q_u8(in + 16);
+    const uint8x16_t v2 = vld1q_u8(in + 32);
+    const uint8x16_t v3 = vld1q_u8(in + 48);
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    masks.quote = movemaskNeon(vceqq_u8(v0, quote), vceqq_u8(v1, quote), vceqq_u8(v2, quote),
+                               vceqq_u8(v3, quote));
+    masks.backslash = movemaskNeon(vceqq_u8(v0, backslash), vceqq_u8(v1, backslash),
+                                   vceqq_u8(v2, backslash), vceqq_u8(v3, backslash));
+    masks.whitespace = movemaskNeon(whitespaceNeon(v0), whitespaceNeon(v1), whitespaceNeon(v2),
+                                    whitespaceNeon(v3));
+    masks.structural = movemaskNeon(structuralNeon(v0), structuralNeon(v1), structuralNeon(v2),
+                                    structuralNeon(v3));
+}
+
+#endif
+
+ClassifyKernel selectClassifyKernel() {
+#if defined(DAVE_SIMD_X86)
+    if (simd::cpuFeatures().avx2) {
+        return &classifyAvx2;
+    }
+#elif defined(DAVE_SIMD_NEON)
+    return &classifyNeon;
+#endif
+    return &classifyScalar;
+}
+
+// Bit i of the result is the XOR of bits 0..i of x: ones from each opening quote up to, but
+// not including, the matching closing quote.
+inline quint64 prefixXor(quint64 x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// ============================================================================
+// Validation
+// ============================================================================
+
+// Scalars run to the next whitespace, structural character or quote. A backslash does not end
+// one, so a stray escape outside a string is reported as part of the scalar it sits in.
+bool endsScalar(char ch) {
+    return (kByteClass[static_cast<unsigned char>(ch)] & ~kBackslash) != 0;
+}
+
+bool isSimpleEscape(char ch) {
+    switch (ch) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+bool isHexDigit(char ch) {
+    return isDigit(ch) || (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F');
+}
+
+// Returns the offset of the first byte that breaks the number or literal in [pos, end), or -1.
+qsizetype checkScalar(const char *data, qsizetype pos, qsizetype end) {
+    for (const char *literal : {"true", "false", "null"}) {
+        if (data[pos] != literal[0]) {
+            continue;
+        }
+        qsizetype i = pos;
+        for (const char *ch = literal; *ch; ch++, i++) {
+            if (i == end || data[i] != *ch) {
+                return i;
+            }
+        }
+        return i == end ? -1 : i;
+    }
+
+    qsizetype i = pos;
+    if (data[i] == '-') {
+        i++;
+    }
+    if (i == end || !isDigit(data[i])) {
+        return i;
+    }
+    if (data[i] == '0') {
+        i++;
+    } else {
+        while (i < end && isDigit(data[i])) {
+            i++;
+        }
+    }
+    if (i < end && data[i] == '.') {
+        if (++i == end || !isDigit(data[i])) {
+            return i;
+        }
+        while (i < end && isDigit(data[i])) {
+            i++;
+        }
+    }
+    if (i < end && (data[i] == 'e' || data[i] == 'E')) {
+        i++;
+        if (i < end && (data[i] == '+' || data[i] == '-')) {
+            i++;
+        }
+        if (i == end || !isDigit(data[i])) {
+            return i;
+        }
+        while (i < end && isDigit(data[i])) {
+            i++;
+        }
+    }
+    return i == end ? -1 : i;
+}
+
+// Checks the contents of a string between its quotes: escapes, control characters and UTF-8.
+// Returns the offset of the first offending byte, or -1; `message` says what was wrong.
+qsizetype checkString(const char *data, qsizetype pos, qsizetype end, const char **message) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    qsizetype i = pos;
+    while (i < end) {
+        const unsigned char ch = bytes[i];
+        if (ch >= 0x20 && ch < 0x80 && ch != '\\') {
+            i++;
+            continue;
+        }
+        if (ch < 0x20) {
+            *message = "Unescaped control character in string";
+            return i;
+        }
+        if (ch == '\\') {
+            const char escape = i + 1 < end ? data[i + 1] : '\0';
+            if (escape == 'u') {
+                for (qsizetype j = i + 2; j < i + 6; j++) {
+                    if (j >= end || !isHexDigit(data[j])) {
+                        *message = "Invalid \\u escape";
+                        return j;
+                    }
+                }
+                i += 6;
+            } else if (isSimpleEscape(escape)) {
+                i += 2;
+            } else {
+                *message = "Invalid escape";
+                return i + 1;
+            }
+            continue;
+        }
+
+        // Multi-byte UTF-8: no overlong forms, no surrogates, nothing past U+10FFFF
+        int length;
+        unsigned char lo = 0x80;
+        unsigned char hi = 0xBF;
+        if (ch >= 0xC2 && ch <= 0xDF) {
+            length = 2;
+        } else if (ch >= 0xE0 && ch <= 0xEF) {
+            length = 3;
+            lo = ch == 0xE0 ? 0xA0 : 0x80;
+            hi = ch == 0xED ? 0x9F : 0xBF;
+        } else if (ch >= 0xF0 && ch <= 0xF4) {
+            length = 4;
+            lo = ch == 0xF0 ? 0x90 : 0x80;
+            hi = ch == 0xF4 ? 0x8F : 0xBF;
+        } else {
+            *message = "Invalid UTF-8";
+            return i;
+        }
+        for (int k = 1; k < length; k++) {
+            const unsigned char next = i + k < end ? bytes[i + k] : 0;
+            if (next < (k == 1 ? lo : 0x80) || next > (k == 1 ? hi : 0xBF)) {
+                *message = "Invalid UTF-8";
+                return i + k;
+            }
+        }
+        i += length;
+    }
+    return -1;
+}
+
+// Grammar check over tape entries. It can be resumed, so the tape may be consumed a window at a
+// time while it is being built.
+class Validator {
+  public:
+    Validator(QByteArrayView input, qsizetype *errorPosition, QString *error)
+        : data(input.data()), size(input.size()), errorPosition(errorPosition), error(error) {}
+
+    // Checks entries from the front of `tape` and returns how many were used. Unless `final`, a
+    // string whose closing quote is not on the tape yet is left for the next call.
+    qsizetype run(const QList<qsizetype> &tape, bool final);
+    bool finish();  // called once the input is exhausted
+
+    bool failed = false;
+
+  private:
+    enum Expect { Value, Key, Colon, AfterValue };
+
+    bool fail(qsizetype position, const char *message);
+
+    const char *data;
+    qsizetype size;
+    qsizetype *errorPosition;
+    QString *error;
+    QByteArray open;  // '{' or '[' for each enclosing container
+    Expect expect = Value;
+    bool justOpened = false;  // nothing since the last '{' or '['
+};
+
+qsizetype Validator::run(const QList<qsizetype> &tape, bool final) {
+    qsizetype t = 0;
+    while (t < tape.size()) {
+        const qsizetype pos = tape[t];
+        const char ch = data[pos];
+        const char close = open.isEmpty() ? '\0' : (open.back() == '{' ? '}' : ']');
+
+        if (expect == AfterValue) {
+            if (open.isEmpty()) {
+                fail(pos, "Unexpected content after the value");
+                return t;
+            }
+            if (ch == ',') {
+                expect = open.back() == '{' ? Key : Value;
+            } else if (ch == close) {
+                open.chop(1);
+            } else {
+                fail(pos, close == '}' ? "Expected ',' or '}'" : "Expected ',' or ']'");
+                return t;
+            }
+            t++;
+            continue;
+        }
+        if (expect == Colon) {
+            if (ch != ':') {
+                fail(pos, "Expected ':'");
+                return t;
+            }
+            expect = Value;
+            t++;
+            continue;
+        }
+
+        // A value, or a key, which must be a string
+        const bool opened = justOpened;
+        justOpened = false;
+        if (opened && ch == close) {
+            open.chop(1);  // {} or []
+            expect = AfterValue;
+            t++;
+        } else if (expect == Key && ch != '"') {
+            fail(pos, "Expected a string key");
+            return t;
+        } else if (ch == '{' || ch == '[') {
+            open.append(ch);
+            expect = ch == '{' ? Key : Value;
+            justOpened = true;
+            t++;
+        } else if (ch == '"') {
+            if (t + 1 == tape.size()) {
+                if (final) {
+                    fail(size, "Unterminated string");
+                }
+                justOpened = opened;
+                return t;
+            }
+            const char *message = nullptr;
+            const qsizetype bad = checkString(data, pos + 1, tape[t + 1], &message);
+            if (bad >= 0) {
+                fail(bad, message);
+                return t;
+            }
+            expect = expect == Key ? Colon : AfterValue;
+            t += 2;
+        } else if (!endsScalar(ch)) {
+            qsizetype end = pos + 1;
+            while (end < size && !endsScalar(data[end])) {
+                end++;
+            }
+            const qsizetype bad = checkScalar(data, pos, end);
+            if (bad >= 0) {
+                fail(bad, "Invalid literal");
+                return t;
+            }
+            expect = AfterValue;
+            t++;
+        } else {
+            fail(pos, "Expected a value");
+            return t;
+        }
+    }
+    return t;
+}
+
+bool Validator::finish() {
+    if (failed) {
+        return false;
+    }
+    if (expect != AfterValue || !open.isEmpty()) {
+        return fail(size, "Unexpected end of input");
+    }
+    return true;
+}
+
+bool Validator::fail(qsizetype position, const char *message) {
+    failed = true;
+    if (errorPosition) {
+        *errorPosition = position;
+    }
+    if (error) {
+        *error = QString("Error: %1 at position %2").arg(QLatin1String(message)).arg(position);
+    }
+    return false;
+}
+
+}  // namespace
+
+void JsonIndex::Scanner::scan(QByteArrayView chunk, QList<qsizetype> &tape) {
+    const char *pos = chunk.data();
+    const char *end = pos + chunk.size();
+    if (!pending.isEmpty()) {
+        const qsizetype needed = qMin<qsizetype>(kBlockSize - pending.size(), end - pos);
+        pending.append(pos, needed);
+        pos += needed;
+        if (pending.size() < kBlockSize) {
+            return;
+        }
+        scanBlock(pending.constData(), tape);
+        pending.clear();
+    }
+    while (end - pos >= kBlockSize) {
+        scanBlock(pos, tape);
+        pos += kBlockSize;
+    }
+    pending.append(pos, end - pos);
+}
+
+void JsonIndex::Scanner::finish(QList<qsizetype> &tape) {
+    if (pending.isEmpty()) {
+        return;
+    }
+    pending.append(kBlockSize - pending.size(), ' ');  // whitespace never reaches the tape
+    scanBlock(pending.constData(), tape);
+    pending.clear();
+}
+
+void JsonIndex::Scanner::scanBlock(const char *block, QList<qsizetype> &tape) {
+    static const ClassifyKernel classify = selectClassifyKernel();
+    BlockMasks masks;
+    classify(block, masks);
+
+    // A character is escaped when preceded by an odd-length run of backslashes. Adding the
+    // runs that start on odd bits to the backslash mask carries each of them past its end, which
+    // flips the parity pattern for exactly those runs; the carry out of bit 63 is the escape
+    // state of the next block.
+    constexpr quint64 kEvenBits = 0x5555555555555555ULL;
+    const quint64 backslash = masks.backslash & ~escaped;
+    const quint64 followsEscape = (backslash << 1) | escaped;
+    const quint64 oddStarts = backslash & ~kEvenBits & ~followsEscape;
+    const quint64 evenStarts = oddStarts + backslash;
+    escaped = evenStarts < backslash ? 1 : 0;
+    const quint64 escapedBits = (kEvenBits ^ (evenStarts << 1)) & followsEscape;
+
+    const quint64 quotes = masks.quote & ~escapedBits;
+    const quint64 strings = prefixXor(quotes) ^ inString;
+    inString = static_cast<quint64>(static_cast<qint64>(strings) >> 63);
+
+    const quint64 scalar = ~(masks.whitespace | masks.structural | masks.quote | strings);
+    const quint64 scalarStarts = scalar & ~((scalar << 1) | scalarCarry);
+    scalarCarry = scalar >> 63;
+
+    quint64 bits = (masks.structural & ~strings) | quotes | scalarStarts;
+    if (bits) {
+        const qsizetype used = tape.size();
+        tape.resize(used + qPopulationCount(bits));
+        qsizetype *out = tape.data() + used;
+        while (bits) {
+            *out++ = offset + qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+        }
+    }
+    offset += kBlockSize;
+}
+
+QList<qsizetype> JsonIndex::build(QByteArrayView input) {
+    QList<qsizetype> tape;
+    Scanner scanner;
+    scanner.scan(input, tape);
+    scanner.finish(tape);
+    return tape;
+}
+
+bool JsonIndex::validate(QByteArrayView input, qsizetype *errorPosition, QString *error) {
+    // The tape is checked as it is built, so memory stays flat whatever the input size
+    Validator validator(input, errorPosition, error);
+    Scanner scanner;
+    QList<qsizetype> tape;
+    qsizetype window = 0;
+    do {
+        const qsizetype length = qMin(kWindowSize, input.size() - window);
+        scanner.scan(input.sliced(window, length), tape);
+        window += length;
+        const bool final = window == input.size();
+        if (final) {
+            scanner.finish(tape);
+        }
+        tape.remove(0, validator.run(tape, final));
+        if (validator.failed) {
+            return false;
+        }
+    } while (window < input.size());
+    return validator.finish();
+}
+
+bool JsonIndex::validate(QByteArrayView input, const QList<qsizetype> &tape,
+                         qsizetype *errorPosition, QString *error) {
+    Validator validator(input, errorPosition, error);
+    validator.run(tape, true);
+    return !validator.failed && validator.finish();
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+
+// Structural index of a JSON text, built in the manner of simdjson's stage 1. Input is
+// classified 64 bytes at a time (AVX2 or NEON where available, scalar otherwise) into bitmasks
+// of quotes, backslashes, whitespace and structural characters; escapes and string regions are
+// then resolved with carry-propagating bit arithmetic, so no byte is ever branched on.
+//
+// The resulting tape holds, in order, the offset of every structural character outside strings
+// ({ } [ ] : ,), of both quotes of every string, and of the first byte of every other scalar.
+// Consumers (validation, formatting, queries) walk the tape instead of the raw bytes.
+class JsonIndex {
+  public:
+    // Input handed to each Scanner::scan() call by consumers that use the tape as it is built
+    static constexpr qsizetype kWindowSize = 64 * 1024;
+
+    // Incremental indexer for input that arrives in chunks. Bytes are classified in whole
+    // 64-byte blocks; up to 63 trailing bytes are held back until more input or finish().
+    class Scanner {
+      public:
+        void scan(QByteArrayView chunk, QList<qsizetype> &tape);
+        void finish(QList<qsizetype> &tape);
+
+      private:
+        void scanBlock(const char *block, QList<qsizetype> &tape);
+
+        QByteArray pending;
+        qsizetype offset = 0;       // input offset of the next block
+        quint64 inString = 0;       // all ones while the previous block ended inside a string
+        quint64 escaped = 0;        // 1 if the first byte of the next block is escaped
+        quint64 scalarCarry = 0;    // 1 if the previous block ended inside a scalar
+    };
+
+    static QList<qsizetype> build(QByteArrayView input);
+
+    // Strict RFC 8259 check of a single JSON text. On failure, errorPosition receives the
+    // byte offset of the first offending character (the input size if the text is cut short).
+    static bool validate(QByteArrayView input, qsizetype *errorPosition = nullptr,
+                         QString *error = nullptr);
+    static bool validate(QByteArrayView input, const QList<qsizetype> &tape,
+                         qsizetype *errorPosition = nullptr, QString *error = nullptr);
+};
\ No newline at end of file
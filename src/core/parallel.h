@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+#include <atomic>
+#include <functional>
+
+namespace parallel {
+
+// Number of workers worth splitting `length` units of work across when each worker should
+// get at least `minPerWorker` units.
+inline int workerCount(qsizetype length, qsizetype minPerWorker) {
+    const qsizetype byLength = minPerWorker > 0 ? length / minPerWorker : length;
+    return static_cast<int>(qBound<qsizetype>(1, byLength, QThread::idealThreadCount()));
+}
+
+// Runs task(0) .. task(count - 1) on the global thread pool and the calling thread and returns
+// once all of them have finished. Helpers are only started on idle pool threads (tryStart), so
+// this is safe to call from a pool thread: in the worst case the caller runs every task itself.
+inline void forEach(int count, const std::function<void(int)> &task) {
+    if (count <= 0) {
+        return;
+    }
+
+    std::atomic<int> next{0};
+    auto drain = [&]() {
+        for (int i = next++; i < count; i = next++) {
+            task(i);
+        }
+    };
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    QSemaphore done;
+    int started = 0;
+    for (int helper = 1; helper < count; helper++) {
+        if (!pool->tryStart([&]() {
+                drain();
+                done.release();
+            })) {
+            break;
+        }
+        started++;
+    }
+
+    drain();
+    done.acquire(started);
+}
+
+}  // namespace parallel
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+// Shared helpers for the vectorized kernels in dave_core.
+//
+// Kernels are compiled for their instruction set with DAVE_TARGET_* so the library itself
+// keeps the baseline architecture flags; callers pick a kernel at runtime via cpuFeatures().
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define DAVE_SIMD_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define DAVE_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+#if defined(DAVE_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define DAVE_TARGET_SSE41 __attribute__((target("sse4.1")))
+    #define DAVE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define DAVE_TARGET_SSE41
+    #define DAVE_TARGET_AVX2
+#endif
+
+namespace simd {
+
+struct CpuFeatures {
+    bool sse41 = false;
+    bool avx2 = false;
+    bool neon = false;
+};
+
+inline CpuFeatures detectCpuFeatures() {
+    CpuFeatures features;
+#if defined(DAVE_SIMD_X86)
+    #if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = {};
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    if (maxLeaf >= 1) {
+        __cpuid(info, 1);
+        features.sse41 = (info[2] & (1 << 19)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (osxsave && maxLeaf >= 7) {
+            const bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+            __cpuidex(info, 7, 0);
+            features.avx2 = ymmEnabled && (info[1] & (1 << 5)) != 0;
+        }
+    }
+    #else
+    __builtin_cpu_init();
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    #endif
+#elif defined(DAVE_SIMD_NEON)
+    features.neon = true;  // Advanced SIMD is mandatory on AArch64
+#endif
+    return features;
+}
+
+inline const CpuFeatures &cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+}  // namespace simd
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+// Cancellation and progress for one long-running call, shared between the thread that runs it
+// and the one that started it. The call polls cancelled() at its checkpoints and returns early
+// with what it has; cancel() may come from any thread at any time. Progress goes to a callback
+// on whichever thread does the work, at most once per whole percent and never backwards: calls
+// from concurrent workers are serialised.
+class TaskControl {
+  public:
+    using ProgressCallback = std::function<void(int percent)>;
+
+    TaskControl() = default;
+    explicit TaskControl(ProgressCallback callback) : callback(std::move(callback)) {}
+    TaskControl(const TaskControl &) = delete;
+    TaskControl &operator=(const TaskControl &) = delete;
+
+    void cancel() { flag.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return flag.load(std::memory_order_relaxed); }
+
+    // `done` units of `total`; safe to call from several workers at once
+    void report(qint64 done, qint64 total) {
+        if (!callback || total <= 0) {
+            return;
+        }
+        const int percent = static_cast<int>(qBound<qint64>(0, done * 100 / total, 100));
+        if (percent <= lastPercent.load(std::memory_order_relaxed)) {
+            return;  // the common case, without taking the lock
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (percent > lastPercent.load(std::memory_order_relaxed)) {
+            lastPercent.store(percent, std::memory_order_relaxed);
+            callback(percent);
+        }
+    }
+
+  private:
+    std::atomic<bool> flag{false};
+    std::atomic<int> lastPercent{-1};
+    std::mutex mutex;  // held while the callback runs
+    ProgressCallback callback;
+};
+
+// Time limit for one call, which cancelling the call's TaskControl ends early. Checking it is
+// cheap enough for inner loops: the clock and the flag are only read on every `interval`th
+// check, the first one included.
+class Deadline {
+  public:
+    Deadline(qint64 milliseconds, const TaskControl *control, quint32 interval = 4096)
+        : milliseconds(milliseconds), control(control), interval(interval) {
+        timer.start();
+    }
+
+    bool expired() {
+        if (checks++ % interval == 0) {
+            passed = timer.elapsed() >= milliseconds || (control && control->cancelled());
+        }
+        return passed;
+    }
+
+  private:
+    QElapsedTimer timer;
+    qint64 milliseconds;
+    const TaskControl *control;
+    quint32 interval;
+    quint32 checks = 0;
+    bool passed = false;
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "text_buffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+void TextBuffer::setData(const QByteArray &data) {
+    chunks.clear();
+    cut(data, 0, data.size(), chunks);
+    total = data.size();
+    updateStarts(0);
+}
+
+void TextBuffer::clear() {
+    chunks.clear();
+    starts.clear();
+    total = 0;
+}
+
+// The range is cut out at chunk boundaries, splitting at most two chunks, and the new data goes
+// in between. Neighbours that fit in one chunk together are then merged, so a run of small edits
+// in one place does not leave behind a long trail of tiny chunks.
+void TextBuffer::replace(qsizetype position, qsizetype length, const QByteArray &data) {
+    position = qBound<qsizetype>(0, position, total);
+    length = qBound<qsizetype>(0, length, total - position);
+    const int first = split(position);
+    const int last = split(position + length);
+    chunks.remove(first, last - first);
+
+    QList<Chunk> inserted;
+    cut(data, 0, data.size(), inserted);
+    for (qsizetype k = 0; k < inserted.size(); k++) {
+        chunks.insert(first + k, std::move(inserted[k]));
+    }
+    total += data.size() - length;
+
+    const int from = qMax(0, first - 1);
+    int to = qMin(int(chunks.size()), first + int(inserted.size()) + 1);
+    for (int k = from; k + 1 < to;) {
+        Chunk &chunk = chunks[k];
+        const Chunk &next = chunks[k + 1];
+        if (chunk.length + next.length > ChunkSize) {
+            k++;
+            continue;
+        }
+        QByteArray joined(bytes(k), chunk.length);
+        joined.append(bytes(k + 1), next.length);
+        chunk = Chunk(joined, 0, joined.size());
+        chunks.remove(k + 1);
+        to--;
+    }
+    updateStarts(from);
+}
+
+char TextBuffer::at(qsizetype position) const {
+    const int k = chunkAt(position);
+    return bytes(k)[position - starts[k]];
+}
+
+QByteArray TextBuffer::mid(qsizetype position, qsizetype length) const {
+    position = qBound<qsizetype>(0, position, total);
+    length = qBound<qsizetype>(0, length, total - position);
+    if (length == 0) {
+        return QByteArray();
+    }
+
+    int k = chunkAt(position);
+    const Chunk &chunk = chunks[k];
+    if (chunk.offset == 0 && position == starts[k] && length == chunk.data.size()) {
+        return chunk.data;  // shared, not copied
+    }
+    QByteArray result;
+    result.reserve(length);
+    for (qsizetype from = position - starts[k]; length > 0; k++, from = 0) {
+        const qsizetype n = qMin(length, chunks[k].length - from);
+        result.append(bytes(k) + from, n);
+        length -= n;
+    }
+    return result;
+}
+
+// A line with no break in the LineLimit bytes before a multiple of LineLimit is cut there, so
+// the search never goes further back than the block before the one holding `position`
+qsizetype TextBuffer::lineStart(qsizetype position) const {
+    position = qBound<qsizetype>(0, position, total);
+    const qsizetype block = position / LineLimit * LineLimit;
+    const qsizetype newline = lastNewline(qMax<qsizetype>(0, block - LineLimit), position);
+    if (newline >= 0) {
+        return newline + 1;
+    }
+    if (position == block && block > 0 && block < total && at(block) == '\n') {
+        return lineStart(block - 1);  // a '\n' at the cut ends the line instead
+    }
+    return block;
+}
+
+qsizetype TextBuffer::lineEnd(qsizetype position) const {
+    if (position >= total) {
+        return total;
+    }
+    position = qMax<qsizetype>(0, position);
+    const qsizetype next = (position / LineLimit + 1) * LineLimit;
+    const qsizetype newline = firstNewline(position, qMin(next, total));
+    if (newline >= 0 || next >= total) {
+        return newline >= 0 ? newline : total;
+    }
+    if (firstNewline(next - LineLimit, position) < 0) {
+        return next;
+    }
+    // The line starts in this block, so it is only cut at the end of the next one
+    const qsizetype after = qMin(next + LineLimit, total);
+    const qsizetype end = firstNewline(next, after);
+    return end >= 0 ? end : after;
+}
+
+qsizetype TextBuffer::rowStart(qsizetype position, qsizetype width) const {
+    position = qBound<qsizetype>(0, position, total);
+    const qsizetype line = lineStart(position);
+    const qsizetype end = lineEnd(position);
+    const qsizetype lastRow = end > line ? (end - line - 1) / width : 0;
+    const qsizetype row = qMin((position - line) / width, lastRow);
+    const qsizetype start = rowAt(line, end, row, width);
+    return start > position && row > 0 ? rowAt(line, end, row - 1, width) : start;
+}
+
+qsizetype TextBuffer::rowEnd(qsizetype rowStart, qsizetype width) const {
+    const qsizetype line = lineStart(rowStart);
+    const qsizetype end = lineEnd(rowStart);
+    const qsizetype row = (rowStart - line) / width;
+    return (row + 1) * width >= end - line ? end : rowAt(line, end, row + 1, width);
+}
+
+qsizetype TextBuffer::nextRow(qsizetype rowStart, qsizetype width) const {
+    const qsizetype end = rowEnd(rowStart, width);
+    if (end < lineEnd(rowStart)) {
+        return end;
+    }
+    if (end == total) {
+        return -1;
+    }
+    return at(end) == '\n' ? end + 1 : end;
+}
+
+qsizetype TextBuffer::previousRow(qsizetype rowStart, qsizetype width) const {
+    return rowStart > 0 ? this->rowStart(rowStart - 1, width) : 0;
+}
+
+int TextBuffer::chunkAt(qsizetype position) const {
+    return int(std::upper_bound(starts.begin(), starts.end(), position) - starts.begin()) - 1;
+}
+
+const QList<quint16> &TextBuffer::newlinesIn(int chunk) const {
+    const Chunk &c = chunks[chunk];
+    if (!c.indexed) {
+        const char *data = bytes(chunk);
+        for (const char *p = data; (p = static_cast<const char *>(
+                                        std::memchr(p, '\n', c.length - (p - data))));
+             p++) {
+            c.newlines.append(quint16(p - data));
+        }
+        c.indexed = true;
+    }
+    return c.newlines;
+}
+
+// Position of the first '\n' in [from, to), or -1
+qsizetype TextBuffer::firstNewline(qsizetype from, qsizetype to) const {
+    if (from >= to) {
+        return -1;
+    }
+    for (int k = chunkAt(from); k < chunks.size() && starts[k] < to; k++) {
+        const QList<quint16> &newlines = newlinesIn(k);
+        const auto it = std::lower_bound(newlines.begin(), newlines.end(), from - starts[k]);
+        if (it != newlines.end()) {
+            return starts[k] + *it < to ? starts[k] + *it : -1;
+        }
+    }
+    return -1;
+}
+
+// Position of the last '\n' in [from, to), or -1
+qsizetype TextBuffer::lastNewline(qsizetype from, qsizetype to) const {
+    if (from >= to) {
+        return -1;
+    }
+    for (int k = chunkAt(to - 1); k >= 0 && starts[k] + chunks[k].length > from; k--) {
+        const QList<quint16> &newlines = newlinesIn(k);
+        const auto it = std::lower_bound(newlines.begin(), newlines.end(), to - starts[k]);
+        if (it != newlines.begin()) {
+            return starts[k] + *(it - 1) >= from ? starts[k] + *(it - 1) : -1;
+        }
+    }
+    return -1;
+}
+
+const char *TextBuffer::bytes(int chunk) const {
+    return chunks[chunk].data.constData() + chunks[chunk].offset;
+}
+
+// Row `row` of the line [line, end), moved forward off the continuation bytes of a character
+qsizetype TextBuffer::rowAt(qsizetype line, qsizetype end, qsizetype row, qsizetype width) const {
+    qsizetype position = line + row * width;
+    while (row > 0 && position < end && (at(position) & 0xC0) == 0x80) {
+        position++;
+    }
+    return position;
+}
+
+void TextBuffer::cut(const QByteArray &data, qsizetype offset, qsizetype length,
+                     QList<Chunk> &out) const {
+    for (qsizetype from = offset; from < offset + length; from += ChunkSize) {
+        out.append(Chunk(data, from, qMin(ChunkSize, offset + length - from)));
+    }
+}
+
+// Makes `position` a chunk boundary and returns the index of the chunk that starts there
+int TextBuffer::split(qsizetype position) {
+    if (position >= total) {
+        return int(chunks.size());
+    }
+    const int k = chunkAt(position);
+    const qsizetype left = position - starts[k];
+    if (left == 0) {
+        return k;
+    }
+    Chunk &chunk = chunks[k];
+    Chunk right(chunk.data, chunk.offset + left, chunk.length - left);
+    chunk = Chunk(chunk.data, chunk.offset, left);
+    chunks.insert(k + 1, std::move(right));
+    starts.insert(k + 1, position);
+    return k + 1;
+}
+
+void TextBuffer::updateStarts(int from) {
+    starts.resize(chunks.size());
+    qsizetype position = from > 0 ? starts[from - 1] + chunks[from - 1].length : 0;
+    for (qsizetype k = from; k < chunks.size(); k++) {
+        starts[k] = position;
+        position += chunks[k].length;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+
+// Read-mostly UTF-8 text for the output views, held as a list of chunks that share the bytes
+// they were given: setting even a very large text copies nothing, and replacing a range only
+// splits the chunks at its two ends. Each chunk finds its line breaks the first time a line
+// lookup reaches it, so a view pays for the part of the text it shows, not for all of it.
+//
+// Long lines are wrapped into rows of a fixed number of bytes counted from the start of the
+// line, each row start moved forward past UTF-8 continuation bytes. Row boundaries then follow
+// from the line start alone, which keeps scrolling through a single multi-megabyte line cheap.
+// A line is also cut at a multiple of LineLimit when the LineLimit bytes before it hold no
+// '\n', so finding where a line starts or ends looks at no more than two such blocks.
+class TextBuffer {
+  public:
+    static constexpr qsizetype ChunkSize = 64 * 1024;  // line breaks are indexed in 16 bits
+    static constexpr qsizetype LineLimit = 16 * ChunkSize;
+
+    TextBuffer() = default;
+    explicit TextBuffer(const QByteArray &data) { setData(data); }
+
+    void setData(const QByteArray &data);
+    void clear();
+    void replace(qsizetype position, qsizetype length, const QByteArray &data);
+    void append(const QByteArray &data) { replace(total, 0, data); }
+
+    qsizetype size() const { return total; }
+    bool isEmpty() const { return total == 0; }
+    char at(qsizetype position) const;
+    QByteArray mid(qsizetype position, qsizetype length) const;
+    QByteArray toByteArray() const { return mid(0, total); }
+
+    // Start of the line holding `position`, and the position of the '\n' that ends it (size()
+    // for the last line, the cut itself for a line cut at LineLimit)
+    qsizetype lineStart(qsizetype position) const;
+    qsizetype lineEnd(qsizetype position) const;
+
+    // Rows of `width` bytes plus the rest of a character cut at the end, width >= 4. Every text
+    // has at least one row, the empty line after a final '\n' included; nextRow() returns -1
+    // after the last one and previousRow() stays at 0 before the first.
+    qsizetype rowStart(qsizetype position, qsizetype width) const;
+    qsizetype rowEnd(qsizetype rowStart, qsizetype width) const;
+    qsizetype nextRow(qsizetype rowStart, qsizetype width) const;
+    qsizetype previousRow(qsizetype rowStart, qsizetype width) const;
+
+  private:
+    struct Chunk {
+        Chunk(const QByteArray &data, qsizetype offset, qsizetype length)
+            : data(data), offset(offset), length(length) {}
+
+        QByteArray data;  // shared with the other chunks cut from the same array
+        qsizetype offset;
+        qsizetype length;
+        mutable QList<quint16> newlines;  // positions within the chunk, once indexed
+        mutable bool indexed = false;
+    };
+
+    int chunkAt(qsizetype position) const;
+    const QList<quint16> &newlinesIn(int chunk) const;
+    qsizetype firstNewline(qsizetype from, qsizetype to) const;
+    qsizetype lastNewline(qsizetype from, qsizetype to) const;
+    const char *bytes(int chunk) const;
+    qsizetype rowAt(qsizetype line, qsizetype end, qsizetype row, qsizetype width) const;
+    void cut(const QByteArray &data, qsizetype offset, qsizetype length, QList<Chunk> &out) const;
+    int split(qsizetype position);
+    void updateStarts(int from);
+
+    QList<Chunk> chunks;
+    QList<qsizetype> starts;  // position of each chunk in the text
+    qsizetype total = 0;
+};
\ No newline at end of file
@@ -3,340 +3,1851 @@
 #include <QtCore/qmath.h>
 
 #include <QChar>
-#include <QRegularExpression>
+#include <QList>
 #include <QStringList>
+#include <QStringView>
 
-QString Unpacker::deobfuscateJavaScript(const QString &input) {
-    QString result = input;
+#include <QElapsedTimer>
+#include <QSet>
 
-    // Handle Dean Edwards packer format first
-    result = unpackDeanEdwards(result);
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
 
-    // Handle hex escapes \\xXX
-    QRegularExpression hexRegex("\\\\x([0-9A-Fa-f]{2})");
-    QRegularExpressionMatchIterator hexIt = hexRegex.globalMatch(result);
-    QList<QPair<QString, QString>> hexReplacements;
-    while (hexIt.hasNext()) {
-        QRegularExpressionMatch match = hexIt.next();
-        bool ok;
-        int value = match.captured(1).toInt(&ok, 16);
-        if (ok && value > 0) {
-            hexReplacements.append({match.captured(0), QString(QChar(value))});
+#include "decoder.h"
+#include "js_ast.h"
+#include "js_lexer.h"
+#include "json5_document.h"
+#include "json_formatter.h"
+#include "parallel.h"
+#include "task_control.h"
+
+namespace {
+
+// The packer encodes keyword indexes with 0-9a-z up to base 36 and continues with A-Z up to
+// base 62. Its "High ASCII" mode (base 95) uses U+00A1 .. U+00FF as digits instead.
+constexpr int kMaxWordBase = 62;
+constexpr int kMaxBase = 95;
+constexpr char16_t kHighAsciiZero = 0xA1;
+constexpr qint8 kNotDigit = -1;
+
+constexpr std::array<qint8, 128> makePackerDigitTable() {
+    std::array<qint8, 128> table{};
+    for (auto &entry : table) {
+        entry = kNotDigit;
+    }
+    for (int i = 0; i < 10; i++) {
+        table['0' + i] = static_cast<qint8>(i);
+    }
+    for (int i = 0; i < 26; i++) {
+        table['a' + i] = static_cast<qint8>(10 + i);
+        table['A' + i] = static_cast<qint8>(36 + i);
+    }
+    return table;
+}
+
+constexpr std::array<qint8, 128> kPackerDigits = makePackerDigitTable();
+
+int packerDigit(QChar ch, int base) {
+    const char16_t unit = ch.unicode();
+    int digit = kNotDigit;
+    if (base > kMaxWordBase) {
+        if (unit >= kHighAsciiZero && unit < kHighAsciiZero + base) {
+            digit = unit - kHighAsciiZero;
         }
+    } else if (unit < kPackerDigits.size()) {
+        digit = kPackerDigits[unit];
     }
-    for (const auto &replacement : hexReplacements) {
-        result.replace(replacement.first, replacement.second);
+    return digit < base ? digit : kNotDigit;
+}
+
+// Tokens are JavaScript \w runs, or runs of high-ASCII digits in base 95 mode.
+bool isPackedTokenChar(QChar ch, bool highAscii) {
+    const char16_t unit = ch.unicode();
+    if (highAscii) {
+        return unit >= kHighAsciiZero && unit <= 0xFF;
+    }
+    return unit < kPackerDigits.size() && (kPackerDigits[unit] != kNotDigit || unit == '_');
+}
+
+// Keyword index a token stands for, or -1 for ordinary words the packer left alone.
+int packedTokenIndex(QStringView token, int base, int count) {
+    if (token.size() > 1 && packerDigit(token[0], base) == 0) {
+        return -1;  // the packer never emits leading zeros
     }
 
-    // Handle unicode escapes \\uXXXX
-    QRegularExpression unicodeRegex("\\\\u([0-9A-Fa-f]{4})");
-    QRegularExpressionMatchIterator unicodeIt = unicodeRegex.globalMatch(result);
-    QList<QPair<QString, QString>> unicodeReplacements;
-    while (unicodeIt.hasNext()) {
-        QRegularExpressionMatch match = unicodeIt.next();
-        bool ok;
-        int value = match.captured(1).toInt(&ok, 16);
-        if (ok && value > 0) {
-            unicodeReplacements.append({match.captured(0), QString(QChar(value))});
+    qint64 value = 0;
+    for (QChar ch : token) {
+        const int digit = packerDigit(ch, base);
+        if (digit == kNotDigit) {
+            return -1;
+        }
+        value = value * base + digit;
+        if (value >= count) {
+            return -1;
         }
     }
-    for (const auto &replacement : unicodeReplacements) {
-        result.replace(replacement.first, replacement.second);
+    return static_cast<int>(value);
+}
+
+void skipSpaces(QStringView source, qsizetype &pos) {
+    while (pos < source.size() && source[pos].isSpace()) {
+        pos++;
     }
+}
+
+bool readLiteral(QStringView source, qsizetype &pos, QStringView literal) {
+    skipSpaces(source, pos);
+    if (!source.mid(pos).startsWith(literal)) {
+        return false;
+    }
+    pos += literal.size();
+    return true;
+}
 
-    // Handle String.fromCharCode calls
-    QRegularExpression charCodeRegex("String\\.fromCharCode\\(([0-9,\\s]+)\\)");
-    QRegularExpressionMatchIterator charIt = charCodeRegex.globalMatch(result);
-    QList<QPair<QString, QString>> charReplacements;
-    while (charIt.hasNext()) {
-        QRegularExpressionMatch match = charIt.next();
-        QString chars = match.captured(1);
-        QStringList charCodes = chars.split(',', Qt::SkipEmptyParts);
-        QString decoded;
-        for (const QString &code : charCodes) {
-            bool ok;
-            int value = code.trimmed().toInt(&ok);
-            if (ok && value > 0 && value <= 0x10FFFF) {
-                decoded += QChar(value);
+bool readInteger(QStringView source, qsizetype &pos, int &value) {
+    skipSpaces(source, pos);
+    const qsizetype start = pos;
+    qint64 parsed = 0;
+    while (pos < source.size() && source[pos].isDigit() && parsed <= INT_MAX) {
+        parsed = parsed * 10 + source[pos].digitValue();
+        pos++;
+    }
+    value = static_cast<int>(parsed);
+    return pos > start && parsed <= INT_MAX;
+}
+
+// Reads the quoted JavaScript string starting at `pos` and resolves its escapes.
+bool readStringLiteral(QStringView source, qsizetype &pos, QString &value) {
+    skipSpaces(source, pos);
+    if (pos >= source.size() || (source[pos] != '\'' && source[pos] != '"')) {
+        return false;
+    }
+
+    const QChar quote = source[pos++];
+    value.clear();
+    while (pos < source.size()) {
+        QChar ch = source[pos++];
+        if (ch == quote) {
+            return true;
+        }
+        if (ch == '\\' && pos < source.size()) {
+            ch = source[pos++];
+            if (ch == 'n') {
+                ch = '\n';
+            } else if (ch == 'r') {
+                ch = '\r';
+            } else if (ch == 't') {
+                ch = '\t';
             }
         }
-        charReplacements.append({match.captured(0), '"' + decoded + '"'});
+        value += ch;
     }
-    for (const auto &replacement : charReplacements) {
-        result.replace(replacement.first, replacement.second);
+    return false;
+}
+
+constexpr char32_t kMaxCodePoint = 0x10FFFF;
+
+int hexDigit(QChar ch) {
+    const char16_t unit = ch.unicode();
+    if (unit >= '0' && unit <= '9') {
+        return unit - '0';
+    }
+    if (unit >= 'a' && unit <= 'f') {
+        return unit - 'a' + 10;
     }
+    if (unit >= 'A' && unit <= 'F') {
+        return unit - 'A' + 10;
+    }
+    return -1;
+}
 
-    // Unescape common patterns
-    result.replace("\\\\n", "\n");
-    result.replace("\\\\t", "\t");
-    result.replace("\\\\r", "\r");
-    result.replace("\\\\\\\\", "\\");
-    result.replace("\\\\'", "'");
-    result.replace("\\\\\"", "\"");
+// Value of exactly `digits` hex digits at `pos`, or -1 if the input ends or a digit is missing.
+int readHex(const QChar *pos, const QChar *end, int digits) {
+    if (end - pos < digits) {
+        return -1;
+    }
+    int value = 0;
+    for (int i = 0; i < digits; i++) {
+        const int digit = hexDigit(pos[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
 
-    return result;
+// Code points above U+FFFF become a surrogate pair instead of being truncated to 16 bits.
+void appendCodePoint(QString &output, char32_t codePoint) {
+    if (QChar::requiresSurrogates(codePoint)) {
+        output += QChar(QChar::highSurrogate(codePoint));
+        output += QChar(QChar::lowSurrogate(codePoint));
+    } else {
+        output += QChar(static_cast<char16_t>(codePoint));
+    }
+}
+
+// Decodes the backslash escape at `pos` into `output` and returns the position after it, or
+// nullptr when there is nothing to decode there. NUL escapes are left alone.
+const QChar *decodeEscape(const QChar *pos, const QChar *end, QString &output) {
+    if (end - pos < 2) {
+        return nullptr;
+    }
+
+    const char16_t next = pos[1].unicode();
+    if (next == 'x') {
+        const int value = readHex(pos + 2, end, 2);
+        if (value <= 0) {
+            return nullptr;
+        }
+        appendCodePoint(output, value);
+        return pos + 4;
+    }
+
+    if (next == 'u' && pos + 2 < end && pos[2] == '{') {
+        const QChar *digit = pos + 3;
+        char32_t value = 0;
+        while (digit < end && hexDigit(*digit) >= 0 && value <= kMaxCodePoint) {
+            value = value * 16 + hexDigit(*digit);
+            digit++;
+        }
+        if (digit == pos + 3 || digit == end || *digit != '}' || value == 0 ||
+            value > kMaxCodePoint) {
+            return nullptr;
+        }
+        appendCodePoint(output, value);
+        return digit + 1;
+    }
+
+    if (next == 'u') {
+        const int value = readHex(pos + 2, end, 4);
+        if (value <= 0) {
+            return nullptr;
+        }
+        appendCodePoint(output, value);
+        return pos + 6;
+    }
+
+    if (next >= '0' && next <= '7') {
+        // Legacy octal escapes, at most \377
+        const int maxDigits = next <= '3' ? 3 : 2;
+        const QChar *digit = pos + 1;
+        int value = 0;
+        for (int i = 0; i < maxDigits && digit < end && digit->unicode() >= '0' &&
+                        digit->unicode() <= '7';
+             i++, digit++) {
+            value = value * 8 + (digit->unicode() - '0');
+        }
+        if (value == 0) {
+            return nullptr;
+        }
+        appendCodePoint(output, value);
+        return digit;
+    }
+
+    if (next == '\\' && end - pos >= 3) {
+        // Escapes that were escaped once more, e.g. inside an eval()'d string
+        switch (pos[2].unicode()) {
+            case 'n':
+                output += '\n';
+                return pos + 3;
+            case 't':
+                output += '\t';
+                return pos + 3;
+            case 'r':
+                output += '\r';
+                return pos + 3;
+            case '\'':
+            case '"':
+                output += pos[2];
+                return pos + 3;
+            case '\\':
+                if (end - pos >= 4 && pos[3] == '\\') {
+                    output += '\\';
+                    return pos + 4;
+                }
+                break;
+        }
+    }
+    return nullptr;
 }
 
-QString Unpacker::unpackDeanEdwards(const QString &input) {
-    // More flexible Dean Edwards packer pattern
-    QRegularExpression packerRegex("eval\\(function\\(p,a,c,k,e,r\\)\\{.*?\\}\\('([^']*)',(\\d+),("
-                                   "\\d+),'([^']*)'\\.split\\('\\|'\\),0,\\{\\}\\)\\)");
-    QRegularExpressionMatch match = packerRegex.match(input);
+// Replaces String.fromCharCode(...) with literal numeric arguments by the string it builds.
+const QChar *decodeFromCharCode(const QChar *pos, const QChar *end, QString &output) {
+    constexpr QStringView kCall = u"String.fromCharCode(";
+    if (!QStringView(pos, end).startsWith(kCall)) {
+        return nullptr;
+    }
 
-    if (!match.hasMatch()) {
-        return input;  // Not packed with Dean Edwards packer
+    QString decoded;
+    const QChar *cursor = pos + kCall.size();
+    bool expectNumber = true;
+    while (cursor < end) {
+        const char16_t unit = cursor->unicode();
+        if (cursor->isSpace()) {
+            cursor++;
+        } else if (unit == ')' && !expectNumber) {
+            output += '"' + decoded + '"';
+            return cursor + 1;
+        } else if (unit == ',' && !expectNumber) {
+            expectNumber = true;
+            cursor++;
+        } else if (unit >= '0' && unit <= '9' && expectNumber) {
+            qint64 value = 0;
+            while (cursor < end && cursor->isDigit()) {
+                value = qMin<qint64>(value * 10 + cursor->digitValue(), kMaxCodePoint + 1);
+                cursor++;
+            }
+            if (value > 0 && value <= kMaxCodePoint) {
+                appendCodePoint(decoded, static_cast<char32_t>(value));
+            }
+            expectNumber = false;
+        } else {
+            return nullptr;  // computed arguments; leave the call as written
+        }
     }
+    return nullptr;
+}
 
-    QString packedCode = match.captured(1);
-    int base = match.captured(2).toInt();
-    int count = match.captured(3).toInt();
-    QString keywordsStr = match.captured(4);
+// One left-to-right pass over the script. Decoded text is never rescanned, so an escape that
+// decodes to a backslash cannot combine with the characters after it. Once `deadline` has
+// expired the script comes back as written.
+QString decodeEscapes(QStringView input, Deadline &deadline) {
+    QString output;
+    output.reserve(input.size());  // every decoded form is shorter than its source
 
-    QStringList keywords = keywordsStr.split('|');
+    const QChar *pos = input.data();
+    const QChar *end = pos + input.size();
+    const QChar *plain = pos;
+    while (pos < end) {
+        const char16_t unit = pos->unicode();
+        if (unit != '\\' && unit != 'S') {
+            pos++;
+            continue;
+        }
 
-    // Pad keywords array to match count
-    while (keywords.size() < count) {
-        keywords.append("");
+        if (deadline.expired()) {
+            return input.toString();
+        }
+        output.append(plain, pos - plain);
+        plain = pos;
+        const QChar *after = unit == '\\' ? decodeEscape(pos, end, output)
+                                           : decodeFromCharCode(pos, end, output);
+        if (after) {
+            pos = plain = after;
+        } else if (unit == '\\' && pos + 1 < end && pos[1] == '\\') {
+            pos += 2;  // an escaped backslash; what follows it is plain text
+        } else {
+            pos++;
+        }
     }
+    output.append(plain, pos - plain);
+    return output;
+}
 
-    QString result = packedCode;
+// ---------------------------------------------------------------------------------------------
+// Unpacking formats
+// ---------------------------------------------------------------------------------------------
 
-    // Replace encoded tokens with keywords - process in reverse order to avoid conflicts
-    for (int i = count - 1; i >= 0; i--) {
-        QString keyword = (i < keywords.size()) ? keywords[i] : "";
-        if (!keyword.isEmpty()) {
-            QString token = toBase(i, base);
+constexpr int kMaxNesting = 64;  // parentheses and calls inside one statically evaluated string
 
-            // Use word boundaries for replacement - fix the regex pattern
-            QRegularExpression tokenRegex("\\b" + QRegularExpression::escape(token) + "\\b");
-            result.replace(tokenRegex, keyword);
+// Tokens of a script other than comments, with a few lookups by index. Indexes past the end
+// read as an empty token of no type, so patterns can be matched without bounds checks.
+class ScriptTokens {
+  public:
+    // Lexing stops early once `deadline` has expired
+    ScriptTokens(QStringView script, Deadline &deadline) : source(script) {
+        JsLexer lexer(script);
+        for (JsLexer::Token token = lexer.next();
+             token.type != JsLexer::EndOfInput && !deadline.expired(); token = lexer.next()) {
+            if (token.type != JsLexer::LineComment && token.type != JsLexer::BlockComment) {
+                tokens.append(token);
+            }
         }
     }
 
-    return result;
+    qsizetype size() const { return tokens.size(); }
+    const JsLexer::Token &operator[](qsizetype index) const { return tokens[index]; }
+
+    QStringView text(qsizetype index) const {
+        if (index < 0 || index >= tokens.size()) {
+            return {};
+        }
+        return source.mid(tokens[index].start, tokens[index].length);
+    }
+
+    bool is(qsizetype index, JsLexer::TokenType type) const {
+        return index >= 0 && index < tokens.size() && tokens[index].type == type;
+    }
+    bool is(qsizetype index, JsLexer::TokenType type, QStringView word) const {
+        return is(index, type) && text(index) == word;
+    }
+    bool isPunctuator(qsizetype index, QStringView punctuator) const {
+        return is(index, JsLexer::Punctuator, punctuator);
+    }
+
+    qsizetype end(qsizetype index) const { return tokens[index].start + tokens[index].length; }
+
+    // Index of the bracket closing the one at `open`, or -1
+    qsizetype matching(qsizetype open) const {
+        const QStringView opening = text(open);
+        const QStringView closing = opening == u"(" ? u")" : opening == u"[" ? u"]" : u"}";
+        int depth = 0;
+        for (qsizetype i = open; i < tokens.size(); i++) {
+            if (tokens[i].type != JsLexer::Punctuator) {
+                continue;
+            }
+            const QStringView punctuator = text(i);
+            if (punctuator == opening) {
+                depth++;
+            } else if (punctuator == closing && --depth == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+  private:
+    QStringView source;
+    QList<JsLexer::Token> tokens;
+};
+
+bool isGlobalObject(QStringView word) {
+    return word == u"window" || word == u"self" || word == u"globalThis";
 }
 
-QString Unpacker::toBase(int num, int base) {
-    if (num == 0)
-        return "0";
+// Integer literal as JavaScript reads it: decimal, or hex with a 0x prefix
+bool integerValue(QStringView text, qint64 &value) {
+    bool ok = false;
+    if (text.startsWith(u"0x") || text.startsWith(u"0X")) {
+        value = text.mid(2).toLongLong(&ok, 16);
+    } else {
+        value = text.toLongLong(&ok, 10);
+    }
+    return ok;
+}
 
-    QString chars = "0123456789abcdefghijklmnopqrstuvwxyz";
-    QString result;
+// unescape(): %XX and %uXXXX, any other '%' stays as written
+QString unescapeValue(QStringView text) {
+    QString value;
+    value.reserve(text.size());
+    const QChar *pos = text.data();
+    const QChar *end = pos + text.size();
+    while (pos < end) {
+        if (*pos == '%') {
+            const bool wide = end - pos > 1 && pos[1] == 'u';
+            const int unit = readHex(pos + (wide ? 2 : 1), end, wide ? 4 : 2);
+            if (unit >= 0) {
+                value += QChar(static_cast<char16_t>(unit));
+                pos += wide ? 6 : 3;
+                continue;
+            }
+        }
+        value += *pos++;
+    }
+    return value;
+}
 
-    while (num > 0) {
-        result.prepend(chars[num % base]);
-        num /= base;
+// decodeURIComponent(): %XX escapes are UTF-8 bytes
+bool decodeUriValue(QStringView text, QString &value) {
+    QByteArray bytes;
+    bytes.reserve(text.size());
+    qsizetype plain = 0;
+    for (qsizetype i = text.indexOf('%'); i >= 0; i = text.indexOf('%', plain)) {
+        const int byte = readHex(text.data() + i + 1, text.data() + text.size(), 2);
+        if (byte < 0) {
+            return false;  // URIError at runtime
+        }
+        bytes += text.mid(plain, i - plain).toUtf8();
+        bytes += static_cast<char>(byte);
+        plain = i + 3;
     }
+    bytes += text.mid(plain).toUtf8();
+    value = QString::fromUtf8(bytes);
+    return true;
+}
 
-    return result;
+bool atobValue(QStringView text, QString &value) {
+    QByteArray encoded;
+    encoded.reserve(text.size());
+    for (QChar ch : text) {
+        if (ch.unicode() > 0xFF) {
+            return false;
+        }
+        encoded += static_cast<char>(ch.unicode());
+    }
+    QByteArray decoded;
+    if (Decoder::decodeBase64(encoded, decoded) != Decoder::Ok) {
+        return false;
+    }
+    value = QString::fromLatin1(decoded);  // atob() yields one character per byte
+    return true;
 }
 
-QString Unpacker::beautifyJavaScript(const QString &input) {
-    QString result = input;
-    int indentLevel = 0;
-    QString indentStr = "    ";  // 4 spaces
-    QString formatted;
-    bool inString = false;
-    QChar stringChar;
-    bool escaped = false;
-
-    for (int i = 0; i < result.length(); i++) {
-        QChar ch = result[i];
-
-        // Handle string literals
-        if (!escaped && (ch == '"' || ch == '\'')) {
-            if (!inString) {
-                inString = true;
-                stringChar = ch;
-            } else if (ch == stringChar) {
-                inString = false;
-            }
-            formatted += ch;
+bool staticConcatenation(const ScriptTokens &tokens, qsizetype &index, QString &value, int depth);
+
+// One operand of a statically known string: a literal, a parenthesized concatenation, or a call
+// to a decoding builtin with a statically known argument.
+bool staticOperand(const ScriptTokens &tokens, qsizetype &index, QString &value, int depth) {
+    if (depth > kMaxNesting) {
+        return false;
+    }
+    if (tokens.is(index, JsLexer::String) || tokens.is(index, JsLexer::Template)) {
+        return JsLexer::stringValue(tokens.text(index++), value);
+    }
+    if (tokens.isPunctuator(index, u"(")) {
+        index++;
+        if (!staticConcatenation(tokens, index, value, depth + 1) ||
+            !tokens.isPunctuator(index, u")")) {
+            return false;
+        }
+        index++;
+        return true;
+    }
+
+    while (tokens.is(index, JsLexer::Identifier) && isGlobalObject(tokens.text(index)) &&
+           tokens.isPunctuator(index + 1, u".")) {
+        index += 2;
+    }
+    if (!tokens.is(index, JsLexer::Identifier)) {
+        return false;
+    }
+    const QStringView name = tokens.text(index);
+
+    if (name == u"String" && tokens.isPunctuator(index + 1, u".") &&
+        tokens.text(index + 2) == u"fromCharCode" && tokens.isPunctuator(index + 3, u"(")) {
+        index += 4;
+        value.clear();
+        while (!tokens.isPunctuator(index, u")")) {
+            qint64 code = 0;
+            if (!tokens.is(index, JsLexer::Number) || !integerValue(tokens.text(index), code) ||
+                code < 0 || code > kMaxCodePoint) {
+                return false;
+            }
+            appendCodePoint(value, static_cast<char32_t>(code));
+            index++;
+            if (tokens.isPunctuator(index, u",")) {
+                index++;
+            } else if (!tokens.isPunctuator(index, u")")) {
+                return false;
+            }
+        }
+        index++;
+        return true;
+    }
+
+    const bool known = name == u"atob" || name == u"unescape" || name == u"decodeURIComponent";
+    if (!known || !tokens.isPunctuator(index + 1, u"(")) {
+        return false;
+    }
+    index += 2;
+    QString argument;
+    if (!staticConcatenation(tokens, index, argument, depth + 1) ||
+        !tokens.isPunctuator(index, u")")) {
+        return false;
+    }
+    index++;
+    if (name == u"atob") {
+        return atobValue(argument, value);
+    }
+    if (name == u"unescape") {
+        value = unescapeValue(argument);
+        return true;
+    }
+    return decodeUriValue(argument, value);
+}
+
+// operand ('+' operand)*, starting at `index` and leaving it on the first token after
+bool staticConcatenation(const ScriptTokens &tokens, qsizetype &index, QString &value,
+                         int depth) {
+    if (!staticOperand(tokens, index, value, depth)) {
+        return false;
+    }
+    QString operand;
+    while (tokens.isPunctuator(index, u"+")) {
+        index++;
+        if (!staticOperand(tokens, index, operand, depth)) {
+            return false;
+        }
+        value += operand;
+    }
+    return true;
+}
+
+// Whether `name` occurs followed by a '(' and something that can start a static string, so
+// scripts that merely call eval(code) are not tokenized for nothing
+bool hasStaticCall(QStringView script, QStringView name) {
+    static const QStringView kStarts[] = {
+        u"'", u"\"", u"`", u"(", u"atob", u"unescape", u"decodeURIComponent",
+        u"String.fromCharCode", u"window", u"self", u"globalThis",
+    };
+    for (qsizetype pos = script.indexOf(name); pos >= 0; pos = script.indexOf(name, pos + 1)) {
+        qsizetype next = pos + name.size();
+        while (next < script.size() && script[next].isSpace()) {
+            next++;
+        }
+        if (next == script.size() || script[next] != '(') {
             continue;
         }
+        do {
+            next++;
+        } while (next < script.size() && script[next].isSpace());
+        const QStringView argument = script.mid(next);
+        for (QStringView start : kStarts) {
+            if (argument.startsWith(start)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-        if (inString) {
-            formatted += ch;
-            escaped = (ch == '\\' && !escaped);
+// Whether an expression can end with the token at `index` (a keyword such as typeof cannot)
+bool endsExpression(const ScriptTokens &tokens, qsizetype index) {
+    if (tokens.is(index, JsLexer::Punctuator)) {
+        return tokens.isPunctuator(index, u")") || tokens.isPunctuator(index, u"]");
+    }
+    return !tokens.is(index, JsLexer::Keyword);
+}
+
+// Whether the tokens [first, last] of `script` make up a whole statement: nothing before them
+// or after them on their lines is part of the same expression
+bool isStatement(QStringView script, const ScriptTokens &tokens, qsizetype first, qsizetype last) {
+    const auto lineBreakBefore = [&](qsizetype index) {
+        const qsizetype from = tokens.end(index - 1);
+        return script.mid(from, tokens[index].start - from).contains(u'\n');
+    };
+    const bool starts = first == 0 || tokens.isPunctuator(first - 1, u";") ||
+                        tokens.isPunctuator(first - 1, u"{") ||
+                        tokens.isPunctuator(first - 1, u"}") ||
+                        (lineBreakBefore(first) && endsExpression(tokens, first - 1));
+    if (!starts) {
+        return false;
+    }
+    return last + 1 == tokens.size() || tokens.isPunctuator(last + 1, u";") ||
+           tokens.isPunctuator(last + 1, u"}") ||
+           (lineBreakBefore(last + 1) && !tokens.is(last + 1, JsLexer::Punctuator));
+}
+
+// Whether the statement starting at `first` is the unbraced body of an if, while, for or with,
+// where code of several statements has to be put in a block to stay under the condition
+bool isControlBody(const ScriptTokens &tokens, qsizetype first) {
+    if (!tokens.isPunctuator(first - 1, u")")) {
+        return false;
+    }
+    int depth = 0;
+    for (qsizetype i = first - 1; i >= 0; i--) {
+        if (tokens.isPunctuator(i, u")")) {
+            depth++;
+        } else if (tokens.isPunctuator(i, u"(") && --depth == 0) {
+            return tokens.is(i - 1, JsLexer::Keyword, u"if") ||
+                   tokens.is(i - 1, JsLexer::Keyword, u"while") ||
+                   tokens.is(i - 1, JsLexer::Keyword, u"for") ||
+                   tokens.is(i - 1, JsLexer::Keyword, u"with");
+        }
+    }
+    return false;
+}
+
+bool detectEval(QStringView script) {
+    return hasStaticCall(script, u"eval") || hasStaticCall(script, u"Function");
+}
+
+// eval(<string>) and Function(<string>)() with a statically known string are replaced by the
+// code they run: a Function call by an immediately invoked function around it, an eval only when
+// it is a statement of its own, since inside an expression it stands for the code's value (and
+// in a block when it is the body of an if or loop). Other calls (computed arguments, Function
+// with parameters) stay as written.
+bool unpackEval(QStringView script, QString &output, Deadline &deadline) {
+    const ScriptTokens tokens(script, deadline);
+    output.clear();
+    qsizetype copied = 0;  // the script up to here is in `output` already
+    for (qsizetype i = 0; i < tokens.size(); i++) {
+        if (deadline.expired()) {
+            return false;
+        }
+        const QStringView name = tokens.text(i);
+        const bool isEval = name == u"eval";
+        if (!tokens.is(i, JsLexer::Identifier) || (!isEval && name != u"Function") ||
+            !tokens.isPunctuator(i + 1, u"(")) {
             continue;
         }
 
-        escaped = false;
+        qsizetype first = i;
+        if (tokens.isPunctuator(i - 1, u".")) {
+            if (!isGlobalObject(tokens.text(i - 2))) {
+                continue;  // someone's own eval method
+            }
+            first = i - 2;
+        } else if (!isEval && tokens.is(i - 1, JsLexer::Keyword, u"new")) {
+            first = i - 1;
+        }
 
-        switch (ch.toLatin1()) {
-            case '{':
-                formatted += ch;
-                formatted += '\n';
-                indentLevel++;
-                for (int j = 0; j < indentLevel; j++) {
-                    formatted += indentStr;
-                }
-                break;
+        qsizetype next = i + 2;
+        QString code;
+        if (!staticConcatenation(tokens, next, code, 0) || !tokens.isPunctuator(next, u")")) {
+            continue;
+        }
+        if (!isEval) {
+            if (!tokens.isPunctuator(next + 1, u"(") || !tokens.isPunctuator(next + 2, u")")) {
+                continue;  // a function that is built but not called here
+            }
+            next += 2;
+        } else if (!isStatement(script, tokens, first, next)) {
+            continue;
+        }
 
-            case '}':
-                // Remove trailing whitespace
-                while (formatted.endsWith(' ') || formatted.endsWith('\t')) {
-                    formatted.chop(1);
-                }
-                if (!formatted.endsWith('\n')) {
-                    formatted += '\n';
-                }
-                indentLevel = qMax(0, indentLevel - 1);
-                for (int j = 0; j < indentLevel; j++) {
-                    formatted += indentStr;
+        output += script.mid(copied, tokens[first].start - copied);
+        if (!isEval) {
+            output += "(function(){" + code + "})()";
+        } else if (isControlBody(tokens, first)) {
+            output += "{" + code + "}";
+        } else {
+            output += code;
+        }
+        copied = tokens.end(next);
+        i = next;
+    }
+    if (copied == 0) {
+        return false;
+    }
+    output += script.mid(copied);
+    return true;
+}
+
+// obfuscator.io moves every string into one array, rotated by a fixed count at startup, and reads
+// it through an accessor function:
+//
+//     var _0x1a2b = ['log', 'Hello'];
+//     (function (array, count) { ... array['push'](array['shift']()) ... }(_0x1a2b, 0x1));
+//     var _0x3c4d = function (index, key) { index = index - 0x0; var value = _0x1a2b[index]; ...
+//     console[_0x3c4d('0x0')](_0x3c4d('0x1'));
+//
+// Accessor calls with a literal index are replaced by the string they return. Arrays encoded
+// with the tool's base64 option are decoded with the alphabet found in the accessor; RC4
+// encoded arrays, whose calls carry a key, are left alone.
+bool detectStringArray(QStringView script) {
+    return script.contains(u"_0x");  // the tool's default identifier names
+}
+
+struct StringArray {
+    qsizetype declaration = 0;  // token index of the array's name
+    QStringList strings;
+};
+
+QList<StringArray> findStringArrays(const ScriptTokens &tokens) {
+    QList<StringArray> arrays;
+    for (qsizetype i = 0; i + 3 < tokens.size(); i++) {
+        if (!tokens.is(i, JsLexer::Identifier) || !tokens.isPunctuator(i + 1, u"=") ||
+            !tokens.isPunctuator(i + 2, u"[") || !tokens.is(i + 3, JsLexer::String)) {
+            continue;
+        }
+        StringArray array;
+        array.declaration = i;
+        qsizetype index = i + 3;
+        QString value;
+        while (tokens.is(index, JsLexer::String) &&
+               JsLexer::stringValue(tokens.text(index), value)) {
+            array.strings.append(value);
+            index += tokens.isPunctuator(index + 1, u",") ? 2 : 1;
+        }
+        if (tokens.isPunctuator(index, u"]")) {
+            arrays.append(array);
+            i = index;
+        }
+    }
+    return arrays;
+}
+
+// Where each identifier occurs and which named functions are defined, gathered in one pass over
+// a layer so that every candidate array is looked up rather than searched for again
+class ScriptIndex {
+  public:
+    struct Function {
+        qsizetype name = 0;  // token index of the function's name
+        qsizetype body = 0;  // its '{'
+        qsizetype end = 0;   // and the matching '}'
+    };
+
+    explicit ScriptIndex(const ScriptTokens &tokens) {
+        for (qsizetype i = 0; i < tokens.size(); i++) {
+            if (tokens.is(i, JsLexer::Identifier)) {
+                identifiers[tokens.text(i)].append(i);
+            }
+        }
+        for (qsizetype i = 0; i + 2 < tokens.size(); i++) {
+            qsizetype name = i;
+            qsizetype parameters = -1;
+            if (tokens.is(i, JsLexer::Identifier) && tokens.isPunctuator(i + 1, u"=") &&
+                tokens.is(i + 2, JsLexer::Keyword, u"function") &&
+                tokens.isPunctuator(i + 3, u"(")) {
+                parameters = i + 3;
+            } else if (tokens.is(i, JsLexer::Keyword, u"function") &&
+                       tokens.is(i + 1, JsLexer::Identifier) && tokens.isPunctuator(i + 2, u"(")) {
+                parameters = i + 2;
+                name = ++i;
+            }
+            const qsizetype close = parameters < 0 ? -1 : tokens.matching(parameters);
+            if (close < 0 || !tokens.isPunctuator(close + 1, u"{")) {
+                continue;
+            }
+            const qsizetype end = tokens.matching(close + 1);
+            if (end >= 0) {
+                functions.append({name, close + 1, end});
+            }
+        }
+    }
+
+    // Token indices of `name`, in order
+    QList<qsizetype> uses(QStringView name) const { return identifiers.value(name); }
+
+    QList<Function> functions;  // in order of their names
+
+  private:
+    QHash<QStringView, QList<qsizetype>> identifiers;
+};
+
+// The startup rotation: the array handed to a function expression together with a count
+qint64 rotationCount(const ScriptTokens &tokens, const ScriptIndex &index, QStringView name) {
+    for (const qsizetype use : index.uses(name)) {
+        const qsizetype i = use - 1;
+        qint64 count = 0;
+        if (tokens.isPunctuator(i, u"(") && tokens.isPunctuator(i + 2, u",") &&
+            tokens.is(i + 3, JsLexer::Number) && tokens.isPunctuator(i + 4, u")") &&
+            (tokens.isPunctuator(i - 1, u"}") || tokens.isPunctuator(i - 1, u")")) &&
+            integerValue(tokens.text(i + 3), count) && count >= 0) {
+            return count;
+        }
+    }
+    return 0;
+}
+
+struct Accessor {
+    QStringView name;
+    qsizetype first = 0;  // token range of the definition, which is left alone
+    qsizetype last = 0;
+    qint64 offset = 0;
+    QString alphabet;  // base64 alphabet, for encoded arrays
+};
+
+bool findAccessor(const ScriptTokens &tokens, const ScriptIndex &index, QStringView array,
+                  Accessor &accessor) {
+    const QList<qsizetype> uses = index.uses(array);
+    for (const ScriptIndex::Function &function : index.functions) {
+        bool readsArray = false;
+        for (auto use = std::upper_bound(uses.begin(), uses.end(), function.body);
+             use != uses.end() && *use < function.end; ++use) {
+            readsArray |= tokens.isPunctuator(*use + 1, u"[");
+        }
+        if (!readsArray) {
+            continue;
+        }
+
+        accessor = Accessor();
+        accessor.name = tokens.text(function.name);
+        accessor.first = function.name;
+        accessor.last = function.end;
+        for (qsizetype k = function.body + 1; k < function.end; k++) {
+            // index = index - 0x12
+            if (tokens.is(k, JsLexer::Identifier) && tokens.isPunctuator(k + 1, u"=") &&
+                tokens.text(k + 2) == tokens.text(k) && tokens.isPunctuator(k + 3, u"-") &&
+                tokens.is(k + 4, JsLexer::Number)) {
+                integerValue(tokens.text(k + 4), accessor.offset);
+            }
+            QString value;
+            if (tokens.is(k, JsLexer::String) && tokens[k].length == 67 &&
+                JsLexer::stringValue(tokens.text(k), value) && value.endsWith('=')) {
+                accessor.alphabet = value.chopped(1);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// The tool's own atob() over a custom alphabet, followed by its UTF-8 decoding step
+bool decodeArrayString(QStringView text, const QString &alphabet, QString &value) {
+    QByteArray bytes;
+    quint32 bits = 0;
+    int count = 0;
+    for (QChar ch : text) {
+        if (ch == '=') {
+            break;
+        }
+        const qsizetype digit = alphabet.indexOf(ch);
+        if (digit < 0) {
+            return false;
+        }
+        bits = bits << 6 | quint32(digit);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            bytes += static_cast<char>(bits >> count & 0xFF);
+        }
+    }
+    value = QString::fromUtf8(bytes);
+    return true;
+}
+
+bool unpackStringArray(QStringView script, QString &output, Deadline &deadline) {
+    const ScriptTokens tokens(script, deadline);
+    if (deadline.expired()) {
+        return false;
+    }
+    const ScriptIndex scriptIndex(tokens);
+    for (StringArray &array : findStringArrays(tokens)) {
+        if (deadline.expired()) {
+            return false;
+        }
+        const QStringView name = tokens.text(array.declaration);
+        Accessor accessor;
+        if (!findAccessor(tokens, scriptIndex, name, accessor)) {
+            continue;
+        }
+        const qint64 rotation = rotationCount(tokens, scriptIndex, name) % array.strings.size();
+        std::rotate(array.strings.begin(), array.strings.begin() + rotation,
+                    array.strings.end());
+
+        output.clear();
+        qsizetype copied = 0;
+        for (const qsizetype i : scriptIndex.uses(accessor.name)) {
+            if (deadline.expired()) {
+                return false;
+            }
+            if ((i >= accessor.first && i <= accessor.last) || tokens.isPunctuator(i - 1, u".") ||
+                !tokens.isPunctuator(i + 1, u"(") || !tokens.isPunctuator(i + 3, u")")) {
+                continue;
+            }
+            qint64 index = 0;
+            QString literal;
+            const bool literalIndex =
+                tokens.is(i + 2, JsLexer::Number)
+                    ? integerValue(tokens.text(i + 2), index)
+                    : tokens.is(i + 2, JsLexer::String) &&
+                          JsLexer::stringValue(tokens.text(i + 2), literal) &&
+                          integerValue(literal, index);
+            index -= accessor.offset;
+            if (!literalIndex || index < 0 || index >= array.strings.size()) {
+                continue;
+            }
+            QString value = array.strings[index];
+            if (!accessor.alphabet.isEmpty() &&
+                !decodeArrayString(array.strings[index], accessor.alphabet, value)) {
+                continue;
+            }
+            output += script.mid(copied, tokens[i].start - copied);
+            output += JsLexer::quote(value);
+            copied = tokens.end(i + 3);
+        }
+        if (copied > 0) {
+            output += script.mid(copied);
+            return true;
+        }
+    }
+    return false;
+}
+
+// JJencode spells a script with nothing but symbols, digits and one variable ($ by default):
+//
+//     $=~[];$={___:++$,$$$$:(![]+"")[$], ... };$.$_=...;$.$($.$($.$$+"\""+<payload>+"\"")())();
+//
+// The payload concatenates quoted fragments and properties of $ standing for the digits 0-9,
+// the letters a-f, l, o, t and u; together they spell a string literal with octal and \u
+// escapes for every other character.
+bool detectJJencode(QStringView script) {
+    return script.contains(u"=~[];");
+}
+
+bool unpackJJencode(QStringView script, QString &output, Deadline &deadline) {
+    const qsizetype setup = script.indexOf(u"=~[];");
+    qsizetype start = setup;
+    while (start > 0 && (script[start - 1] == '$' || script[start - 1] == '_' ||
+                         script[start - 1].isLetterOrNumber())) {
+        start--;
+    }
+    const QStringView global = script.mid(start, setup - start);
+    if (global.isEmpty()) {
+        return false;
+    }
+
+    const QString prefix = QString("%1.$(%1.$(%1.$$+\"\\\"\"+").arg(global);
+    const QStringView suffix = u"\"\\\"\")())()";
+    const qsizetype payload = script.indexOf(prefix, setup);
+    const qsizetype payloadEnd = payload < 0 ? -1 : script.indexOf(suffix, payload);
+    if (payloadEnd < 0) {
+        return false;
+    }
+
+    struct Symbol {
+        const char16_t *name;
+        char16_t value;
+    };
+    static const Symbol kSymbols[] = {
+        {u"___", '0'},  {u"__$", '1'},  {u"_$_", '2'},  {u"_$$", '3'},  {u"$__", '4'},
+        {u"$_$", '5'},  {u"$$_", '6'},  {u"$$$", '7'},  {u"$___", '8'}, {u"$__$", '9'},
+        {u"$_$_", 'a'}, {u"$_$$", 'b'}, {u"$$__", 'c'}, {u"$$_$", 'd'}, {u"$$$_", 'e'},
+        {u"$$$$", 'f'}, {u"_$", 'o'},   {u"__", 't'},   {u"_", 'u'},
+    };
+    const QString letterL = QString("(![]+\"\")[%1._$_]").arg(global);
+
+    // The fragments spell the body of a string literal, which is then read like any other
+    QString literal = "\"";
+    QStringView rest = script.mid(payload + prefix.size(), payloadEnd - payload - prefix.size());
+    QString fragment;
+    while (!rest.isEmpty()) {
+        if (deadline.expired()) {
+            return false;
+        }
+        if (rest.front() == '"') {
+            qsizetype close = 1;
+            while (close < rest.size() && rest[close] != '"') {
+                close += rest[close] == '\\' ? 2 : 1;
+            }
+            if (close >= rest.size() || !JsLexer::stringValue(rest.first(close + 1), fragment)) {
+                return false;
+            }
+            literal += fragment;
+            rest = rest.mid(close + 1);
+        } else if (rest.startsWith(letterL)) {
+            literal += 'l';
+            rest = rest.mid(letterL.size());
+        } else if (rest.startsWith(global) && rest.mid(global.size()).startsWith('.')) {
+            qsizetype length = global.size() + 1;
+            while (length < rest.size() && (rest[length] == '$' || rest[length] == '_')) {
+                length++;
+            }
+            const QStringView property = rest.mid(global.size() + 1, length - global.size() - 1);
+            const Symbol *symbol = std::find_if(
+                std::begin(kSymbols), std::end(kSymbols),
+                [property](const Symbol &symbol) { return property == QStringView(symbol.name); });
+            if (symbol == std::end(kSymbols)) {
+                return false;
+            }
+            literal += QChar(symbol->value);
+            rest = rest.mid(length);
+        } else {
+            return false;
+        }
+
+        if (rest.startsWith('+')) {
+            rest = rest.mid(1);
+        } else if (!rest.isEmpty()) {
+            return false;
+        }
+    }
+    literal += '"';
+
+    QString code;
+    if (!JsLexer::stringValue(literal, code)) {
+        return false;
+    }
+    qsizetype end = payloadEnd + suffix.size();
+    end += script.mid(end).startsWith(';');
+    output = script.first(start).toString();
+    output += code;
+    output += script.mid(end);
+    return true;
+}
+
+// AAencode spells a script with Japanese emoticons. After a fixed preamble every character
+// is (ﾟДﾟ)[ﾟεﾟ] (a backslash) followed by the octal digits of its code, or by (oﾟｰﾟo) ('u')
+// and four hex digits, each digit one of sixteen emoticon expressions. Whitespace carries no
+// meaning, and the whole script is one encoded program.
+bool detectAAencode(QStringView script) {
+    return script.contains(u"(ﾟДﾟ)") && script.contains(u"ﾟεﾟ");
+}
+
+bool unpackAAencode(QStringView script, QString &output, Deadline &deadline) {
+    // The expressions of the encoder's digits 0-f, without whitespace
+    static const char16_t *const kDigits[] = {
+        u"(c^_^o)",
+        u"(ﾟΘﾟ)",
+        u"((o^_^o)-(ﾟΘﾟ))",
+        u"(o^_^o)",
+        u"(ﾟｰﾟ)",
+        u"((ﾟｰﾟ)+(ﾟΘﾟ))",
+        u"((o^_^o)+(o^_^o))",
+        u"((ﾟｰﾟ)+(o^_^o))",
+        u"((ﾟｰﾟ)+(ﾟｰﾟ))",
+        u"((ﾟｰﾟ)+(ﾟｰﾟ)+(ﾟΘﾟ))",
+        u"(ﾟДﾟ).ﾟωﾟﾉ",
+        u"(ﾟДﾟ).ﾟΘﾟﾉ",
+        u"(ﾟДﾟ)['c']",
+        u"(ﾟДﾟ).ﾟｰﾟﾉ",
+        u"(ﾟДﾟ).ﾟДﾟﾉ",
+        u"(ﾟДﾟ)[ﾟΘﾟ]",
+    };
+    constexpr QStringView kStart = u"(ﾟДﾟ)['_']((ﾟДﾟ)['_'](ﾟεﾟ+(ﾟДﾟ)[ﾟoﾟ]+";
+    constexpr QStringView kEnd = u"(ﾟДﾟ)[ﾟoﾟ])(ﾟΘﾟ))('_')";
+    constexpr QStringView kBackslash = u"(ﾟДﾟ)[ﾟεﾟ]+";
+    constexpr QStringView kUnicode = u"(oﾟｰﾟo)+";
+
+    QString compact;
+    compact.reserve(script.size());
+    for (QChar ch : script) {
+        if (!ch.isSpace()) {
+            compact += ch;
+        }
+    }
+    const qsizetype start = compact.indexOf(kStart);
+    const qsizetype end = start < 0 ? -1 : compact.lastIndexOf(kEnd);
+    if (start < 0 || end < start + kStart.size()) {
+        return false;
+    }
+    const QStringView trailer = QStringView(compact).mid(end + kEnd.size());
+    if (!trailer.isEmpty() && trailer != u";") {
+        return false;
+    }
+
+    QStringView rest = QStringView(compact).mid(start + kStart.size(), end - start - kStart.size());
+    QString code;
+    while (!rest.isEmpty()) {
+        if (deadline.expired()) {
+            return false;
+        }
+        if (!rest.startsWith(kBackslash)) {
+            return false;
+        }
+        rest = rest.mid(kBackslash.size());
+        const bool unicode = rest.startsWith(kUnicode);
+        if (unicode) {
+            rest = rest.mid(kUnicode.size());
+        }
+
+        char32_t value = 0;
+        int digits = 0;
+        while (!rest.isEmpty() && !rest.startsWith(kBackslash)) {
+            const int base = unicode ? 16 : 8;
+            int digit = 0;
+            while (digit < base && !rest.startsWith(QStringView(kDigits[digit]))) {
+                digit++;
+            }
+            if (digit == base || digits == 6) {
+                return false;
+            }
+            value = value * base + digit;
+            digits++;
+            rest = rest.mid(QStringView(kDigits[digit]).size());
+            if (rest.startsWith('+')) {
+                rest = rest.mid(1);
+            }
+        }
+        if (digits == 0 || value > kMaxCodePoint) {
+            return false;
+        }
+        appendCodePoint(code, value);
+    }
+    output = code;
+    return true;
+}
+
+// Why a call that ran out of time or was cancelled stopped
+Unpacker::StopReason interruption(const Unpacker::Budget &budget) {
+    return budget.control && budget.control->cancelled() ? Unpacker::Cancelled
+                                                         : Unpacker::TimeLimit;
+}
+
+// Output side of the beautifier. Whitespace is only requested and is written out together with
+// the next token, so a token can still take back the space or line break the previous one
+// asked for.
+struct JsWriter {
+    explicit JsWriter(qsizetype capacity) { output.reserve(capacity); }
+
+    void requestSpace() { spacePending = true; }
+    void cancelSpace() { spacePending = false; }
+    void requestNewline(int count = 1) { newlinesPending = qMax(newlinesPending, count); }
+    void cancelNewline() { newlinesPending = 0; }
+
+    void write(QStringView text) {
+        if (!output.isEmpty()) {
+            if (newlinesPending > 0) {
+                for (int i = 0; i < newlinesPending; i++) {
+                    output.append('\n');
                 }
-                formatted += ch;
-                if (i + 1 < result.length() && result[i + 1] != ')' && result[i + 1] != ';' &&
-                    result[i + 1] != '}') {
-                    formatted += '\n';
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += indentStr;
-                    }
+                for (int i = 0; i < indent; i++) {
+                    output.append(u"    ");
                 }
-                break;
+            } else if (spacePending) {
+                output.append(' ');
+            }
+        }
+        newlinesPending = 0;
+        spacePending = false;
+        output.append(text);
+    }
 
-            case ';':
-                formatted += ch;
-                if (i + 1 < result.length() && result[i + 1] != '}' && result[i + 1] != ')') {
-                    formatted += '\n';
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += indentStr;
-                    }
-                }
-                break;
+    QString output;
+    int indent = 0;
+    int newlinesPending = 0;
+    bool spacePending = false;
+};
 
-            case '(':
-                formatted += ch;
-                // Check if this is a function declaration
-                if (i > 7 && result.mid(i - 8, 8) == "function") {
-                    // Keep parameters on same line for function declarations
-                }
-                break;
+// Whether `token` can end an operand, after which '+' is binary, '(' is a call and so on.
+bool endsOperand(const JsLexer::Token &token, QStringView text) {
+    switch (token.type) {
+        case JsLexer::Identifier:
+        case JsLexer::Number:
+        case JsLexer::String:
+        case JsLexer::Regex:
+            return true;
+        case JsLexer::Template:
+            return !text.endsWith(u"${");
+        case JsLexer::Keyword:
+            return text == u"this" || text == u"super" || text == u"null" || text == u"true" ||
+                   text == u"false";
+        case JsLexer::Punctuator:
+            return text == u")" || text == u"]";
+        default:
+            return false;
+    }
+}
 
-            case ')':
-                formatted += ch;
-                // Look ahead for opening brace
-                if (i + 1 < result.length() && result[i + 1] == '{') {
-                    formatted += '\n';
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += indentStr;
-                    }
-                }
-                break;
+// A '{' is an object literal where an expression is expected, and a block everywhere else.
+bool opensObjectLiteral(const JsLexer::Token &previous, QStringView text, bool afterLabel) {
+    if (previous.type == JsLexer::Keyword) {
+        return text == u"return" || text == u"typeof" || text == u"yield" || text == u"await" ||
+               text == u"in" || text == u"void" || text == u"delete" || text == u"case" ||
+               text == u"instanceof";
+    }
+    if (previous.type != JsLexer::Punctuator) {
+        return false;
+    }
+    if (text == u":") {
+        return !afterLabel;
+    }
+    return text != u")" && text != u"]" && text != u"}" && text != u"=>" && text != u";";
+}
 
-            case ':':
-                formatted += ch;
-                formatted += " ";
-                break;
+}  // namespace
 
-            case ' ':
-                // Don't add multiple spaces
-                if (!formatted.endsWith(' ') && !formatted.endsWith('\n') &&
-                    !formatted.endsWith('\t')) {
-                    formatted += ch;
-                }
-                break;
+void Unpacker::Registry::add(const Format &format) {
+    list.append(format);
+}
 
-            default:
-                formatted += ch;
+Unpacker::Result Unpacker::Registry::unpack(const QString &input) const {
+    return unpack(input, Budget());
+}
+
+Unpacker::Result Unpacker::Registry::unpack(const QString &input, const Budget &budget) const {
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.output = input;
+    if (input.size() > budget.maxSize) {
+        result.stopReason = SizeLimit;
+        return result;
+    }
+    QSet<QString> seen = {input};  // earlier layers, implicitly shared with them
+    QString output;
+    Deadline deadline(budget.maxMilliseconds, budget.control);
+    for (;;) {
+        const Format *applied = nullptr;
+        for (const Format &format : list) {
+            if (format.detect(result.output) && format.unpack(result.output, output, deadline) &&
+                output != result.output) {
+                applied = &format;
                 break;
+            }
+        }
+        if (!applied) {
+            // A format that gave up at the deadline leaves it expired
+            result.stopReason = deadline.expired() ? interruption(budget) : FixedPoint;
+            return result;
+        }
+        if (output.size() > budget.maxSize) {
+            result.stopReason = SizeLimit;
+            return result;
+        }
+        if (seen.contains(output)) {
+            result.stopReason = Cycle;  // a layer that packs itself again
+            return result;
         }
-    }
 
-    // Clean up extra newlines
-    while (formatted.contains("\n\n\n")) {
-        formatted.replace("\n\n\n", "\n\n");
+        seen.insert(output);
+        result.output.swap(output);
+        result.layers.append(applied->name);
+        if (result.layers.size() >= budget.maxLayers) {
+            result.stopReason = LayerLimit;
+            return result;
+        }
+        if (timer.elapsed() >= budget.maxMilliseconds ||
+            (budget.control && budget.control->cancelled())) {
+            result.stopReason = interruption(budget);
+            return result;
+        }
     }
+}
 
-    return formatted.trimmed();
+const Unpacker::Registry &Unpacker::builtinFormats() {
+    static const Registry registry = [] {
+        Registry formats;
+        formats.add({"Dean Edwards",
+                     [](QStringView script) {
+                         return script.contains(u"eval(function(p,a,c,k,e,");
+                     },
+                     &Unpacker::unpackDeanEdwards});
+        formats.add({"JJencode", &detectJJencode, &unpackJJencode});
+        formats.add({"AAencode", &detectAAencode, &unpackAAencode});
+        formats.add({"string array", &detectStringArray, &unpackStringArray});
+        formats.add({"eval", &detectEval, &unpackEval});
+        return formats;
+    }();
+    return registry;
 }
 
-QString Unpacker::formatJson(const QString &input) {
-    QString text = input.trimmed();
-    if (text.isEmpty())
-        return text;
+QString Unpacker::deobfuscateJavaScript(const QString &input, QStringList *layers) {
+    Result result = deobfuscateJavaScript(input, Budget());
+    if (layers) {
+        *layers = result.layers;
+    }
+    return result.output;
+}
 
-    // Fix common JSON issues
-    QString fixed = text;
+Unpacker::Result Unpacker::deobfuscateJavaScript(const QString &input, const Budget &budget) {
+    QElapsedTimer timer;
+    timer.start();
+    Result result = builtinFormats().unpack(input, budget);
 
-    // Add quotes to unquoted keys and string values
-    fixed.replace(QRegularExpression("([{,]\\s*)([a-zA-Z_][a-zA-Z0-9_]*)\\s*:"), "\\1\"\\2\":");
-    fixed.replace(QRegularExpression(":\\s*([a-zA-Z_][a-zA-Z0-9_\\s]*)\\s*([,}])"), ": \"\\1\"\\2");
+    // Unpacking leaves plain code behind; folding its constants undoes the string splitting,
+    // hex numbers and lookup arrays obfuscators put on top. Both passes get what is left of the
+    // budget, and a pass that runs out of it leaves the text as it was.
+    Deadline deadline(budget.maxMilliseconds - timer.elapsed(), budget.control);
+    if (result.stopReason != TimeLimit && result.stopReason != Cancelled &&
+        result.stopReason != SizeLimit) {
+        result.output = JsAst::simplify(result.output, &deadline);
+    }
+    result.output = decodeEscapes(result.output, deadline);
+    if (deadline.expired() && result.stopReason != SizeLimit) {
+        result.stopReason = interruption(budget);
+    }
+    return result;
+}
 
-    // Fix single quotes to double quotes
-    fixed.replace("'", "\"");
+// Locates eval(function(p,a,c,k,e,r){...}('payload',base,count,'k1|k2|...'.split('|'),...))
+// with a forward scan instead of a backtracking pattern over the whole input.
+bool Unpacker::parsePackedScript(QStringView source, PackedScript &script) {
+    qsizetype pos = source.indexOf(u"eval(function(p,a,c,k,e,");
+    if (pos < 0) {
+        return false;
+    }
+    pos = source.indexOf(u"}('", pos);
+    if (pos < 0) {
+        return false;
+    }
+    pos += 2;
+
+    return readStringLiteral(source, pos, script.payload) && readLiteral(source, pos, u",") &&
+           readInteger(source, pos, script.base) && readLiteral(source, pos, u",") &&
+           readInteger(source, pos, script.count) && readLiteral(source, pos, u",") &&
+           readStringLiteral(source, pos, script.keywords) &&
+           readLiteral(source, pos, u".split(") && script.base >= 2 && script.base <= kMaxBase;
+}
 
-    // Clean up any double quotes around numbers or booleans
-    fixed.replace(QRegularExpression("\"(\\d+(?:\\.\\d+)?)\""), "\\1");
-    fixed.replace(QRegularExpression("\"(true|false|null)\""), "\\1");
+bool Unpacker::unpackDeanEdwards(QStringView input, QString &output, Deadline &deadline) {
+    PackedScript script;
+    if (!parsePackedScript(input, script)) {
+        return false;
+    }
 
-    // Format with proper indentation
-    QString formatted = "";
-    int indentLevel = 0;
-    bool inString = false;
-    bool escaped = false;
+    QList<QStringView> keywords;
+    qsizetype keywordStart = 0;
+    for (qsizetype i = 0; i <= script.keywords.size(); i++) {
+        if (i == script.keywords.size() || script.keywords[i] == '|') {
+            keywords.append(QStringView(script.keywords).mid(keywordStart, i - keywordStart));
+            keywordStart = i + 1;
+        }
+    }
 
-    for (int i = 0; i < fixed.length(); i++) {
-        QChar ch = fixed[i];
+    // One pass over the payload: every token is decoded once and looked up, the same result
+    // the packer's per-keyword \b<token>\b replacements produce
+    const bool highAscii = script.base > kMaxWordBase;
+    const QChar *pos = script.payload.constData();
+    const QChar *end = pos + script.payload.size();
+    output.clear();
+    output.reserve(script.payload.size() + script.keywords.size());
+    while (pos < end) {
+        if (deadline.expired()) {
+            return false;
+        }
+        const QChar *start = pos;
+        if (!isPackedTokenChar(*pos, highAscii)) {
+            while (pos < end && !isPackedTokenChar(*pos, highAscii)) {
+                pos++;
+            }
+            output.append(start, pos - start);
+            continue;
+        }
 
-        if (!escaped && ch == '\"') {
-            inString = !inString;
+        while (pos < end && isPackedTokenChar(*pos, highAscii)) {
+            pos++;
+        }
+        const int index = packedTokenIndex(QStringView(start, pos), script.base, script.count);
+        if (index >= 0 && index < keywords.size() && !keywords[index].isEmpty()) {
+            output.append(keywords[index]);
+        } else {
+            output.append(start, pos - start);
         }
+    }
 
-        if (!inString) {
-            switch (ch.toLatin1()) {
-                case '{':
-                case '[':
-                    formatted += ch;
-                    formatted += "\n";
-                    indentLevel++;
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += "  ";
-                    }
-                    break;
-
-                case '}':
-                case ']':
-                    // Remove trailing spaces and add newline
-                    formatted = formatted.trimmed();
-                    formatted += "\n";
-                    indentLevel = qMax(0, indentLevel - 1);
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += "  ";
-                    }
-                    formatted += ch;
-                    break;
-
-                case ',':
-                    formatted += ch;
-                    formatted += "\n";
-                    for (int j = 0; j < indentLevel; j++) {
-                        formatted += "  ";
-                    }
-                    break;
+    return true;
+}
 
-                case ':':
-                    formatted += ch;
-                    formatted += " ";
-                    break;
+namespace {
 
-                case ' ':
-                case '\t':
-                case '\n':
-                case '\r':
-                    // Skip whitespace outside strings
-                    break;
+// Whether a statement starting with `token` comes out the same with or without the one before
+// it. Comments, tokens that may continue the previous statement (else, '.', ',', binary
+// operators, ...) and regexes, which after a '}' would read as division, do not.
+bool startsPiece(const JsLexer::Token &token, QStringView text) {
+    switch (token.type) {
+        case JsLexer::Identifier:
+        case JsLexer::Number:
+        case JsLexer::String:
+            return true;
+        case JsLexer::Template:
+            return !text.startsWith('}');
+        case JsLexer::Keyword:
+            return text != u"else" && text != u"catch" && text != u"finally" && text != u"while";
+        case JsLexer::Punctuator:
+            return text == u"{" || text == u"(" || text == u"[" || text == u"!" || text == u"~" ||
+                   text == u"+" || text == u"-" || text == u"++" || text == u"--";
+        default:
+            return false;
+    }
+}
 
-                default:
-                    formatted += ch;
-                    break;
+// One run of the beautifier over a script or a piece of one. A piece can be beautified on its
+// own when it is cut between two top-level statements: nothing but the line breaks carries over
+// a ';' or '}' at the top level, and the top level has indent 0.
+struct Beautified {
+    QString output;
+    bool finished = true;          // false: the deadline passed, the rest was copied as written
+    int newlines = 0;              // line breaks before the first token
+    bool startsStatement = false;  // the first token reads the same after anything
+    bool endsStatement = false;    // ends with a top-level ';' or '}', nothing left open
+};
+
+Beautified beautifyScript(QStringView input, Deadline deadline, TaskControl *progress = nullptr) {
+    struct Scope {
+        QChar bracket;
+        bool object = false;     // {} of an object literal: one member per line
+        bool forHeader = false;  // (...) of a for statement: ';' does not end a line
+        bool doBody = false;
+        bool inCase = false;  // statements of a case clause, indented one level further
+        int ternaries = 0;    // open '?' waiting for their ':'
+    };
+
+    JsLexer lexer(input);
+    JsWriter out(input.size() + input.size() / 2);
+    QList<Scope> scopes = {{'{'}};  // the top level reads like a block
+
+    JsLexer::Token previous;
+    QStringView previousText;
+    bool tightNext = false;      // the last token binds to the next one, as in "!a" or "a.b"
+    bool caseLabel = false;      // the next plain ':' ends a case or default label
+    bool afterLabel = false;     // the previous token was the ':' of such a label
+    bool closedDoBody = false;   // the last '}' ended the body of a do-while loop
+    int substitutions = 0;       // open ${ of template literals
+    qsizetype written = 0;       // input up to the end of the last token handled
+    JsLexer::Token last;         // comments included, unlike `previous`
+    QStringView lastText;
+    Beautified result;
+    int tokens = 0;
+    for (JsLexer::Token token = lexer.next(); token.type != JsLexer::EndOfInput;
+         token = lexer.next()) {
+        if (deadline.expired()) {
+            out.output += input.mid(written);  // the rest as written
+            result.finished = false;
+            break;
+        }
+        if (progress && ++tokens % 65536 == 0) {
+            progress->report(token.start, input.size());
+        }
+        written = token.start + token.length;
+        const QStringView text = lexer.text(token);
+        if (last.type == JsLexer::EndOfInput) {
+            result.newlines = token.newlines;
+            result.startsStatement = startsPiece(token, text);
+        }
+        last = token;
+        lastText = text;
+
+        // The author's line breaks are kept, at most one blank line at a time. Beyond
+        // readability this keeps every line break automatic semicolon insertion might rely on.
+        if (token.newlines > 0) {
+            out.requestNewline(qMin(token.newlines, 2));
+        }
+        if (tightNext) {
+            out.cancelSpace();
+            tightNext = false;
+        }
+
+        if (token.type == JsLexer::LineComment || token.type == JsLexer::BlockComment) {
+            if (token.type == JsLexer::LineComment && token.newlines == 0) {
+                out.cancelNewline();  // a trailing comment stays on its line
             }
+            out.requestSpace();
+            out.write(text);
+            if (token.type == JsLexer::LineComment) {
+                out.requestNewline();
+            } else {
+                out.requestSpace();
+            }
+            continue;
+        }
+
+        const bool afterOperand = endsOperand(previous, previousText);
+        const bool labelEnded = afterLabel;
+        afterLabel = false;
+        Scope &scope = scopes.last();
+        if (token.type != JsLexer::Punctuator) {
+            if (token.type == JsLexer::Template && text.startsWith('}')) {
+                out.cancelSpace();  // closes a substitution; part of the template literal
+                out.cancelNewline();
+                substitutions--;
+            } else if (previous.type == JsLexer::Keyword || afterOperand) {
+                out.requestSpace();
+            }
+            const bool label = token.type == JsLexer::Keyword &&
+                               (text == u"case" || text == u"default") && !scope.object;
+            if (label && scope.inCase) {
+                scope.inCase = false;
+                out.indent--;
+            }
+            if (previousText == u"}" && token.newlines == 0 && token.type == JsLexer::Keyword &&
+                (text == u"else" || text == u"catch" || text == u"finally" ||
+                 (text == u"while" && closedDoBody))) {
+                out.cancelNewline();
+                out.requestSpace();
+            }
+            out.write(text);
+            if (label) {
+                caseLabel = true;
+            }
+            if (token.type == JsLexer::Template && text.endsWith(u"${")) {
+                tightNext = true;
+                substitutions++;
+            }
+        } else if (text == u"{") {
+            const bool object = opensObjectLiteral(previous, previousText, labelEnded);
+            if (previous.type != JsLexer::EndOfInput && previousText != u"(" &&
+                previousText != u"[" && previousText != u"...") {
+                out.requestSpace();
+            }
+            out.write(text);
+            Scope opened{'{'};
+            opened.object = object;
+            opened.doBody = previousText == u"do";
+            scopes.append(opened);
+            out.indent++;
+            out.requestNewline();
+            caseLabel = false;
+        } else if (text == u"}") {
+            closedDoBody = scope.doBody;
+            const int levels = scope.inCase ? 2 : 1;
+            if (scopes.size() > 1) {
+                scopes.removeLast();
+            }
+            out.indent = qMax(0, out.indent - levels);
+            if (previousText == u"{") {
+                out.cancelNewline();  // {} stays on one line
+                out.cancelSpace();
+            } else {
+                out.requestNewline();
+            }
+            out.write(text);
+            out.requestNewline();
+        } else if (text == u"(" || text == u"[") {
+            const bool call = afterOperand && previous.type != JsLexer::Keyword;
+            if (call) {
+                out.cancelSpace();
+                if (token.newlines == 0) {
+                    out.cancelNewline();
+                }
+            } else if (previous.type == JsLexer::Keyword && previousText != u"function" &&
+                       previousText != u"super" && previousText != u"import" &&
+                       previousText != u"this") {
+                out.requestSpace();
+            }
+            out.write(text);
+            Scope opened{text[0]};
+            opened.forHeader = previousText == u"for";
+            scopes.append(opened);
+            tightNext = true;
+        } else if (text == u")" || text == u"]") {
+            if (scopes.size() > 1) {
+                scopes.removeLast();
+            }
+            out.cancelSpace();
+            if (token.newlines == 0) {
+                out.cancelNewline();
+            }
+            out.write(text);
+        } else if (text == u";" || text == u",") {
+            out.cancelSpace();
+            if (token.newlines == 0) {
+                out.cancelNewline();
+            }
+            out.write(text);
+            if (text == u";" ? scope.forHeader : !scope.object) {
+                out.requestSpace();
+            } else {
+                out.requestNewline();
+            }
+            if (text == u";") {
+                caseLabel = false;
+            }
+        } else if (text == u"." || text == u"?.") {
+            out.cancelSpace();
+            if (token.newlines == 0) {
+                out.cancelNewline();
+            }
+            out.write(text);
+            tightNext = true;
+        } else if (text == u":") {
+            if (scope.ternaries > 0) {
+                scope.ternaries--;
+                out.requestSpace();
+                out.write(text);
+                out.requestSpace();
+            } else {
+                out.cancelSpace();
+                out.write(text);
+                if (caseLabel) {
+                    out.requestNewline();
+                    caseLabel = false;
+                    afterLabel = true;
+                    if (!scope.inCase) {
+                        scope.inCase = true;
+                        out.indent++;
+                    }
+                } else {
+                    out.requestSpace();
+                }
+            }
+        } else if (((text == u"++" || text == u"--") && afterOperand && token.newlines == 0)) {
+            out.cancelSpace();  // postfix
+            out.write(text);
+        } else if (text == u"!" || text == u"~" || text == u"..." || text == u"++" ||
+                   text == u"--" || ((text == u"+" || text == u"-") && !afterOperand)) {
+            // Prefix operators stay attached to their operand
+            if (previous.type == JsLexer::Keyword || afterOperand ||
+                (previous.type == JsLexer::Punctuator && previousText != u"(" &&
+                 previousText != u"[" && previousText != u"!" && previousText != u"~")) {
+                out.requestSpace();
+            }
+            out.write(text);
+            tightNext = true;
         } else {
-            formatted += ch;
+            // Binary and assignment operators, '?' and '=>'
+            if (text == u"?") {
+                scope.ternaries++;
+            }
+            out.requestSpace();
+            out.write(text);
+            out.requestSpace();
         }
 
-        escaped = (ch == '\\' && !escaped);
+        previous = token;
+        previousText = text;
+    }
+
+    const Scope &top = scopes.first();
+    result.endsStatement = result.finished && scopes.size() == 1 && out.indent == 0 &&
+                           substitutions == 0 && top.ternaries == 0 && !top.inCase && !caseLabel &&
+                           last.type == JsLexer::Punctuator &&
+                           (lastText == u";" || lastText == u"}");
+    result.output.swap(out.output);
+    if (progress && result.finished) {
+        progress->report(1, 1);
     }
+    return result;
+}
 
-    return formatted.trimmed();
+}  // namespace
+
+QString Unpacker::beautifyJavaScript(const QString &input) {
+    return beautifyJavaScript(input, Budget()).output;
+}
+
+Unpacker::Result Unpacker::beautifyJavaScript(const QString &input, const Budget &budget) {
+    Result result;
+    if (input.size() > budget.maxSize) {
+        result.output = input;
+        result.stopReason = SizeLimit;
+        return result;
+    }
+    Beautified beautified = beautifyScript(
+        input, Deadline(budget.maxMilliseconds, budget.control), budget.control);
+    result.output.swap(beautified.output);
+    if (!beautified.finished) {
+        result.stopReason = interruption(budget);
+    }
+    return result;
+}
+
+QString Unpacker::beautifyJavaScriptParallel(const QString &input) {
+    return beautifyJavaScriptParallel(input, Budget()).output;
+}
+
+Unpacker::Result Unpacker::beautifyJavaScriptParallel(const QString &input, const Budget &budget) {
+    constexpr qsizetype kMinPiece = 256 * 1024;
+    const int workers = parallel::workerCount(input.size(), kMinPiece);
+    if (input.size() < ParallelThreshold || input.size() > budget.maxSize || workers < 2) {
+        return beautifyJavaScript(input, budget);
+    }
+
+    // Cut after top-level statements, a few pieces per worker so that one long module does not
+    // leave the others idle
+    QElapsedTimer timer;
+    timer.start();
+    const QStringView script(input);
+    const qsizetype pieceSize = qMax(kMinPiece, input.size() / (4 * workers));
+    QList<qsizetype> cuts = {0};
+    for (qsizetype end : JsLexer::topLevelEnds(script)) {
+        if (end - cuts.last() < pieceSize || end == script.size()) {
+            continue;
+        }
+        JsLexer lexer(script.mid(end));
+        const JsLexer::Token next = lexer.next();
+        if (startsPiece(next, lexer.text(next))) {
+            cuts.append(end);
+        }
+    }
+    cuts.append(script.size());
+    const int pieces = cuts.size() - 1;
+    if (pieces < 2) {
+        return beautifyJavaScript(input, budget);  // a single statement, e.g. one big IIFE
+    }
+
+    QList<Beautified> beautified(pieces);
+    std::atomic<int> done{0};
+    parallel::forEach(pieces, [&](int k) {
+        const QStringView piece = script.mid(cuts[k], cuts[k + 1] - cuts[k]);
+        const Deadline deadline(budget.maxMilliseconds - timer.elapsed(), budget.control);
+        beautified[k] = beautifyScript(piece, deadline);
+        if (budget.control) {
+            budget.control->report(++done, pieces);
+        }
+    });
+
+    // The pieces are joined with the line breaks the sequential beautifier puts between two
+    // statements. The pre-scan is not the lexer: where a piece shows it was cut elsewhere after
+    // all, everything from the piece before it on is beautified again, in one go.
+    Result result;
+    qsizetype size = 0;
+    for (const Beautified &piece : beautified) {
+        size += piece.output.size() + 2;
+    }
+    result.output.reserve(size);
+    qsizetype joint = 0;  // where the output of the last piece joined starts
+    for (int k = 0; k < pieces; k++) {
+        const Beautified &piece = beautified[k];
+        if (k > 0 && !(beautified[k - 1].endsStatement && piece.startsStatement)) {
+            result.output.truncate(joint);
+            const Deadline deadline(budget.maxMilliseconds - timer.elapsed(), budget.control);
+            Beautified rest = beautifyScript(script.mid(cuts[k - 1]), deadline);
+            result.output += rest.output;
+            result.stopReason = rest.finished ? FixedPoint : interruption(budget);
+            break;
+        }
+        for (int i = 0; k > 0 && i < qBound(1, piece.newlines, 2); i++) {
+            result.output.append('\n');
+        }
+        joint = result.output.size();
+        result.output += piece.output;
+        if (!piece.finished) {
+            result.stopReason = interruption(budget);
+        }
+    }
+    return result;
+}
+
+Unpacker::StopReason Unpacker::deobfuscateJavaScript(QByteArrayView input, QByteArray &output,
+                                                     const Budget &budget, QStringList *layers) {
+    const Result result = deobfuscateJavaScript(QString::fromUtf8(input), budget);
+    output = result.output.toUtf8();
+    if (layers) {
+        *layers = result.layers;
+    }
+    return result.stopReason;
+}
+
+Unpacker::StopReason Unpacker::beautifyJavaScript(QByteArrayView input, QByteArray &output,
+                                                  const Budget &budget) {
+    const Result result = beautifyJavaScript(QString::fromUtf8(input), budget);
+    output = result.output.toUtf8();
+    return result.stopReason;
+}
+
+Unpacker::StopReason Unpacker::beautifyJavaScriptParallel(QByteArrayView input, QByteArray &output,
+                                                          const Budget &budget) {
+    const Result result = beautifyJavaScriptParallel(QString::fromUtf8(input), budget);
+    output = result.output.toUtf8();
+    return result.stopReason;
+}
+
+QString Unpacker::formatJson(const QString &input) {
+    return formatJson(input, Budget()).output;
+}
+
+Unpacker::Result Unpacker::formatJson(const QString &input, const Budget &budget) {
+    Result result;
+    if (input.size() > budget.maxSize) {
+        result.output = input;
+        result.stopReason = SizeLimit;
+        return result;
+    }
+    QByteArray output;
+    result.stopReason = formatJson(input.toUtf8(), output, budget);
+    result.output = QString::fromUtf8(output);
+    return result;
+}
+
+Unpacker::StopReason Unpacker::formatJson(QByteArrayView input, QByteArray &output,
+                                          const Budget &budget) {
+    output.clear();
+    if (input.size() > budget.maxSize) {
+        output = input.toByteArray();
+        return SizeLimit;
+    }
+    const QByteArray text = input.toByteArray().trimmed();
+    if (text.isEmpty())
+        return FixedPoint;
+
+    // Relaxed JSON (comments, single quotes, unquoted keys, trailing commas ...) is parsed and
+    // written back as strict JSON; anything else is only re-indented as written
+    constexpr qsizetype kSlice = 1024 * 1024;  // formatted between two looks at the clock
+    Deadline deadline(budget.maxMilliseconds, budget.control, 1);
+    Deadline converting(budget.maxMilliseconds, budget.control);
+    Json5Document document;
+    const bool parsed = document.parse(text, nullptr, nullptr, &converting);
+    const QByteArray json = parsed ? document.toJson(&converting) : text;
+    if (json.isEmpty() || (!parsed && converting.expired())) {
+        output = input.toByteArray();  // out of time before any of it could be formatted
+        return interruption(budget);
+    }
+    if (json.size() <= kSlice) {
+        output = JsonFormatter::format(json);
+        return FixedPoint;
+    }
+
+    // Large documents go through the streaming formatter a slice at a time, so the deadline is
+    // noticed; whatever is left when it passes is copied as written
+    JsonFormatter formatter;
+    for (qsizetype pos = 0; pos < json.size(); pos += kSlice) {
+        if (deadline.expired()) {
+            output += formatter.takeOutput();
+            output.append(QByteArrayView(json).sliced(pos));
+            return interruption(budget);
+        }
+        formatter.push(QByteArrayView(json).sliced(pos, qMin(kSlice, json.size() - pos)));
+        output += formatter.takeOutput();
+        if (budget.control) {
+            budget.control->report(pos + kSlice, json.size());
+        }
+    }
+    return FixedPoint;
 }
\ No newline at end of file
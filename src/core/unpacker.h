@@ -1,14 +1,105 @@
 #pragma once
 
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
 #include <QString>
+#include <QStringList>
+#include <QStringView>
+
+class Deadline;
+class TaskControl;
 
 class Unpacker {
   public:
-    static QString deobfuscateJavaScript(const QString &input);
+    // One obfuscation scheme that can be undone without running the script. detect() is a cheap
+    // prefilter (a substring search or two) run before every attempt, so a script that is not
+    // packed costs almost nothing to check; unpack() returns false when the script does not have
+    // the scheme's shape after all or nothing in it can be resolved statically, and gives up the
+    // same way once `deadline` has expired.
+    struct Format {
+        const char *name;
+        bool (*detect)(QStringView script);
+        bool (*unpack)(QStringView script, QString &output, Deadline &deadline);
+    };
+
+    // Bounds on one call. Every pass is linear in its input, and long ones check the clock as
+    // they go, so hitting a limit ends the call promptly with what was done up to that point.
+    // The same checks notice a cancelled `control`, and the beautifier and the JSON formatter
+    // report their progress to it.
+    struct Budget {
+        int maxLayers = 32;
+        qint64 maxMilliseconds = 5000;
+        qsizetype maxSize = 64 * 1024 * 1024;  // larger inputs and results are left as they are
+        TaskControl *control = nullptr;
+    };
+
+    // FixedPoint: the call ran to the end. Any other reason means the output is partial.
+    enum StopReason { FixedPoint, LayerLimit, TimeLimit, SizeLimit, Cycle, Cancelled };
+
+    struct Result {
+        QString output;
+        QStringList layers;  // names of the formats undone, outermost first
+        StopReason stopReason = FixedPoint;
+    };
+
+    // Ordered set of formats. unpack() applies the first one that changes the script, then
+    // starts over from the top with the result, until no format changes it any more: nested and
+    // mixed packers come apart layer by layer.
+    class Registry {
+      public:
+        void add(const Format &format);
+        const QList<Format> &formats() const { return list; }
+
+        Result unpack(const QString &input) const;
+        Result unpack(const QString &input, const Budget &budget) const;
+
+      private:
+        QList<Format> list;
+    };
+
+    // Dean Edwards, JJencode, AAencode, obfuscator.io string arrays, and eval()/Function()
+    // of strings that can be computed statically (concatenation, atob, unescape, ...)
+    static const Registry &builtinFormats();
+
+    static QString deobfuscateJavaScript(const QString &input, QStringList *layers = nullptr);
     static QString beautifyJavaScript(const QString &input);
     static QString formatJson(const QString &input);
 
+    // The same within a budget. Past the deadline, or once cancelled, the beautifier and the
+    // JSON formatter copy the rest of the input as written; deobfuscation returns the layers
+    // undone so far.
+    static Result deobfuscateJavaScript(const QString &input, const Budget &budget);
+    static Result beautifyJavaScript(const QString &input, const Budget &budget);
+    static Result formatJson(const QString &input, const Budget &budget);
+
+    // Same output as beautifyJavaScript(), computed on the global thread pool: the script is cut
+    // at top-level statement boundaries, which bundles have by the hundred, and the pieces are
+    // beautified concurrently. Scripts shorter than ParallelThreshold characters, or made of a
+    // single statement, are beautified on the calling thread.
+    static constexpr qsizetype ParallelThreshold = 1024 * 1024;
+    static QString beautifyJavaScriptParallel(const QString &input);
+    static Result beautifyJavaScriptParallel(const QString &input, const Budget &budget);
+
+    // Byte-oriented forms of the budgeted calls for UTF-8 files and bulk callers. The result
+    // replaces the contents of `output`. The JSON formatter works on the bytes as they are; the
+    // JavaScript passes work on UTF-16 and convert once on the way in and once on the way out.
+    static StopReason deobfuscateJavaScript(QByteArrayView input, QByteArray &output,
+                                            const Budget &budget, QStringList *layers = nullptr);
+    static StopReason beautifyJavaScript(QByteArrayView input, QByteArray &output,
+                                         const Budget &budget);
+    static StopReason beautifyJavaScriptParallel(QByteArrayView input, QByteArray &output,
+                                                 const Budget &budget);
+    static StopReason formatJson(QByteArrayView input, QByteArray &output, const Budget &budget);
+
   private:
-    static QString unpackDeanEdwards(const QString &input);
-    static QString toBase(int num, int base);
+    struct PackedScript {
+        QString payload;
+        int base = 0;
+        int count = 0;
+        QString keywords;
+    };
+
+    static bool parsePackedScript(QStringView source, PackedScript &script);
+    static bool unpackDeanEdwards(QStringView input, QString &output, Deadline &deadline);
 };
\ No newline at end of file
@@ -17,6 +17,7 @@ class TestCurlBuilder : public QObject {
     void testComplexCommand();
     void testEscaping();
     void testCommonHeaderValues();
+    void testCommandUpdates();
 };
 
 void TestCurlBuilder::testBasicCommand() {
@@ -191,5 +192,53 @@ void TestCurlBuilder::testCommonHeaderValues() {
     QVERIFY(unknown.isEmpty());
 }
 
+void TestCurlBuilder::testCommandUpdates() {
+    CurlBuilder::Command command;
+    QString mirror;  // what a view patched with each edit shows
+    auto update = [&](const CurlBuilder::CurlOptions &options) {
+        const CurlBuilder::Command::Edit edit = command.update(options);
+        mirror.replace(edit.position, edit.removed, edit.inserted);
+        return edit;
+    };
+
+    CurlBuilder::CurlOptions options;
+    options.url = "https://example.com";
+    options.body = QString("{\"key\": \"value\"}\n").repeated(10000);
+    CurlBuilder::Command::Edit edit = update(options);
+    QCOMPARE(edit.position, qsizetype(0));
+    QCOMPARE(mirror, CurlBuilder::buildCurlCommand(options));
+
+    // A keystroke in the body replaces the keystroke, escaped, and nothing else
+    options.body.insert(5000, '"');
+    edit = update(options);
+    QCOMPARE(edit.removed, qsizetype(0));
+    QCOMPARE(edit.inserted, QString("\\\""));
+    QCOMPARE(mirror, CurlBuilder::buildCurlCommand(options));
+
+    options.method = CurlBuilder::POST;
+    options.headers.append(QPair<QString, QString>("Content-Type", "application/json"));
+    edit = update(options);
+    QVERIFY(edit.inserted.size() < 100);
+    QCOMPARE(mirror, CurlBuilder::buildCurlCommand(options));
+
+    options.headers.append(QPair<QString, QString>("Accept", "*/*"));
+    options.insecure = true;
+    update(options);
+    options.headers.removeFirst();
+    options.url.clear();
+    update(options);
+    QCOMPARE(mirror, CurlBuilder::buildCurlCommand(options));
+
+    // Nothing changed, nothing to patch
+    edit = update(options);
+    QCOMPARE(edit.removed, qsizetype(0));
+    QVERIFY(edit.inserted.isEmpty());
+
+    options.body.clear();
+    update(options);
+    QCOMPARE(mirror, CurlBuilder::buildCurlCommand(options));
+    QCOMPARE(command.text(), mirror);
+}
+
 QTEST_MAIN(TestCurlBuilder)
 #include "test_curl_builder.moc"
\ No newline at end of file
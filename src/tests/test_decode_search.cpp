@@ -0,0 +1,161 @@
+#include <QtTest/QtTest>
+
+#include "../core/decode_search.h"
+#include "../core/task_control.h"
+
+class TestDecodeSearch : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testNestedLayers();
+    void testSingleLayer();
+    void testPlainTextHasNoChains();
+    void testGarbageIsPruned();
+    void testKnownBinaryEndsChain();
+    void testDepthBudget();
+    void testCacheIsReused();
+    void testCacheLimit();
+    void testCancellation();
+    void testDescribe();
+};
+
+namespace {
+
+const QByteArray kPlain = "Meet me behind the old library at seven tonight and bring the documents";
+
+QByteArray rot13(const QByteArray &text) {
+    QByteArray rotated;
+    Decoder::decodeROT(text, 13, rotated);
+    return rotated;
+}
+
+}  // namespace
+
+void TestDecodeSearch::testNestedLayers() {
+    // ROT13, then hex, then base64: the chain is found in reverse
+    const QByteArray payload = rot13(kPlain).toHex().toBase64();
+
+    DecodeSearch search;
+    const QList<DecodeSearch::Chain> chains = search.search(payload);
+    QVERIFY(!chains.isEmpty());
+
+    const DecodeSearch::Chain &best = chains.first();
+    QCOMPARE(best.output, kPlain);
+    QCOMPARE(best.steps.size(), qsizetype(3));
+    QCOMPARE(best.steps[0].algorithm, Decoder::Base64);
+    QCOMPARE(best.steps[1].algorithm, Decoder::Hex);
+    QCOMPARE(best.steps[2].algorithm, Decoder::ROT);
+    QCOMPARE(best.steps[2].rotShift, 13);
+}
+
+void TestDecodeSearch::testSingleLayer() {
+    DecodeSearch search;
+    const QList<DecodeSearch::Chain> chains = search.search(kPlain.toBase64());
+    QVERIFY(!chains.isEmpty());
+    QCOMPARE(chains.first().output, kPlain);
+    QCOMPARE(chains.first().steps.size(), qsizetype(1));
+}
+
+void TestDecodeSearch::testPlainTextHasNoChains() {
+    DecodeSearch search;
+    QVERIFY(search.search(kPlain).isEmpty());
+}
+
+void TestDecodeSearch::testGarbageIsPruned() {
+    QByteArray noise;
+    quint32 seed = 12345;
+    for (int i = 0; i < 512; i++) {
+        seed = seed * 1103515245 + 12345;
+        noise.append(char(seed >> 24));
+    }
+    noise[0] = 0;  // not a known container
+
+    DecodeSearch search;
+    QVERIFY(search.search(noise.toBase64()).isEmpty());
+}
+
+void TestDecodeSearch::testKnownBinaryEndsChain() {
+    const QByteArray gzip = QByteArray("\x1f\x8b\x08\x00", 4) + QByteArray(64, '\x7f');
+
+    DecodeSearch search;
+    const QList<DecodeSearch::Chain> chains = search.search(gzip.toHex());
+    QVERIFY(!chains.isEmpty());
+    QCOMPARE(chains.first().output, gzip);
+}
+
+void TestDecodeSearch::testDepthBudget() {
+    const QByteArray payload = kPlain.toHex().toBase64();
+
+    DecodeSearch::Budget budget;
+    budget.maxDepth = 1;
+    DecodeSearch search;
+    for (const DecodeSearch::Chain &chain : search.search(payload, budget)) {
+        QCOMPARE(chain.steps.size(), qsizetype(1));
+        QVERIFY(chain.output != kPlain);
+    }
+
+    budget.maxDepth = 2;
+    const QList<DecodeSearch::Chain> chains = search.search(payload, budget);
+    QVERIFY(!chains.isEmpty());
+    QCOMPARE(chains.first().output, kPlain);
+}
+
+void TestDecodeSearch::testCacheIsReused() {
+    const QByteArray inner = kPlain.toHex();
+    const QByteArray payload = inner.toBase64();
+
+    DecodeSearch search;
+    search.search(payload);
+    const qsizetype cached = search.cacheSize();
+    QVERIFY(cached >= 3);
+
+    // Same input again, then an input whose decoding lands on an already cached layer
+    search.search(payload);
+    QCOMPARE(search.cacheSize(), cached);
+    search.search(inner);
+    QCOMPARE(search.cacheSize(), cached);
+
+    search.clearCache();
+    QCOMPARE(search.cacheSize(), qsizetype(0));
+}
+
+void TestDecodeSearch::testCacheLimit() {
+    const QByteArray payload = rot13(kPlain).toHex().toBase64();
+
+    DecodeSearch search;
+    search.search(payload);
+    const qsizetype unlimited = search.cacheSize();
+    search.clearCache();
+
+    // The cache is dropped along the way, but the search still finds everything it did before
+    DecodeSearch::Budget budget;
+    budget.maxCacheBytes = 1;
+    const QList<DecodeSearch::Chain> chains = search.search(payload, budget);
+    QVERIFY(!chains.isEmpty());
+    QCOMPARE(chains.first().output, kPlain);
+    QVERIFY(search.cacheSize() < unlimited);
+}
+
+void TestDecodeSearch::testCancellation() {
+    const QByteArray payload = kPlain.toHex().toBase64();
+
+    // Cancelled before the first expansion: nothing is decoded or cached
+    TaskControl control;
+    control.cancel();
+    DecodeSearch::Budget budget;
+    budget.control = &control;
+    DecodeSearch search;
+    QVERIFY(search.search(payload, budget).isEmpty());
+    QCOMPARE(search.cacheSize(), qsizetype(0));
+    QVERIFY(!search.search(payload).isEmpty());
+}
+
+void TestDecodeSearch::testDescribe() {
+    const QList<DecodeSearch::Step> steps = {
+        {Decoder::Base64, 0}, {Decoder::ROT, 13}, {Decoder::ROT47, 0}};
+    QCOMPARE(DecodeSearch::describe(steps), QString("Base64 → ROT13 → ROT47"));
+    QCOMPARE(DecodeSearch::describe({}), QString());
+}
+
+QTEST_MAIN(TestDecodeSearch)
+#include "test_decode_search.moc"
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <QtTest/QtTest>
 
 #include "../core/decoder.h"
+#include "../core/task_control.h"
 
 class TestDecoder : public QObject {
     Q_OBJECT
@@ -12,7 +13,24 @@ class TestDecoder : public QObject {
     void testHexDecode();
     void testROTDecode_data();
     void testROTDecode();
+    void testROT47Decode();
+    void testRankROTShifts();
+    void testDetectEncoding_data();
+    void testDetectEncoding();
+    void testDetectPlainText();
     void testInvalidInput();
+    void testBase64ErrorPosition();
+    void testHexErrorPosition();
+    void testStreamMatchesOneShot_data();
+    void testStreamMatchesOneShot();
+    void testStreamErrors();
+    void testLiveMatchesDecode_data();
+    void testLiveMatchesDecode();
+    void testLiveEditIsLocal();
+    void testParallelMatchesSequential();
+    void testParallelCancellation();
+    void testBatchDecode();
+    void testByteApi();
 };
 
 void TestDecoder::testBase64Decode_data() {
@@ -24,6 +42,10 @@ void TestDecoder::testBase64Decode_data() {
     QTest::newRow("empty") << "" << "";
     QTest::newRow("padding") << "SGVsbG8gV29ybGQ=" << "Hello World";
     QTest::newRow("multiline") << "VGhpcyBpcyBhIHRlc3Q=" << "This is a test";
+    QTest::newRow("unpadded") << "SGVsbG8gV29ybGQ" << "Hello World";
+    QTest::newRow("url_safe") << "Pz8_Pj4-" << "?\?\?>>>";
+    QTest::newRow("mime_wrapped") << "VGhpcyBpcyBh\r\nIHRlc3Q=\r\n" << "This is a test";
+    QTest::newRow("long") << QString("QUJD").repeated(64) << QString("ABC").repeated(64);
 }
 
 void TestDecoder::testBase64Decode() {
@@ -43,6 +65,10 @@ void TestDecoder::testHexDecode_data() {
     QTest::newRow("uppercase") << "48656C6C6F" << "Hello";
     QTest::newRow("mixed_case") << "48656c6C6f" << "Hello";
     QTest::newRow("with_spaces") << "48 65 6c 6c 6f" << "Hello";
+    QTest::newRow("colons") << "48:65:6c:6c:6f" << "Hello";
+    QTest::newRow("0x_prefixes") << "0x48, 0x65, 0x6c, 0x6c, 0x6f" << "Hello";
+    QTest::newRow("x_escapes") << "\\x48\\x65\\x6c\\x6c\\x6f" << "Hello";
+    QTest::newRow("long") << QString("414243").repeated(64) << QString("ABC").repeated(64);
     QTest::newRow("empty") << "" << "";
 }
 
@@ -67,6 +93,11 @@ void TestDecoder::testROTDecode_data() {
     QTest::newRow("mixed_case") << "UrYyB" << 13 << "HeLlO";
     QTest::newRow("with_numbers") << "uryyb123" << 13 << "hello123";
     QTest::newRow("with_spaces") << "uryyb jbeyq" << 13 << "hello world";
+    QTest::newRow("negative_shift") << "gdkkn" << -1 << "hello";
+    QTest::newRow("non_ascii") << QString::fromUtf8("ürÿyb ✓") << 13
+                               << QString::fromUtf8("üeÿlo ✓");
+    QTest::newRow("long") << QString("Uryyb, Jbeyq! ").repeated(40) << 13
+                          << QString("Hello, World! ").repeated(40);
     QTest::newRow("empty") << "" << 13 << "";
 }
 
@@ -79,6 +110,78 @@ void TestDecoder::testROTDecode() {
     QCOMPARE(result, expected);
 }
 
+void TestDecoder::testROT47Decode() {
+    QCOMPARE(Decoder::decodeROT47("w6==@ (@C=5P"), QString("Hello World!"));
+    QCOMPARE(Decoder::decode("w6==@", Decoder::ROT47), QString("Hello"));
+
+    const QString printable = QString("!\"#$%&'()*+,-./0123456789:;<=>?@ABC~ ").repeated(10);
+    QCOMPARE(Decoder::decodeROT47(Decoder::decodeROT47(printable)), printable);
+
+    QByteArray output;
+    QCOMPARE(Decoder::decodeROT47(QByteArray("w6==@\xff"), output), Decoder::Ok);
+    QCOMPARE(output, QByteArray("Hello\xff"));
+}
+
+void TestDecoder::testRankROTShifts() {
+    const QString plain = "Meet me behind the library at seven";
+    for (int shift : {1, 3, 13, 25}) {
+        const QList<Decoder::RotCandidate> ranked =
+            Decoder::rankROTShifts(Decoder::decodeROT(plain, 26 - shift));
+        QCOMPARE(ranked.size(), qsizetype(25));
+        QCOMPARE(ranked.first().shift, shift);
+        QVERIFY(ranked.first().score > ranked.last().score);
+    }
+
+    const QList<Decoder::RotCandidate> bytes =
+        Decoder::rankROTShifts(QByteArrayView("Gur synt vf va gur onpxhc"));
+    QCOMPARE(bytes.first().shift, 13);
+}
+
+void TestDecoder::testDetectEncoding_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<int>("algorithm");
+    QTest::addColumn<int>("rotShift");
+
+    QTest::newRow("base64") << "SGVsbG8gV29ybGQsIHRoaXMgaXMgYSB0ZXN0IQ==" << int(Decoder::Base64)
+                            << 0;
+    QTest::newRow("base64_unpadded") << "dGhlIHF1aWNrIGJyb3duIGZveA" << int(Decoder::Base64) << 0;
+    QTest::newRow("hex") << "48656c6c6f2c20776f726c6421" << int(Decoder::Hex) << 0;
+    QTest::newRow("hex_escapes") << "\\x48\\x65\\x6c\\x6c\\x6f" << int(Decoder::Hex) << 0;
+    QTest::newRow("rot13") << "Zrrg zr oruvaq gur byq yvoenel ng frira gbavtug" << int(Decoder::ROT)
+                           << 13;
+    QTest::newRow("rot3") << "Phhw ph dw wkh xvxdo sodfh diwhu gdun" << int(Decoder::ROT) << 3;
+    QTest::newRow("rot47") << "|66E >6 369:?5 E96 @=5 =:3C2CJ 2E D6G6? E@?:89E"
+                           << int(Decoder::ROT47) << 0;
+    QTest::newRow("base64_utf8") << "0J/RgNC40LLQtdGCLCDQutCw0Log0LTQtdC70LAg0YMg0YLQtdCx0Y8g0YHQtdCz"
+                                    "0L7QtNC90Y8g0LLQtdGH0LXRgNC+0Lw/"
+                                 << int(Decoder::Base64) << 0;
+    const QString largeBase64 = QString("QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVph").repeated(1 << 17);
+    QTest::newRow("large_base64") << largeBase64 << int(Decoder::Base64) << 0;
+}
+
+void TestDecoder::testDetectEncoding() {
+    QFETCH(QString, input);
+    QFETCH(int, algorithm);
+    QFETCH(int, rotShift);
+
+    const QList<Decoder::Detection> detections = Decoder::detectEncoding(input);
+    QVERIFY(!detections.isEmpty());
+    QCOMPARE(int(detections.first().algorithm), algorithm);
+    QCOMPARE(detections.first().rotShift, rotShift);
+    QVERIFY(detections.first().confidence > 0.5);
+
+    const QByteArray bytes = input.toUtf8();
+    const QList<Decoder::Detection> byteDetections = Decoder::detectEncoding(QByteArrayView(bytes));
+    QCOMPARE(byteDetections.first().algorithm, detections.first().algorithm);
+}
+
+void TestDecoder::testDetectPlainText() {
+    const QString plain = "The quick brown fox jumps over the lazy dog";
+    QVERIFY(Decoder::detectEncoding(plain).isEmpty());
+    QVERIFY(Decoder::detectEncoding(QString("abc")).isEmpty());
+    QVERIFY(Decoder::detectEncoding(QString()).isEmpty());
+}
+
 void TestDecoder::testInvalidInput() {
     // Test invalid Base64
     QString result = Decoder::decode("invalid base64!", Decoder::Base64);
@@ -93,5 +196,331 @@ void TestDecoder::testInvalidInput() {
     QCOMPARE(result, "abc");  // No shift should return original
 }
 
+void TestDecoder::testBase64ErrorPosition() {
+    QCOMPARE(Decoder::decodeBase64("aGVs*bG8="),
+             QString("Error: Invalid base64 input at position 4"));
+    QCOMPARE(Decoder::decodeBase64("aGVsbG8=x"),
+             QString("Error: Invalid base64 input at position 8"));
+    QCOMPARE(Decoder::decodeBase64("aGVsb"), QString("Error: Invalid base64 input at position 4"));
+
+    // Errors past the vectorized prefix are still reported at their exact index
+    QString longInput = QString("QUJD").repeated(64) + QChar(0x00E9) + "QUJD";
+    QCOMPARE(Decoder::decodeBase64(longInput),
+             QString("Error: Invalid base64 input at position 256"));
+}
+
+void TestDecoder::testHexErrorPosition() {
+    QCOMPARE(Decoder::decodeHex("48 65 zz"), QString("Error: Invalid hex input at position 6"));
+    QCOMPARE(Decoder::decodeHex("4 8"), QString("Error: Invalid hex input at position 1"));
+    QCOMPARE(Decoder::decodeHex(QString("41").repeated(40) + "4g"),
+             QString("Error: Invalid hex input at position 81"));
+    QCOMPARE(Decoder::decodeHex("48 6"), QString("Error: Invalid hex input (odd length)"));
+}
+
+void TestDecoder::testStreamMatchesOneShot_data() {
+    QTest::addColumn<int>("algorithm");
+    QTest::addColumn<QString>("input");
+
+    QTest::newRow("base64") << int(Decoder::Base64) << "SGVsbG8gV29ybGQ=";
+    QTest::newRow("base64_unpadded") << int(Decoder::Base64) << "SGVsbG8gV29ybGQ";
+    QTest::newRow("base64_mime") << int(Decoder::Base64) << "VGhpcyBpcyBh\r\nIHRlc3Q=\r\n";
+    QTest::newRow("base64_long") << int(Decoder::Base64) << QString("QUJD").repeated(100);
+    QTest::newRow("hex") << int(Decoder::Hex) << "48 65 6c 6c 6f";
+    QTest::newRow("hex_prefixes") << int(Decoder::Hex) << "0x48 0x65 \\x6c\\x6c 6f";
+    QTest::newRow("hex_long") << int(Decoder::Hex) << QString("414243").repeated(100);
+    QTest::newRow("rot") << int(Decoder::ROT) << "Uryyb, Jbeyq! 123";
+}
+
+void TestDecoder::testStreamMatchesOneShot() {
+    QFETCH(int, algorithm);
+    QFETCH(QString, input);
+
+    const auto algo = static_cast<Decoder::Algorithm>(algorithm);
+    const QString expected = Decoder::decode(input, algo);
+    const QByteArray bytes = input.toUtf8();
+
+    // Chunk sizes that split quads, nibbles and "0x"/"\\x" prefixes at every offset
+    for (qsizetype chunkSize : {1, 2, 3, 5, 7, 64, 1024}) {
+        Decoder::Stream stream(algo);
+        QByteArray output;
+        for (qsizetype i = 0; i < bytes.size(); i += chunkSize) {
+            QVERIFY(stream.push(QByteArrayView(bytes).mid(i, chunkSize)));
+            output += stream.takeOutput();
+        }
+        QVERIFY(stream.finish());
+        output += stream.takeOutput();
+        QCOMPARE(QString::fromUtf8(output), expected);
+    }
+}
+
+void TestDecoder::testStreamErrors() {
+    Decoder::Stream base64(Decoder::Base64);
+    QVERIFY(base64.push("aGVs"));
+    QVERIFY(!base64.push("b*G8="));
+    QCOMPARE(base64.errorPosition(), qsizetype(5));
+    QCOMPARE(base64.errorString(), Decoder::decodeBase64("aGVsb*G8="));
+
+    Decoder::Stream hex(Decoder::Hex);
+    QVERIFY(hex.push("48 6"));
+    QVERIFY(hex.push("5 6"));
+    QVERIFY(!hex.finish());
+    QCOMPARE(hex.errorString(), Decoder::decodeHex("48 65 6"));
+}
+
+void TestDecoder::testLiveMatchesDecode_data() {
+    QTest::addColumn<int>("algorithm");
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("alphabet");
+
+    // Long enough to span several checkpoints. The "errors" rows mostly type characters that
+    // break the encoding, so their edits also move in and out of the error state.
+    const QString mime = QString("QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVph\r\n").repeated(300);
+    QTest::newRow("base64") << int(Decoder::Base64) << QString("QUJD").repeated(2500)
+                            << "QUJDabc+/\n ";
+    QTest::newRow("base64_mime") << int(Decoder::Base64) << mime << "QUJDab-_\r\n";
+    QTest::newRow("base64_errors") << int(Decoder::Base64) << QString("QUJD").repeated(2500)
+                                   << "QUJD=*";
+    QTest::newRow("hex") << int(Decoder::Hex) << QString("0x41 \\x42 43").repeated(800)
+                         << "0123456789abcdef :";
+    QTest::newRow("hex_errors") << int(Decoder::Hex) << QString("0x41 \\x42 43").repeated(800)
+                                << "0x\\g4";
+    QTest::newRow("rot") << int(Decoder::ROT) << QString("Uryyb, Jbeyq! ").repeated(700)
+                         << QString("abcXYZ !\n") + QChar(0xE9) + QChar(0x4E2D);
+}
+
+void TestDecoder::testLiveMatchesDecode() {
+    QFETCH(int, algorithm);
+    QFETCH(QString, text);
+    QFETCH(QString, alphabet);
+
+    const auto algo = static_cast<Decoder::Algorithm>(algorithm);
+    // Live leaves a unit still being typed at the end pending instead of failing on it
+    auto expectedFor = [algo](QString input) {
+        QByteArray bytes;
+        qsizetype position = -1;
+        Decoder::Status status = Decoder::decode(input.toUtf8(), algo, bytes, 13, &position);
+        while (status == Decoder::IncompleteInput ||
+               (status == Decoder::InvalidInput && input.endsWith('\\') &&
+                position == input.size() - 1)) {
+            input.chop(1);
+            status = Decoder::decode(input.toUtf8(), algo, bytes, 13, &position);
+        }
+        return status == Decoder::Ok ? bytes : Decoder::decode(input, algo).toUtf8();
+    };
+
+    Decoder::Live live(algo);
+    Decoder::Live::Edit edit = live.setText(text);
+    QByteArray output = edit.inserted;
+    QCOMPARE(output, expectedFor(text));
+
+    // Splice every edit into a mirror of the output, as a view showing it would
+    quint32 seed = 7;
+    auto random = [&seed] {
+        seed = seed * 1103515245 + 12345;
+        return seed >> 16;
+    };
+    for (int i = 0; i < 400; i++) {
+        const qsizetype position = random() % (text.size() + 1);
+        const qsizetype removed = qMin<qsizetype>(random() % 4, text.size() - position);
+        QString added;
+        for (int n = random() % 6; n > 0; n--) {
+            added += alphabet.at(random() % alphabet.size());
+        }
+        text.replace(position, removed, added);
+
+        edit = live.edit(position, removed, added);
+        if (edit.resync) {
+            // Only removing the last error takes the whole text
+            QVERIFY(output.startsWith("Error:"));
+            edit = live.setText(text);
+        }
+        QVERIFY(edit.position >= 0 && edit.position + edit.removed <= output.size());
+        output.replace(edit.position, edit.removed, edit.inserted);
+        QCOMPARE(live.text(), text);
+        QCOMPARE(output, expectedFor(text));
+        QCOMPARE(live.hasError(), output.startsWith("Error:"));
+    }
+}
+
+void TestDecoder::testLiveEditIsLocal() {
+    const QString text = QString("QUJD").repeated(100000);
+    Decoder::Live live(Decoder::Base64);
+    live.setText(text);
+
+    // Whole quads in the middle re-decode just themselves and the quads either side
+    Decoder::Live::Edit edit = live.edit(200000, 0, "REVG");
+    QCOMPARE(edit.position, qsizetype(149997));
+    QCOMPARE(edit.removed, qsizetype(6));
+    QCOMPARE(edit.inserted, QByteArray("ABCDEFABC"));
+
+    edit = live.edit(200000, 4, QString());
+    QCOMPARE(edit.position, qsizetype(149997));
+    QCOMPARE(edit.removed, qsizetype(9));
+    QCOMPARE(edit.inserted, QByteArray("ABCABC"));
+
+    // Typing at the end touches only the last quads, and a lone sextet waits for the next one
+    edit = live.edit(400000, 0, "R");
+    QCOMPARE(edit.position, qsizetype(299997));
+    QCOMPARE(edit.removed, qsizetype(3));
+    QCOMPARE(edit.inserted, QByteArray("ABC"));
+    QVERIFY(!live.hasError());
+    edit = live.edit(400001, 0, "E");
+    QCOMPARE(edit.position, qsizetype(300000));
+    QCOMPARE(edit.removed, qsizetype(0));
+    QCOMPARE(edit.inserted, QByteArray("D"));
+
+    // Invalid input replaces the output with the error. Edits after it leave the output alone,
+    // edits before it only move the error, and removing it asks for the whole text again.
+    edit = live.edit(10, 0, "*");
+    QVERIFY(live.hasError());
+    QCOMPARE(edit.inserted, Decoder::decodeBase64(live.text()).toUtf8());
+    edit = live.edit(300000, 0, "QUJD");
+    QVERIFY(!edit.resync);
+    QCOMPARE(edit.removed, qsizetype(0));
+    QVERIFY(edit.inserted.isEmpty());
+    edit = live.edit(0, 4, QString());
+    QCOMPARE(edit.inserted, QByteArray("Error: Invalid base64 input at position 6"));
+    edit = live.edit(6, 1, QString());
+    QVERIFY(edit.resync);
+    edit = live.setText(live.text());
+    QVERIFY(!live.hasError());
+    QCOMPARE(edit.inserted.size(), qsizetype(300001));
+
+    // ROT maps each character to its own UTF-8 bytes
+    Decoder::Live rot(Decoder::ROT);
+    rot.setText(QString("Uryyb, ") + QChar(0xE9) + " Jbeyq!");
+    edit = rot.edit(10, 1, "o");
+    QCOMPARE(edit.position, qsizetype(10));
+    QCOMPARE(edit.removed, qsizetype(3));
+    QCOMPARE(edit.inserted, QByteArray("Wbr"));
+}
+
+void TestDecoder::testParallelMatchesSequential() {
+    const qsizetype lines = Decoder::ParallelThreshold / 64 + 1;
+
+    // MIME-style lines put whitespace at arbitrary offsets relative to the segment cuts
+    const QString base64 = QString("QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVph\r\n").repeated(lines);
+    QCOMPARE(Decoder::decodeParallel(base64, Decoder::Base64),
+             Decoder::decode(base64, Decoder::Base64));
+
+    const QString hex =
+        QString("0x41 0x42 0x43 \\x44\\x45 464748494a4b4c4d4e4f50\n").repeated(lines);
+    QCOMPARE(Decoder::decodeParallel(hex, Decoder::Hex), Decoder::decode(hex, Decoder::Hex));
+
+    const QString rot = QString("Gur dhvpx oebja sbk whzcf bire gur ynml qbt.\n").repeated(lines);
+    QCOMPARE(Decoder::decodeParallel(rot, Decoder::ROT, 13),
+             Decoder::decode(rot, Decoder::ROT, 13));
+
+    // A run without symbols that is longer than a segment, here inside a quad, leaves the
+    // segments that start in it empty
+    const QString gap = QString("QUJD").repeated(lines) + "QU" + QString(lines * 64, ' ') + "JD" +
+                        QString("RUZH").repeated(lines);
+    QCOMPARE(Decoder::decodeParallel(gap, Decoder::Base64), Decoder::decode(gap, Decoder::Base64));
+
+    // Errors fall back to the sequential decoder and report the same position
+    const QString invalid = QString("QUJD").repeated(lines * 16) + "QU*D";
+    QCOMPARE(Decoder::decodeParallel(invalid, Decoder::Base64),
+             Decoder::decode(invalid, Decoder::Base64));
+    QByteArray bytes;
+    qsizetype position = -1;
+    QCOMPARE(Decoder::decodeParallel(invalid, Decoder::Base64, bytes, 13, nullptr, &position),
+             Decoder::InvalidInput);
+    QCOMPARE(position, invalid.size() - 2);
+
+    // The byte form hands back decoded bytes that are not UTF-8 unchanged
+    const QString binary = QString("/wCA/wCA\n").repeated(lines * 8);
+    QByteArray expected;
+    QCOMPARE(Decoder::decode(binary.toLatin1(), Decoder::Base64, expected), Decoder::Ok);
+    QCOMPARE(Decoder::decodeParallel(binary, Decoder::Base64, bytes), Decoder::Ok);
+    QCOMPARE(bytes, expected);
+    QCOMPARE(bytes.left(3), QByteArray("\xff\x00\x80", 3));
+}
+
+void TestDecoder::testParallelCancellation() {
+    const qsizetype lines = Decoder::ParallelThreshold / 32 + 1;
+    const QString base64 = QString("QUJDREVGR0hJSktMTU5PUFFSU1RVVldYWVph\r\n").repeated(lines);
+    const QString rot = QString("Gur dhvpx oebja sbk whzcf bire gur ynml qbt.\n").repeated(lines);
+
+    // Segments report from several workers at once; the callback still sees a rising sequence
+    QList<int> percents;
+    TaskControl control([&percents](int percent) { percents.append(percent); });
+    QCOMPARE(Decoder::decodeParallel(base64, Decoder::Base64, 13, &control),
+             Decoder::decode(base64, Decoder::Base64));
+    QVERIFY(!percents.isEmpty());
+    QCOMPARE(percents.last(), 100);
+    QVERIFY(std::adjacent_find(percents.begin(), percents.end(), std::greater_equal<int>()) ==
+            percents.end());
+
+    TaskControl cancelled;
+    cancelled.cancel();
+    QVERIFY(Decoder::decodeParallel(base64, Decoder::Base64, 13, &cancelled).isEmpty());
+    QVERIFY(Decoder::decodeParallel(rot, Decoder::ROT, 13, &cancelled).isEmpty());
+
+    // Short inputs are decoded on the calling thread in one go
+    QCOMPARE(Decoder::decodeParallel("aGVsbG8=", Decoder::Base64, 13, &cancelled),
+             QString("hello"));
+}
+
+void TestDecoder::testBatchDecode() {
+    const QList<QByteArray> tokens = {"aGVsbG8=", "d29ybGQ", "", "aGV*sbG8=", "aGVsb",
+                                      QByteArray("QUJD").repeated(300)};
+    QList<QByteArrayView> views;
+    for (const QByteArray &token : tokens) {
+        views.append(token);
+    }
+
+    const Decoder::BatchResult batch = Decoder::decodeBatch(views, Decoder::Base64);
+    QCOMPARE(batch.items.size(), tokens.size());
+    QCOMPARE(batch.output(0), QByteArrayView("hello"));
+    QCOMPARE(batch.output(1), QByteArrayView("world"));
+    QCOMPARE(batch.items[2].status, Decoder::Ok);
+    QCOMPARE(batch.output(2).size(), qsizetype(0));
+    QCOMPARE(batch.items[3].status, Decoder::InvalidInput);
+    QCOMPARE(batch.items[3].errorPosition, qsizetype(3));
+    QCOMPARE(batch.items[4].status, Decoder::IncompleteInput);
+    QCOMPARE(batch.output(5).toByteArray(), QByteArray("ABC").repeated(300));
+
+    // Enough items to spread across several workers; each must match the one-shot decoder
+    QList<QByteArray> hexTokens;
+    for (int i = 0; i < 5000; i++) {
+        hexTokens.append(QByteArray::number(i * 7919, 16).rightJustified(8, '0'));
+    }
+    QList<QByteArrayView> hexViews(hexTokens.begin(), hexTokens.end());
+    const Decoder::BatchResult hexBatch = Decoder::decodeBatch(hexViews, Decoder::Hex);
+    for (int i = 0; i < hexTokens.size(); i++) {
+        QCOMPARE(QString::fromUtf8(hexBatch.output(i).toByteArray()),
+                 Decoder::decodeHex(QString::fromLatin1(hexTokens[i])));
+    }
+}
+
+void TestDecoder::testByteApi() {
+    // Every byte value survives, which the QString API cannot promise for binary payloads
+    QByteArray binary;
+    for (int i = 0; i < 256; i++) {
+        binary.append(char(i));
+    }
+
+    QByteArray output;
+    QCOMPARE(Decoder::decodeBase64(binary.toBase64(), output), Decoder::Ok);
+    QCOMPARE(output, binary);
+    QCOMPARE(Decoder::decode(binary.toHex(), Decoder::Hex, output), Decoder::Ok);
+    QCOMPARE(output, binary);
+
+    // A smaller result reuses the buffer instead of allocating
+    const char *buffer = output.constData();
+    QCOMPARE(Decoder::decodeHex("48 65 6c 6c 6f", output), Decoder::Ok);
+    QCOMPARE(output, QByteArray("Hello"));
+    QCOMPARE(output.constData(), buffer);
+
+    QCOMPARE(Decoder::decodeROT("Uryyb", 13, output), Decoder::Ok);
+    QCOMPARE(output, QByteArray("Hello"));
+
+    qsizetype position = -1;
+    QCOMPARE(Decoder::decodeBase64("aGVs*bG8=", output, &position), Decoder::InvalidInput);
+    QCOMPARE(position, qsizetype(4));
+    QVERIFY(output.isEmpty());
+    QCOMPARE(Decoder::decodeHex("48 6", output), Decoder::IncompleteInput);
+}
+
 QTEST_MAIN(TestDecoder)
 #include "test_decoder.moc"
\ No newline at end of file
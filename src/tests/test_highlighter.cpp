@@ -0,0 +1,179 @@
+#include <QtTest/QtTest>
+
+#include "../core/highlighter.h"
+
+class TestHighlighter : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testSpans_data();
+    void testSpans();
+    void testResume();
+    void testLineByLine();
+    void testDeepNesting();
+};
+
+namespace {
+
+const char *formatName(Highlighter::Format format) {
+    switch (format) {
+        case Highlighter::Keyword:
+            return "Keyword";
+        case Highlighter::Number:
+            return "Number";
+        case Highlighter::String:
+            return "String";
+        case Highlighter::Property:
+            return "Property";
+        case Highlighter::Comment:
+            return "Comment";
+        case Highlighter::Regex:
+            return "Regex";
+        default:
+            return "Plain";
+    }
+}
+
+// "Format:text" for each span, adjacent spans of one format joined
+QString describe(const QString &text, const QList<Highlighter::Span> &spans) {
+    QStringList parts;
+    qsizetype end = -1;
+    Highlighter::Format last = Highlighter::Plain;
+    for (const Highlighter::Span &span : spans) {
+        const QString piece = text.mid(span.start, span.length);
+        if (span.start == end && span.format == last) {
+            parts.last() += piece;
+        } else {
+            parts.append(QString(formatName(span.format)) + ":" + piece);
+        }
+        end = span.start + span.length;
+        last = span.format;
+    }
+    return parts.join(' ');
+}
+
+// The format of every character, from spans that must be in order and not overlap
+QList<int> formatsOf(qsizetype length, const QList<Highlighter::Span> &spans) {
+    QList<int> formats(length, Highlighter::Plain);
+    qsizetype previousEnd = 0;
+    for (const Highlighter::Span &span : spans) {
+        if (span.start < previousEnd || span.start + span.length > length) {
+            return {};
+        }
+        for (qsizetype i = span.start; i < span.start + span.length; i++) {
+            formats[i] = span.format;
+        }
+        previousEnd = span.start + span.length;
+    }
+    return formats;
+}
+
+const QString kScript = "/* header\n * comment */\n"
+                        "const re = /[/]x\\/y/gi, half = total / 2 / count;\n"
+                        "let s = 'it\\'s' + \"line\\\ncontinued\";\n"
+                        "const t = `a ${b + `c ${d} e`} f\nsecond ${ {k: 1}.k } line`;\n"
+                        "x.default = this.delete(1e-3, 0x1F, .5); // done\n"
+                        "if (a) /re/.test(b); else c = a++ / 2;\n";
+
+}  // namespace
+
+void TestHighlighter::testSpans_data() {
+    QTest::addColumn<int>("language");
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    const int js = Highlighter::JavaScript;
+    const int json = Highlighter::Json;
+    QTest::newRow("keywords") << js << "var x = 1; // hi" << "Keyword:var Number:1 Comment:// hi";
+    QTest::newRow("division") << js << "a = b / c / d" << "";
+    QTest::newRow("regex") << js << "r = /x[/]y/g.test(s)" << "Regex:/x[/]y/g";
+    QTest::newRow("regex_after_keyword") << js << "return /a/" << "Keyword:return Regex:/a/";
+    QTest::newRow("division_after_value") << js << "this / 2 / x" << "Keyword:this Number:2";
+    QTest::newRow("member_names") << js << "x.default = y?.new" << "";
+    QTest::newRow("strings") << js << "'it\\'s' + \"a\"" << "String:'it\\'s' String:\"a\"";
+    QTest::newRow("template") << js << "`a${b + `c${d}`}e` / 2"
+                              << "String:`a${ String:`c${ String:}`}e` Number:2";
+    QTest::newRow("template_braces") << js << "`${ {a: 1} }`" << "String:`${ Number:1 String:}`";
+    QTest::newRow("block_comment") << js << "/* a\n b */ return /re/"
+                                   << "Comment:/* a\n b */ Keyword:return Regex:/re/";
+    QTest::newRow("unterminated_string") << js << "'abc\nvar" << "String:'abc Keyword:var";
+    QTest::newRow("numbers") << js << "0x1F + 1e-3 + .5" << "Number:0x1F Number:1e-3 Number:.5";
+    QTest::newRow("json") << json << "{\"key\": \"value\", \"n\": -1.5e+3, \"ok\": true}"
+                          << "Property:\"key\" String:\"value\" Property:\"n\" Number:1.5e+3 "
+                             "Property:\"ok\" Keyword:true";
+    QTest::newRow("json_no_regex") << json << "{a: 1} / 2 /" << "Number:1 Number:2";
+    QTest::newRow("json5_comment") << json << "{a: null} // c" << "Keyword:null Comment:// c";
+}
+
+void TestHighlighter::testSpans() {
+    QFETCH(int, language);
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    const auto lang = static_cast<Highlighter::Language>(language);
+    QList<Highlighter::Span> spans;
+    Highlighter::State state = 0;
+    QCOMPARE(Highlighter::lex(input, 0, input.size(), state, lang, &spans), input.size());
+    QCOMPARE(describe(input, spans), expected);
+
+    // UTF-8 bytes lex the same, at the same offsets for ASCII text
+    QList<Highlighter::Span> byteSpans;
+    const QByteArray utf8 = input.toUtf8();
+    state = 0;
+    Highlighter::lex(utf8, 0, utf8.size(), state, lang, &byteSpans);
+    QCOMPARE(describe(input, byteSpans), expected);
+}
+
+void TestHighlighter::testResume() {
+    QList<Highlighter::Span> spans;
+    Highlighter::State state = 0;
+    Highlighter::lex(kScript, 0, kScript.size(), state, Highlighter::JavaScript, &spans);
+    const QList<int> whole = formatsOf(kScript.size(), spans);
+    QVERIFY(!whole.isEmpty());
+
+    // Stopping anywhere and resuming from the returned state colours every character the same
+    for (qsizetype cut = 0; cut <= kScript.size(); cut++) {
+        QList<Highlighter::Span> pieces;
+        state = 0;
+        const qsizetype stop =
+            Highlighter::lex(kScript, 0, cut, state, Highlighter::JavaScript, &pieces);
+        QVERIFY(stop >= cut);
+        Highlighter::lex(kScript, stop, kScript.size(), state, Highlighter::JavaScript, &pieces);
+        QCOMPARE(formatsOf(kScript.size(), pieces), whole);
+    }
+}
+
+void TestHighlighter::testLineByLine() {
+    QList<Highlighter::Span> spans;
+    Highlighter::State state = 0;
+    Highlighter::lex(kScript, 0, kScript.size(), state, Highlighter::JavaScript, &spans);
+    const QList<int> whole = formatsOf(kScript.size(), spans);
+
+    // An editor's blocks, each lexed with its line break from the state the previous one left
+    QList<int> lines;
+    state = 0;
+    qsizetype start = 0;
+    while (start < kScript.size()) {
+        const qsizetype end = kScript.indexOf('\n', start) + 1;
+        const QString line = kScript.mid(start, end - start);
+        QList<Highlighter::Span> lineSpans;
+        Highlighter::lex(line, 0, line.size(), state, Highlighter::JavaScript, &lineSpans);
+        lines += formatsOf(line.size(), lineSpans);
+        start = end;
+    }
+    QCOMPARE(lines, whole);
+}
+
+void TestHighlighter::testDeepNesting() {
+    // Braces beyond what the state holds still close a substitution nested inside them
+    const QString text =
+        QString("{").repeated(40) + "`${ {x: 1} }` / 2" + QString("}").repeated(40);
+    QList<Highlighter::Span> spans;
+    Highlighter::State state = 0;
+    Highlighter::lex(text, 0, text.size(), state, Highlighter::JavaScript, &spans);
+    QCOMPARE(describe(text, spans), QString("String:`${ Number:1 String:}` Number:2"));
+    QVERIFY(int(state) >= 0);
+}
+
+QTEST_MAIN(TestHighlighter)
+#include "test_highlighter.moc"
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <QtTest/QtTest>
+
+#include "../core/js_ast.h"
+#include "../core/task_control.h"
+
+class TestJsAst : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testFold_data();
+    void testFold();
+    void testInlineArrays_data();
+    void testInlineArrays();
+    void testRoundTrip_data();
+    void testRoundTrip();
+    void testTree();
+    void testDeepNesting();
+    void testLargeScript();
+    void testDeadline();
+};
+
+void TestJsAst::testFold_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("concat") << "var s = 'ev' + \"al\";" << "var s = 'eval';";
+    QTest::newRow("arithmetic") << "x = 0x10 * 2 + 1;" << "x = 33;";
+    QTest::newRow("hex_literal") << "f(0xff, 0b101, 0o17, 1_000)" << "f(255, 5, 15, 1000)";
+    QTest::newRow("not_not_array") << "a = !![]; b = ![];" << "a = true; b = false;";
+    QTest::newRow("unary_plus_array") << "n = +[] + +!![];" << "n = 1;";
+    QTest::newRow("array_concat") << "s = [] + 'x' + 1;" << "s = 'x1';";
+    QTest::newRow("typeof") << "t = typeof 'x' + typeof 1;" << "t = 'stringnumber';";
+    QTest::newRow("char_at") << "c = 'abc'[1] + 'hello'.length;" << "c = 'b5';";
+    QTest::newRow("bracket_to_dot") << "obj['log'](x['a-b'])" << "obj.log(x['a-b'])";
+    QTest::newRow("conditional") << "v = 1 < 2 ? a : b;" << "v = a;";
+    QTest::newRow("conditional_string") << "v = '' ? a : b;" << "v = b;";
+    QTest::newRow("logical") << "f(1 && a, 0 || b, null ?? c, 0 && d)" << "f(a, b, c, 0)";
+    QTest::newRow("reassociate") << "s = x + 'a' + 'b' + 1;" << "s = x + 'ab1';";
+    QTest::newRow("no_reassociate_numbers") << "s = x + 1 + 2;" << "s = x + 1 + 2;";
+    QTest::newRow("equality") << "f('1' == 1, null == 0, [] == '', 1 === 1.0)"
+                              << "f(true, false, true, true)";
+    QTest::newRow("bitwise") << "x = (5 | 2) ^ 1 << 3 >>> 1;" << "x = 3;";
+    QTest::newRow("negative") << "x = -(2 * 3); y = -1;" << "x = -6; y = -1;";
+    QTest::newRow("double_negative") << "x = 1 - -(1 + 1);" << "x = 3;";
+    QTest::newRow("unary_clash") << "x = -(-f(1 + 1));" << "x = - -f(2);";
+    QTest::newRow("nan_kept") << "x = 0 / 0; y = 'a' * 2;" << "x = 0 / 0; y = 'a' * 2;";
+    QTest::newRow("number_text") << "f(0.1 + 0.2, 1e21 * 10, 2 ** -3, 1 / 3 * 1e-7)"
+                                 << "f(0.30000000000000004, 1e+22, 0.125, 3.333333333333333e-8)";
+    QTest::newRow("escape_quote") << "s = \"it's\" + '\\n';" << "s = 'it\\'s\\n';";
+    QTest::newRow("parens_for_precedence") << "x = a * (1 + 2);" << "x = a * 3;";
+    QTest::newRow("member_on_number") << "x = (0x1).toString();" << "x = (1).toString();";
+    QTest::newRow("statement_function") << "(function(){}).call(x, 'a' + 'b');"
+                                        << "(function(){}).call(x, 'ab');";
+    QTest::newRow("function_body") << "function f() { return 'a' + 'b'; }"
+                                   << "function f() { return 'ab'; }";
+    QTest::newRow("arrow_body") << "g = () => 2 * 2;" << "g = () => 4;";
+    QTest::newRow("template_substitution") << "t = `a${1 + 1}b`;" << "t = `a${2}b`;";
+    QTest::newRow("object_value") << "o = {k: 'a' + 'b', [1 + 1]: 0};" << "o = {k: 'ab', [2]: 0};";
+    QTest::newRow("class_field") << "class A { x = 2 * 3; m() { return !0; } }"
+                                 << "class A { x = 6; m() { return true; } }";
+    QTest::newRow("assignment_target") << "'abc'.length = 1; x = 'ab'[0];"
+                                       << "'abc'.length = 1; x = 'a';";
+    QTest::newRow("asi") << "a = 1 + 1\nb = 'x' + 'y'\n" << "a = 2\nb = 'xy'\n";
+    QTest::newRow("comments_kept") << "/* c */ x = 1 + 1; // two" << "/* c */ x = 2; // two";
+    QTest::newRow("if_condition") << "if ('a' === 'a') { run(); }" << "if (true) { run(); }";
+    QTest::newRow("for_header") << "for (var i = 0x0; i < 0xa; i++) {}"
+                                << "for (var i = 0; i < 10; i++) {}";
+}
+
+void TestJsAst::testFold() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(JsAst::simplify(input), expected);
+}
+
+void TestJsAst::testInlineArrays_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("inlined") << "var _0x = ['log', 'hi'];\nconsole[_0x[0]](_0x[1]);"
+                             << "var _0x = ['log', 'hi'];\nconsole.log('hi');";
+    QTest::newRow("computed_index") << "var k = ['a', 'b'];\nf(k[0x1], k['0'], k[2 - 2]);"
+                                    << "var k = ['a', 'b'];\nf('b', 'a', 'a');";
+    QTest::newRow("concat_after") << "const s = ['ev', 'al'];\nwindow[s[0] + s[1]](x);"
+                                  << "const s = ['ev', 'al'];\nwindow.eval(x);";
+    QTest::newRow("written") << "var a = ['x'];\na[0] = 'y';\nf(a[0]);"
+                             << "var a = ['x'];\na[0] = 'y';\nf(a[0]);";
+    QTest::newRow("passed_around") << "var a = ['x'];\nshuffle(a);\nf(a[0]);"
+                                   << "var a = ['x'];\nshuffle(a);\nf(a[0]);";
+    QTest::newRow("redeclared") << "var a = ['x'];\nvar a = ['y'];\nf(a[0]);"
+                                << "var a = ['x'];\nvar a = ['y'];\nf(a[0]);";
+    QTest::newRow("shadowed_parameter") << "var a = ['x'];\nfunction g(a) { return a[0]; }"
+                                        << "var a = ['x'];\nfunction g(a) { return a[0]; }";
+    QTest::newRow("dynamic_index") << "var a = ['x'];\nf(a[i]);" << "var a = ['x'];\nf(a[i]);";
+    QTest::newRow("out_of_range") << "var a = ['x'];\nf(a[1]);" << "var a = ['x'];\nf(a[1]);";
+    QTest::newRow("non_literal") << "var a = [x];\nf(a[0]);" << "var a = [x];\nf(a[0]);";
+    QTest::newRow("property_name") << "var a = ['x'];\nf(o.a, a[0]);"
+                                   << "var a = ['x'];\nf(o.a, 'x');";
+}
+
+void TestJsAst::testInlineArrays() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(JsAst::simplify(input), expected);
+}
+
+void TestJsAst::testRoundTrip_data() {
+    QTest::addColumn<QString>("input");
+
+    QTest::newRow("plain") << "function add(a, b) {\n  return a + b; // sum\n}\n";
+    QTest::newRow("regex") << "var r = /a+b/g.test(s) ? x / 2 : y;";
+    QTest::newRow("module") << "import { a } from './a';\nexport default class B extends a {}";
+    QTest::newRow("async") << "const f = async (x) => { for await (const y of x) yield* y; };";
+    QTest::newRow("unbalanced") << "if (a { x = 1 + ; }) ]] '";
+    QTest::newRow("unterminated") << "var s = 'abc";
+    QTest::newRow("holes") << "var a = [, 1, , 2];";
+    QTest::newRow("optional_chain") << "a?.b?.[c]?.(d) ?? e";
+    QTest::newRow("labels") << "outer: for (;;) { break outer; }";
+    QTest::newRow("switch") << "switch (x) { case 1: f(); break; default: g(); }";
+    QTest::newRow("getters") << "var o = { get x() { return 1; }, set x(v) {}, async *g() {} };";
+    QTest::newRow("empty") << "";
+}
+
+void TestJsAst::testRoundTrip() {
+    QFETCH(QString, input);
+
+    JsAst ast;
+    ast.parse(input);
+    QCOMPARE(ast.toSource(), input);
+    QCOMPARE(JsAst::simplify(input), input);
+}
+
+void TestJsAst::testTree() {
+    JsAst ast;
+    ast.parse("x = a + b - c * d;");
+    const JsAst::Node *root = ast.root();
+    QCOMPARE(root->kind, JsAst::Source);
+    QCOMPARE(root->count, 1);
+
+    const JsAst::Node *assignment = root->children[0];
+    QCOMPARE(assignment->kind, JsAst::Assignment);
+    QVERIFY(assignment->statement);
+
+    // a + b - c * d is one chain of two operators around a product
+    const JsAst::Node *sum = assignment->children[1];
+    QCOMPARE(sum->kind, JsAst::Binary);
+    QCOMPARE(sum->count, 3);
+    QCOMPARE(sum->operators[0], QStringView(u"+"));
+    QCOMPARE(sum->operators[1], QStringView(u"-"));
+    QCOMPARE(sum->children[2]->kind, JsAst::Binary);
+    QCOMPARE(ast.nodeCount(), qsizetype(9));
+
+    QCOMPARE(ast.foldConstants(), 0);
+    QCOMPARE(ast.toSource(), QString("x = a + b - c * d;"));
+}
+
+void TestJsAst::testDeepNesting() {
+    // Past the nesting cap the statement is kept as written instead of recursing further
+    const int depth = 100000;
+    const QString parens = QString(depth, '(') + "1 + 1" + QString(depth, ')');
+    QCOMPARE(JsAst::simplify(parens), parens);
+
+    const QString arrays = "x = " + QString(depth, '[') + QString(depth, ']') + ";";
+    QCOMPARE(JsAst::simplify(arrays), arrays);
+
+    QString chain = "a";
+    for (int i = 0; i < depth; i++) {
+        chain += ".b";
+    }
+    QCOMPARE(JsAst::simplify(chain + "; y = 1 + 1;"), chain + "; y = 2;");
+
+    QString unary = QString(depth, '!') + "x";
+    QCOMPARE(JsAst::simplify(unary), unary);
+}
+
+void TestJsAst::testLargeScript() {
+    // A long concatenation is one flat chain, and folds in a single pass
+    QString script = "var s = ''";
+    for (int i = 0; i < 200000; i++) {
+        script += " + 'ab'";
+    }
+    script += ";\n";
+    for (int i = 0; i < 20000; i++) {
+        script += "f(0x" + QString::number(i, 16) + ", 'a' + 'b');\n";
+    }
+    const QString simplified = JsAst::simplify(script);
+    QVERIFY(simplified.startsWith("var s = 'abababab"));
+    QVERIFY(simplified.contains("\nf(4095, 'ab');\n"));
+    QCOMPARE(simplified.size(), qsizetype(10 + 400000 + 2) + [] {
+        qsizetype size = 0;
+        for (int i = 0; i < 20000; i++) {
+            size += QString("\nf(%1, 'ab');").arg(i).size();
+        }
+        return size;
+    }());
+}
+
+void TestJsAst::testDeadline() {
+    const QString script = "x = 1 + 1; y = 0x10;";
+    Deadline unlimited(60000, nullptr);
+    QCOMPARE(JsAst::simplify(script, &unlimited), QString("x = 2; y = 16;"));
+
+    // Out of time the script comes back as written; a parse cut short leaves no tree
+    Deadline expired(0, nullptr);
+    QCOMPARE(JsAst::simplify(script, &expired), script);
+    JsAst ast;
+    ast.parse(script, &expired);
+    QVERIFY(!ast.root());
+    QCOMPARE(ast.foldConstants(), 0);
+    QCOMPARE(ast.toSource(), script);
+
+    TaskControl control;
+    control.cancel();
+    Deadline cancelled(60000, &control);
+    QCOMPARE(JsAst::simplify(script, &cancelled), script);
+}
+
+QTEST_MAIN(TestJsAst)
+#include "test_js_ast.moc"
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include <QtTest/QtTest>
+
+#include "../core/js_lexer.h"
+
+class TestJsLexer : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testTokens_data();
+    void testTokens();
+    void testNewlines();
+    void testKeywordsAfterMemberAccess();
+    void testUnterminatedInput();
+    void testStringValue_data();
+    void testStringValue();
+    void testTopLevelEnds_data();
+    void testTopLevelEnds();
+};
+
+namespace {
+
+// Renders tokens as "kind(text)" separated by spaces
+QString describe(const QString &source) {
+    static const char *const kKinds[] = {"id",   "kw",   "num",  "str",   "tpl",
+                                         "re",   "punc", "line", "block", "end"};
+    JsLexer lexer(source);
+    QStringList parts;
+    for (JsLexer::Token token = lexer.next(); token.type != JsLexer::EndOfInput;
+         token = lexer.next()) {
+        parts.append(QString("%1(%2)").arg(kKinds[token.type], lexer.text(token).toString()));
+    }
+    return parts.join(' ');
+}
+
+}  // namespace
+
+void TestJsLexer::testTokens_data() {
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("statement") << "var a=1;" << "kw(var) id(a) punc(=) num(1) punc(;)";
+    QTest::newRow("longest_punctuator")
+        << "a>>>=b?\?=c" << "id(a) punc(>>>=) id(b) punc(?\?=) id(c)";
+    QTest::newRow("optional_chaining") << "a?.b" << "id(a) punc(?.) id(b)";
+    QTest::newRow("conditional_decimal")
+        << "a?.5:b" << "id(a) punc(?) num(.5) punc(:) id(b)";
+    QTest::newRow("numbers") << "0x1F 1e-3 1_000n .5" << "num(0x1F) num(1e-3) num(1_000n) num(.5)";
+    QTest::newRow("strings") << "'it\\'s' \"a\\\"b\"" << "str('it\\'s') str(\"a\\\"b\")";
+
+    // Regex literals against division
+    QTest::newRow("regex_after_assign") << "x=/a+b/gi" << "id(x) punc(=) re(/a+b/gi)";
+    QTest::newRow("division_after_name") << "a/b/c" << "id(a) punc(/) id(b) punc(/) id(c)";
+    QTest::newRow("division_after_paren") << "(a)/2" << "punc(() id(a) punc()) punc(/) num(2)";
+    QTest::newRow("regex_after_return") << "return /x/" << "kw(return) re(/x/)";
+    QTest::newRow("regex_slash_in_class") << "r=/[/]\\//" << "id(r) punc(=) re(/[/]\\//)";
+    QTest::newRow("division_assign") << "a/=2" << "id(a) punc(/=) num(2)";
+
+    // Template literals split at substitutions
+    QTest::newRow("template") << "`a${b}c`" << "tpl(`a${) id(b) tpl(}c`)";
+    QTest::newRow("template_nested_braces")
+        << "`${{a:1}.a}`" << "tpl(`${) punc({) id(a) punc(:) num(1) punc(}) punc(.) id(a) tpl(}`)";
+    QTest::newRow("template_nested_template")
+        << "`x${`y${z}`}`" << "tpl(`x${) tpl(`y${) id(z) tpl(}`) tpl(}`)";
+    QTest::newRow("regex_in_substitution") << "`${/a/}`" << "tpl(`${) re(/a/) tpl(}`)";
+
+    // Comments
+    QTest::newRow("comments")
+        << "a// x\n/* y */b" << "id(a) line(// x) block(/* y */) id(b)";
+    QTest::newRow("comment_keeps_regex_context")
+        << "x=/* c */ /y/" << "id(x) punc(=) block(/* c */) re(/y/)";
+    QTest::newRow("hashbang") << "#!/usr/bin/env node\nx" << "line(#!/usr/bin/env node) id(x)";
+
+    QTest::newRow("private_name") << "this.#x" << "kw(this) punc(.) id(#x)";
+    QTest::newRow("unicode_identifier") << QString::fromUtf8("var café=1")
+                                        << QString::fromUtf8("kw(var) id(café) punc(=) num(1)");
+}
+
+void TestJsLexer::testTokens() {
+    QFETCH(QString, source);
+    QFETCH(QString, expected);
+
+    QCOMPARE(describe(source), expected);
+}
+
+void TestJsLexer::testNewlines() {
+    const QString source = "a\r\nb\n\n\nc /* \n */ d";
+    const QList<JsLexer::Token> tokens = JsLexer::tokenize(source);
+    QCOMPARE(tokens.size(), 5);
+    QCOMPARE(tokens[0].newlines, 0);
+    QCOMPARE(tokens[1].newlines, 1);
+    QCOMPARE(tokens[2].newlines, 3);
+    QCOMPARE(tokens[3].type, JsLexer::BlockComment);
+    QCOMPARE(tokens[4].newlines, 0);
+}
+
+void TestJsLexer::testKeywordsAfterMemberAccess() {
+    QCOMPARE(describe("a.default/b.return/2"),
+             QString("id(a) punc(.) id(default) punc(/) id(b) punc(.) id(return) punc(/) num(2)"));
+    QVERIFY(JsLexer::isKeyword(u"instanceof"));
+    QVERIFY(!JsLexer::isKeyword(u"of"));
+}
+
+void TestJsLexer::testUnterminatedInput() {
+    // Everything is consumed and lexing ends, whatever is left open
+    QCOMPARE(describe("'abc\nx"), QString("str('abc) id(x)"));
+    QCOMPARE(describe("`a${b"), QString("tpl(`a${) id(b)"));
+    QCOMPARE(describe("/* open"), QString("block(/* open)"));
+    QCOMPARE(describe("x=/open\n1"), QString("id(x) punc(=) punc(/) id(open) num(1)"));
+}
+
+void TestJsLexer::testStringValue_data() {
+    QTest::addColumn<QString>("literal");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("value");
+
+    QTest::newRow("plain") << "'abc'" << true << "abc";
+    QTest::newRow("double_quotes") << "\"it's\"" << true << "it's";
+    QTest::newRow("escapes") << "'\\x41\\u0042\\u{43}\\101\\n\\''" << true << "ABCA\n'";
+    QTest::newRow("line_continuation") << "'a\\\nb'" << true << "ab";
+    QTest::newRow("nul") << "'\\0'" << true << QString(QChar(0));
+    QTest::newRow("template") << "`a\\tb`" << true << "a\tb";
+    QTest::newRow("bad_hex") << "'\\xZZ'" << false << "";
+    QTest::newRow("bad_unicode") << "'\\u{110000}'" << false << "";
+}
+
+void TestJsLexer::testStringValue() {
+    QFETCH(QString, literal);
+    QFETCH(bool, valid);
+    QFETCH(QString, value);
+
+    QString decoded;
+    QCOMPARE(JsLexer::stringValue(literal, decoded), valid);
+    if (valid) {
+        QCOMPARE(decoded, value);
+        // quote() gives a literal that reads back as the same value
+        QString again;
+        QVERIFY(JsLexer::stringValue(JsLexer::quote(value), again));
+        QCOMPARE(again, value);
+    }
+}
+
+void TestJsLexer::testTopLevelEnds_data() {
+    QTest::addColumn<QString>("source");
+    QTest::addColumn<QString>("expected");  // source with a '|' at each end
+
+    QTest::newRow("statements") << "a;b;c" << "a;|b;|c";
+    QTest::newRow("blocks") << "function f(){x;}g();for(;;){}"
+                            << "function f(){x;}|g();|for(;;){}|";
+    QTest::newRow("object") << "x={a:[1,2]};y" << "x={a:[1,2]}|;|y";
+    QTest::newRow("strings") << "s=';}';t=\"};\";u" << "s=';}';|t=\"};\";|u";
+    QTest::newRow("comments") << "a//;}\n;b/*;}*/" << "a//;}\n;|b/*;}*/";
+    QTest::newRow("regex") << "r=/;}/g;x=a/b;c" << "r=/;}/g;|x=a/b;|c";
+    QTest::newRow("regex_class") << "r=/[/;]/;c" << "r=/[/;]/;|c";
+    QTest::newRow("regex_after_keyword") << "return /;/;x" << "return /;/;|x";
+    QTest::newRow("division_after_member") << "a.return / 1;/;/" << "a.return / 1;|/;/";
+    QTest::newRow("division_after_paren") << "(a)/2;/;/" << "(a)/2;|/;/";
+    QTest::newRow("template") << "t=`;${{a:1}};`;x" << "t=`;${{a:1}};`;|x";
+    QTest::newRow("unbalanced") << "}a;(;" << "}|a;|(;";
+}
+
+void TestJsLexer::testTopLevelEnds() {
+    QFETCH(QString, source);
+    QFETCH(QString, expected);
+
+    QString marked = source;
+    const QList<qsizetype> ends = JsLexer::topLevelEnds(source);
+    for (qsizetype i = ends.size() - 1; i >= 0; i--) {
+        marked.insert(ends[i], '|');
+    }
+    QCOMPARE(marked, expected);
+}
+
+QTEST_MAIN(TestJsLexer)
+#include "test_js_lexer.moc"
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include <QtTest/QtTest>
+
+#include "../core/json5_document.h"
+#include "../core/task_control.h"
+
+class TestJson5Document : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testParse_data();
+    void testParse();
+    void testErrors_data();
+    void testErrors();
+    void testValues();
+    void testInternedKeys();
+    void testSortKeys();
+    void testDuplicateKeys();
+    void testDiff();
+    void testLargeDocument();
+    void testDeadline();
+};
+
+namespace {
+
+QString describe(const QList<Json5Document::Difference> &differences) {
+    static const char *const kKinds[] = {"added", "removed", "changed"};
+    QStringList parts;
+    for (const Json5Document::Difference &difference : differences) {
+        parts.append(QString("%1 %2 %3>%4")
+                         .arg(QString(kKinds[difference.kind]), difference.path,
+                              QString::fromUtf8(difference.before),
+                              QString::fromUtf8(difference.after)));
+    }
+    return parts.join(", ");
+}
+
+}  // namespace
+
+void TestJson5Document::testParse_data() {
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("strict") << QByteArray("{\"a\": [1, -2.5e3, true, false, null, \"x\"]}")
+                            << QByteArray("{\"a\":[1,-2.5e3,true,false,null,\"x\"]}");
+    QTest::newRow("unquoted_keys") << QByteArray("{a: 1, $b_2: 2}")
+                                   << QByteArray("{\"a\":1,\"$b_2\":2}");
+    QTest::newRow("single_quotes") << QByteArray("{'k': 'say \"hi\"'}")
+                                   << QByteArray("{\"k\":\"say \\\"hi\\\"\"}");
+    QTest::newRow("apostrophe") << QByteArray("['it\\'s', \"it's\"]")
+                                << QByteArray("[\"it's\",\"it's\"]");
+    QTest::newRow("trailing_commas") << QByteArray("{\"a\": [1, 2,], }")
+                                     << QByteArray("{\"a\":[1,2]}");
+    QTest::newRow("comments") << QByteArray("// head\n[1, /* two */ 2] // tail")
+                              << QByteArray("[1,2]");
+    QTest::newRow("numbers") << QByteArray("[0x1F, +1, .5, 5., 007, -0xA, 1e2]")
+                             << QByteArray("[31,1,0.5,5,7,-10,1e2]");
+    QTest::newRow("non_finite") << QByteArray("[Infinity, -Infinity, NaN]")
+                                << QByteArray("[null,null,null]");
+    QTest::newRow("escapes") << QByteArray("['\\x41\\u00e9\\ud83d\\ude00\\v\\0\\/', 'a\\\nb']")
+                             << QByteArray("[\"A\xc3\xa9\xf0\x9f\x98\x80\\u000b\\u0000/\",\"ab\"]");
+    QTest::newRow("bare_words") << QByteArray("{mode: fast lane , on: true}")
+                                << QByteArray("{\"mode\":\"fast lane\",\"on\":true}");
+    QTest::newRow("whitespace") << QByteArray("\xef\xbb\xbf{\xc2\xa0\"a\"\v:\f1}")
+                                << QByteArray("{\"a\":1}");
+    QTest::newRow("top_level_literal") << QByteArray(" NaN ") << QByteArray("null");
+    QTest::newRow("empty_containers") << QByteArray("{a: {}, b: []}")
+                                      << QByteArray("{\"a\":{},\"b\":[]}");
+    QTest::newRow("scalar_root") << QByteArray(" 'x' ") << QByteArray("\"x\"");
+}
+
+void TestJson5Document::testParse() {
+    QFETCH(QByteArray, input);
+    QFETCH(QByteArray, expected);
+
+    Json5Document document;
+    QString error;
+    QVERIFY2(document.parse(input, nullptr, &error), qPrintable(error));
+    QCOMPARE(document.toJson(), expected);
+}
+
+void TestJson5Document::testErrors_data() {
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<qsizetype>("errorPosition");
+
+    QTest::newRow("empty") << QByteArray("") << qsizetype(0);
+    QTest::newRow("missing_colon") << QByteArray("{a 1}") << qsizetype(3);
+    QTest::newRow("missing_comma") << QByteArray("[1 2]") << qsizetype(3);
+    QTest::newRow("empty_member") << QByteArray("{a:}") << qsizetype(3);
+    QTest::newRow("leading_comma") << QByteArray("[,1]") << qsizetype(1);
+    QTest::newRow("mismatched_close") << QByteArray("[1}") << qsizetype(2);
+    QTest::newRow("unterminated_string") << QByteArray("['abc") << qsizetype(5);
+    QTest::newRow("newline_in_string") << QByteArray("['a\nb']") << qsizetype(3);
+    QTest::newRow("bad_escape") << QByteArray("['\\u12x4']") << qsizetype(6);
+    QTest::newRow("unterminated_comment") << QByteArray("[1 /* x") << qsizetype(3);
+    QTest::newRow("bad_number") << QByteArray("[1.2.3]") << qsizetype(4);
+    QTest::newRow("content_after_value") << QByteArray("{} x") << qsizetype(3);
+    QTest::newRow("unclosed") << QByteArray("{a: [1") << qsizetype(6);
+    QTest::newRow("top_level_word") << QByteArray("  not json at all") << qsizetype(2);
+}
+
+void TestJson5Document::testErrors() {
+    QFETCH(QByteArray, input);
+    QFETCH(qsizetype, errorPosition);
+
+    Json5Document document;
+    qsizetype position = -1;
+    QVERIFY(!document.parse(input, &position));
+    QCOMPARE(position, errorPosition);
+    QVERIFY(!document.root());
+
+    QString error;
+    document.parse("[1 2]", nullptr, &error);
+    QCOMPARE(error, QString("Error: Expected ',' or ']' at position 3"));
+}
+
+void TestJson5Document::testValues() {
+    Json5Document document;
+    QVERIFY(document.parse("{a: 1, s: 'x\\ty', list: [true, null], a: 2}"));
+    const Json5Document::Value *root = document.root();
+    QCOMPARE(root->type, Json5Document::Object);
+    QCOMPARE(root->size, qsizetype(4));
+    QCOMPARE(root->find("a")->toDouble(), 2.0);  // the last of a repeated key wins
+    QCOMPARE(root->find("s")->string(), QByteArrayView("x\ty"));
+    QCOMPARE(root->find("s")->position, qsizetype(10));
+    QVERIFY(!root->find("missing"));
+
+    const Json5Document::Value *list = root->find("list");
+    QCOMPARE(list->type, Json5Document::Array);
+    QCOMPARE(list->items[0]->boolean, true);
+    QCOMPARE(list->items[1]->type, Json5Document::Null);
+    QCOMPARE(document.nodeCount(), qsizetype(7));
+
+    QVERIFY(document.parse("[-0x1F, +.5, -Infinity, NaN]"));
+    QCOMPARE(document.root()->items[0]->toDouble(), -31.0);
+    QCOMPARE(document.root()->items[1]->toDouble(), 0.5);
+    QCOMPARE(document.root()->items[2]->toDouble(), -qInf());
+    QVERIFY(qIsNaN(document.root()->items[3]->toDouble()));
+}
+
+void TestJson5Document::testInternedKeys() {
+    Json5Document document;
+    QVERIFY(document.parse("[{id: 1, 'name': 'a'}, {\"id\": 2, name: 'b'}]"));
+    const Json5Document::Value *first = document.root()->items[0];
+    const Json5Document::Value *second = document.root()->items[1];
+    QCOMPARE(first->members[0].key, second->members[0].key);
+    QCOMPARE(first->members[1].key, second->members[1].key);
+}
+
+void TestJson5Document::testSortKeys() {
+    Json5Document document;
+    QVERIFY(document.parse("{b: {z: 1, y: 2}, a: [{d: 1, c: 2}], b2: 0, b: 3}"));
+    document.sortKeys();
+    QCOMPARE(document.toJson(),
+             QByteArray("{\"a\":[{\"c\":2,\"d\":1}],\"b\":{\"y\":2,\"z\":1},\"b\":3,\"b2\":0}"));
+}
+
+void TestJson5Document::testDuplicateKeys() {
+    Json5Document document;
+    QVERIFY(document.parse(
+        "{a: 1, b: {c: 1, c: 2}, 'a': 3, l: [{x: 0, x: 0}], 'a/b': {k: 0, k: 1}}"));
+    const QList<Json5Document::DuplicateKey> duplicates = document.duplicateKeys();
+    QCOMPARE(duplicates.size(), 4);
+    QCOMPARE(duplicates[0].path, QString("/b"));
+    QCOMPARE(duplicates[0].key, QByteArray("c"));
+    QCOMPARE(duplicates[0].position, qsizetype(17));
+    QCOMPARE(duplicates[1].path, QString(""));  // the root, while "/" is the member named ""
+    QCOMPARE(duplicates[1].key, QByteArray("a"));
+    QCOMPARE(duplicates[2].path, QString("/l/0"));
+    QCOMPARE(duplicates[3].path, QString("/a~1b"));
+}
+
+void TestJson5Document::testDiff() {
+    Json5Document before;
+    Json5Document after;
+    QVERIFY(before.parse("{a: 1, b: [1, 2, 3], c: {d: 'x'}, e: null, f: 1.0}"));
+    QVERIFY(
+        after.parse("{\"a\": 1, \"b\": [1, 5], \"c\": {\"d\": 'y', \"n\": 0}, \"f\": 1, g: []}"));
+    QCOMPARE(describe(Json5Document::diff(before, after)),
+             QString("changed /b/1 2>5, removed /b/2 3>, changed /c/d \"x\">\"y\", "
+                     "added /c/n >0, removed /e null>, added /g >[]"));
+
+    QVERIFY(Json5Document::diff(before, before).isEmpty());
+
+    Json5Document scalar;
+    QVERIFY(scalar.parse("42"));
+    QCOMPARE(describe(Json5Document::diff(before, scalar)).left(10), QString("changed  {"));
+
+    // "/" points at the member with the empty key, not at the root
+    Json5Document emptyKey;
+    QVERIFY(emptyKey.parse("{'': 2}"));
+    QVERIFY(scalar.parse("{'': 1}"));
+    QCOMPARE(describe(Json5Document::diff(scalar, emptyKey)), QString("changed / 1>2"));
+}
+
+void TestJson5Document::testLargeDocument() {
+    // Deep nesting parses without recursion, and a million nodes in one go
+    const int depth = 200000;
+    const QByteArray deep = QByteArray(depth, '[') + QByteArray(depth, ']');
+    Json5Document document;
+    QVERIFY(document.parse(deep));
+    QCOMPARE(document.nodeCount(), qsizetype(depth));
+    QCOMPARE(document.toJson(), deep);
+
+    QByteArray wide = "[";
+    for (int i = 0; i < 250000; i++) {
+        wide += "{k: 1, s: 'v'},";
+    }
+    wide += "]";
+    QVERIFY(document.parse(wide));
+    QCOMPARE(document.nodeCount(), qsizetype(1 + 250000 * 3));
+    QCOMPARE(document.root()->size, qsizetype(250000));
+    QVERIFY(document.arenaSize() > 0);
+}
+
+void TestJson5Document::testDeadline() {
+    const QByteArray text = "{a: [1, 2, {b: 'c'}], d: null}";
+    Json5Document document;
+    Deadline open(60000, nullptr);
+    QVERIFY(document.parse(text, nullptr, nullptr, &open));
+    QCOMPARE(document.toJson(&open), document.toJson());
+
+    // Past the deadline the parse fails where it stopped and serialising gives up
+    TaskControl control;
+    control.cancel();
+    Deadline passed(60000, &control);
+    QVERIFY(document.toJson(&passed).isEmpty());
+    qsizetype position = -1;
+    QString error;
+    QVERIFY(!document.parse(text, &position, &error, &passed));
+    QCOMPARE(position, qsizetype(0));
+    QCOMPARE(error, QString("Error: Out of time at position 0"));
+}
+
+QTEST_MAIN(TestJson5Document)
+#include "test_json5_document.moc"
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <QtTest/QtTest>
+
+#include "../core/json_formatter.h"
+
+class TestJsonFormatter : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testFormat_data();
+    void testFormat();
+    void testOptions();
+    void testChunkBoundaries();
+    void testStreamOfValues();
+    void testLargeDocument();
+};
+
+void TestJsonFormatter::testFormat_data() {
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("object") << QByteArray("{\"a\":1,\"b\":true}")
+                            << QByteArray("{\n  \"a\": 1,\n  \"b\": true\n}");
+    QTest::newRow("nested") << QByteArray("{\"a\":[1,{\"b\":null}]}")
+                            << QByteArray("{\n  \"a\": [\n    1,\n    {\n      \"b\": null\n    }\n"
+                                          "  ]\n}");
+    QTest::newRow("empty_containers") << QByteArray("{\"a\":{},\"b\":[ ]}")
+                                      << QByteArray("{\n  \"a\": {},\n  \"b\": []\n}");
+    QTest::newRow("whitespace_dropped") << QByteArray(" [ 1 ,\r\n\t2 ] ")
+                                        << QByteArray("[\n  1,\n  2\n]");
+    QTest::newRow("strings_untouched")
+        << QByteArray("[\"a, {b}: [c]\",\"q\\\"{\",\"\\\\\"]")
+        << QByteArray("[\n  \"a, {b}: [c]\",\n  \"q\\\"{\",\n  \"\\\\\"\n]");
+    QTest::newRow("scalar") << QByteArray(" -1.5e3 ") << QByteArray("-1.5e3");
+    QTest::newRow("utf8") << QByteArray("{\"k\":\"\xc3\xa9\xe2\x9c\x93\"}")
+                          << QByteArray("{\n  \"k\": \"\xc3\xa9\xe2\x9c\x93\"\n}");
+    QTest::newRow("empty") << QByteArray() << QByteArray();
+}
+
+void TestJsonFormatter::testFormat() {
+    QFETCH(QByteArray, input);
+    QFETCH(QByteArray, expected);
+
+    QCOMPARE(JsonFormatter::format(input), expected);
+}
+
+void TestJsonFormatter::testOptions() {
+    const QByteArray input = "{ \"a\" : [ 1 , 2 ] , \"b\" : { } }";
+
+    JsonFormatter::Options wide;
+    wide.indentWidth = 4;
+    QCOMPARE(JsonFormatter::format(input, wide),
+             QByteArray("{\n    \"a\": [\n        1,\n        2\n    ],\n    \"b\": {}\n}"));
+
+    JsonFormatter::Options tabs;
+    tabs.useTabs = true;
+    QCOMPARE(JsonFormatter::format(input, tabs),
+             QByteArray("{\n\t\"a\": [\n\t\t1,\n\t\t2\n\t],\n\t\"b\": {}\n}"));
+
+    JsonFormatter::Options compact;
+    compact.compact = true;
+    QCOMPARE(JsonFormatter::format(input, compact), QByteArray("{\"a\":[1,2],\"b\":{}}"));
+}
+
+void TestJsonFormatter::testChunkBoundaries() {
+    // Splitting the input anywhere, escapes included, must not change the result
+    const QByteArray input = "{\"a\\\\\\\"b\": [true, \"x\\\"}\", -12.5e+3, {}], \"c\" :null}";
+    const QByteArray expected = JsonFormatter::format(input);
+
+    for (qsizetype split = 0; split <= input.size(); split++) {
+        JsonFormatter formatter;
+        formatter.push(QByteArrayView(input).first(split));
+        QByteArray output = formatter.takeOutput();
+        formatter.push(QByteArrayView(input).sliced(split));
+        output += formatter.takeOutput();
+        QCOMPARE(output, expected);
+    }
+
+    // One byte at a time
+    JsonFormatter formatter;
+    QByteArray output;
+    for (char ch : input) {
+        formatter.push(QByteArrayView(&ch, 1));
+        output += formatter.takeOutput();
+    }
+    QCOMPARE(output, expected);
+}
+
+void TestJsonFormatter::testStreamOfValues() {
+    // Newline-delimited JSON stays one value per line
+    const QByteArray input = "{\"a\":1}\n{\"b\":2}";
+
+    JsonFormatter::Options compact;
+    compact.compact = true;
+    QCOMPARE(JsonFormatter::format(input, compact), QByteArray("{\"a\":1}\n{\"b\":2}"));
+    QCOMPARE(JsonFormatter::format(input), QByteArray("{\n  \"a\": 1\n}\n{\n  \"b\": 2\n}"));
+}
+
+void TestJsonFormatter::testLargeDocument() {
+    // format() consumes its index a window at a time; tokens crossing windows must survive
+    QByteArray input = "[";
+    for (int i = 0; i < 5000; i++) {
+        input += "{\"s\" : \"" + QByteArray(i % 89, 'y') + "\\\"\" , \"n\":-12.5e3 } ,";
+    }
+    input += "true  ]";
+
+    JsonFormatter formatter;
+    formatter.push(input);
+    const QByteArray expected = formatter.takeOutput();
+    QCOMPARE(JsonFormatter::format(input), expected);
+}
+
+QTEST_MAIN(TestJsonFormatter)
+#include "test_json_formatter.moc"
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <QtTest/QtTest>
+
+#include "../core/json_index.h"
+
+class TestJsonIndex : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testTape_data();
+    void testTape();
+    void testMatchesReference();
+    void testChunkedScan();
+    void testValidate_data();
+    void testValidate();
+    void testErrorMessage();
+    void testLargeDocument();
+};
+
+namespace {
+
+QString describe(const QList<qsizetype> &tape) {
+    QStringList parts;
+    for (qsizetype pos : tape) {
+        parts.append(QString::number(pos));
+    }
+    return parts.join(' ');
+}
+
+// Byte-at-a-time statement of what the tape should hold
+QList<qsizetype> referenceTape(QByteArrayView input) {
+    QList<qsizetype> tape;
+    bool inString = false;
+    bool inScalar = false;
+    bool escapeNext = false;
+    for (qsizetype i = 0; i < input.size(); i++) {
+        const char ch = input[i];
+        const bool escaped = escapeNext;
+        escapeNext = ch == '\\' && !escaped;
+        if (inString) {
+            if (ch == '"' && !escaped) {
+                tape.append(i);
+                inString = false;
+            }
+            continue;
+        }
+        if (ch == '"') {
+            if (!escaped) {
+                tape.append(i);
+                inString = true;
+            }
+            inScalar = false;
+        } else if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+            inScalar = false;
+        } else if (QByteArray("{}[]:,").contains(ch)) {
+            tape.append(i);
+            inScalar = false;
+        } else if (!inScalar) {
+            tape.append(i);
+            inScalar = true;
+        }
+    }
+    return tape;
+}
+
+// Deterministic noise heavy in quotes, backslash runs and structure
+QByteArray randomJsonish(quint32 seed, qsizetype size) {
+    static const char kAlphabet[] = "\"\"\\\\\\{}[]:,  \nab1-";
+    QByteArray text;
+    text.reserve(size);
+    for (qsizetype i = 0; i < size; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        text.append(kAlphabet[(seed >> 24) % (sizeof(kAlphabet) - 1)]);
+    }
+    return text;
+}
+
+}  // namespace
+
+void TestJsonIndex::testTape_data() {
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("object") << QByteArray("{\"a\": 1}") << "0 1 3 4 6 7";
+    QTest::newRow("array") << QByteArray("[true, -2.5]") << "0 1 5 7 11";
+    QTest::newRow("structure_in_string") << QByteArray("[\"{,:}\"]") << "0 1 6 7";
+    QTest::newRow("escaped_quote") << QByteArray("[\"a\\\"b\"]") << "0 1 6 7";
+    QTest::newRow("escaped_backslash") << QByteArray("[\"a\\\\\",1]") << "0 1 5 6 7 8";
+    QTest::newRow("unterminated") << QByteArray("[\"abc, 1]") << "0 1";
+    QTest::newRow("empty") << QByteArray() << "";
+    QTest::newRow("whitespace") << QByteArray(" \t\r\n") << "";
+
+    // Carries across the 64-byte block boundary
+    QTest::newRow("string_across_blocks")
+        << (QByteArray("[\"") + QByteArray(70, 'x') + "\",1]") << "0 1 72 73 74 75";
+    QTest::newRow("escape_across_blocks")
+        << (QByteArray("[\"") + QByteArray(61, 'x') + "\\\"\"]") << "0 1 65 66";
+    QTest::newRow("scalar_across_blocks")
+        << (QByteArray(60, ' ') + "12345678") << "60";
+}
+
+void TestJsonIndex::testTape() {
+    QFETCH(QByteArray, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(describe(JsonIndex::build(input)), expected);
+}
+
+void TestJsonIndex::testMatchesReference() {
+    // Whatever kernel this machine runs must agree with the byte-wise definition
+    for (quint32 seed = 1; seed <= 200; seed++) {
+        const QByteArray input = randomJsonish(seed, seed * 7);
+        const QList<qsizetype> tape = JsonIndex::build(input);
+        const QList<qsizetype> expected = referenceTape(input);
+        QCOMPARE(tape, expected);
+    }
+
+    // Backslash runs of every length ending at every offset of a block
+    for (int run = 1; run <= 8; run++) {
+        for (int offset = 0; offset < 70; offset++) {
+            const QByteArray input =
+                "[\"" + QByteArray(offset, 'x') + QByteArray(run, '\\') + "\",\"y\"]";
+            const QList<qsizetype> tape = JsonIndex::build(input);
+            const QList<qsizetype> expected = referenceTape(input);
+            QCOMPARE(tape, expected);
+        }
+    }
+}
+
+void TestJsonIndex::testChunkedScan() {
+    const QByteArray input = randomJsonish(42, 300);
+    const QList<qsizetype> expected = JsonIndex::build(input);
+
+    for (qsizetype split = 0; split <= input.size(); split += 7) {
+        QList<qsizetype> tape;
+        JsonIndex::Scanner scanner;
+        scanner.scan(QByteArrayView(input).first(split), tape);
+        scanner.scan(QByteArrayView(input).sliced(split), tape);
+        scanner.finish(tape);
+        QCOMPARE(tape, expected);
+    }
+}
+
+void TestJsonIndex::testValidate_data() {
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<qsizetype>("errorPosition");  // -1 for valid input
+
+    QTest::newRow("document") << QByteArray(
+        "{\"a\": [1, 2.5e-3, -0, true, false, null, \"x\\u00e9\\n\"], \"b\": {}, \"c\": []}")
+                              << qsizetype(-1);
+    QTest::newRow("scalar") << QByteArray(" 42 ") << qsizetype(-1);
+    QTest::newRow("utf8") << QByteArray("[\"\xc3\xa9\xe2\x9c\x93\xf0\x9f\x98\x80\"]")
+                          << qsizetype(-1);
+    QTest::newRow("empty") << QByteArray() << qsizetype(0);
+    QTest::newRow("trailing_comma") << QByteArray("{\"a\":1,}") << qsizetype(7);
+    QTest::newRow("missing_comma") << QByteArray("[1 2]") << qsizetype(3);
+    QTest::newRow("missing_colon") << QByteArray("{\"a\" 1}") << qsizetype(5);
+    QTest::newRow("unquoted_key") << QByteArray("{a:1}") << qsizetype(1);
+    QTest::newRow("mismatched_close") << QByteArray("{\"a\":1]") << qsizetype(6);
+    QTest::newRow("leading_zero") << QByteArray("[01]") << qsizetype(2);
+    QTest::newRow("bare_decimal_point") << QByteArray("[1.]") << qsizetype(3);
+    QTest::newRow("truncated_literal") << QByteArray("[tru]") << qsizetype(4);
+    QTest::newRow("bad_escape") << QByteArray("[\"a\\x\"]") << qsizetype(4);
+    QTest::newRow("bad_unicode_escape") << QByteArray("[\"\\u12G4\"]") << qsizetype(6);
+    QTest::newRow("control_character") << QByteArray("[\"a\tb\"]") << qsizetype(3);
+    QTest::newRow("truncated_utf8") << QByteArray("[\"\xc3\"]") << qsizetype(3);
+    QTest::newRow("utf8_surrogate") << QByteArray("[\"\xed\xa0\x80\"]") << qsizetype(3);
+    QTest::newRow("content_after_value") << QByteArray("[1]]") << qsizetype(3);
+    QTest::newRow("unterminated_string") << QByteArray("[\"abc") << qsizetype(5);
+    QTest::newRow("unclosed_containers") << QByteArray("{\"a\":{\"b\":[") << qsizetype(11);
+    QTest::newRow("escape_outside_string") << QByteArray("[1\\\"]") << qsizetype(2);
+}
+
+void TestJsonIndex::testValidate() {
+    QFETCH(QByteArray, input);
+    QFETCH(qsizetype, errorPosition);
+
+    qsizetype position = -1;
+    const bool valid = JsonIndex::validate(input, &position);
+    QCOMPARE(valid, errorPosition < 0);
+    QCOMPARE(position, errorPosition);
+}
+
+void TestJsonIndex::testErrorMessage() {
+    QString error;
+    QVERIFY(!JsonIndex::validate("[1 2]", nullptr, &error));
+    QCOMPARE(error, QString("Error: Expected ',' or ']' at position 3"));
+}
+
+void TestJsonIndex::testLargeDocument() {
+    // Long enough for validation to span several scan windows, with strings crossing them
+    QByteArray input = "[";
+    for (int i = 0; i < 5000; i++) {
+        input += "{\"key\": \"" + QByteArray(i % 97, 'x') + "\\\"\", \"n\": [1, 2.5, null]},\n";
+    }
+    input += "{}]";
+    QVERIFY(input.size() > 3 * JsonIndex::kWindowSize);
+    QVERIFY(JsonIndex::validate(input));
+    QVERIFY(JsonIndex::validate(input, JsonIndex::build(input)));
+
+    const qsizetype broken = input.lastIndexOf("null");
+    input[broken + 1] = 'o';
+    qsizetype position = -1;
+    QVERIFY(!JsonIndex::validate(input, &position));
+    QCOMPARE(position, broken + 1);
+    QVERIFY(!JsonIndex::validate(input, JsonIndex::build(input), &position));
+    QCOMPARE(position, broken + 1);
+}
+
+QTEST_MAIN(TestJsonIndex)
+#include "test_json_index.moc"
\ No newline at end of file
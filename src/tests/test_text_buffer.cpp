@@ -0,0 +1,195 @@
+#include <QtTest/QtTest>
+
+#include "../core/text_buffer.h"
+
+class TestTextBuffer : public QObject {
+    Q_OBJECT
+
+  private slots:
+    void testRows_data();
+    void testRows();
+    void testLines();
+    void testSharedData();
+    void testReplace();
+    void testLongLine();
+    void testCutLine();
+};
+
+namespace {
+
+// Every row from the first to the last, joined with '|'
+QByteArray rows(const TextBuffer &buffer, qsizetype width) {
+    QByteArrayList parts;
+    for (qsizetype row = 0; row >= 0; row = buffer.nextRow(row, width)) {
+        parts.append(buffer.mid(row, buffer.rowEnd(row, width) - row));
+    }
+    return parts.join('|');
+}
+
+}  // namespace
+
+void TestTextBuffer::testRows_data() {
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<int>("width");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("empty") << QByteArray() << 4 << QByteArray("");
+    QTest::newRow("short") << QByteArray("abc") << 4 << QByteArray("abc");
+    QTest::newRow("exact") << QByteArray("abcd") << 4 << QByteArray("abcd");
+    QTest::newRow("wrapped") << QByteArray("abcdefghij") << 4 << QByteArray("abcd|efgh|ij");
+    QTest::newRow("lines") << QByteArray("ab\ncdefg\n\nh") << 4 << QByteArray("ab|cdef|g||h");
+    QTest::newRow("final_newline") << QByteArray("ab\n") << 4 << QByteArray("ab|");
+    QTest::newRow("line_of_width") << QByteArray("abcdefgh\nx") << 4 << QByteArray("abcd|efgh|x");
+    // Rows keep their place in the line; a character cut at the end pushes the next row's start
+    QTest::newRow("utf8") << QByteArray("abc\xc3\xa9" "defg") << 4
+                          << QByteArray("abc\xc3\xa9|def|g");
+    QTest::newRow("utf8_at_end") << QByteArray("abc\xe2\x82\xac") << 4
+                                 << QByteArray("abc\xe2\x82\xac");
+}
+
+void TestTextBuffer::testRows() {
+    QFETCH(QByteArray, text);
+    QFETCH(int, width);
+    QFETCH(QByteArray, expected);
+
+    const TextBuffer buffer(text);
+    QCOMPARE(rows(buffer, width), expected);
+
+    // Walking back visits the same rows, and any position maps to the row that holds it
+    QList<qsizetype> forward;
+    for (qsizetype row = 0; row >= 0; row = buffer.nextRow(row, width)) {
+        forward.append(row);
+        for (qsizetype pos = row; pos < buffer.rowEnd(row, width); pos++) {
+            QCOMPARE(buffer.rowStart(pos, width), row);
+        }
+    }
+    QList<qsizetype> backward = {forward.last()};
+    while (backward.last() > 0) {
+        backward.append(buffer.previousRow(backward.last(), width));
+    }
+    std::reverse(backward.begin(), backward.end());
+    QCOMPARE(backward, forward);
+}
+
+void TestTextBuffer::testLines() {
+    const TextBuffer buffer(QByteArray("one\ntwo\n\nfour"));
+    QCOMPARE(buffer.lineStart(0), qsizetype(0));
+    QCOMPARE(buffer.lineEnd(0), qsizetype(3));
+    QCOMPARE(buffer.lineStart(3), qsizetype(0));  // the '\n' belongs to the line it ends
+    QCOMPARE(buffer.lineStart(4), qsizetype(4));
+    QCOMPARE(buffer.lineEnd(6), qsizetype(7));
+    QCOMPARE(buffer.lineStart(8), qsizetype(8));
+    QCOMPARE(buffer.lineEnd(8), qsizetype(8));
+    QCOMPARE(buffer.lineStart(13), qsizetype(9));
+    QCOMPARE(buffer.lineEnd(10), qsizetype(13));
+    QCOMPARE(buffer.lineStart(buffer.size()), qsizetype(9));
+}
+
+void TestTextBuffer::testSharedData() {
+    const QByteArray data = QByteArray("line\n").repeated(100000);
+    TextBuffer buffer(data);
+    QCOMPARE(buffer.size(), data.size());
+    QCOMPARE(buffer.toByteArray(), data);
+
+    // Chunks point into `data` rather than holding copies of it
+    const qsizetype middle = TextBuffer::ChunkSize + 7;
+    QCOMPARE(buffer.mid(middle - 10, 20), data.mid(middle - 10, 20));
+    QCOMPARE(buffer.at(middle), data.at(middle));
+    QCOMPARE(buffer.lineStart(middle), qsizetype(middle - middle % 5));
+
+    buffer.clear();
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(buffer.nextRow(0, 8), qsizetype(-1));
+}
+
+void TestTextBuffer::testReplace() {
+    QByteArray expected;
+    for (int i = 0; i < 40000; i++) {
+        expected += QByteArray::number(i) + (i % 7 == 0 ? "\n" : " ");
+    }
+    TextBuffer buffer(expected);
+
+    // Edits of every size across chunk boundaries, checked against a plain byte array
+    for (int i = 0; i < 300; i++) {
+        const qsizetype position = (qsizetype(i) * 104729) % (expected.size() + 1);
+        const qsizetype length = qMin<qsizetype>((i * 37) % (i % 3 == 0 ? 90000 : 40),
+                                                 expected.size() - position);
+        const QByteArray data = i % 5 == 0 ? QByteArray() : QByteArray("x\ny").repeated(i % 11);
+        expected.replace(position, length, data);
+        buffer.replace(position, length, data);
+        QCOMPARE(buffer.size(), expected.size());
+
+        const qsizetype probe = (qsizetype(i) * 7919) % (expected.size() + 1);
+        const qsizetype start = expected.lastIndexOf('\n', probe - 1) + 1;
+        const qsizetype end = expected.indexOf('\n', probe);
+        QCOMPARE(buffer.lineStart(probe), probe == 0 ? 0 : start);
+        QCOMPARE(buffer.lineEnd(probe), end < 0 ? expected.size() : end);
+    }
+    QCOMPARE(buffer.toByteArray(), expected);
+
+    buffer.append("tail");
+    QCOMPARE(buffer.toByteArray(), expected + "tail");
+}
+
+void TestTextBuffer::testLongLine() {
+    // One line across many chunks: rows still follow from its start alone
+    const QByteArray data = "x" + QByteArray("0123456789").repeated(50000) + "\ny";
+    const TextBuffer buffer(data);
+    const qsizetype width = 80;
+    QCOMPARE(buffer.rowStart(400000 + 17, width), qsizetype(400000));  // a multiple of 80
+    QCOMPARE(buffer.nextRow(400000, width), qsizetype(400000 + width));
+    const qsizetype last = buffer.previousRow(data.size() - 1, width);
+    QCOMPARE(last, qsizetype((data.size() - 3) / width * width));
+    QCOMPARE(buffer.nextRow(last, width), data.size() - 1);
+    QCOMPARE(buffer.nextRow(data.size() - 1, width), qsizetype(-1));
+}
+
+void TestTextBuffer::testCutLine() {
+    const qsizetype limit = TextBuffer::LineLimit;
+    const QByteArray data = QByteArray(2 * limit + 100, 'x') + "\n" + QByteArray(limit, 'y') + "\n"
+                            + QByteArray(limit - 1, 'z') + "\nend";
+    const TextBuffer buffer(data);
+
+    // A line with no break in the block before a multiple of LineLimit is cut there
+    QCOMPARE(buffer.lineStart(limit - 1), qsizetype(0));
+    QCOMPARE(buffer.lineEnd(0), limit);
+    QCOMPARE(buffer.lineStart(limit), limit);
+    QCOMPARE(buffer.lineEnd(limit + 5), 2 * limit);
+    QCOMPARE(buffer.lineStart(2 * limit + 50), 2 * limit);
+    QCOMPARE(buffer.lineEnd(2 * limit), 2 * limit + 100);
+    // A line that starts within a block runs on past the next multiple
+    QCOMPARE(buffer.lineStart(3 * limit + 50), 2 * limit + 101);
+    QCOMPARE(buffer.lineEnd(2 * limit + 101), 3 * limit + 101);
+    // A '\n' right at a multiple ends its line rather than starting an empty one
+    const TextBuffer ended(QByteArray(limit, 'x') + "\ny");
+    QCOMPARE(ended.lineStart(limit), qsizetype(0));
+    QCOMPARE(ended.lineEnd(0), limit);
+    QCOMPARE(ended.nextRow(limit - 4, 4), limit + 1);
+    QCOMPARE(ended.previousRow(limit + 1, 4), limit - 4);
+
+    // Rows stop at the cuts without losing or repeating a byte, in both directions
+    const qsizetype width = 1000;
+    QList<qsizetype> forward;
+    qsizetype covered = 0;
+    for (qsizetype row = 0; row >= 0; row = buffer.nextRow(row, width)) {
+        forward.append(row);
+        QCOMPARE(row, covered);
+        covered = buffer.rowEnd(row, width);
+        QVERIFY(covered - row <= width);
+        if (covered < data.size() && data.at(covered) == '\n') {
+            covered++;
+        }
+    }
+    QCOMPARE(covered, data.size());
+    QVERIFY(forward.contains(limit));
+    QVERIFY(forward.contains(2 * limit));
+    QList<qsizetype> backward = {forward.last()};
+    while (backward.last() > 0) {
+        backward.append(buffer.previousRow(backward.last(), width));
+    }
+    std::reverse(backward.begin(), backward.end());
+    QCOMPARE(backward, forward);
+}
+
+QTEST_MAIN(TestTextBuffer)
+#include "test_text_buffer.moc"
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <QtTest/QtTest>
 
+#include "../core/json_formatter.h"
+#include "../core/task_control.h"
 #include "../core/unpacker.h"
 
 class TestUnpacker : public QObject {
@@ -8,14 +10,127 @@ class TestUnpacker : public QObject {
   private slots:
     void testJavaScriptDeobfuscation_data();
     void testJavaScriptDeobfuscation();
+    void testEscapesAreDecodedOnce();
     void testJavaScriptBeautification_data();
     void testJavaScriptBeautification();
+    void testJavaScriptBeautificationOutput_data();
+    void testJavaScriptBeautificationOutput();
+    void testParallelBeautification_data();
+    void testParallelBeautification();
     void testJsonFormatting_data();
     void testJsonFormatting();
+    void testJsonRepair_data();
+    void testJsonRepair();
     void testDeanEdwardsUnpacking();
+    void testDeanEdwardsTokens_data();
+    void testDeanEdwardsTokens();
+    void testDeanEdwardsBases_data();
+    void testDeanEdwardsBases();
     void testStringFromCharCode();
+    void testUnpackFormats_data();
+    void testUnpackFormats();
+    void testUnpackBudget();
+    void testOperationBudget();
+    void testCancellation();
+    void testByteApi();
 };
 
+namespace {
+
+// Ports of the JJencode and AAencode encoders, so the decoders are checked against real output
+QString jjencode(const QString &global, const QString &text) {
+    static const char *const kDigits[] = {"___",  "__$",  "_$_",  "_$$",  "$__",  "$_$",
+                                          "$$_",  "$$$",  "$___", "$__$", "$_$_", "$_$$",
+                                          "$$__", "$$_$", "$$$_", "$$$$"};
+    const QString g = global;
+    QString r;
+    QString s;
+    const auto flush = [&](bool close) {
+        if (!s.isEmpty()) {
+            r += "\"" + s + (close ? "\"+" : "");
+        } else if (!close) {
+            r += "\"";
+        }
+        s.clear();
+    };
+    for (QChar ch : text) {
+        const int n = ch.unicode();
+        if (n == 0x22 || n == 0x5c) {
+            s += "\\\\\\" + QString(ch);
+        } else if ((n >= 0x21 && n <= 0x2f) || (n >= 0x3a && n <= 0x40) ||
+                   (n >= 0x5b && n <= 0x60) || (n >= 0x7b && n <= 0x7f)) {
+            s += ch;
+        } else if ((n >= 0x30 && n <= 0x39) || (n >= 0x61 && n <= 0x66)) {
+            flush(true);
+            r += g + "." + kDigits[n < 0x40 ? n - 0x30 : n - 0x57] + "+";
+        } else if (n == 'l' || n == 'o' || n == 't' || n == 'u') {
+            flush(true);
+            r += n == 'l'   ? "(![]+\"\")[" + g + "._$_]+"
+                 : n == 'o' ? g + "._$+"
+                 : n == 't' ? g + ".__+"
+                            : g + "._+";
+        } else {
+            flush(false);
+            r += "\\\\\"+";
+            if (n >= 128) {
+                r += g + "._+";
+            }
+            const QString digits =
+                n < 128 ? QString::number(n, 8) : QString::number(n, 16).rightJustified(4, '0');
+            for (QChar digit : digits) {
+                r += g + "." + kDigits[digit.digitValue() >= 0 ? digit.digitValue()
+                                                                : digit.unicode() - 'a' + 10] +
+                     "+";
+            }
+        }
+    }
+    flush(true);
+
+    // The encoder's fixed preamble, with G standing for the variable
+    QString script =
+        "G=~[];G={___:++G,$$$$:(![]+\"\")[G],__$:++G,$_$_:(![]+\"\")[G],_$_:++G,"
+        "$_$$:({}+\"\")[G],$$_$:(G[G]+\"\")[G],_$$:++G,$$$_:(!\"\"+\"\")[G],$__:++G,$_$:++G,"
+        "$$__:({}+\"\")[G],$$_:++G,$$$:++G,$___:++G,$__$:++G};G.$_=(G.$_=G+\"\")[G.$_$]+"
+        "(G._$=G.$_[G.__$])+(G.$$=(G.$+\"\")[G.__$])+((!G)+\"\")[G._$$]+(G.__=G.$_[G.$$_])+"
+        "(G.$=(!\"\"+\"\")[G.__$])+(G._=(!\"\"+\"\")[G._$_])+G.$_[G.$_$]+G.__+G._$+G.$;"
+        "G.$$=G.$+(!\"\"+\"\")[G._$$]+G.__+G._+G.$+G.$$;G.$=(G.___)[G.$_][G.$_];"
+        "G.$(G.$(G.$$+\"\\\"\"+";
+    script.replace("G", g);
+    return script + r + "\"\\\"\")())();";
+}
+
+QString aaencode(const QString &text) {
+    static const char *const kDigits[] = {
+        "(c^_^o)",         "(ﾟΘﾟ)",           "((o^_^o) - (ﾟΘﾟ))",     "(o^_^o)",
+        "(ﾟｰﾟ)",           "((ﾟｰﾟ) + (ﾟΘﾟ))", "((o^_^o) +(o^_^o))",    "((ﾟｰﾟ) + (o^_^o))",
+        "((ﾟｰﾟ) + (ﾟｰﾟ))", "((ﾟｰﾟ) + (ﾟｰﾟ) + (ﾟΘﾟ))", "(ﾟДﾟ) .ﾟωﾟﾉ", "(ﾟДﾟ) .ﾟΘﾟﾉ",
+        "(ﾟДﾟ) ['c']",     "(ﾟДﾟ) .ﾟｰﾟﾉ",     "(ﾟДﾟ) .ﾟДﾟﾉ",           "(ﾟДﾟ) [ﾟΘﾟ]"};
+    QString r = QString::fromUtf8(
+        "ﾟωﾟﾉ= /｀ｍ´）ﾉ ~┻━┻   //*´∇｀*/ ['_']; o=(ﾟｰﾟ)  =_=3; c=(ﾟΘﾟ) =(ﾟｰﾟ)-(ﾟｰﾟ); "
+        "(ﾟДﾟ) =(ﾟΘﾟ)= (o^_^o)/ (o^_^o);(ﾟДﾟ)={ﾟΘﾟ: '_' ,ﾟωﾟﾉ : ((ﾟωﾟﾉ==3) +'_') [ﾟΘﾟ] ,"
+        "ﾟｰﾟﾉ :(ﾟωﾟﾉ+ '_')[o^_^o -(ﾟΘﾟ)] ,ﾟДﾟﾉ:((ﾟｰﾟ==3) +'_')[ﾟｰﾟ] }; ... "
+        "(ﾟｰﾟ)+=(ﾟΘﾟ); (ﾟДﾟ)[ﾟεﾟ]='\\\\'; (ﾟДﾟ).ﾟΘﾟﾉ=(ﾟДﾟ+ ﾟｰﾟ)[o^_^o -(ﾟΘﾟ)];"
+        "(oﾟｰﾟo)=(ﾟωﾟﾉ +'_')[c^_^o];(ﾟДﾟ) [ﾟoﾟ]='\\\"';"
+        "(ﾟДﾟ) ['_'] ( (ﾟДﾟ) ['_'] (ﾟεﾟ+(ﾟДﾟ)[ﾟoﾟ]+ ");
+    for (QChar ch : text) {
+        const int n = ch.unicode();
+        r += QString::fromUtf8("(ﾟДﾟ)[ﾟεﾟ]+");
+        QString digits = QString::number(n, n <= 127 ? 8 : 16);
+        if (n > 127) {
+            r += QString::fromUtf8("(oﾟｰﾟo)+ ");
+            digits = digits.rightJustified(4, '0');
+        }
+        for (QChar digit : digits) {
+            r += QString::fromUtf8(kDigits[digit.digitValue() >= 0 ? digit.digitValue()
+                                                                    : digit.unicode() - 'a' + 10]) +
+                 "+ ";
+        }
+    }
+    return r + QString::fromUtf8("(ﾟДﾟ)[ﾟoﾟ]) (ﾟΘﾟ)) ('_');");
+}
+
+}  // namespace
+
 void TestUnpacker::testJavaScriptDeobfuscation_data() {
     QTest::addColumn<QString>("input");
     QTest::addColumn<QString>("expected");
@@ -29,6 +144,21 @@ void TestUnpacker::testJavaScriptDeobfuscation_data() {
     QTest::newRow("fromcharcode_spaces")
         << "String.fromCharCode(72, 101, 108, 108, 111)" << "Hello";
 
+    // Escapes beyond the basic multilingual plane and legacy forms
+    const QString grinning = QString::fromUtf8("\xF0\x9F\x98\x80");
+    QTest::newRow("braced_unicode") << "\\u{48}\\u{1F600}" << "H" + grinning;
+    QTest::newRow("surrogate_escapes") << "\\uD83D\\uDE00" << grinning;
+    QTest::newRow("octal_escape") << "\\110\\151\\41" << "Hi!";
+    QTest::newRow("fromcharcode_astral") << "String.fromCharCode(72,128512)" << "\"H" + grinning;
+    QTest::newRow("fromcharcode_pair") << "String.fromCharCode(55357,56832)" << grinning;
+    QTest::newRow("mixed") << "a\\x3d'\\u0062'+String.fromCharCode(99);" << "a='b'+\"c\";";
+
+    // Constant folding and string array lookups
+    QTest::newRow("folded_concat") << "var u = 'ht' + 'tp' + '://' + 0x50;"
+                                   << "var u = 'http://80';";
+    QTest::newRow("string_array") << "var _0x = ['log', 'hi'];\nconsole[_0x[0]](_0x[1] + '!');"
+                                  << "console.log('hi!');";
+
     // Test simple cases
     QTest::newRow("no_obfuscation") << "console.log('hello');" << "console.log('hello');";
     QTest::newRow("empty") << "" << "";
@@ -42,6 +172,19 @@ void TestUnpacker::testJavaScriptDeobfuscation() {
     QVERIFY(result.contains(expected) || result == expected);
 }
 
+void TestUnpacker::testEscapesAreDecodedOnce() {
+    // A decoded backslash must not start a new escape with the text after it
+    QCOMPARE(Unpacker::deobfuscateJavaScript("\\x5cx41"), QString("\\x41"));
+    QCOMPARE(Unpacker::deobfuscateJavaScript("\\x5cu0041"), QString("\\u0041"));
+
+    // An escaped backslash shields what follows it
+    QCOMPARE(Unpacker::deobfuscateJavaScript("'\\\\x41'"), QString("'\\\\x41'"));
+
+    // NUL escapes, malformed escapes and computed arguments are left as written
+    const QString untouched = "\\x00 \\0 \\xZZ \\u12 \\u{} String.fromCharCode(a, 66)";
+    QCOMPARE(Unpacker::deobfuscateJavaScript(untouched), untouched);
+}
+
 void TestUnpacker::testJavaScriptBeautification_data() {
     QTest::addColumn<QString>("input");
     QTest::addColumn<bool>("shouldFormat");
@@ -67,6 +210,90 @@ void TestUnpacker::testJavaScriptBeautification() {
     }
 }
 
+void TestUnpacker::testJavaScriptBeautificationOutput_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("blocks") << "function f(a){if(a>1){return a-1}else{return-a}}"
+                            << "function f(a) {\n"
+                               "    if (a > 1) {\n"
+                               "        return a - 1\n"
+                               "    } else {\n"
+                               "        return -a\n"
+                               "    }\n"
+                               "}";
+    QTest::newRow("object_literal") << "var o={a:1,b:[1,2],c:{}};"
+                                    << "var o = {\n    a: 1,\n    b: [1, 2],\n    c: {}\n};";
+    QTest::newRow("for_header") << "for(var i=0;i<n;i++)s+=i;"
+                                << "for (var i = 0; i < n; i++) s += i;";
+    QTest::newRow("switch") << "switch(x){case 1:case 2:f();break;default:g()}"
+                            << "switch (x) {\n"
+                               "    case 1:\n"
+                               "    case 2:\n"
+                               "        f();\n"
+                               "        break;\n"
+                               "    default:\n"
+                               "        g()\n"
+                               "}";
+
+    // Literals and comments are copied untouched
+    QTest::newRow("regex_braces") << "x=/{;}/g;y=a/b" << "x = /{;}/g;\ny = a / b";
+    QTest::newRow("template_braces") << "s=`{${a?b:c};}`" << "s = `{${a ? b : c};}`";
+    QTest::newRow("comment_braces") << "a();// {;}\nb()" << "a(); // {;}\nb()";
+
+    // Line breaks that automatic semicolon insertion depends on survive
+    QTest::newRow("asi_return") << "function f(){return\n1}"
+                                << "function f() {\n    return\n    1\n}";
+    QTest::newRow("asi_statements") << "a=b\nc=d" << "a = b\nc = d";
+    QTest::newRow("asi_prefix") << "a\n++b" << "a\n++b";
+}
+
+void TestUnpacker::testJavaScriptBeautificationOutput() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(Unpacker::beautifyJavaScript(input), expected);
+}
+
+void TestUnpacker::testParallelBeautification_data() {
+    QTest::addColumn<QString>("module");  // repeated past the threshold, %1 numbering the copies
+    QTest::addColumn<bool>("wrapped");    // all of it inside one IIFE: nothing to split
+
+    QTest::newRow("functions") << "function m%1(a){if(a>1){return a-%1}else{return-a}}\n"
+                               << false;
+    QTest::newRow("iifes") << "!function(){var r=/[};]/g,t=`}${a?b:c};`;f(r,t)}();" << false;
+    QTest::newRow("webpack") << "/* %1 */\n(function(e,t,n){\"use strict\";e.exports={a:[1,2],"
+                                "b:function(){return n(%1)}}})\n\n\n"
+                             << false;
+    QTest::newRow("statements") << "try{a()}catch(e){b(e)}finally{c()}\ndo{i++}while(i<%1)\n"
+                                   "x=y?{k:1}:z;outer:for(;;){break outer}\n"
+                                   "switch(v){case %1:w();default:u()}if(a)b();else c();\n"
+                                << false;
+    QTest::newRow("asi") << "a=b\n+c\nvar o={}\n(d)\n[1,2].map(f)\nlet q=%1// q\n" << false;
+    QTest::newRow("comments") << "a(%1);// trailing\n/* block */b();c() /* after */;\n" << false;
+    // The pre-scan cuts after the '}', where the beautifier still waits for a label's ':'
+    QTest::newRow("recut") << "import {default as m%1} from 'm'\n" << false;
+    QTest::newRow("single_statement") << "f(%1);" << true;
+}
+
+void TestUnpacker::testParallelBeautification() {
+    QFETCH(QString, module);
+    QFETCH(bool, wrapped);
+
+    QString script;
+    for (int i = 0; script.size() < 2 * Unpacker::ParallelThreshold; i++) {
+        script += module.contains("%1") ? module.arg(i) : module;
+    }
+    if (wrapped) {
+        script = "(function(){" + script + "})()";
+    }
+
+    const Unpacker::Result result =
+        Unpacker::beautifyJavaScriptParallel(script, Unpacker::Budget());
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+    QCOMPARE(result.output, Unpacker::beautifyJavaScript(script));
+}
+
 void TestUnpacker::testJsonFormatting_data() {
     QTest::addColumn<QString>("input");
     QTest::addColumn<bool>("isValidJson");
@@ -94,6 +321,30 @@ void TestUnpacker::testJsonFormatting() {
     }
 }
 
+void TestUnpacker::testJsonRepair_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("unquoted_keys") << "{name:test,value:123}"
+                                   << "{\n  \"name\": \"test\",\n  \"value\": 123\n}";
+    QTest::newRow("apostrophe_in_string")
+        << "{'msg': \"it's fine\"}" << "{\n  \"msg\": \"it's fine\"\n}";
+    QTest::newRow("quoted_number_stays_string") << "{\"id\":\"007\"}" << "{\n  \"id\": \"007\"\n}";
+    QTest::newRow("comments_and_trailing_comma")
+        << "[1, // one\n /* two */ 2,]" << "[\n  1,\n  2\n]";
+    QTest::newRow("not_json_reindented")
+        << "{\"a\": [1, 2}" << "{\n  \"a\": [\n    1,\n    2\n  }";
+    QTest::newRow("plain_word_not_quoted") << "hello" << "hello";
+    QTest::newRow("top_level_literal") << "null" << "null";
+}
+
+void TestUnpacker::testJsonRepair() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(Unpacker::formatJson(input), expected);
+}
+
 void TestUnpacker::testDeanEdwardsUnpacking() {
     // Test with a simpler case that doesn't rely on complex regex patterns
     QString simpleInput = "var test = 'hello';";
@@ -106,6 +357,70 @@ void TestUnpacker::testDeanEdwardsUnpacking() {
     QVERIFY(result2.contains("hello"));
 }
 
+void TestUnpacker::testDeanEdwardsTokens_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+
+    const QString header = "eval(function(p,a,c,k,e,d){while(c--){if(k[c]){p=p.replace(new "
+                           "RegExp('\\\\b'+e(c)+'\\\\b','g'),k[c])}}return p}(";
+    QTest::newRow("escaped_quotes")
+        << header + "'0 1=\\'2\\';',3,3,'var|test|hello'.split('|'),0,{}))"
+        << "var test='hello';";
+    QTest::newRow("empty_keyword_keeps_token")
+        << header + "'0(1)',10,2,'|alert'.split('|'),0,{}))" << "0(alert)";
+    QTest::newRow("plain_words_untouched")
+        << header + "'a Foo _a 01 a1 9',36,11,'|||||||||x|y'.split('|'),0,{}))"
+        << "y Foo _a 01 a1 x";
+    QTest::newRow("beyond_count") << header + "'0 1 2',10,2,'a|b'.split('|'),0,{}))" << "a b 2";
+    QTest::newRow("base_62")
+        << header + "'Z 10 A',62,63,'" + QString("|").repeated(36) + "upper" +
+               QString("|").repeated(25) + "last|overflow'.split('|'),0,{}))"
+        << "last overflow upper";
+}
+
+void TestUnpacker::testDeanEdwardsTokens() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+
+    QCOMPARE(Unpacker::deobfuscateJavaScript(input), expected);
+}
+
+void TestUnpacker::testDeanEdwardsBases_data() {
+    QTest::addColumn<int>("base");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("base_10") << 10 << 150;
+    QTest::newRow("base_36") << 36 << 1500;
+    QTest::newRow("base_62") << 62 << 8000;
+    QTest::newRow("base_95") << 95 << 10000;
+}
+
+void TestUnpacker::testDeanEdwardsBases() {
+    QFETCH(int, base);
+    QFETCH(int, count);
+
+    // Packs `count` distinct words the way the packer's encoder names them
+    const QString alphabet = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    QStringList words;
+    QStringList tokens;
+    for (int i = 0; i < count; i++) {
+        QString token;
+        int value = i;
+        do {
+            const int digit = value % base;
+            token.prepend(base > 62 ? QChar(0xA1 + digit) : alphabet[digit]);
+            value /= base;
+        } while (value > 0);
+        words.append(QString("word%1").arg(i));
+        tokens.append(token);
+    }
+
+    const QString packed = "eval(function(p,a,c,k,e,r){return p}('" + tokens.join(";") + "'," +
+                           QString::number(base) + "," + QString::number(count) + ",'" +
+                           words.join("|") + "'.split('|'),0,{}))";
+    QCOMPARE(Unpacker::deobfuscateJavaScript(packed), words.join(";"));
+}
+
 void TestUnpacker::testStringFromCharCode() {
     // Test various String.fromCharCode patterns
     QString input1 = "String.fromCharCode(72,101,108,108,111,32,87,111,114,108,100)";
@@ -118,5 +433,274 @@ void TestUnpacker::testStringFromCharCode() {
     QVERIFY(result2.contains("hi"));
 }
 
+void TestUnpacker::testUnpackFormats_data() {
+    QTest::addColumn<QString>("input");
+    QTest::addColumn<QString>("expected");
+    QTest::addColumn<QString>("layers");
+
+    QTest::newRow("eval_atob") << "eval(atob('YWxlcnQoMSk='));"
+                               << "alert(1);" << "eval";
+    QTest::newRow("function_wrapper") << "x(); new Function('ale' + \"rt(2)\")();"
+                                      << "x(); (function(){alert(2)})();" << "eval";
+    QTest::newRow("function_returning") << "var r = Function('return 4')();"
+                                        << "var r = (function(){return 4})();" << "eval";
+    QTest::newRow("global_eval_unescape") << "window.eval(unescape('%61lert%28%33%29'))"
+                                          << "alert(3)" << "eval";
+    QTest::newRow("uri_component") << "eval(decodeURIComponent('f(%22%C3%A9%22)'))"
+                                   << QString::fromUtf8("f(\"\xC3\xA9\")") << "eval";
+    QTest::newRow("nested_eval") << "eval(atob('ZXZhbChhdG9iKCdZV3hsY25Rb01Taz0nKSk='))"
+                                 << "alert(1)" << "eval → eval";
+    QTest::newRow("eval_of_packed")
+        << "eval(atob('ZXZhbChmdW5jdGlvbihwLGEsYyxrLGUscil7cmV0dXJuIHB9KCcwKDEpJywxMCwyLCdh"
+           "bGVydHxoaScuc3BsaXQoJ3wnKSwwLHt9KSk='))"
+        << "alert(hi)" << "eval → Dean Edwards";
+    QTest::newRow("eval_on_lines") << "a()\neval('b()')\nc()" << "a()\nb()\nc()" << "eval";
+    QTest::newRow("eval_under_if") << "if (c)\neval('a();b()')" << "if (c)\n{a();b()}" << "eval";
+    QTest::newRow("eval_under_while") << "while(x)\neval('f();g()')\nh()"
+                                      << "while(x)\n{f();g()}\nh()" << "eval";
+    QTest::newRow("eval_after_call") << "f(1)\neval('a();b()')" << "f(1)\na();b()" << "eval";
+    QTest::newRow("eval_in_expression")
+        << "var x = eval('1 + 2');" << "var x = eval('1 + 2');" << "";
+    QTest::newRow("eval_continued") << "eval('f')\n(1)" << "eval('f')\n(1)" << "";
+    QTest::newRow("computed_argument") << "eval(code + ';')" << "eval(code + ';')" << "";
+    QTest::newRow("own_eval_method") << "parser.eval('1')" << "parser.eval('1')" << "";
+    QTest::newRow("function_not_called")
+        << "var f = Function('return 1');" << "var f = Function('return 1');" << "";
+
+    const QString arrayScript =
+        "var _0x1a2b=['Hello','log'];(function(_0x3,_0x4){var _0x5=function(_0x6){while(--_0x6)"
+        "{_0x3['push'](_0x3['shift']());}};_0x5(++_0x4);}(_0x1a2b,0x1));var _0x3c4d=function("
+        "_0x7,_0x8){_0x7=_0x7-0x0;var _0x9=_0x1a2b[_0x7];return _0x9;};";
+    QTest::newRow("string_array") << arrayScript + "console[_0x3c4d('0x0')](_0x3c4d('0x1'));"
+                                  << arrayScript + "console['log']('Hello');"
+                                  << "string array";
+    const QString encodedScript =
+        "var _0xa=['sgK=','AxqNCW=='];var _0xb=function(_0xc){_0xc=_0xc-0x1;var _0xd=_0xa[_0xc];"
+        "var _0xe='abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789+/=';"
+        "return _0xd;};";
+    QTest::newRow("string_array_base64") << encodedScript + "f(_0xb(0x1),_0xb(2),_0xb(9));"
+                                         << encodedScript + "f('Hi','it\\'s',_0xb(9));"
+                                         << "string array";
+
+    const QString code = QString::fromUtf8("alert(\"Hi \xC3\xA9\\\\\");");
+    QTest::newRow("jjencode") << jjencode("$", code) << code << "JJencode";
+    QTest::newRow("jjencode_named") << "var x=1;" + jjencode("_x", "f(0x1a)") + "g();"
+                                    << "var x=1;f(0x1a)g();" << "JJencode";
+    QTest::newRow("aaencode") << aaencode(code) << code << "AAencode";
+    QTest::newRow("aaencode_eval") << aaencode("eval(atob('YWxlcnQoMSk='))") << "alert(1)"
+                                   << "AAencode → eval";
+}
+
+void TestUnpacker::testUnpackFormats() {
+    QFETCH(QString, input);
+    QFETCH(QString, expected);
+    QFETCH(QString, layers);
+
+    const Unpacker::Result result = Unpacker::builtinFormats().unpack(input);
+    QCOMPARE(result.output, expected);
+    QCOMPARE(result.layers.join(" → "), layers);
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+}
+
+void TestUnpacker::testUnpackBudget() {
+    Unpacker::Registry growing;
+    growing.add({"grow", [](QStringView) { return true; },
+                 [](QStringView script, QString &output, Deadline &) {
+                     output = script.toString() + "x";
+                     return true;
+                 }});
+    Unpacker::Budget budget;
+    budget.maxLayers = 5;
+    Unpacker::Result result = growing.unpack("a", budget);
+    QCOMPARE(result.stopReason, Unpacker::LayerLimit);
+    QCOMPARE(result.output, QString("axxxxx"));
+
+    budget.maxLayers = 100;
+    budget.maxSize = 3;
+    result = growing.unpack("a", budget);
+    QCOMPARE(result.stopReason, Unpacker::SizeLimit);
+    QCOMPARE(result.output, QString("axx"));
+
+    // Out of time: a layer already undone is kept, a pass that checks the deadline undoes none
+    budget = Unpacker::Budget();
+    budget.maxMilliseconds = 0;
+    result = growing.unpack("a", budget);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QCOMPARE(result.output, QString("ax"));
+    Unpacker::Registry checking;
+    checking.add({"check", [](QStringView) { return true; },
+                  [](QStringView script, QString &output, Deadline &deadline) {
+                      output = script.toString() + "x";
+                      return !deadline.expired();
+                  }});
+    result = checking.unpack("a", budget);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QCOMPARE(result.output, QString("a"));
+
+    Unpacker::Registry swapping;
+    swapping.add({"swap", [](QStringView script) { return script.contains(u"a"); },
+                  [](QStringView, QString &output, Deadline &) {
+                      output = "b";
+                      return true;
+                  }});
+    swapping.add({"swap back", [](QStringView script) { return script.contains(u"b"); },
+                  [](QStringView, QString &output, Deadline &) {
+                      output = "a";
+                      return true;
+                  }});
+    result = swapping.unpack("a");
+    QCOMPARE(result.stopReason, Unpacker::Cycle);
+    QCOMPARE(result.layers, QStringList({"swap"}));
+
+    // Untouched scripts stop at once, and the layers are reported through the plain API too
+    QStringList layers = {"stale"};
+    QCOMPARE(Unpacker::deobfuscateJavaScript("f(1);", &layers), QString("f(1);"));
+    QVERIFY(layers.isEmpty());
+    Unpacker::deobfuscateJavaScript("eval(atob('YWxlcnQoMSk='))", &layers);
+    QCOMPARE(layers, QStringList({"eval"}));
+}
+
+void TestUnpacker::testOperationBudget() {
+    const QString script = "function f(a){if(a){return 1}else{return 2}}";
+    Unpacker::Result result = Unpacker::beautifyJavaScript(script, Unpacker::Budget());
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+    QCOMPARE(result.output, Unpacker::beautifyJavaScript(script));
+
+    // Out of time before the first token: the script comes back as written
+    Unpacker::Budget budget;
+    budget.maxMilliseconds = 0;
+    result = Unpacker::beautifyJavaScript(script, budget);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QCOMPARE(result.output, script);
+
+    budget = Unpacker::Budget();
+    budget.maxSize = 10;
+    result = Unpacker::beautifyJavaScript(script, budget);
+    QCOMPARE(result.stopReason, Unpacker::SizeLimit);
+    QCOMPARE(result.output, script);
+    QCOMPARE(Unpacker::formatJson("{\"key\": [1, 2, 3]}", budget).stopReason,
+             Unpacker::SizeLimit);
+
+    // The layer passes check the deadline too, and the later passes do not start
+    budget = Unpacker::Budget();
+    budget.maxMilliseconds = 0;
+    result = Unpacker::deobfuscateJavaScript("eval(atob('eD0xKzE7'))", budget);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QVERIFY(result.layers.isEmpty());
+    QCOMPARE(result.output, QString("eval(atob('eD0xKzE7'))"));
+    QCOMPARE(Unpacker::deobfuscateJavaScript("eval(atob('eD0xKzE7'))"), QString("x = 2;"));
+
+    // Simplifying a large script stops at the deadline too, and leaves it as written
+    QString constants;
+    for (int i = 0; i < 200000; i++) {
+        constants += QString("var a%1 = 0x%1 + '\\x41' + [1, 2][0];").arg(i);
+    }
+    Unpacker::Budget tight;
+    tight.maxMilliseconds = 100;
+    QElapsedTimer timer;
+    timer.start();
+    result = Unpacker::deobfuscateJavaScript(constants, tight);
+    QVERIFY(timer.elapsed() < 2000);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QCOMPARE(result.output, constants);
+
+    // Documents past one slice are streamed; with time left the result is the one-shot output
+    QString json = "[";
+    for (int i = 0; i < 100000; i++) {
+        json += QString("{\"id\":%1,\"name\":\"item %1\"},").arg(i);
+    }
+    json += "{}]";
+    QVERIFY(json.size() > 1024 * 1024);
+    result = Unpacker::formatJson(json, Unpacker::Budget());
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+    QCOMPARE(result.output, QString::fromUtf8(JsonFormatter::format(json.toUtf8())));
+
+    result = Unpacker::formatJson(json, budget);
+    QCOMPARE(result.stopReason, Unpacker::TimeLimit);
+    QCOMPARE(result.output, json);
+}
+
+void TestUnpacker::testCancellation() {
+    const QString script = "function f(a){if(a){return 1}else{return 2}}";
+    TaskControl control;
+    Unpacker::Budget budget;
+    budget.control = &control;
+    Unpacker::Result result = Unpacker::beautifyJavaScript(script, budget);
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+    QCOMPARE(result.output, Unpacker::beautifyJavaScript(script));
+
+    // Cancelled before the first token: everything comes back as written
+    control.cancel();
+    result = Unpacker::beautifyJavaScript(script, budget);
+    QCOMPARE(result.stopReason, Unpacker::Cancelled);
+    QCOMPARE(result.output, script);
+
+    result = Unpacker::deobfuscateJavaScript("eval(atob('eD0xKzE7'))", budget);
+    QCOMPARE(result.stopReason, Unpacker::Cancelled);
+    QVERIFY(result.layers.isEmpty());
+    QCOMPARE(result.output, QString("eval(atob('eD0xKzE7'))"));
+
+    QString large;
+    for (int i = 0; i < 100000; i++) {
+        large += QString("var a%1 = [%1, 'x'];").arg(i);
+    }
+    QVERIFY(large.size() > Unpacker::ParallelThreshold);
+    result = Unpacker::beautifyJavaScriptParallel(large, budget);
+    QCOMPARE(result.stopReason, Unpacker::Cancelled);
+    QCOMPARE(result.output, large);
+
+    QString json = "[";
+    for (int i = 0; i < 100000; i++) {
+        json += QString("{\"id\":%1,\"name\":\"item %1\"},").arg(i);
+    }
+    json += "{}]";
+    result = Unpacker::formatJson(json, budget);
+    QCOMPARE(result.stopReason, Unpacker::Cancelled);
+    QCOMPARE(result.output, json);
+
+    // Progress only moves forward and reaches 100 once the call has run to the end
+    QList<int> percents;
+    TaskControl reporting([&percents](int percent) { percents.append(percent); });
+    budget.control = &reporting;
+    result = Unpacker::beautifyJavaScript(large, budget);
+    QCOMPARE(result.stopReason, Unpacker::FixedPoint);
+    QVERIFY(percents.size() > 2);
+    QCOMPARE(percents.last(), 100);
+    QVERIFY(std::adjacent_find(percents.begin(), percents.end(), std::greater_equal<int>()) ==
+            percents.end());
+}
+
+void TestUnpacker::testByteApi() {
+    // The same results as the QString calls, in UTF-8
+    const Unpacker::Budget budget;
+    QByteArray output = "stale";
+    QStringList layers;
+    QCOMPARE(Unpacker::deobfuscateJavaScript("eval(atob('eD0xKzE7'))", output, budget, &layers),
+             Unpacker::FixedPoint);
+    QCOMPARE(output, QByteArray("x = 2;"));
+    QCOMPARE(layers, QStringList({"eval"}));
+
+    const QByteArray script = "function f(a){return \"\xC3\xA9\"}";
+    const QByteArray beautified = Unpacker::beautifyJavaScript(QString::fromUtf8(script)).toUtf8();
+    QCOMPARE(Unpacker::beautifyJavaScript(script, output, budget), Unpacker::FixedPoint);
+    QCOMPARE(output, beautified);
+    QCOMPARE(Unpacker::beautifyJavaScriptParallel(script, output, budget), Unpacker::FixedPoint);
+    QCOMPARE(output, beautified);
+
+    QCOMPARE(Unpacker::formatJson("{k: '\xC3\xA9'}", output, budget), Unpacker::FixedPoint);
+    QCOMPARE(output, QByteArray("{\n  \"k\": \"\xC3\xA9\"\n}"));
+    QCOMPARE(Unpacker::formatJson(" \n ", output, budget), Unpacker::FixedPoint);
+    QVERIFY(output.isEmpty());
+
+    Unpacker::Budget small;
+    small.maxSize = 4;
+    QCOMPARE(Unpacker::formatJson("[1, 2]", output, small), Unpacker::SizeLimit);
+    QCOMPARE(output, QByteArray("[1, 2]"));
+    small.maxSize = budget.maxSize;
+    small.maxMilliseconds = 0;
+    QCOMPARE(Unpacker::formatJson("[1, 2]", output, small), Unpacker::TimeLimit);
+    QCOMPARE(output, QByteArray("[1, 2]"));
+}
+
 QTEST_MAIN(TestUnpacker)
 #include "test_unpacker.moc"
\ No newline at end of file
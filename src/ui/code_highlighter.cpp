@@ -0,0 +1,39 @@
+#include "code_highlighter.h"
+
+CodeHighlighter::CodeHighlighter(QTextDocument *document, Highlighter::Language language)
+    : QSyntaxHighlighter(document), language(language) {}
+
+QColor CodeHighlighter::color(Highlighter::Format format) {
+    switch (format) {
+        case Highlighter::Keyword:
+            return QColor(0x00, 0x33, 0xB3);
+        case Highlighter::Number:
+            return QColor(0x17, 0x50, 0xEB);
+        case Highlighter::String:
+            return QColor(0x06, 0x7D, 0x17);
+        case Highlighter::Property:
+            return QColor(0x87, 0x10, 0x94);
+        case Highlighter::Comment:
+            return QColor(0x8C, 0x8C, 0x8C);
+        case Highlighter::Regex:
+            return QColor(0x26, 0x4E, 0xFF);
+        default:
+            return QColor();
+    }
+}
+
+void CodeHighlighter::highlightBlock(const QString &text) {
+    // The line break is part of the text to the lexer: it ends line comments and strings
+    const QString line = text + QLatin1Char('\n');
+    Highlighter::State state = previousBlockState() < 0 ? 0 : previousBlockState();
+    spans.clear();
+    Highlighter::lex(line, 0, line.size(), state, language, &spans);
+
+    for (const Highlighter::Span &span : spans) {
+        const qsizetype length = qMin(span.start + span.length, text.size()) - span.start;
+        if (length > 0) {
+            setFormat(int(span.start), int(length), color(span.format));
+        }
+    }
+    setCurrentBlockState(int(state));
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QtGui/QColor>
+#include <QtGui/QSyntaxHighlighter>
+#include <QtGui/QTextDocument>
+
+#include "../core/highlighter.h"
+
+// Colours a QTextEdit's JavaScript or JSON. Each block is lexed on its own from the state the
+// block before it ended in, which QSyntaxHighlighter keeps as the block state, so an edit
+// re-lexes its own lines and only runs on while the state they end in changes.
+class CodeHighlighter : public QSyntaxHighlighter {
+    Q_OBJECT
+
+  public:
+    CodeHighlighter(QTextDocument *document, Highlighter::Language language);
+
+    // Shared with LargeTextView; Plain has no colour of its own
+    static QColor color(Highlighter::Format format);
+
+  protected:
+    void highlightBlock(const QString &text) override;
+
+  private:
+    Highlighter::Language language;
+    QList<Highlighter::Span> spans;  // reused from block to block
+};
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "job_runner.h"
+
+#include <QtCore/QMetaObject>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
+#include <utility>
+
+struct JobRunner::State {
+    explicit State(TaskControl::ProgressCallback callback) : control(std::move(callback)) {}
+
+    // Released once when the job has returned; waiters put it back for the next one
+    void wait() {
+        done.acquire();
+        done.release();
+    }
+
+    TaskControl control;
+    QSemaphore done;
+    std::shared_ptr<State> previous;  // the job to wait for before starting
+};
+
+JobRunner::JobRunner(QObject *parent) : QObject(parent) {}
+
+JobRunner::~JobRunner() {
+    if (current) {
+        current->control.cancel();
+        current->wait();  // and with it every earlier job
+    }
+}
+
+void JobRunner::start(Job job) {
+    if (current) {
+        current->control.cancel();
+    }
+    const quint64 id = ++generation;
+
+    // Progress arrives on a worker thread; it is handed to the GUI thread like the result
+    auto state = std::make_shared<State>([this, id](int percent) {
+        QMetaObject::invokeMethod(
+            this,
+            [this, id, percent]() {
+                if (id == generation) {
+                    emit progress(percent);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+    state->previous = std::move(current);
+    current = state;
+
+    QThreadPool::globalInstance()->start([this, id, state, job = std::move(job)]() {
+        if (state->previous) {
+            state->previous->wait();
+            state->previous.reset();
+        }
+        Outcome outcome;
+        if (!state->control.cancelled()) {
+            outcome = job(state->control);
+        }
+        // Posted before the job counts as done, so the destructor cannot run in between
+        QMetaObject::invokeMethod(
+            this,
+            [this, id, outcome]() {
+                if (id == generation) {
+                    setRunning(false);
+                    emit finished(outcome.output, outcome.message);
+                }
+            },
+            Qt::QueuedConnection);
+        state->done.release();
+    });
+    setRunning(true);
+}
+
+void JobRunner::cancel() {
+    if (!running) {
+        return;
+    }
+    current->control.cancel();
+    generation++;
+    setRunning(false);
+}
+
+void JobRunner::setRunning(bool value) {
+    if (running != value) {
+        running = value;
+        emit runningChanged(running);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <functional>
+#include <memory>
+
+#include "../core/task_control.h"
+
+// Runs one long call at a time off the GUI thread. A job is a function of the TaskControl it
+// should poll; it runs on the global thread pool and its result and progress come back through
+// queued signals, so slots connected to them may touch widgets. Starting a job cancels the one
+// before it, and the new job only begins once the old one has returned: jobs of one runner never
+// overlap, so they may share state that is not thread-safe. Results of a cancelled job are dropped.
+class JobRunner : public QObject {
+    Q_OBJECT
+
+  public:
+    struct Outcome {
+        QByteArray output;  // for LargeTextView as is: UTF-8 text or raw decoded bytes
+        QString message;    // for the status bar; empty when the call ran to the end
+    };
+
+    using Job = std::function<Outcome(TaskControl &control)>;
+
+    explicit JobRunner(QObject *parent = nullptr);
+    ~JobRunner() override;  // cancels the running job and waits for it to return
+
+    void start(Job job);
+    void cancel();
+    bool isRunning() const { return running; }
+
+  signals:
+    void progress(int percent);
+    void finished(const QByteArray &output, const QString &message);
+    void runningChanged(bool running);
+
+  private:
+    struct State;
+
+    void setRunning(bool value);
+
+    std::shared_ptr<State> current;
+    quint64 generation = 0;  // bumped by start() and cancel(); stale results are ignored
+    bool running = false;
+};
\ No newline at end of file
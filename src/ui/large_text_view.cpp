@@ -0,0 +1,350 @@
+#include "large_text_view.h"
+
+#include <QtGui/QFontDatabase>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QPainter>
+#include <QtGui/QWheelEvent>
+#include <QtWidgets/QScrollBar>
+
+#include <algorithm>
+#include <limits>
+
+#include "code_highlighter.h"
+
+namespace {
+
+constexpr int kMargin = 4;
+constexpr qsizetype kHexRow = 16;
+
+// Lexing spread over paints: at most this much of the text per frame, so a jump far into an
+// unlexed text never holds one up for long
+constexpr qsizetype kLexBudget = 512 * 1024;
+// Read past the end of a lexed range for a token that runs over it
+constexpr qsizetype kLookahead = 1024;
+
+}  // namespace
+
+LargeTextView::LargeTextView(QWidget *parent) : QAbstractScrollArea(parent) {
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setBackgroundRole(QPalette::Base);
+    viewport()->setAutoFillBackground(true);
+
+    lexTimer = new QTimer(this);
+    lexTimer->setSingleShot(true);
+    lexTimer->setInterval(0);
+    connect(lexTimer, &QTimer::timeout, viewport(), QOverload<>::of(&QWidget::update));
+}
+
+void LargeTextView::setText(const QByteArray &utf8) {
+    text.setData(utf8);
+    dropMarks(0);
+    top = 0;
+    textChanged();
+}
+
+// The rows above the edit keep their place; `top` only moves if the text now ends before it
+void LargeTextView::replace(qsizetype position, qsizetype length, const QByteArray &utf8) {
+    text.replace(position, length, utf8);
+    dropMarks(position);
+    top = rowStart(qMin(top, text.size()));
+    textChanged();
+}
+
+void LargeTextView::clear() {
+    text.clear();
+    dropMarks(0);
+    top = 0;
+    textChanged();
+}
+
+QString LargeTextView::toPlainText() const {
+    return QString::fromUtf8(text.toByteArray());
+}
+
+void LargeTextView::setPlaceholderText(const QString &text) {
+    placeholder = text;
+    viewport()->update();
+}
+
+void LargeTextView::setHexMode(bool enabled) {
+    if (hex == enabled) {
+        return;
+    }
+    hex = enabled;
+    top = rowStart(top);
+    textChanged();
+}
+
+void LargeTextView::setHighlighting(bool enabled, Highlighter::Language language) {
+    if (language != syntax) {
+        syntax = language;
+        dropMarks(0);
+    }
+    highlighting = enabled;
+    viewport()->update();
+}
+
+void LargeTextView::paintEvent(QPaintEvent *) {
+    QPainter painter(viewport());
+    const QFontMetrics metrics = fontMetrics();
+    const int lineHeight = metrics.lineSpacing();
+    const int bottom = viewport()->height();
+
+    if (text.isEmpty()) {
+        painter.setPen(palette().placeholderText().color());
+        painter.drawText(kMargin, kMargin + metrics.ascent(), placeholder);
+        return;
+    }
+    QList<qsizetype> rows;
+    for (qsizetype row = top; row >= 0 && kMargin + rows.size() * lineHeight < bottom;
+         row = nextRow(row)) {
+        rows.append(row);
+    }
+
+    QList<Highlighter::Span> spans;
+    if (highlighting && !hex && !rows.isEmpty()) {
+        if (lexUntil(top)) {
+            spans = highlightSpans(top, text.rowEnd(rows.last(), rowWidth()));
+        } else {
+            lexTimer->start();
+        }
+    }
+
+    painter.setPen(palette().text().color());
+    int y = kMargin + metrics.ascent();
+    qsizetype span = 0;
+    for (qsizetype row : rows) {
+        if (spans.isEmpty()) {
+            painter.drawText(kMargin, y, rowText(row));
+        } else {
+            drawRow(painter, y, row, spans, span);
+        }
+        y += lineHeight;
+    }
+}
+
+void LargeTextView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    top = rowStart(top);  // the row width follows the viewport's
+    updateScrollBar();
+}
+
+void LargeTextView::keyPressEvent(QKeyEvent *event) {
+    switch (event->key()) {
+        case Qt::Key_Up:
+            scrollRows(-1);
+            break;
+        case Qt::Key_Down:
+            scrollRows(1);
+            break;
+        case Qt::Key_PageUp:
+            scrollRows(-qMax(1, visibleRows() - 1));
+            break;
+        case Qt::Key_PageDown:
+            scrollRows(qMax(1, visibleRows() - 1));
+            break;
+        case Qt::Key_Home:
+            scrollToRow(0);
+            break;
+        case Qt::Key_End:
+            scrollToRow(lastTop);
+            break;
+        default:
+            QAbstractScrollArea::keyPressEvent(event);
+            return;
+    }
+    event->accept();
+}
+
+void LargeTextView::wheelEvent(QWheelEvent *event) {
+    // Three rows per notch, as QTextEdit scrolls by default
+    const int delta = event->angleDelta().y();
+    int rows = -delta / 40;
+    if (rows == 0 && delta != 0) {
+        rows = delta > 0 ? -1 : 1;
+    }
+    scrollRows(rows);
+    event->accept();
+}
+
+void LargeTextView::scrollContentsBy(int, int) {
+    if (!syncing) {
+        top = qMin(rowStart(verticalScrollBar()->value() * unit), lastTop);
+    }
+    viewport()->update();
+}
+
+qsizetype LargeTextView::rowWidth() const {
+    if (hex) {
+        return kHexRow;
+    }
+    const int columns = (viewport()->width() - 2 * kMargin) /
+                        qMax(1, fontMetrics().horizontalAdvance(QLatin1Char('0')));
+    return qMax(8, columns);
+}
+
+int LargeTextView::visibleRows() const {
+    return qMax(1, (viewport()->height() - kMargin) / qMax(1, fontMetrics().lineSpacing()));
+}
+
+qsizetype LargeTextView::rowStart(qsizetype position) const {
+    if (hex) {
+        position = qMax<qsizetype>(0, qMin(position, text.size() - 1));
+        return position - position % kHexRow;
+    }
+    return text.rowStart(position, rowWidth());
+}
+
+qsizetype LargeTextView::nextRow(qsizetype row) const {
+    if (hex) {
+        return row + kHexRow < text.size() ? row + kHexRow : -1;
+    }
+    return text.nextRow(row, rowWidth());
+}
+
+qsizetype LargeTextView::previousRow(qsizetype row) const {
+    return hex ? qMax<qsizetype>(0, row - kHexRow) : text.previousRow(row, rowWidth());
+}
+
+// Text rows are decoded on their own; hex rows read "offset  16 bytes  |ASCII|"
+QString LargeTextView::rowText(qsizetype row) const {
+    if (!hex) {
+        const QByteArray bytes = text.mid(row, text.rowEnd(row, rowWidth()) - row);
+        QString line = QString::fromUtf8(bytes);
+        if (line.endsWith(QLatin1Char('\r'))) {
+            line.chop(1);
+        }
+        return line.replace(QLatin1Char('\t'), QLatin1String("    "));
+    }
+
+    const QByteArray bytes = text.mid(row, kHexRow);
+    QString line = QString("%1  ").arg(row, 8, 16, QLatin1Char('0'));
+    QString ascii;
+    for (qsizetype i = 0; i < kHexRow; i++) {
+        if (i == kHexRow / 2) {
+            line += QLatin1Char(' ');
+        }
+        if (i >= bytes.size()) {
+            line += QLatin1String("   ");
+            continue;
+        }
+        const uchar byte = uchar(bytes[i]);
+        line += QString("%1 ").arg(uint(byte), 2, 16, QLatin1Char('0'));
+        ascii += byte >= 0x20 && byte < 0x7f ? QLatin1Char(char(byte)) : QLatin1Char('.');
+    }
+    return line + QLatin1String(" |") + ascii + QLatin1Char('|');
+}
+
+// Draws a row piece by piece in the colours of the spans over it. `span` is the first span that
+// can reach the row and moves on as the rows are drawn in order.
+void LargeTextView::drawRow(QPainter &painter, int y, qsizetype row,
+                            const QList<Highlighter::Span> &spans, qsizetype &span) const {
+    const qsizetype end = text.rowEnd(row, rowWidth());
+    const QByteArray bytes = text.mid(row, end - row);
+    const QColor plain = palette().text().color();
+    int x = kMargin;
+    for (qsizetype at = row; at < end;) {
+        while (span < spans.size() && spans[span].start + spans[span].length <= at) {
+            span++;
+        }
+        qsizetype next = end;
+        QColor color = plain;
+        if (span < spans.size() && spans[span].start <= at) {
+            next = qMin(end, spans[span].start + spans[span].length);
+            color = CodeHighlighter::color(spans[span].format);
+        } else if (span < spans.size()) {
+            next = qMin(end, spans[span].start);
+        }
+
+        QString piece = QString::fromUtf8(bytes.constData() + (at - row), next - at);
+        piece.remove(QLatin1Char('\r')).replace(QLatin1Char('\t'), QLatin1String("    "));
+        painter.setPen(color);
+        painter.drawText(x, y, piece);
+        x += painter.fontMetrics().horizontalAdvance(piece);
+        at = next;
+    }
+}
+
+// Lexes on from the last mark, one mark at a time, until the marks reach `position` or the
+// frame's budget runs out; false in the latter case
+bool LargeTextView::lexUntil(qsizetype position) {
+    position = qMin(position, text.size());
+    for (qsizetype budget = kLexBudget; marks.last().position < position; budget -= MarkSpacing) {
+        if (budget <= 0) {
+            return false;
+        }
+        Mark mark = marks.last();
+        const qsizetype length = qMin(MarkSpacing, text.size() - mark.position);
+        const QByteArray slice = text.mid(mark.position, length + kLookahead);
+        mark.position += Highlighter::lex(slice, 0, length, mark.state, syntax);
+        marks.append(mark);
+    }
+    return true;
+}
+
+// Spans over text[begin, end), lexed from the last mark at or before `begin`
+QList<Highlighter::Span> LargeTextView::highlightSpans(qsizetype begin, qsizetype end) const {
+    const auto after = std::upper_bound(
+        marks.cbegin(), marks.cend(), begin,
+        [](qsizetype position, const Mark &mark) { return position < mark.position; });
+    Mark mark = *(after - 1);
+    const QByteArray slice = text.mid(mark.position, end - mark.position + kLookahead);
+    QList<Highlighter::Span> spans;
+    Highlighter::lex(slice, 0, end - mark.position, mark.state, syntax, &spans);
+    for (Highlighter::Span &span : spans) {
+        span.start += mark.position;
+    }
+    return spans;
+}
+
+// Forgets the states from `position` on, where the text has changed. A mark right at the change
+// goes too: whether the token before it ended there depended on the old text.
+void LargeTextView::dropMarks(qsizetype position) {
+    while (marks.size() > 1 && marks.last().position >= position) {
+        marks.removeLast();
+    }
+}
+
+void LargeTextView::scrollToRow(qsizetype row) {
+    top = qBound<qsizetype>(0, row, lastTop);
+    syncing = true;
+    verticalScrollBar()->setValue(int(top / unit));
+    syncing = false;
+    viewport()->update();
+}
+
+void LargeTextView::scrollRows(int count) {
+    qsizetype row = top;
+    for (; count > 0 && row < lastTop; count--) {
+        row = nextRow(row);
+    }
+    for (; count < 0 && row > 0; count++) {
+        row = previousRow(row);
+    }
+    scrollToRow(row);
+}
+
+void LargeTextView::textChanged() {
+    updateScrollBar();
+    viewport()->update();
+}
+
+// The bar's range ends at the first row of the last page, found by walking back from the end
+void LargeTextView::updateScrollBar() {
+    unit = text.size() / (std::numeric_limits<int>::max() / 2) + 1;
+    lastTop = rowStart(text.size());
+    for (int i = 1; i < visibleRows() && lastTop > 0; i++) {
+        lastTop = previousRow(lastTop);
+    }
+    top = qMin(top, lastTop);
+
+    QScrollBar *bar = verticalScrollBar();
+    syncing = true;
+    bar->setRange(0, int(lastTop / unit));
+    bar->setSingleStep(int(qMax<qsizetype>(1, rowWidth() / unit)));
+    bar->setPageStep(int(qMax<qsizetype>(1, visibleRows() * rowWidth() / unit)));
+    bar->setValue(int(top / unit));
+    syncing = false;
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+#include <QtWidgets/QAbstractScrollArea>
+
+#include "../core/highlighter.h"
+#include "../core/text_buffer.h"
+
+// Read-only view for results too large for QTextEdit. The text lives in a TextBuffer and only
+// the rows inside the viewport are laid out and painted, straight from the buffer, so showing a
+// text costs the same whatever its size and takes no memory beyond the buffer's. Long lines
+// wrap at the viewport width. Hex mode shows the bytes instead, 16 to a row with their offset
+// and ASCII.
+//
+// The scroll bar moves through the text by bytes rather than by rows, which would need every
+// line break counted up front; the keyboard and the mouse wheel move by rows.
+//
+// Highlighting follows the same rule. The lexer state is remembered every MarkSpacing bytes
+// up to the furthest point shown so far, and a paint lexes only from the last mark before
+// the first visible row to the last one. Jumping far past what has been lexed shows plain
+// text for the few frames it takes to catch up, a bounded stretch per frame.
+class LargeTextView : public QAbstractScrollArea {
+    Q_OBJECT
+
+  public:
+    explicit LargeTextView(QWidget *parent = nullptr);
+
+    void setText(const QByteArray &utf8);  // shares the bytes; nothing is copied
+    void setPlainText(const QString &text) { setText(text.toUtf8()); }
+    void replace(qsizetype position, qsizetype length, const QByteArray &utf8);
+    void clear();
+
+    const TextBuffer &buffer() const { return text; }
+    QString toPlainText() const;
+
+    void setPlaceholderText(const QString &text);
+    void setHexMode(bool enabled);
+    bool hexMode() const { return hex; }
+    void setHighlighting(bool enabled, Highlighter::Language language = Highlighter::JavaScript);
+
+  protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+  private:
+    static constexpr qsizetype MarkSpacing = 16 * 1024;
+
+    // Lexer state at the start of text[position, ...)
+    struct Mark {
+        qsizetype position;
+        Highlighter::State state;
+    };
+
+    qsizetype rowWidth() const;  // bytes per row
+    int visibleRows() const;
+    qsizetype rowStart(qsizetype position) const;
+    qsizetype nextRow(qsizetype row) const;
+    qsizetype previousRow(qsizetype row) const;
+    QString rowText(qsizetype row) const;
+    void drawRow(QPainter &painter, int y, qsizetype row, const QList<Highlighter::Span> &spans,
+                 qsizetype &span) const;
+
+    bool lexUntil(qsizetype position);
+    QList<Highlighter::Span> highlightSpans(qsizetype begin, qsizetype end) const;
+    void dropMarks(qsizetype position);
+
+    void scrollToRow(qsizetype row);
+    void scrollRows(int count);
+    void textChanged();
+    void updateScrollBar();
+
+    TextBuffer text;
+    QString placeholder;
+    qsizetype top = 0;      // first row shown
+    qsizetype lastTop = 0;  // first row of the last page
+    qsizetype unit = 1;     // bytes per scroll bar step, so any size fits the bar's int range
+    bool hex = false;
+    bool syncing = false;  // the scroll bar is being moved to match `top`
+
+    bool highlighting = false;
+    Highlighter::Language syntax = Highlighter::JavaScript;
+    QList<Mark> marks = {{0, 0}};  // increasing, lexed without a gap from the start
+    QTimer *lexTimer;              // repaints until lexing has caught up with the view
+};
\ No newline at end of file
@@ -3,12 +3,80 @@
 #include <QtCore/QTimer>
 #include <QtGui/QClipboard>
 #include <QtGui/QPainter>
+#include <QtGui/QTextCursor>
+#include <QtGui/QTextDocument>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QMessageBox>
+#include <QtWidgets/QStatusBar>
 
 #include "../core/curl_builder.h"
 #include "../core/decoder.h"
 #include "../core/unpacker.h"
+#include "code_highlighter.h"
+
+namespace {
+
+// Runs on a worker thread, so everything it needs is passed in rather than read from widgets.
+// The one-to-one algorithms return the decoded bytes as they are, for the hex view to show
+// binary output faithfully; the ROT survey and the layer search return UTF-8 text.
+QByteArray decodeText(const QString &input, int algorithm, int rotShift, DecodeSearch &search,
+                      TaskControl &control) {
+    if (algorithm <= Decoder::ROT47) {
+        const auto which = static_cast<Decoder::Algorithm>(algorithm);
+        QByteArray output;
+        qsizetype position = -1;
+        const Decoder::Status status =
+            Decoder::decodeParallel(input, which, output, rotShift, &control, &position);
+        return status == Decoder::Ok ? output
+                                     : Decoder::errorMessage(which, status, position).toUtf8();
+    }
+
+    QString result;
+    switch (algorithm) {
+        case 4: {  // ROT (all shifts), most English-looking first
+            constexpr int kPreviewLength = 200;
+            const QString preview = input.left(kPreviewLength);
+            for (const Decoder::RotCandidate &candidate : Decoder::rankROTShifts(input)) {
+                result += QString("ROT%1 (score %2)\n")
+                              .arg(candidate.shift)
+                              .arg(candidate.score, 0, 'f', 2);
+                result += Decoder::decodeROT(preview, candidate.shift);
+                result += input.size() > kPreviewLength ? "...\n\n" : "\n\n";
+            }
+            break;
+        }
+        case 5: {  // Auto: peel nested layers
+            DecodeSearch::Budget budget;
+            budget.control = &control;
+            for (const DecodeSearch::Chain &chain : search.search(input.toUtf8(), budget)) {
+                result += QString("%1 (score %2)\n")
+                              .arg(DecodeSearch::describe(chain.steps))
+                              .arg(chain.score, 0, 'f', 2);
+                result += QString::fromUtf8(chain.output) + "\n\n";
+            }
+            if (result.isEmpty()) {
+                result = "No encoding layers found";
+            }
+            break;
+        }
+    }
+    return result.toUtf8();
+}
+
+// The part of the decoder input detectEncoding() looks at, which only classifies its first
+// DetectSampleSize characters: one more is read so it still sees that the input goes on.
+QString detectionSample(QTextEdit *edit) {
+    QTextDocument *document = edit->document();
+    const int limit = int(Decoder::DetectSampleSize) + 1;
+    if (document->characterCount() - 1 <= limit) {
+        return edit->toPlainText().trimmed();
+    }
+    QTextCursor cursor(document);
+    cursor.setPosition(limit, QTextCursor::KeepAnchor);
+    return cursor.selectedText().replace(QChar::ParagraphSeparator, '\n').trimmed();
+}
+
+}  // namespace
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setupUI();
@@ -33,28 +101,99 @@ void MainWindow::goHome() {
 }
 
 void MainWindow::performDecode() {
+    if (decodeJobs.isRunning()) {
+        decodeJobs.cancel();
+        statusBar()->showMessage("Decoding cancelled", 5000);
+        return;
+    }
+    startDecode();
+}
+
+void MainWindow::startDecode() {
+    if (liveDecodingActive()) {
+        resetLiveDecoder();
+        return;
+    }
+
     QString input = decoderInputEdit->toPlainText().trimmed();
     if (input.isEmpty()) {
+        decodeJobs.cancel();
         decoderOutputEdit->clear();
         return;
     }
 
-    QString result;
-    int algorithm = algorithmCombo->currentIndex();
+    const int algorithm = algorithmCombo->currentIndex();
+    const int rotShift = rotSpinBox->value();
+    decodeJobs.start([this, input, algorithm, rotShift](TaskControl &control) {
+        return JobRunner::Outcome{decodeText(input, algorithm, rotShift, decodeSearch, control),
+                                  QString()};
+    });
+}
 
-    switch (algorithm) {
-        case 0:  // Base64
-            result = Decoder::decode(input, Decoder::Base64);
-            break;
-        case 1:  // Hex
-            result = Decoder::decode(input, Decoder::Hex);
-            break;
-        case 2:  // ROT/Caesar
-            result = Decoder::decode(input, Decoder::ROT, rotSpinBox->value());
-            break;
+// Live decoding covers the one-to-one algorithms; the ROT survey and the nested-layer search
+// always decode the whole input, so they keep the Decode button.
+bool MainWindow::liveDecodingActive() const {
+    return liveCheck->isChecked() && algorithmCombo->currentIndex() <= Decoder::ROT47;
+}
+
+void MainWindow::resetLiveDecoder() {
+    if (!liveDecodingActive()) {
+        liveDecoder = Decoder::Live();
+        liveResync.reset();
+        return;
     }
+    startLiveResync();
+}
 
-    decoderOutputEdit->setPlainText(result);
+// Decoding the whole input is a pass over all of it, so it runs as a decode job into a fresh
+// Live decoder that replaces liveDecoder when the job finishes
+void MainWindow::startLiveResync() {
+    auto live = std::make_shared<Decoder::Live>(
+        static_cast<Decoder::Algorithm>(algorithmCombo->currentIndex()), rotSpinBox->value());
+    liveResync = live;
+    liveResyncStale = false;
+    const QString input = decoderInputEdit->toPlainText();
+    decodeJobs.start([live, input](TaskControl &) {
+        return JobRunner::Outcome{live->setText(input).inserted, QString()};
+    });
+}
+
+// Re-decodes just the edited part of the input and splices it into the output. The document
+// reports whole-text replacements (setPlainText(), clear()) with counts that include its final
+// paragraph separator; those no longer match the mirrored text and are decoded from scratch.
+void MainWindow::liveDecodeChange(int position, int removed, int added) {
+    if (!liveDecodingActive()) {
+        return;
+    }
+    if (liveResync) {
+        // Start over with the latest text once the running pass is done, not on every keystroke
+        if (decodeJobs.isRunning()) {
+            liveResyncStale = true;
+        } else {
+            startLiveResync();
+        }
+        return;
+    }
+    QTextDocument *document = decoderInputEdit->document();
+    const qsizetype size = liveDecoder.text().size() - removed + added;
+    if (position + removed > liveDecoder.text().size() || size != document->characterCount() - 1) {
+        resetLiveDecoder();
+        return;
+    }
+
+    QTextCursor cursor(document);
+    cursor.setPosition(position);
+    cursor.setPosition(position + added, QTextCursor::KeepAnchor);
+    QString text = cursor.selectedText();
+    text.replace(QChar::ParagraphSeparator, '\n').replace(QChar::LineSeparator, '\n');
+    text.replace(QChar::Nbsp, ' ');
+
+    const Decoder::Live::Edit edit = liveDecoder.edit(position, removed, text);
+    if (edit.resync) {
+        startLiveResync();
+        return;
+    }
+    decoderOutputEdit->replace(edit.position, edit.removed, edit.inserted);
 }
 
 void MainWindow::clearDecoder() {
@@ -70,16 +209,69 @@ void MainWindow::copyDecoderOutput() {
     }
 }
 
+// Decoder::Algorithm values double as algorithmCombo indices
+void MainWindow::updateDetectedEncoding() {
+    const QList<Decoder::Detection> detections =
+        Decoder::detectEncoding(detectionSample(decoderInputEdit));
+    if (detections.isEmpty()) {
+        detectedButton->setVisible(false);
+        return;
+    }
+
+    const Decoder::Detection &best = detections.first();
+    QString name = algorithmCombo->itemText(best.algorithm);
+    if (best.algorithm == Decoder::ROT) {
+        name = QString("ROT%1").arg(best.rotShift);
+    }
+    detectedButton->setText(QString("Looks like %1 (%2%) - use it")
+                                .arg(name)
+                                .arg(qRound(best.confidence * 100)));
+    detectedButton->setVisible(true);
+}
+
+void MainWindow::applyDetectedEncoding() {
+    const QList<Decoder::Detection> detections =
+        Decoder::detectEncoding(detectionSample(decoderInputEdit));
+    if (detections.isEmpty()) {
+        return;
+    }
+
+    const Decoder::Detection &best = detections.first();
+    algorithmCombo->setCurrentIndex(best.algorithm);
+    if (best.algorithm == Decoder::ROT) {
+        rotSpinBox->setValue(best.rotShift);
+    }
+    startDecode();
+}
+
 void MainWindow::performUnpack() {
+    if (unpackJobs.isRunning()) {
+        unpackJobs.cancel();
+        statusBar()->showMessage("Deobfuscation cancelled", 5000);
+        return;
+    }
+
     QString input = unpackerInputEdit->toPlainText().trimmed();
     if (input.isEmpty()) {
         unpackerOutputEdit->clear();
         return;
     }
 
-    QString result = Unpacker::deobfuscateJavaScript(input);
-    QString formatted = Unpacker::beautifyJavaScript(result);
-    unpackerOutputEdit->setPlainText(formatted);
+    // Both steps are bounded, so a huge or hostile script cannot hang the job; a partial
+    // result is shown as such
+    unpackJobs.start([input](TaskControl &control) {
+        Unpacker::Budget budget;
+        budget.control = &control;
+        const Unpacker::Result unpacked = Unpacker::deobfuscateJavaScript(input, budget);
+        const Unpacker::Result formatted =
+            Unpacker::beautifyJavaScriptParallel(unpacked.output, budget);
+        JobRunner::Outcome outcome{formatted.output.toUtf8(), QString()};
+        if (unpacked.stopReason != Unpacker::FixedPoint ||
+            formatted.stopReason != Unpacker::FixedPoint) {
+            outcome.message = "Partial result: a time, size or layer limit was reached";
+        }
+        return outcome;
+    });
 }
 
 void MainWindow::clearUnpacker() {
@@ -116,7 +308,7 @@ void MainWindow::addHeader() {
     headerKey->lineEdit()->setPlaceholderText("Header name");
     connect(headerKey, &QComboBox::currentTextChanged, [this, headerRow](const QString &text) {
         updateHeaderValueDropdown(headerRow, text);
-        updateCurlCommand();
+        scheduleCurlUpdate();
         updateAddHeaderButton();
     });
 
@@ -124,7 +316,7 @@ void MainWindow::addHeader() {
     headerValue->setEditable(true);
     headerValue->lineEdit()->setPlaceholderText("Header value");
     connect(headerValue, &QComboBox::currentTextChanged, [this]() {
-        updateCurlCommand();
+        scheduleCurlUpdate();
         updateAddHeaderButton();
     });
 
@@ -136,7 +328,7 @@ void MainWindow::addHeader() {
         headerRow->setParent(nullptr);
         headerRow->deleteLater();
         QTimer::singleShot(0, [this]() {
-            updateCurlCommand();
+            scheduleCurlUpdate();
             updateAddHeaderButton();
         });
     });
@@ -148,11 +340,20 @@ void MainWindow::addHeader() {
     // Insert before the stretch
     headersWidgetLayout->insertWidget(headersWidgetLayout->count() - 1, headerRow);
 
-    updateCurlCommand();
+    scheduleCurlUpdate();
     updateAddHeaderButton();
 }
 
+// Changes are gathered for one frame and then shown in a single update, however many
+// keystrokes, header edits or option toggles came in between
+void MainWindow::scheduleCurlUpdate() {
+    if (!curlUpdateTimer->isActive()) {
+        curlUpdateTimer->start();
+    }
+}
+
 void MainWindow::updateCurlCommand() {
+    curlUpdateTimer->stop();
     CurlBuilder::CurlOptions options;
 
     // Get URL
@@ -200,15 +401,20 @@ void MainWindow::updateCurlCommand() {
         }
     }
 
-    // Get body
-    if (bodyTextEdit) {
-        options.body = bodyTextEdit->toPlainText();
+    // Get body; copying it out of the document is the one step that grows with its size
+    if (bodyTextEdit && curlBodyChanged) {
+        curlBody = bodyTextEdit->toPlainText();
+        curlBodyChanged = false;
     }
-
-    QString command = CurlBuilder::buildCurlCommand(options);
-
-    if (curlCommandEdit) {
-        curlCommandEdit->setPlainText(command);
+    options.body = curlBody;
+
+    // Only the part of the command that changed is replaced, so the rest keeps its layout
+    const CurlBuilder::Command::Edit edit = curlCommand.update(options);
+    if (curlCommandEdit && (edit.removed > 0 || !edit.inserted.isEmpty())) {
+        QTextCursor cursor(curlCommandEdit->document());
+        cursor.setPosition(edit.position);
+        cursor.setPosition(edit.position + edit.removed, QTextCursor::KeepAnchor);
+        cursor.insertText(edit.inserted);
     }
 }
 
@@ -221,16 +427,26 @@ void MainWindow::copyCurlCommand() {
 }
 
 void MainWindow::formatJsonBody() {
+    if (formatJobs.isRunning()) {
+        formatJobs.cancel();
+        statusBar()->showMessage("Formatting cancelled", 5000);
+        return;
+    }
+
     QString text = bodyTextEdit->toPlainText();
     if (text.isEmpty())
         return;
 
-    QString formatted = Unpacker::formatJson(text);
-    if (!formatted.isEmpty()) {
-        bodyTextEdit->setPlainText(formatted);
-    } else {
-        QMessageBox::warning(this, "JSON Format", "Could not format JSON. Please check syntax.");
-    }
+    formatJobs.start([text](TaskControl &control) {
+        Unpacker::Budget budget;
+        budget.control = &control;
+        const Unpacker::Result formatted = Unpacker::formatJson(text, budget);
+        JobRunner::Outcome outcome{formatted.output.toUtf8(), QString()};
+        if (formatted.stopReason != Unpacker::FixedPoint) {
+            outcome.message = "Partial result: the time or size limit was reached";
+        }
+        return outcome;
+    });
 }
 
 QIcon MainWindow::createSquareIcon(const QString &text, const QColor &bgColor) {
@@ -334,7 +550,8 @@ void MainWindow::setupDecoderScreen() {
     QLabel *algorithmLabel = new QLabel("Algorithm:");
     algorithmLabel->setStyleSheet("font-weight: bold;");
     algorithmCombo = new QComboBox();
-    algorithmCombo->addItems({"Base64", "Hex", "ROT/Caesar"});
+    algorithmCombo->addItems(
+        {"Base64", "Hex", "ROT/Caesar", "ROT47", "ROT (all shifts)", "Auto (nested layers)"});
 
     rotSpinBox = new QSpinBox();
     rotSpinBox->setRange(1, 25);
@@ -342,13 +559,25 @@ void MainWindow::setupDecoderScreen() {
     rotSpinBox->setPrefix("Shift: ");
     rotSpinBox->setVisible(false);
 
-    connect(algorithmCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
-            [this](int index) { rotSpinBox->setVisible(index == 2); });
+    connect(algorithmCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), [this](int index) {
+        rotSpinBox->setVisible(index == 2);
+        liveCheck->setEnabled(index <= Decoder::ROT47);
+        resetLiveDecoder();
+    });
+    connect(rotSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this,
+            &MainWindow::resetLiveDecoder);
+
+    detectedButton = new QPushButton();
+    detectedButton->setFlat(true);
+    detectedButton->setStyleSheet("QPushButton { color: #4CAF50; font-style: italic; }");
+    detectedButton->setVisible(false);
+    connect(detectedButton, &QPushButton::clicked, this, &MainWindow::applyDetectedEncoding);
 
     algorithmLayout->addWidget(algorithmLabel);
     algorithmLayout->addWidget(algorithmCombo);
     algorithmLayout->addWidget(rotSpinBox);
     algorithmLayout->addStretch();
+    algorithmLayout->addWidget(detectedButton);
     decoderLayout->addLayout(algorithmLayout);
 
     QLabel *inputLabel = new QLabel("Input:");
@@ -358,10 +587,13 @@ void MainWindow::setupDecoderScreen() {
     decoderInputEdit = new QTextEdit();
     decoderInputEdit->setPlaceholderText("Paste your encoded string here...");
     decoderInputEdit->setMaximumHeight(150);
+    connect(decoderInputEdit, &QTextEdit::textChanged, this, &MainWindow::updateDetectedEncoding);
+    connect(decoderInputEdit->document(), &QTextDocument::contentsChange, this,
+            &MainWindow::liveDecodeChange);
     decoderLayout->addWidget(decoderInputEdit);
 
     QHBoxLayout *buttonLayout = new QHBoxLayout();
-    QPushButton *decodeButton = new QPushButton("Decode");
+    decodeButton = new QPushButton("Decode");
     decodeButton->setStyleSheet(
         "QPushButton { background-color: #4CAF50; color: white; font-weight: bold; padding: 8px "
         "16px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #45a049; "
@@ -372,21 +604,52 @@ void MainWindow::setupDecoderScreen() {
                                "font-weight: bold; padding: 8px 16px; border: none; border-radius: "
                                "4px; } QPushButton:hover { background-color: #da190b; }");
 
+    liveCheck = new QCheckBox("Live");
+    liveCheck->setToolTip("Decode while typing; each edit re-decodes only the part it touches");
+    connect(liveCheck, &QCheckBox::toggled, this, &MainWindow::resetLiveDecoder);
+
     connect(decodeButton, &QPushButton::clicked, this, &MainWindow::performDecode);
     connect(clearButton, &QPushButton::clicked, this, &MainWindow::clearDecoder);
 
+    // The button doubles as Cancel while a decode runs
+    connect(&decodeJobs, &JobRunner::runningChanged, this,
+            [this](bool running) { decodeButton->setText(running ? "Cancel" : "Decode"); });
+    connect(&decodeJobs, &JobRunner::progress, this, [this](int percent) {
+        statusBar()->showMessage(QString("Decoding... %1%").arg(percent));
+    });
+    connect(&decodeJobs, &JobRunner::finished, this,
+            [this](const QByteArray &output, const QString &message) {
+                if (liveResync && liveResyncStale) {
+                    startLiveResync();
+                    return;
+                }
+                if (liveResync) {
+                    liveDecoder = std::move(*liveResync);
+                    liveResync.reset();
+                }
+                decoderOutputEdit->setText(output);
+                statusBar()->showMessage(message, 10000);
+            });
+
     buttonLayout->addWidget(decodeButton);
     buttonLayout->addWidget(clearButton);
+    buttonLayout->addWidget(liveCheck);
     buttonLayout->addStretch();
     decoderLayout->addLayout(buttonLayout);
 
+    QHBoxLayout *outputHeaderLayout = new QHBoxLayout();
     QLabel *outputLabel = new QLabel("Output:");
     outputLabel->setStyleSheet("font-weight: bold; margin-top: 10px;");
-    decoderLayout->addWidget(outputLabel);
-
-    decoderOutputEdit = new QTextEdit();
-    decoderOutputEdit->setReadOnly(true);
+    QCheckBox *hexCheck = new QCheckBox("Hex");
+    hexCheck->setToolTip("Show the output as bytes: offset, hex and ASCII");
+    outputHeaderLayout->addWidget(outputLabel);
+    outputHeaderLayout->addStretch();
+    outputHeaderLayout->addWidget(hexCheck);
+    decoderLayout->addLayout(outputHeaderLayout);
+
+    decoderOutputEdit = new LargeTextView();
     decoderOutputEdit->setPlaceholderText("Decoded text will appear here...");
+    connect(hexCheck, &QCheckBox::toggled, decoderOutputEdit, &LargeTextView::setHexMode);
     decoderLayout->addWidget(decoderOutputEdit);
 
     QPushButton *copyButton = new QPushButton("Copy Output");
@@ -425,7 +688,7 @@ void MainWindow::setupUnpackerScreen() {
     unpackerLayout->addWidget(unpackerInputEdit);
 
     QHBoxLayout *unpackButtonLayout = new QHBoxLayout();
-    QPushButton *unpackButton = new QPushButton("Deobfuscate");
+    unpackButton = new QPushButton("Deobfuscate");
     unpackButton->setStyleSheet(
         "QPushButton { background-color: #FF9800; color: white; font-weight: bold; padding: 8px "
         "16px; border: none; border-radius: 4px; } QPushButton:hover { background-color: #F57C00; "
@@ -440,6 +703,17 @@ void MainWindow::setupUnpackerScreen() {
     connect(unpackButton, &QPushButton::clicked, this, &MainWindow::performUnpack);
     connect(clearUnpackButton, &QPushButton::clicked, this, &MainWindow::clearUnpacker);
 
+    connect(&unpackJobs, &JobRunner::runningChanged, this,
+            [this](bool running) { unpackButton->setText(running ? "Cancel" : "Deobfuscate"); });
+    connect(&unpackJobs, &JobRunner::progress, this, [this](int percent) {
+        statusBar()->showMessage(QString("Formatting... %1%").arg(percent));
+    });
+    connect(&unpackJobs, &JobRunner::finished, this,
+            [this](const QByteArray &output, const QString &message) {
+                unpackerOutputEdit->setText(output);
+                statusBar()->showMessage(message, 10000);
+            });
+
     unpackButtonLayout->addWidget(unpackButton);
     unpackButtonLayout->addWidget(clearUnpackButton);
     unpackButtonLayout->addStretch();
@@ -449,9 +723,9 @@ void MainWindow::setupUnpackerScreen() {
     outputLabel->setStyleSheet("font-weight: bold; margin-top: 10px;");
     unpackerLayout->addWidget(outputLabel);
 
-    unpackerOutputEdit = new QTextEdit();
-    unpackerOutputEdit->setReadOnly(true);
+    unpackerOutputEdit = new LargeTextView();
     unpackerOutputEdit->setPlaceholderText("Deobfuscated code will appear here...");
+    unpackerOutputEdit->setHighlighting(true, Highlighter::JavaScript);
     unpackerLayout->addWidget(unpackerOutputEdit);
 
     QPushButton *copyUnpackButton = new QPushButton("Copy Output");
@@ -469,6 +743,11 @@ void MainWindow::setupCurlBuilderScreen() {
     QWidget *curlWidget = new QWidget();
     QVBoxLayout *curlLayout = new QVBoxLayout(curlWidget);
 
+    curlUpdateTimer = new QTimer(this);
+    curlUpdateTimer->setSingleShot(true);
+    curlUpdateTimer->setInterval(16);  // about one frame
+    connect(curlUpdateTimer, &QTimer::timeout, this, &MainWindow::updateCurlCommand);
+
     QPushButton *backButton = new QPushButton("← Back to Home");
     backButton->setStyleSheet(
         "QPushButton { background-color: #666; color: white; padding: 8px 16px; border: none; "
@@ -487,7 +766,7 @@ void MainWindow::setupCurlBuilderScreen() {
 
     urlLineEdit = new QLineEdit();
     urlLineEdit->setPlaceholderText("https://api.example.com/endpoint");
-    connect(urlLineEdit, &QLineEdit::textChanged, this, &MainWindow::updateCurlCommand);
+    connect(urlLineEdit, &QLineEdit::textChanged, this, &MainWindow::scheduleCurlUpdate);
     urlLayout->addWidget(urlLineEdit);
 
     curlLayout->addWidget(urlGroup);
@@ -500,7 +779,7 @@ void MainWindow::setupCurlBuilderScreen() {
     methodCombo = new QComboBox();
     methodCombo->addItems({"GET", "POST", "PUT", "DELETE", "PATCH", "HEAD", "OPTIONS"});
     connect(methodCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
-            &MainWindow::updateCurlCommand);
+            &MainWindow::scheduleCurlUpdate);
 
     methodLayout->addWidget(methodLabel, 0, 0);
     methodLayout->addWidget(methodCombo, 0, 1);
@@ -510,14 +789,14 @@ void MainWindow::setupCurlBuilderScreen() {
     verboseCombo = new QComboBox();
     verboseCombo->addItems({"None", "-v", "-vv", "-vvv"});
     connect(verboseCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
-            &MainWindow::updateCurlCommand);
+            &MainWindow::scheduleCurlUpdate);
 
     followRedirectsCheck = new QCheckBox("Follow redirects (-L)");
-    connect(followRedirectsCheck, &QCheckBox::toggled, this, &MainWindow::updateCurlCommand);
+    connect(followRedirectsCheck, &QCheckBox::toggled, this, &MainWindow::scheduleCurlUpdate);
     insecureCheck = new QCheckBox("Insecure (-k)");
-    connect(insecureCheck, &QCheckBox::toggled, this, &MainWindow::updateCurlCommand);
+    connect(insecureCheck, &QCheckBox::toggled, this, &MainWindow::scheduleCurlUpdate);
     includeHeadersCheck = new QCheckBox("Include response headers (-i)");
-    connect(includeHeadersCheck, &QCheckBox::toggled, this, &MainWindow::updateCurlCommand);
+    connect(includeHeadersCheck, &QCheckBox::toggled, this, &MainWindow::scheduleCurlUpdate);
 
     methodLayout->addWidget(verboseLabel, 1, 0);
     methodLayout->addWidget(verboseCombo, 1, 1);
@@ -557,10 +836,30 @@ void MainWindow::setupCurlBuilderScreen() {
     QVBoxLayout *bodyLayout = new QVBoxLayout(bodyGroup);
 
     QHBoxLayout *bodyTopLayout = new QHBoxLayout();
-    QPushButton *formatJsonButton = new QPushButton("Format JSON");
+    formatJsonButton = new QPushButton("Format JSON");
     formatJsonButton->setStyleSheet("QPushButton { background-color: #673AB7; color: white; "
                                     "padding: 4px 8px; border: none; border-radius: 4px; }");
     connect(formatJsonButton, &QPushButton::clicked, this, &MainWindow::formatJsonBody);
+
+    // The body stays read-only while it is being formatted so no edit is overwritten
+    connect(&formatJobs, &JobRunner::runningChanged, this, [this](bool running) {
+        formatJsonButton->setText(running ? "Cancel" : "Format JSON");
+        bodyTextEdit->setReadOnly(running);
+    });
+    connect(&formatJobs, &JobRunner::progress, this, [this](int percent) {
+        statusBar()->showMessage(QString("Formatting JSON... %1%").arg(percent));
+    });
+    connect(&formatJobs, &JobRunner::finished, this,
+            [this](const QByteArray &output, const QString &message) {
+                if (output.isEmpty()) {
+                    statusBar()->clearMessage();
+                    QMessageBox::warning(this, "JSON Format",
+                                         "Could not format JSON. Please check syntax.");
+                    return;
+                }
+                bodyTextEdit->setPlainText(QString::fromUtf8(output));
+                statusBar()->showMessage(message, 10000);
+            });
     bodyTopLayout->addStretch();
     bodyTopLayout->addWidget(formatJsonButton);
     bodyLayout->addLayout(bodyTopLayout);
@@ -569,7 +868,11 @@ void MainWindow::setupCurlBuilderScreen() {
     bodyTextEdit->setPlaceholderText("Request body (JSON, form data, etc.)");
     bodyTextEdit->setMaximumHeight(120);
     bodyTextEdit->setStyleSheet("QTextEdit { font-family: 'Courier New', monospace; }");
-    connect(bodyTextEdit, &QTextEdit::textChanged, this, &MainWindow::updateCurlCommand);
+    new CodeHighlighter(bodyTextEdit->document(), Highlighter::Json);
+    connect(bodyTextEdit, &QTextEdit::textChanged, this, [this]() {
+        curlBodyChanged = true;
+        scheduleCurlUpdate();
+    });
     bodyLayout->addWidget(bodyTextEdit);
 
     curlLayout->addWidget(bodyGroup);
@@ -581,6 +884,7 @@ void MainWindow::setupCurlBuilderScreen() {
 
     curlCommandEdit = new QTextEdit();
     curlCommandEdit->setReadOnly(true);
+    curlCommandEdit->setUndoRedoEnabled(false);
     curlCommandEdit->setPlaceholderText("Your curl command will appear here...");
     curlCommandEdit->setMaximumHeight(120);
     curlLayout->addWidget(curlCommandEdit);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <QtCore/QTimer>
 #include <QtGui/QIcon>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QComboBox>
@@ -17,6 +18,14 @@
 #include <QtWidgets/QVBoxLayout>
 #include <QtWidgets/QWidget>
 
+#include <memory>
+
+#include "../core/curl_builder.h"
+#include "../core/decode_search.h"
+#include "../core/decoder.h"
+#include "job_runner.h"
+#include "large_text_view.h"
+
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
@@ -33,6 +42,9 @@ class MainWindow : public QMainWindow {
     void performDecode();
     void clearDecoder();
     void copyDecoderOutput();
+    void updateDetectedEncoding();
+    void applyDetectedEncoding();
+    void liveDecodeChange(int position, int removed, int added);
 
     // Unpacker slots
     void performUnpack();
@@ -41,6 +53,7 @@ class MainWindow : public QMainWindow {
 
     // Curl builder slots
     void addHeader();
+    void scheduleCurlUpdate();
     void updateCurlCommand();
     void copyCurlCommand();
     void formatJsonBody();
@@ -51,6 +64,10 @@ class MainWindow : public QMainWindow {
     void setupDecoderScreen();
     void setupUnpackerScreen();
     void setupCurlBuilderScreen();
+    void startDecode();
+    bool liveDecodingActive() const;
+    void resetLiveDecoder();
+    void startLiveResync();
 
     QIcon createSquareIcon(const QString &text, const QColor &bgColor);
     bool hasIncompleteHeader();
@@ -63,12 +80,22 @@ class MainWindow : public QMainWindow {
     // Decoder components
     QComboBox *algorithmCombo;
     QSpinBox *rotSpinBox;
+    QPushButton *detectedButton;
+    QPushButton *decodeButton;
+    QCheckBox *liveCheck;
     QTextEdit *decoderInputEdit;
-    QTextEdit *decoderOutputEdit;
+    LargeTextView *decoderOutputEdit;
+    Decoder::Live liveDecoder;  // mirrors decoderInputEdit while live decoding is on
+    // Set while decodeJobs decodes the whole input for liveDecoder, which is out of date until
+    // the job hands this over; `liveResyncStale` when the input changed after the job began
+    std::shared_ptr<Decoder::Live> liveResync;
+    bool liveResyncStale = false;
+    DecodeSearch decodeSearch;  // keeps decoded layers cached between runs
 
     // Unpacker components
+    QPushButton *unpackButton;
     QTextEdit *unpackerInputEdit;
-    QTextEdit *unpackerOutputEdit;
+    LargeTextView *unpackerOutputEdit;
 
     // Curl builder components
     QLineEdit *urlLineEdit;
@@ -80,6 +107,16 @@ class MainWindow : public QMainWindow {
     QWidget *headersWidget;
     QVBoxLayout *headersWidgetLayout;
     QPushButton *addHeaderButton;
+    QPushButton *formatJsonButton;
     QTextEdit *bodyTextEdit;
     QTextEdit *curlCommandEdit;
+    QTimer *curlUpdateTimer;
+    CurlBuilder::Command curlCommand;  // what curlCommandEdit shows, patched in place
+    QString curlBody;                  // bodyTextEdit's text, read again only after it changes
+    bool curlBodyChanged = true;
+
+    // Declared last so they are destroyed first: a job still running may use decodeSearch
+    JobRunner decodeJobs;
+    JobRunner unpackJobs;
+    JobRunner formatJobs;
 };
\ No newline at end of file